@@ -0,0 +1,217 @@
+/*
+ * SymmetricEigen3x3.h
+ *
+ * Closed-form eigenanalysis of 3x3 real symmetric matrices, such as
+ * the Hessian of a 3D image at each voxel.
+ *
+ * SymmetricEigenValues3x3(): eigenvalues of a block of n matrices
+ * stored as a structure of arrays (one array per independent
+ * component xx, xy, xz, yy, yz, zz). The eigenvalues are computed
+ * with the trigonometric solution of the characteristic polynomial
+ * (Smith, 1961), instead of the iterative QL method of
+ * itk::SymmetricEigenAnalysis. The loop has no branches and no
+ * dependencies between matrices, so that the compiler can vectorise
+ * it (e.g. with -O3 and a vector math library for acos/cos).
+ *
+ * SymmetricEigenVector3x3(): unit eigenvector of a matrix for a given
+ * eigenvalue, computed as the largest cross product of two rows of
+ * (A - lambda I).
+ *
+ *   O.K. Smith, "Eigenvalues of a symmetric 3x3 matrix",
+ *   Communications of the ACM, 4(4):168, 1961.
+ */
+
+/*
+ * Author: Ramon Casero <rcasero@gmail.com>
+ * Copyright © 2014 University of Oxford
+ * Version: 0.1.0
+ *
+ * University of Oxford means the Chancellor, Masters and Scholars of
+ * the University of Oxford, having an administrative office at
+ * Wellington Square, Oxford OX1 2JD, UK.
+ *
+ * This file is part of Gerardus.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details. The offer of this
+ * program under the terms of the License is subject to the License
+ * being interpreted in accordance with English Law and subject to any
+ * action against the University of Oxford being under the jurisdiction
+ * of the English Courts.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see
+ * <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef SYMMETRICEIGEN3X3_H
+#define SYMMETRICEIGEN3X3_H
+
+/* C++ headers */
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <limits>
+
+/*
+ * SymmetricEigenValues3x3(): eigenvalues e0 <= e1 <= e2 of the n
+ * symmetric matrices
+ *
+ *   [xx[i] xy[i] xz[i]
+ *    xy[i] yy[i] yz[i]
+ *    xz[i] yz[i] zz[i]]
+ */
+template <class T>
+void SymmetricEigenValues3x3(size_t n,
+			     const T *xx, const T *xy, const T *xz,
+			     const T *yy, const T *yz, const T *zz,
+			     T *e0, T *e1, T *e2) {
+
+  const T third = (T)1.0 / (T)3.0;
+  const T twoPiThirds = (T)(2.0 * 3.14159265358979323846 / 3.0);
+
+  for (size_t i = 0; i < n; ++i) {
+
+    // the eigenvalues of A are q + 2p cos(phi + 2k pi/3), where q is
+    // the mean of the diagonal, and B = (A - qI)/p has unit norm
+    const T q = (xx[i] + yy[i] + zz[i]) * third;
+    const T b00 = xx[i] - q;
+    const T b11 = yy[i] - q;
+    const T b22 = zz[i] - q;
+    const T b01 = xy[i];
+    const T b02 = xz[i];
+    const T b12 = yz[i];
+
+    const T p2 = b00 * b00 + b11 * b11 + b22 * b22
+      + (T)2.0 * (b01 * b01 + b02 * b02 + b12 * b12);
+    const T p = std::sqrt(p2 / (T)6.0);
+
+    // if p == 0, A is a multiple of the identity and all the
+    // eigenvalues are q
+    const T invp = (p > (T)0.0) ? (T)1.0 / p : (T)0.0;
+
+    // r = det(B)/2, clamped to [-1, 1] against rounding errors
+    const T det = b00 * (b11 * b22 - b12 * b12)
+      - b01 * (b01 * b22 - b12 * b02)
+      + b02 * (b01 * b12 - b11 * b02);
+    T r = (T)0.5 * det * invp * invp * invp;
+    r = std::min((T)1.0, std::max((T)-1.0, r));
+
+    // e1 is obtained from the trace, and clamped so that rounding
+    // errors don't break the order when two eigenvalues are equal
+    const T phi = std::acos(r) * third;
+    e2[i] = q + (T)2.0 * p * std::cos(phi);
+    e0[i] = q + (T)2.0 * p * std::cos(phi + twoPiThirds);
+    e1[i] = std::min(e2[i], std::max(e0[i], (T)3.0 * q - e0[i] - e2[i]));
+
+  }
+
+}
+
+/*
+ * SymmetricEigenVector3x3(): unit eigenvector v of the symmetric
+ * matrix A (given by its independent components as above) for its
+ * eigenvalue lambda.
+ *
+ * The eigenvector is orthogonal to the rows of (A - lambda I), so it
+ * is computed as the largest of the cross products of each pair of
+ * rows. If lambda is a double eigenvalue, the rows are parallel, and
+ * v is any unit vector orthogonal to them. If A = lambda I, v = (1,
+ * 0, 0). The sign of v is arbitrary
+ */
+template <class T>
+void SymmetricEigenVector3x3(T xx, T xy, T xz, T yy, T yz, T zz,
+			     T lambda, T *v) {
+
+  const T r0[3] = {xx - lambda, xy, xz};
+  const T r1[3] = {xy, yy - lambda, yz};
+  const T r2[3] = {xz, yz, zz - lambda};
+
+  const T c01[3] = {r0[1] * r1[2] - r0[2] * r1[1],
+		    r0[2] * r1[0] - r0[0] * r1[2],
+		    r0[0] * r1[1] - r0[1] * r1[0]};
+  const T c02[3] = {r0[1] * r2[2] - r0[2] * r2[1],
+		    r0[2] * r2[0] - r0[0] * r2[2],
+		    r0[0] * r2[1] - r0[1] * r2[0]};
+  const T c12[3] = {r1[1] * r2[2] - r1[2] * r2[1],
+		    r1[2] * r2[0] - r1[0] * r2[2],
+		    r1[0] * r2[1] - r1[1] * r2[0]};
+
+  const T n01 = c01[0] * c01[0] + c01[1] * c01[1] + c01[2] * c01[2];
+  const T n02 = c02[0] * c02[0] + c02[1] * c02[1] + c02[2] * c02[2];
+  const T n12 = c12[0] * c12[0] + c12[1] * c12[1] + c12[2] * c12[2];
+
+  // squared norm of the largest row, to decide whether the cross
+  // products are only rounding errors
+  const T m0 = r0[0] * r0[0] + r0[1] * r0[1] + r0[2] * r0[2];
+  const T m1 = r1[0] * r1[0] + r1[1] * r1[1] + r1[2] * r1[2];
+  const T m2 = r2[0] * r2[0] + r2[1] * r2[1] + r2[2] * r2[2];
+  const T *rmax = r0;
+  T mmax = m0;
+  if (m1 > mmax) {
+    rmax = r1;
+    mmax = m1;
+  }
+  if (m2 > mmax) {
+    rmax = r2;
+    mmax = m2;
+  }
+
+  // A = lambda I: any vector is an eigenvector
+  if (mmax <= (T)0.0) {
+    v[0] = (T)1.0;
+    v[1] = (T)0.0;
+    v[2] = (T)0.0;
+    return;
+  }
+
+  // single eigenvalue: the rows span a plane, and v is its normal
+  const T *c = c01;
+  T nmax = n01;
+  if (n02 > nmax) {
+    c = c02;
+    nmax = n02;
+  }
+  if (n12 > nmax) {
+    c = c12;
+    nmax = n12;
+  }
+  const T tol = (T)64.0 * std::numeric_limits<T>::epsilon();
+  if (nmax > tol * tol * mmax * mmax) {
+    const T invn = (T)1.0 / std::sqrt(nmax);
+    v[0] = c[0] * invn;
+    v[1] = c[1] * invn;
+    v[2] = c[2] * invn;
+    return;
+  }
+
+  // double eigenvalue: the rows are parallel, and v is any vector
+  // orthogonal to them. Take the cross product of the largest row
+  // with the coordinate axis least aligned with it
+  T a[3] = {(T)0.0, (T)0.0, (T)0.0};
+  if (std::abs(rmax[0]) <= std::abs(rmax[1])
+      && std::abs(rmax[0]) <= std::abs(rmax[2])) {
+    a[0] = (T)1.0;
+  } else if (std::abs(rmax[1]) <= std::abs(rmax[2])) {
+    a[1] = (T)1.0;
+  } else {
+    a[2] = (T)1.0;
+  }
+  v[0] = rmax[1] * a[2] - rmax[2] * a[1];
+  v[1] = rmax[2] * a[0] - rmax[0] * a[2];
+  v[2] = rmax[0] * a[1] - rmax[1] * a[0];
+  const T invn = (T)1.0 / std::sqrt(v[0] * v[0] + v[1] * v[1] + v[2] * v[2]);
+  v[0] *= invn;
+  v[1] *= invn;
+  v[2] *= invn;
+
+}
+
+#endif /* SYMMETRICEIGEN3X3_H */
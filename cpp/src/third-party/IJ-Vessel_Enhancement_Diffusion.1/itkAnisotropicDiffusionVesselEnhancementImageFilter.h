@@ -16,11 +16,15 @@
 =========================================================================*/
 /*=========================================================================
    Edits by Ramon Casero <rcasero@gmail.com> for project Gerardus
-   Version: 0.3.1
+   Version: 0.4.0
    * Minor edits for compatibility with ITK 4.3
    * add linear scales besides logarithmic scales
    * adapt code to compile with ITK v4.x
    * remove progress messages
+   * single precision Hessian and vesselness, and closed-form
+     eigenanalysis instead of SymmetricEigenVectorAnalysisImageFilter
+   * diffusion tensor built from the eigenvector of the smallest
+     magnitude eigenvalue (vessel direction), as in Manniesing et al.
 =========================================================================*/
 #ifndef __itkAnisotropicDiffusionVesselEnhancementImageFilter_h
 #define __itkAnisotropicDiffusionVesselEnhancementImageFilter_h
@@ -31,7 +35,6 @@
 #include "itkDiffusionTensor3D.h"
 #include "itkMultiScaleHessianSmoothed3DToVesselnessMeasureImageFilter.h"
 #include "itkHessianRecursiveGaussianImageFilter.h"
-#include "itkSymmetricEigenVectorAnalysisImageFilter.h"
 
 namespace itk {
 /** \class AnisotropicDiffusionVesselEnhancementFunction
@@ -88,40 +91,21 @@ public:
   typedef AnisotropicDiffusionVesselEnhancementFunction<InputImageType>  
                                                   FiniteDifferenceFunctionType;
   
-  typedef HessianRecursiveGaussianImageFilter< InputImageType >
-                                                HessianFilterType;
-
-  typedef itk::Image< double, 3 >               VesselnessOutputImageType;
+  typedef itk::Image< float, 3 >                VesselnessOutputImageType;
 
   typedef MultiScaleHessianSmoothed3DToVesselnessMeasureImageFilter< 
                                                 InputImageType, 
                                                 VesselnessOutputImageType >
                                                 MultiScaleVesselnessFilterType;
 
-  typedef itk::Matrix<double, ImageDimension, ImageDimension> MatrixType;
-
-  // Define image of matrix pixel type 
-  typedef itk::Image< MatrixType, ImageDimension>  OutputMatrixImageType;
-
-  // Define the symmetric tensor pixel type
-  typedef itk::SymmetricSecondRankTensor< double, ImageDimension> 
-                                                         TensorPixelType;
-  typedef itk::Image< TensorPixelType, ImageDimension>  
-                                                         TensorImageType;
-
-   // Define the type for storing the eigen-value
-  typedef itk::FixedArray< double, ImageDimension >      EigenValueArrayType;
-  
-  // Declare the types of the output images
-  typedef itk::Image< EigenValueArrayType, ImageDimension >  
-                                                  EigenAnalysisOutputImageType;
-  
-  // Declare the type for the filter
-  typedef itk::SymmetricEigenVectorAnalysisImageFilter< 
-                                    TensorImageType, 
-                                    EigenAnalysisOutputImageType,
-                                    OutputMatrixImageType 
-                                    >  EigenVectorMatrixAnalysisFilterType;
+  // Hessian used to compute the vessel direction, in single precision
+  typedef typename MultiScaleVesselnessFilterType::HessianPixelType
+                                                HessianPixelType;
+  typedef typename MultiScaleVesselnessFilterType::HessianImageType
+                                                HessianImageType;
+  typedef HessianRecursiveGaussianImageFilter< InputImageType,
+                                               HessianImageType >
+                                                HessianFilterType;
 
   /** The value type of a time step.  Inherited from the superclass. */
   typedef typename Superclass::TimeStepType TimeStepType;
@@ -280,9 +264,6 @@ private:
   typename MultiScaleVesselnessFilterType::Pointer      m_MultiScaleVesselnessFilter;  
   typename HessianFilterType::Pointer                   m_HessianFilter;  
 
-  typename EigenVectorMatrixAnalysisFilterType::Pointer 
-                                      m_EigenVectorMatrixAnalysisFilter; 
-
   // Vesselness guided diffusion parameters
   double                                                 m_Epsilon;
   double                                                 m_WStrength;
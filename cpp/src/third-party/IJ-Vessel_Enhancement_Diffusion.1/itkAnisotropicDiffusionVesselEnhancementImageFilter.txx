@@ -19,7 +19,11 @@
          * add linear scales besides logarithmic scales
    	 * adapt code to compile with ITK v4.x
    	 * remove progress messages
-   Version: 0.3.1
+         * single precision Hessian and vesselness, and closed-form
+           eigenanalysis instead of SymmetricEigenVectorAnalysisImageFilter
+         * diffusion tensor built from the eigenvector of the smallest
+           magnitude eigenvalue (vessel direction), as in Manniesing et al.
+   Version: 0.4.0
 =========================================================================*/
 #ifndef __itkAnisotropicDiffusionVesselEnhancementImageFilter_txx_
 #define __itkAnisotropicDiffusionVesselEnhancementImageFilter_txx_
@@ -27,6 +31,7 @@
 #include "itkAnisotropicDiffusionVesselEnhancementImageFilter.h"
 #include "itkAnisotropicDiffusionVesselEnhancementFunction.h"
 
+#include <algorithm>
 #include <list>
 #include "itkImageRegionConstIterator.h"
 #include "itkImageRegionIterator.h"
@@ -35,6 +40,7 @@
 
 #include "itkImageFileWriter.h"
 #include "itkVector.h"
+#include "SymmetricEigen3x3.h"
 
 //#define INTERMEDIATE_OUTPUTS
 
@@ -63,10 +69,6 @@ AnisotropicDiffusionVesselEnhancementImageFilter<TInputImage, TOutputImage>
   //instantiate the Hessian filter
   m_HessianFilter                                 = HessianFilterType::New();
 
-  //instantiate the SymmetricEigenVectorAnalysis filter
-  m_EigenVectorMatrixAnalysisFilter = EigenVectorMatrixAnalysisFilterType::New();
-  m_EigenVectorMatrixAnalysisFilter->SetDimension( TensorPixelType::Dimension ); 
- 
   //instantiate the vesselness filter
   m_MultiScaleVesselnessFilter  = MultiScaleVesselnessFilterType::New();
   m_MultiScaleVesselnessFilter->SetSigmaMin( 0.2 );
@@ -316,159 +318,116 @@ AnisotropicDiffusionVesselEnhancementImageFilter<TInputImage, TOutputImage>
   VesselenssImageWriter->Update(); 
 #endif
 
-  // Hessian matrix 
-  typename HessianFilterType::OutputImageType::Pointer   HessianOutputImage;
-  HessianOutputImage = m_HessianFilter->GetOutput();
-
-  // Pass it to the eigenVector matrix analyzer
-  m_EigenVectorMatrixAnalysisFilter->SetInput( HessianOutputImage ); 
-
-  m_EigenVectorMatrixAnalysisFilter->Update();
-
-  typename OutputMatrixImageType::Pointer eigenVectorMatrixOutputImage =
-                              m_EigenVectorMatrixAnalysisFilter->GetOutput();
-
-  typedef  itk::ImageRegionIterator< OutputMatrixImageType > 
-                                    EigenVectorMatrixIteratorType;
-
-  EigenVectorMatrixIteratorType   
-               ig(eigenVectorMatrixOutputImage, eigenVectorMatrixOutputImage->GetLargestPossibleRegion());
-
-  ig.GoToBegin();
+  // Hessian matrix and vesselness response
+  typename HessianImageType::ConstPointer hessian = 
+                                          m_HessianFilter->GetOutput();
+  typename VesselnessOutputImageType::ConstPointer vesselness = 
+                                m_MultiScaleVesselnessFilter->GetOutput();
 
-#ifdef INTERMEDIATE_OUTPUTS
-  typedef ImageFileWriter< OutputMatrixImageType > EigenVectorMatrixWriterType;
-
-  typename EigenVectorMatrixWriterType::Pointer 
-           EigenVectorMatrixWriter = EigenVectorMatrixWriterType::New();
+  if ( hessian->GetBufferedRegion() != 
+                        m_DiffusionTensorImage->GetBufferedRegion()
+       || vesselness->GetBufferedRegion() != 
+                        m_DiffusionTensorImage->GetBufferedRegion() )
+    {
+    itkExceptionMacro(<< "Hessian, vesselness and diffusion tensor regions are different");
+    }
 
-  EigenVectorMatrixWriter->SetFileName( "EigenVectorMatrixImage.mha" );
-  EigenVectorMatrixWriter->SetInput ( m_EigenVectorMatrixAnalysisFilter->GetOutput());
-  EigenVectorMatrixWriter->Update(); 
+  const HessianPixelType *h = hessian->GetBufferPointer();
+  const float *v = vesselness->GetBufferPointer();
+  typename DiffusionTensorImageType::PixelType *d = 
+                                 m_DiffusionTensorImage->GetBufferPointer();
+  const long n = static_cast< long >(
+         m_DiffusionTensorImage->GetBufferedRegion().GetNumberOfPixels() );
+
+  const double iS = 1.0 / m_Sensitivity; 
+
+  // The diffusion tensor has eigenvalue Lambda1 along the vessel
+  // direction (the eigenvector of the Hessian eigenvalue with the
+  // smallest magnitude) and Lambda2 = Lambda3 across it, so
+  //
+  //   D = Lambda2 I + (Lambda1 - Lambda2) u u^T
+  //
+  // which doesn't depend on the sign of u or on the other two
+  // eigenvectors. The Hessian is copied to a structure of arrays
+  // block by block, so that the eigenvalues can be computed with
+  // vector instructions
+  const long blockSize = 256;
+  const long numberOfBlocks = ( n + blockSize - 1 ) / blockSize;
+
+#ifdef _OPENMP
+#pragma omp parallel
 #endif
- 
-  // Vessleness response
-  typename MultiScaleVesselnessFilterType::OutputImageType::Pointer   MultiScaleHessianOutputImage;
-  MultiScaleHessianOutputImage = m_MultiScaleVesselnessFilter->GetOutput();
-
-  typedef typename MultiScaleVesselnessFilterType::OutputImageType      MultiScaleHessianOutputImageType;
-  typedef  itk::ImageRegionIterator< MultiScaleHessianOutputImageType > MultiScaleHessianIteratorType;
-  MultiScaleHessianIteratorType    im(MultiScaleHessianOutputImage, 
-                                    MultiScaleHessianOutputImage->GetLargestPossibleRegion());
-  im.GoToBegin();
-
-  typename DiffusionTensorImageType::PixelType                   tensor;
-
-  double Lambda1;
-  double Lambda2;
-  double Lambda3;
-
-  double iS = 1.0 / m_Sensitivity; 
-
-  MatrixType eigenValueMatrix;
-  MatrixType HessianEigenVectorMatrix;
-  MatrixType HessianEigenVectorMatrixTranspose;
-  MatrixType productMatrix;
-
-  typedef itk::ImageRegionIterator< DiffusionTensorImageType > DiffusionTensorIteratorType;
-
-  DiffusionTensorIteratorType 
-      it( m_DiffusionTensorImage, m_DiffusionTensorImage->GetLargestPossibleRegion() );
-
-  it.GoToBegin();
-
-
-  /* For Debugging */
-  /* ======================= */
-  ImageRegionIterator<OutputImageType>  om(this->GetOutput(),
-                                           this->GetOutput()->GetLargestPossibleRegion());
-  om.GoToBegin();
-
-//  std::cout << "Generate tensor matrix: " << std::endl;
- 
-  //DEBUG: DELETE LATER
-  // Generate a vector image of the eigen values
-
-  typedef itk::Vector<  double , 3>          VectorPixelType;
-  typedef itk::Image< VectorPixelType, 3>    EigenValueImageType;
-  
-
-  EigenValueImageType::Pointer  eigenValueImage = EigenValueImageType::New();
-
-  eigenValueImage->SetSpacing(this->GetOutput()->GetSpacing());
-  eigenValueImage->SetOrigin(this->GetOutput()->GetOrigin());
-  eigenValueImage->SetLargestPossibleRegion(this->GetOutput()->GetLargestPossibleRegion());
-  eigenValueImage->SetRequestedRegion(this->GetOutput()->GetRequestedRegion());
-  eigenValueImage->SetBufferedRegion(this->GetOutput()->GetBufferedRegion());
-  eigenValueImage->Allocate();
-
-  ImageRegionIterator<EigenValueImageType>  eigenImageIterator(eigenValueImage,
-                                           eigenValueImage->GetLargestPossibleRegion());
-  eigenImageIterator.GoToBegin();
-
-  VectorPixelType eigenVectorPixel;
- 
-
-  while( !it.IsAtEnd() )
+  {
+  float xx[blockSize], xy[blockSize], xz[blockSize];
+  float yy[blockSize], yz[blockSize], zz[blockSize];
+  float e0[blockSize], e1[blockSize], e2[blockSize];
+  double u[3];
+
+#ifdef _OPENMP
+#pragma omp for schedule(static)
+#endif
+  for ( long block = 0; block < numberOfBlocks; block++ )
     {
-    // Generate matrix "Q" with the eigenvectors of the Hessian
-    HessianEigenVectorMatrix = ig.Get();
-    HessianEigenVectorMatrixTranspose = HessianEigenVectorMatrix.GetTranspose(); 
-
-    // Generate the diagonal matrix with the eigen values
-    eigenValueMatrix.SetIdentity();
+    const long first = block * blockSize;
+    const long len = std::min( blockSize, n - first );
 
-    double vesselNessValue = static_cast<double> (im.Get());
-    
-    Lambda1 = 1 + ( m_WStrength - 1 ) * vcl_pow ( vesselNessValue, iS ); 
-    Lambda2 = Lambda3 = 1 + ( m_Epsilon - 1 ) * vcl_pow ( vesselNessValue, iS ); 
-
-    eigenValueMatrix(0,0) = Lambda1;
-    eigenValueMatrix(1,1) = Lambda2;
-    eigenValueMatrix(2,2) = Lambda3;
-
-    eigenVectorPixel[0] = Lambda1;
-    eigenVectorPixel[1] = Lambda2;
-    eigenVectorPixel[2] = Lambda3;
-  
-    eigenImageIterator.Set( eigenVectorPixel );
+    for ( long j = 0; j < len; j++ )
+      {
+      const HessianPixelType &pixel = h[first + j];
+      xx[j] = pixel[0];
+      xy[j] = pixel[1];
+      xz[j] = pixel[2];
+      yy[j] = pixel[3];
+      yz[j] = pixel[4];
+      zz[j] = pixel[5];
+      }
 
-    // Generate the tensor matrix
-    productMatrix = HessianEigenVectorMatrix * eigenValueMatrix * HessianEigenVectorMatrixTranspose;
+    SymmetricEigenValues3x3< float >( len, xx, xy, xz, yy, yz, zz, 
+                                      e0, e1, e2 );
 
-    //Copy the ITK::Matrix to the tensor...there should be a better way of doing this TODO
+    for ( long j = 0; j < len; j++ )
+      {
+      typename DiffusionTensorImageType::PixelType &tensor = d[first + j];
 
-    tensor(0,0) = productMatrix(0,0);
-    tensor(0,1) = productMatrix(0,1);
-    tensor(0,2) = productMatrix(0,2);
+      double vesselNessValue = static_cast<double> ( v[first + j] );
 
-    tensor(1,0) = productMatrix(1,0);
-    tensor(1,1) = productMatrix(1,1);
-    tensor(1,2) = productMatrix(1,2);
+      double Lambda1 = 1 + ( m_WStrength - 1 ) * vcl_pow ( vesselNessValue, iS ); 
+      double Lambda2 = 1 + ( m_Epsilon - 1 ) * vcl_pow ( vesselNessValue, iS ); 
 
-    tensor(2,0) = productMatrix(2,0);
-    tensor(2,1) = productMatrix(2,1);
-    tensor(2,2) = productMatrix(2,2);
+      // outside vessels the diffusion is isotropic
+      if ( Lambda1 == Lambda2 )
+        {
+        tensor.Fill( 0.0 );
+        tensor( 0, 0 ) = tensor( 1, 1 ) = tensor( 2, 2 ) = Lambda2;
+        continue;
+        }
 
-    it.Set( tensor );
+      // eigenvalue with the smallest magnitude
+      double lambda = e0[j];
+      if ( vnl_math_abs( e1[j] ) < vnl_math_abs( lambda ) )
+        {
+        lambda = e1[j];
+        }
+      if ( vnl_math_abs( e2[j] ) < vnl_math_abs( lambda ) )
+        {
+        lambda = e2[j];
+        }
+      SymmetricEigenVector3x3< double >( xx[j], xy[j], xz[j], 
+                                         yy[j], yz[j], zz[j], lambda, u );
 
-    ++it;
-    ++ig;
-    ++im;
-    ++eigenImageIterator;
-    
-    ++om;
+      for ( unsigned int r = 0; r < 3; r++ )
+        {
+        for ( unsigned int c = r; c < 3; c++ )
+          {
+          tensor( r, c ) = ( Lambda1 - Lambda2 ) * u[r] * u[c];
+          }
+        tensor( r, r ) += Lambda2;
+        }
+      }
     }
-
-  
+  }
 
 #ifdef INTERMEDIATE_OUTPUTS
-  typedef itk::ImageFileWriter< EigenValueImageType > EigenValueVectorImageWriter;
-  EigenValueVectorImageWriter::Pointer eigenValueVectorImageWriter = EigenValueVectorImageWriter::New();
-  eigenValueVectorImageWriter->SetInput( eigenValueImage );
-  eigenValueVectorImageWriter->SetFileName( "EigenValueVectorImage.mha");
-  eigenValueVectorImageWriter->Update();
-
   typedef ImageFileWriter< DiffusionTensorImageType > DiffusionTensorWriterType;
 
   typename DiffusionTensorWriterType::Pointer   
@@ -16,8 +16,10 @@
 =========================================================================*/
 /*=========================================================================
    Edits by Ramon Casero <rcasero@gmail.com> for project Gerardus
-   Version: 0.1.0
+   Version: 0.2.0
     * Minor edits for compatibility with ITK 4.3
+    * Move the vesselness measure to a static method, so that it can
+      be reused by the multiscale filter without an image per scale
 =========================================================================*/
 #ifndef __itkHessianSmoothed3DToVesselnessMeasureImageFilter_h
 #define __itkHessianSmoothed3DToVesselnessMeasureImageFilter_h
@@ -113,6 +115,13 @@ public:
   itkGetMacro( ScaleVesselnessMeasure, bool );
   itkBooleanMacro(ScaleVesselnessMeasure);
 
+  /** Vesselness measure for the eigenvalues of one Hessian matrix,
+      sorted by value */
+  static double ComputeVesselnessMeasure( const double *eigenValue,
+                                          double alpha, double beta,
+                                          double gamma, double c,
+                                          bool scaleVesselnessMeasure );
+
 #ifdef ITK_USE_CONCEPT_CHECKING
   /** Begin concept checking */
   itkConceptMacro(DoubleConvertibleToOutputCheck,
@@ -14,6 +14,11 @@
      PURPOSE.  See the above copyright notices for more information.
 
 =========================================================================*/
+/*=========================================================================
+   Edits by Ramon Casero <rcasero@gmail.com> for project Gerardus
+   Version: 0.2.0
+    * Move the vesselness measure to ComputeVesselnessMeasure()
+=========================================================================*/
 #ifndef __itkHessianSmoothed3DToVesselnessMeasureImageFilter_txx
 #define __itkHessianSmoothed3DToVesselnessMeasureImageFilter_txx
 
@@ -88,101 +93,113 @@ HessianSmoothed3DToVesselnessMeasureImageFilter< TPixel >
     // Get the eigen value
     eigenValue = it.Get();
 
+    oit.Set( static_cast< OutputPixelType >( 
+               ComputeVesselnessMeasure( eigenValue.GetDataPointer(),
+                                         m_Alpha, m_Beta, m_Gamma, m_C,
+                                         m_ScaleVesselnessMeasure ) ) );
+    ++it;
+    ++oit;
+    }
+    
+}
 
-    // Find the smallest eigenvalue
-    double smallest = vnl_math_abs( eigenValue[0] );
-    double Lambda1 = eigenValue[0];
- 
-    for ( unsigned int i=1; i <=2; i++ )
+template < typename TPixel >
+double
+HessianSmoothed3DToVesselnessMeasureImageFilter< TPixel >
+::ComputeVesselnessMeasure( const double *eigenValue,
+                            double alpha, double beta,
+                            double gamma, double c,
+                            bool scaleVesselnessMeasure )
+{
+  // Find the smallest eigenvalue
+  double smallest = vnl_math_abs( eigenValue[0] );
+  double Lambda1 = eigenValue[0];
+
+  for ( unsigned int i=1; i <=2; i++ )
+    {
+    if ( vnl_math_abs( eigenValue[i] ) < smallest )
       {
-      if ( vnl_math_abs( eigenValue[i] ) < smallest )
-        {
-        Lambda1 = eigenValue[i];
-        smallest = vnl_math_abs( eigenValue[i] );
-        }
+      Lambda1 = eigenValue[i];
+      smallest = vnl_math_abs( eigenValue[i] );
       }
+    }
 
-    // Find the largest eigenvalue
-    double largest = vnl_math_abs( eigenValue[0] );
-    double Lambda3 = eigenValue[0];
- 
-    for ( unsigned int i=1; i <=2; i++ )
+  // Find the largest eigenvalue
+  double largest = vnl_math_abs( eigenValue[0] );
+  double Lambda3 = eigenValue[0];
+
+  for ( unsigned int i=1; i <=2; i++ )
+    {
+    if (  vnl_math_abs( eigenValue[i] > largest ) )
       {
-      if (  vnl_math_abs( eigenValue[i] > largest ) )
-        {
-        Lambda3 = eigenValue[i];
-        largest = vnl_math_abs( eigenValue[i] );
-        }
+      Lambda3 = eigenValue[i];
+      largest = vnl_math_abs( eigenValue[i] );
       }
+    }
 
 
-    //  find Lambda2 so that |Lambda1| < |Lambda2| < |Lambda3|
-    double Lambda2 = eigenValue[0];
+  //  find Lambda2 so that |Lambda1| < |Lambda2| < |Lambda3|
+  double Lambda2 = eigenValue[0];
 
-    for ( unsigned int i=0; i <=2; i++ )
+  for ( unsigned int i=0; i <=2; i++ )
+    {
+    if ( eigenValue[i] != Lambda1 && eigenValue[i] != Lambda3 )
       {
-      if ( eigenValue[i] != Lambda1 && eigenValue[i] != Lambda3 )
-        {
-        Lambda2 = eigenValue[i];
-        break;
-        }
+      Lambda2 = eigenValue[i];
+      break;
       }
+    }
+
+  if ( Lambda2 >= 0.0 ||  Lambda3 >= 0.0 || 
+       vnl_math_abs( Lambda2) < EPSILON  || 
+       vnl_math_abs( Lambda3 ) < EPSILON )
+    {
+    return 0.0;
+    } 
+  else
+    {
+
+    double Lambda1Abs = vnl_math_abs( Lambda1 );
+    double Lambda2Abs = vnl_math_abs( Lambda2 );
+    double Lambda3Abs = vnl_math_abs( Lambda3 );
+
+    double Lambda1Sqr = vnl_math_sqr( Lambda1 );
+    double Lambda2Sqr = vnl_math_sqr( Lambda2 );
+    double Lambda3Sqr = vnl_math_sqr( Lambda3 );
+
+    double AlphaSqr = vnl_math_sqr( alpha );
+    double BetaSqr = vnl_math_sqr( beta );
+    double GammaSqr = vnl_math_sqr( gamma );
+
+    double A  = Lambda2Abs / Lambda3Abs; 
+    double B  = Lambda1Abs / vcl_sqrt ( vnl_math_abs( Lambda2 * Lambda3 )); 
+    double S  = vcl_sqrt( Lambda1Sqr + Lambda2Sqr + Lambda3Sqr );
+
+    double vesMeasure_1  = 
+       ( 1 - vcl_exp(-1.0*(( vnl_math_sqr(A) ) / ( 2.0 * ( AlphaSqr)))));
 
-    if ( Lambda2 >= 0.0 ||  Lambda3 >= 0.0 || 
-         vnl_math_abs( Lambda2) < EPSILON  || 
-         vnl_math_abs( Lambda3 ) < EPSILON )
+    double vesMeasure_2  = 
+       vcl_exp ( -1.0 * ((vnl_math_sqr( B )) /  ( 2.0 * (BetaSqr))));
+
+    double vesMeasure_3  = 
+       ( 1 - vcl_exp( -1.0 * (( vnl_math_sqr( S )) / ( 2.0 * ( GammaSqr)))));
+
+    double vesMeasure_4  = 
+       vcl_exp ( -1.0 * ( 2.0 * vnl_math_sqr( c )) / 
+                                 ( Lambda2Abs * (Lambda3Sqr))); 
+
+    double vesselnessMeasure = 
+       vesMeasure_1 * vesMeasure_2 * vesMeasure_3 * vesMeasure_4; 
+
+    if(  scaleVesselnessMeasure ) 
       {
-      oit.Set( NumericTraits< OutputPixelType >::Zero );
-      } 
+      return Lambda3Abs*vesselnessMeasure;
+      }
     else
       {
-   
-      double Lambda1Abs = vnl_math_abs( Lambda1 );
-      double Lambda2Abs = vnl_math_abs( Lambda2 );
-      double Lambda3Abs = vnl_math_abs( Lambda3 );
-
-      double Lambda1Sqr = vnl_math_sqr( Lambda1 );
-      double Lambda2Sqr = vnl_math_sqr( Lambda2 );
-      double Lambda3Sqr = vnl_math_sqr( Lambda3 );
-
-      double AlphaSqr = vnl_math_sqr( m_Alpha );
-      double BetaSqr = vnl_math_sqr( m_Beta );
-      double GammaSqr = vnl_math_sqr( m_Gamma );
-
-      double A  = Lambda2Abs / Lambda3Abs; 
-      double B  = Lambda1Abs / vcl_sqrt ( vnl_math_abs( Lambda2 * Lambda3 )); 
-      double S  = vcl_sqrt( Lambda1Sqr + Lambda2Sqr + Lambda3Sqr );
-
-      double vesMeasure_1  = 
-         ( 1 - vcl_exp(-1.0*(( vnl_math_sqr(A) ) / ( 2.0 * ( AlphaSqr)))));
-
-      double vesMeasure_2  = 
-         vcl_exp ( -1.0 * ((vnl_math_sqr( B )) /  ( 2.0 * (BetaSqr))));
-
-      double vesMeasure_3  = 
-         ( 1 - vcl_exp( -1.0 * (( vnl_math_sqr( S )) / ( 2.0 * ( GammaSqr)))));
-
-      double vesMeasure_4  = 
-         vcl_exp ( -1.0 * ( 2.0 * vnl_math_sqr( m_C )) / 
-                                   ( Lambda2Abs * (Lambda3Sqr))); 
-
-      double vesselnessMeasure = 
-         vesMeasure_1 * vesMeasure_2 * vesMeasure_3 * vesMeasure_4; 
-
-      if(  m_ScaleVesselnessMeasure ) 
-        {
-        oit.Set( static_cast< OutputPixelType >(
-                                     Lambda3Abs*vesselnessMeasure ) );
-        }
-      else
-        {
-        oit.Set( static_cast< OutputPixelType >( vesselnessMeasure ) );
-        }
+      return vesselnessMeasure;
       }
-    ++it;
-    ++oit;
     }
-    
 }
 
 template < typename TPixel >
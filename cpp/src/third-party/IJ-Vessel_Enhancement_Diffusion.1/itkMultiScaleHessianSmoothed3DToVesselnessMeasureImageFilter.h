@@ -16,9 +16,13 @@
 =========================================================================*/
 /*=========================================================================
    Edits by Ramon Casero <rcasero@gmail.com> for project Gerardus
-   Version: 0.2.1
+   Version: 0.3.0
     * Add linear scales besides logarithmic scales
     * Minor edits for compatibility with ITK 4.3
+    * Compute the Hessian in single precision, and the eigenvalues
+      with the closed-form kernel in SymmetricEigen3x3.h. The
+      vesselness of each scale is merged into the maximum response
+      voxel by voxel, without eigenvalue or vesselness images
 =========================================================================*/
 #ifndef __itkMultiScaleHessianSmoothed3DToVesselnessMeasureImageFilter_h
 #define __itkMultiScaleHessianSmoothed3DToVesselnessMeasureImageFilter_h
@@ -28,6 +32,7 @@
 #include "itkImage.h"
 #include "itkHessianSmoothed3DToVesselnessMeasureImageFilter.h" 
 #include "itkHessianRecursiveGaussianImageFilter.h"
+#include "itkSymmetricSecondRankTensor.h"
 
 namespace itk
 {
@@ -41,7 +46,9 @@ namespace itk
  * image of any pixel type and generates a Hessian image pixels at different
  * scale levels. The vesselness measure is computed from the Hessian image 
  * at each scale level and the best response is selected.  The vesselness 
- * measure is computed using HessianSmoothed3DToVesselnessMeasureImageFilter.
+ * measure is computed using HessianSmoothed3DToVesselnessMeasureImageFilter::
+ * ComputeVesselnessMeasure(), from the eigenvalues of the Hessian given by
+ * the closed-form solver in SymmetricEigen3x3.h.
  *
  * Minimum and maximum sigma value can be set using SetMinSigma and
  * SetMaxSigma methods respectively. The number of scale levels is set
@@ -86,7 +93,11 @@ public:
   typedef typename TOutputImage::PixelType               OutputPixelType;
 
   /** Update image buffer that holds the best vesselness response */ 
-  typedef Image< double, 3>                              UpdateBufferType;
+  typedef Image< float, 3>                               UpdateBufferType;
+
+  /** Hessian image, computed in single precision */
+  typedef SymmetricSecondRankTensor< float, 3 >          HessianPixelType;
+  typedef Image< HessianPixelType, 3 >                   HessianImageType;
 
   /** Image dimension = 3. */
   itkStaticConstMacro(ImageDimension, unsigned int,
@@ -111,12 +122,23 @@ public:
   itkSetMacro(IsSigmaStepLog, bool);
   itkGetMacro(IsSigmaStepLog, bool);
 
+  /** Set/Get macros for the vesselness function parameters */
+  itkSetMacro(Alpha, double);
+  itkGetMacro(Alpha, double);
+  itkSetMacro(Beta, double);
+  itkGetMacro(Beta, double);
+  itkSetMacro(Gamma, double);
+  itkGetMacro(Gamma, double);
+  itkSetMacro(C, double);
+  itkGetMacro(C, double);
+
 protected:
   MultiScaleHessianSmoothed3DToVesselnessMeasureImageFilter();
   ~MultiScaleHessianSmoothed3DToVesselnessMeasureImageFilter() {};
   void PrintSelf(std::ostream& os, Indent indent) const;
   
-  typedef HessianRecursiveGaussianImageFilter< InputImageType >
+  typedef HessianRecursiveGaussianImageFilter< InputImageType,
+                                               HessianImageType >
                                                         HessianFilterType;
 
   typedef HessianSmoothed3DToVesselnessMeasureImageFilter< double >
@@ -143,7 +165,11 @@ private:
 
   bool                                              m_IsSigmaStepLog;
 
-  typename VesselnessFilterType::Pointer            m_VesselnessFilter;
+  double                                            m_Alpha;
+  double                                            m_Beta;
+  double                                            m_Gamma;
+  double                                            m_C;
+
   typename HessianFilterType::Pointer               m_HessianFilter;
 
 
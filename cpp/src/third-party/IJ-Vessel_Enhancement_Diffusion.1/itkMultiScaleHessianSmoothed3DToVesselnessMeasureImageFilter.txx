@@ -16,9 +16,12 @@
 =========================================================================*/
 /*=========================================================================
    Edits by Ramon Casero <rcasero@gmail.com> for project Gerardus
-   Version: 0.2.0
+   Version: 0.3.0
     * Add linear scales besides logarithmic scales
     * Some minor
+    * Single precision Hessian, closed-form eigenvalues, and
+      vesselness merged into the maximum response without per scale
+      images
 =========================================================================*/
 #ifndef __itkMultiScaleHessianSmoothed3DToVesselnessMeasureImageFilter_txx
 #define __itkMultiScaleHessianSmoothed3DToVesselnessMeasureImageFilter_txx
@@ -27,6 +30,9 @@
 #include "itkImageRegionIterator.h"
 #include "itkImageRegionConstIterator.h"
 #include "vnl/vnl_math.h"
+#include "SymmetricEigen3x3.h"
+
+#include <algorithm>
 
 #define EPSILON  1e-03
 
@@ -47,11 +53,14 @@ MultiScaleHessianSmoothed3DToVesselnessMeasureImageFilter
   m_NumberOfSigmaSteps = 10;
   m_IsSigmaStepLog = true;
 
-  m_HessianFilter                = HessianFilterType::New();
-  m_VesselnessFilter             = VesselnessFilterType::New();
+  // Same defaults as HessianSmoothed3DToVesselnessMeasureImageFilter
+  m_Alpha = 0.5;
+  m_Beta  = 0.5;
+  m_Gamma = 5.0;
+
+  m_C = 10e-6;
 
-  //Turn off vesselness measure scaling
-  m_VesselnessFilter->SetScaleVesselnessMeasure( false );
+  m_HessianFilter                = HessianFilterType::New();
 
   //Instantiate Update buffer
   m_UpdateBuffer                 = UpdateBufferType::New();
@@ -88,8 +97,10 @@ MultiScaleHessianSmoothed3DToVesselnessMeasureImageFilter
                  this->GetOutput()->GetRequestedRegion() );
   this->GetOutput()->Allocate();
 
-  // Allocate the buffer
+  // Allocate the buffer. Vesselness is >= 0, so the best response
+  // starts at 0
   AllocateUpdateBuffer();
+  m_UpdateBuffer->FillBuffer( 0.0f );
 
   typename InputImageType::ConstPointer input = this->GetInput();
  
@@ -108,9 +119,7 @@ MultiScaleHessianSmoothed3DToVesselnessMeasureImageFilter
 
     m_HessianFilter->SetSigma( sigma );
 
-    m_VesselnessFilter->SetInput ( m_HessianFilter->GetOutput() ); 
-
-    m_VesselnessFilter->Update();
+    m_HessianFilter->Update();
  
     this->UpdateMaximumResponse();
 
@@ -142,30 +151,70 @@ MultiScaleHessianSmoothed3DToVesselnessMeasureImageFilter
 <TInputImage,TOutputImage>
 ::UpdateMaximumResponse()
 {
+  typename HessianImageType::ConstPointer hessian = 
+                                        m_HessianFilter->GetOutput();
 
-  ImageRegionIterator<UpdateBufferType> 
-            oit(m_UpdateBuffer,m_UpdateBuffer->GetLargestPossibleRegion());
+  if ( hessian->GetBufferedRegion() != m_UpdateBuffer->GetBufferedRegion() )
+    {
+    itkExceptionMacro(<< "Hessian and update buffer regions are different");
+    }
 
-  oit.GoToBegin();
+  const HessianPixelType *h = hessian->GetBufferPointer();
+  float *best = m_UpdateBuffer->GetBufferPointer();
+  const long n = static_cast< long >(
+                 m_UpdateBuffer->GetBufferedRegion().GetNumberOfPixels() );
 
-  typedef typename VesselnessFilterType::OutputImageType   
-                                         VesselnessOutputImageType;
+  // The Hessian is copied to a structure of arrays block by block, so
+  // that the eigenvalues can be computed with vector instructions
+  const long blockSize = 256;
+  const long numberOfBlocks = ( n + blockSize - 1 ) / blockSize;
 
-  ImageRegionIterator<VesselnessOutputImageType> 
-            it(m_VesselnessFilter->GetOutput(),
-            this->m_VesselnessFilter->GetOutput()->GetLargestPossibleRegion());
+#ifdef _OPENMP
+#pragma omp parallel
+#endif
+  {
+  float xx[blockSize], xy[blockSize], xz[blockSize];
+  float yy[blockSize], yz[blockSize], zz[blockSize];
+  float e0[blockSize], e1[blockSize], e2[blockSize];
+  double eigenValue[3];
+
+#ifdef _OPENMP
+#pragma omp for schedule(static)
+#endif
+  for ( long block = 0; block < numberOfBlocks; block++ )
+    {
+    const long first = block * blockSize;
+    const long len = std::min( blockSize, n - first );
 
-  it.GoToBegin();
+    for ( long j = 0; j < len; j++ )
+      {
+      const HessianPixelType &pixel = h[first + j];
+      xx[j] = pixel[0];
+      xy[j] = pixel[1];
+      xz[j] = pixel[2];
+      yy[j] = pixel[3];
+      yz[j] = pixel[4];
+      zz[j] = pixel[5];
+      }
 
-  while(!oit.IsAtEnd())
-    {
-    if( oit.Value() < it.Value() )
+    SymmetricEigenValues3x3< float >( len, xx, xy, xz, yy, yz, zz, 
+                                      e0, e1, e2 );
+
+    for ( long j = 0; j < len; j++ )
       {
-      oit.Value() = it.Value();
+      eigenValue[0] = e0[j];
+      eigenValue[1] = e1[j];
+      eigenValue[2] = e2[j];
+      const float vesselness = static_cast< float >(
+        VesselnessFilterType::ComputeVesselnessMeasure( eigenValue,
+                                 m_Alpha, m_Beta, m_Gamma, m_C, false ) );
+      if ( best[first + j] < vesselness )
+        {
+        best[first + j] = vesselness;
+        }
       }
-    ++oit;
-    ++it;
     }
+  }
 }
 
 template <typename TInputImage, typename TOutputImage >
@@ -205,6 +254,10 @@ MultiScaleHessianSmoothed3DToVesselnessMeasureImageFilter
   
   os << indent << "SigmaMin:  " << m_SigmaMin << std::endl;
   os << indent << "SigmaMax:  " << m_SigmaMax  << std::endl;
+  os << indent << "Alpha: " << m_Alpha << std::endl;
+  os << indent << "Beta:  " << m_Beta  << std::endl;
+  os << indent << "Gamma: " << m_Gamma << std::endl;
+  os << indent << "C: " << m_C << std::endl;
 }
 
 
@@ -22,6 +22,9 @@
  *
  *     >> trisurf(tri{1}, x)
  *
+ *   If TRI is not requested, e.g. ALPHALIM = cgal_alpha_shape3(X), no
+ *   surface triangulation is extracted, which is faster.
+ *
  *
  * [~, TRI] = cgal_alpha_shape3(X, ALPHA)
  *
@@ -29,6 +32,17 @@
  *   probe radius. TRI is a cell array of the same length as ALPHA. Cell
  *   TRI{i} contains the alpha shape triangulation for ALPHA{i}.
  *
+ * [~, ~, TIMES] = cgal_alpha_shape3(...)
+ *
+ *   TIMES is a 2-vector with the wall-clock time in seconds spent building the
+ *   Delaunay triangulation, TIMES(1), and computing the alpha shape and
+ *   extracting the surface triangulations, TIMES(2).
+ *
+ * The points are sorted spatially (BRIO with a Hilbert curve sort) before
+ * they are inserted in the Delaunay triangulation. Thus, the order of the
+ * points in X (e.g. raster order in points extracted from a segmentation)
+ * does not slow down the triangulation.
+ *
  * This function uses CGAL's implementation of non-fixed alpha shapes [1].
  * With non-fixed alpha shapes, the result for all alpha values is computed
  * internally, and then only those the solutions requested by the user are
@@ -49,7 +63,7 @@
  /*
   * Author: Ramon Casero <rcasero@gmail.com>
   * Copyright © 2013 University of Oxford
-  * Version: 0.3.1
+  * Version: 0.4.1
   *
   * University of Oxford means the Chancellor, Masters and Scholars of
   * the University of Oxford, having an administrative office at
@@ -88,12 +102,14 @@
 /* Gerardus headers */
 #include "MatlabImportFilter.h"
 #include "MatlabExportFilter.h"
+#include "DelaunayBuilder.h"
 
 /* CGAL headers */
 #include <CGAL/Exact_predicates_inexact_constructions_kernel.h>
 #include <CGAL/Delaunay_triangulation_3.h>
 #include <CGAL/Triangulation_vertex_base_with_info_3.h>
 #include <CGAL/Alpha_shape_3.h>
+#include <CGAL/Real_timer.h>
 
 typedef CGAL::Exact_predicates_inexact_constructions_kernel K;
 // vertex
@@ -133,7 +149,7 @@ void mexFunction(int nlhs, mxArray *plhs[],
   MatlabInputPointer inNCOMP = matlabImport->RegisterInput(IN_NCOMP, "NCOMP");
 
   // interface to deal with outputs to Matlab
-  enum OutputIndexType {OUT_ALPHAINT, OUT_TRI, OutputIndexType_MAX};
+  enum OutputIndexType {OUT_ALPHAINT, OUT_TRI, OUT_TIMES, OutputIndexType_MAX};
   MatlabExportFilter::Pointer matlabExport = MatlabExportFilter::New();
   matlabExport->ConnectToMatlabFunctionOutput(nlhs, plhs);
 
@@ -144,55 +160,19 @@ void mexFunction(int nlhs, mxArray *plhs[],
   typedef MatlabExportFilter::MatlabOutputPointer MatlabOutputPointer;
   MatlabOutputPointer outALPHAINT = matlabExport->RegisterOutput(OUT_ALPHAINT, "ALPHAINT");
   MatlabOutputPointer outTRI = matlabExport->RegisterOutput(OUT_TRI, "TRI");
+  MatlabOutputPointer outTIMES = matlabExport->RegisterOutput(OUT_TIMES, "TIMES");
 
   // if the set of points is empty, the outputs are empty too
   if (mxIsEmpty(prhs[IN_X])) {
     matlabExport->CopyEmptyArrayToMatlab(outALPHAINT);
     matlabExport->CopyEmptyArrayToMatlab(outTRI);
+    matlabExport->CopyEmptyArrayToMatlab(outTIMES);
     return;
   }
 
-  // default coordinates are NaN values, so that the user can spot
-  // whether there was any problem reading them
-  Point xDef(mxGetNaN(), mxGetNaN(), mxGetNaN());
-
-  // get size of input matrix with the points
-  mwSize nrowsX = mxGetM(prhs[IN_X]);
-  mwSize ncolsX = mxGetN(prhs[IN_X]);
-  if (ncolsX != 3) {
-    mexErrMsgTxt("X must have 3 columns");
-  }
-
   // read points from function
-  std::vector<PointWithIndex> x(nrowsX);
-  for (mwIndex i = 0; i < nrowsX; ++i) {
-
-    // exit if user pressed Ctrl+C
-    ctrlcCheckPoint(__FILE__, __LINE__);
-
-    // read i-th row of input matrix as a point
-    x[i] = std::make_pair(
-			  matlabImport->ReadRowVectorFromMatlab<void, Point>(inX, i, xDef),
-			  i+1 // because this will be a row index in Matlab, 1, ..., Nrows
-			  );
-
-    // don't accept NaNs or Infs, otherwise they will give a segfault
-    if(mxIsNaN(x[i].first[0])
-       || mxIsNaN(x[i].first[1])
-       || mxIsNaN(x[i].first[2])
-       || mxIsInf(x[i].first[0])
-       || mxIsInf(x[i].first[1])
-       || mxIsInf(x[i].first[2])
-       ) {
-      mexErrMsgTxt("X contains NaN or Inf values" );
-    }
-    
-  }
-
-  // // DEBUG:
-  // for (std::vector<PointWithIndex>::iterator it = x.begin(); it != x.end(); ++it) {
-  //   std::cout << "point " << it->second << " = " << it->first << std::endl;
-  // }
+  std::vector<PointWithIndex> x;
+  ReadPointsWithIndexFromMatlab(matlabImport, inX, x);
 
   // read number of components from input
   mwSize numComponents = matlabImport->ReadScalarFromMatlab<mwSize>(inNCOMP, 1);
@@ -200,10 +180,16 @@ void mexFunction(int nlhs, mxArray *plhs[],
   // // DEBUG
   // std::cout << "Computing Delaunay triangulation" << std::endl;
 
-  // Delaunay triangulation
+  // Delaunay triangulation, with the points spatially sorted before
+  // insertion
   // http://www.cgal.org/Manual/latest/doc_html/cgal_manual/Triangulation_3/Chapter_main.html#Subsection_39.5.3
-  Delaunay delaunay(x.begin(), x.end());
-  CGAL_assertion(delaunay.number_of_vertices() == nrowsX);
+  CGAL::Real_timer timer;
+  timer.start();
+  Delaunay delaunay;
+  InsertPointsWithIndexInDelaunay(delaunay, x);
+  CGAL_assertion(delaunay.number_of_vertices() == x.size());
+  timer.stop();
+  double timeDelaunay = timer.time();
 
   // // DEBUG
   // std::cout << "Delaunay triangulation computed" << std::endl;
@@ -213,6 +199,8 @@ void mexFunction(int nlhs, mxArray *plhs[],
   //           << std::endl;
 
   // compute alpha shape
+  timer.reset();
+  timer.start();
   Alpha_shape_3 as(delaunay);
 
   // // DEBUG
@@ -232,17 +220,22 @@ void mexFunction(int nlhs, mxArray *plhs[],
   alphaIt = as.alpha_end();
   alphaintOut[2] = *(--alphaIt); // maximum alpha
 
-  // read vector of alpha values provided by the user
+  // read vector of alpha values provided by the user. If TRI is not
+  // requested, no surface triangulation is extracted, as that means
+  // classifying all the facets of the triangulation for each alpha
   std::vector<double> alphaDef(1, *alphaOptIt);
-  std::vector<double> alpha = matlabImport
-    ->ReadArrayAsVectorFromMatlab<double, std::vector<double> >(inALPHA, alphaDef);
-
-  // create a cell per surface triangulation that we are going to
-  // extract
-  const mwSize triDims[2] = {1, alpha.size()};
-  plhs[OUT_TRI] = mxCreateCellArray(2, triDims);
-  if (plhs[OUT_TRI] == NULL) {
-    mexErrMsgTxt("Cannot allocate memory for output TRI" );
+  std::vector<double> alpha;
+  if (outTRI->isRequested) {
+    alpha = matlabImport
+      ->ReadArrayAsVectorFromMatlab<double, std::vector<double> >(inALPHA, alphaDef);
+
+    // create a cell per surface triangulation that we are going to
+    // extract
+    const mwSize triDims[2] = {1, alpha.size()};
+    plhs[OUT_TRI] = mxCreateCellArray(2, triDims);
+    if (plhs[OUT_TRI] == NULL) {
+      mexErrMsgTxt("Cannot allocate memory for output TRI" );
+    }
   }
 
   // for each alpha value provided by the user, extract the
@@ -307,6 +300,15 @@ void mexFunction(int nlhs, mxArray *plhs[],
 
   } // end loop for each alpha
 
+  // time spent building the Delaunay triangulation, and computing the
+  // alpha shape and extracting the facets
+  timer.stop();
+  if (outTIMES->isRequested) {
+    double *timesOut = matlabExport->AllocateRowVectorInMatlab<double>(outTIMES, 2);
+    timesOut[0] = timeDelaunay;
+    timesOut[1] = timer.time();
+  }
+
 }
 
 #endif /* CGALALPHASHAPE3 */
@@ -17,6 +17,16 @@
  *
  *     >> trisurf(tri{i}, x)
  *
+ * [TRI, TIMES] = cgal_fixed_alpha_shape3(X, ALPHA)
+ *
+ *   TIMES is a 2-vector with the wall-clock time in seconds spent building the
+ *   Delaunay triangulation, TIMES(1), and computing the alpha shapes and
+ *   extracting the surface triangulations, TIMES(2).
+ *
+ * The points are sorted spatially (BRIO with a Hilbert curve sort) before
+ * they are inserted in the Delaunay triangulation. Thus, the order of the
+ * points in X (e.g. raster order in points extracted from a segmentation)
+ * does not slow down the triangulation.
  *
  * This function uses CGAL's implementation of fixed alpha shapes [1]. Fixed
  * alpha shapes are more efficient when only the shape for one or a few
@@ -36,7 +46,7 @@
  /*
   * Author: Ramon Casero <rcasero@gmail.com>
   * Copyright © 2013 University of Oxford
-  * Version: 0.3.1
+  * Version: 0.4.1
   *
   * University of Oxford means the Chancellor, Masters and Scholars of
   * the University of Oxford, having an administrative office at
@@ -76,6 +86,7 @@
 /* Gerardus headers */
 #include "MatlabImportFilter.h"
 #include "MatlabExportFilter.h"
+#include "DelaunayBuilder.h"
 
 /* CGAL headers */
 #include <CGAL/Exact_predicates_inexact_constructions_kernel.h>
@@ -84,6 +95,7 @@
 #include <CGAL/Fixed_alpha_shape_3.h>
 #include <CGAL/Fixed_alpha_shape_vertex_base_3.h>
 #include <CGAL/Fixed_alpha_shape_cell_base_3.h>
+#include <CGAL/Real_timer.h>
 
 typedef CGAL::Exact_predicates_inexact_constructions_kernel K;
 // vertex
@@ -129,7 +141,7 @@ void mexFunction(int nlhs, mxArray *plhs[],
   MatlabInputPointer inALPHA = matlabImport->RegisterInput(IN_ALPHA, "ALPHA");
 
   // interface to deal with outputs to Matlab
-  enum OutputIndexType {OUT_TRI, OutputIndexType_MAX};
+  enum OutputIndexType {OUT_TRI, OUT_TIMES, OutputIndexType_MAX};
   MatlabExportFilter::Pointer matlabExport = MatlabExportFilter::New();
   matlabExport->ConnectToMatlabFunctionOutput(nlhs, plhs);
 
@@ -139,64 +151,34 @@ void mexFunction(int nlhs, mxArray *plhs[],
   // register the outputs for this function at the export filter
   typedef MatlabExportFilter::MatlabOutputPointer MatlabOutputPointer;
   MatlabOutputPointer outTRI = matlabExport->RegisterOutput(OUT_TRI, "TRI");
+  MatlabOutputPointer outTIMES = matlabExport->RegisterOutput(OUT_TIMES, "TIMES");
 
   // if the set of points is empty, the outputs are empty too
   if (mxIsEmpty(prhs[IN_X])) {
     matlabExport->CopyEmptyArrayToMatlab(outTRI);
+    matlabExport->CopyEmptyArrayToMatlab(outTIMES);
     return;
   }
 
-  // default coordinates are NaN values, so that the user can spot
-  // whether there was any problem reading them
-  Point xDef(mxGetNaN(), mxGetNaN(), mxGetNaN());
-
-  // get size of input matrix with the points
-  mwSize nrowsX = mxGetM(prhs[IN_X]);
-  mwSize ncolsX = mxGetN(prhs[IN_X]);
-  if (ncolsX != 3) {
-    mexErrMsgTxt("X must have 3 columns");
-  }
-
   // read points from function
-  std::vector<PointWithIndex> x(nrowsX);
-  for (mwIndex i = 0; i < nrowsX; ++i) {
-
-    // exit if user pressed Ctrl+C
-    ctrlcCheckPoint(__FILE__, __LINE__);
-
-    // read i-th row of input matrix as a point
-    x[i] = std::make_pair(
-			  matlabImport->ReadRowVectorFromMatlab<void, Point>(inX, i, xDef),
-			  i+1 // because this will be a row index in Matlab, 1, ..., Nrows
-			  );
-
-    // don't accept NaNs or Infs, otherwise they will give a segfault
-    if(mxIsNaN(x[i].first[0])
-       || mxIsNaN(x[i].first[1])
-       || mxIsNaN(x[i].first[2])
-       || mxIsInf(x[i].first[0])
-       || mxIsInf(x[i].first[1])
-       || mxIsInf(x[i].first[2])
-       ) {
-      mexErrMsgTxt("X contains NaN or Inf values" );
-    }
-    
-  }
-
-  // // DEBUG:
-  // for (std::vector<PointWithIndex>::iterator it = x.begin(); it != x.end(); ++it) {
-  //   std::cout << "point " << it->second << " = " << it->first << std::endl;
-  // }
+  std::vector<PointWithIndex> x;
+  ReadPointsWithIndexFromMatlab(matlabImport, inX, x);
 
   // // DEBUG
   // std::cout << "time = " << (double(clock() - time0) / CLOCKS_PER_SEC) << " sec" << std::endl;
   // time0 = clock();
   // std::cout << "Computing Delaunay triangulation" << std::endl;
 
-  // Delaunay triangulation
+  // Delaunay triangulation, with the points spatially sorted before
+  // insertion
   // http://www.cgal.org/Manual/latest/doc_html/cgal_manual/Triangulation_3/Chapter_main.html#Subsection_39.5.3
-  Delaunay delaunay(x.begin(), x.end());
-  CGAL_assertion(delaunay.number_of_vertices() == nrowsX);
+  CGAL::Real_timer timer;
+  timer.start();
+  Delaunay delaunay;
+  InsertPointsWithIndexInDelaunay(delaunay, x);
+  CGAL_assertion(delaunay.number_of_vertices() == x.size());
+  timer.stop();
+  double timeDelaunay = timer.time();
 
   // // DEBUG
   // std::cout << "Delaunay triangulation computed" << std::endl;
@@ -217,15 +199,16 @@ void mexFunction(int nlhs, mxArray *plhs[],
   }
 
   // for each alpha value provided by the user, compute the
-  // corresponding alpha shape and extract its surface triangulation
+  // corresponding alpha shape and extract its surface
+  // triangulation. The alpha shapes are computed one at a time:
+  // CGAL's triangulation and alpha shape classes are not thread-safe,
+  // and each alpha shape needs its own copy of the triangulation
+  timer.reset();
+  timer.start();
   for (mwIndex i = 0; i < alpha.size(); ++i) {
 
     // exit if user pressed Ctrl+C
     ctrlcCheckPoint(__FILE__, __LINE__);
-    
-    // // DEBUG
-    // std::cout << "Computing alpha shape in REGULARIZED mode by default"
-    //           << std::endl;
 
     // the alpha shape destroys the Delaunay triangulation, so we need
     // to make a copy each time
@@ -233,70 +216,37 @@ void mexFunction(int nlhs, mxArray *plhs[],
 
     // compute alpha shape
     Alpha_shape_3 as(delaunayCopy, alpha[i]);
-    
-    // // DEBUG
-    // std::cout << "Alpha shape computed in REGULARIZED mode by default"
-    //           << std::endl;
-    // std::cout << "time = " << (double(clock() - time0) / CLOCKS_PER_SEC) << " sec" << std::endl;
-    // time0 = clock();
-    
-    // // DEBUG:
-    // std::cout << "Extracting surface triangulation for alpha = " << alpha[i]
-    // 	      << std::endl;
 
     // get alpha-shape surface
     std::list<Facet>       facets;
     as.get_alpha_shape_facets(std::back_inserter(facets),
 			      Alpha_shape_3::REGULAR);
 
-    // // DEBUG:
-    // std::cout << "Number of facets = " << facets.size() << std::endl;
+    // allocate memory in the current cell for the surface
+    mwSize nfacets = facets.size();
+    double *triOut = matlabExport->AllocateMatrixInCellInMatlab<double>(outTRI, i, nfacets, 3);
 
-    // allocate memory in the current cell for the surface 
-    double *triOut = matlabExport->AllocateMatrixInCellInMatlab<double>(outTRI, i, facets.size(), 3);
-
-    // write facets to Matlab output
-    mwSize row = 0; // row index of Matlab output
+    // write facets to Matlab output, with Matlab indices 1, ..., Nrows
+    mwSize row = 0;
     for (std::list<Facet>::iterator it = facets.begin(); it != facets.end(); ++it) {
-
-      // exit if user pressed Ctrl+C
-      ctrlcCheckPoint(__FILE__, __LINE__);
-
-      // vertex 1 of the triangle
-      triOut[row] 
-	= it->first->vertex(Delaunay::vertex_triple_index(it->second,0))->info();
-      
-      // vertex 2 of the triangle
-      triOut[row+facets.size()] 
-	= it->first->vertex(Delaunay::vertex_triple_index(it->second,1))->info();
-      
-      // vertex 3 of the triangle
-      triOut[row+2*facets.size()] 
-	= it->first->vertex(Delaunay::vertex_triple_index(it->second,2))->info();
-      
-      // // DEBUG:
-      // std::cout << "facet = "
-      // 		<< it->first->vertex(Delaunay::vertex_triple_index(it->second,0))->info()
-      // 		<< ", "
-      // 		<< it->first->vertex(Delaunay::vertex_triple_index(it->second,1))->info()
-      // 		<< ", "
-      // 		<< it->first->vertex(Delaunay::vertex_triple_index(it->second,2))->info()
-      // 		<< std::endl; 
-      
-      // increase row counter
+      for (int j = 0; j < 3; ++j) {
+	triOut[row + j * nfacets]
+	  = it->first->vertex(Delaunay::vertex_triple_index(it->second, j))->info();
+      }
       ++row;
-
-    } // end loop for each facet
-    
-    // // DEBUG
-    // std::cout << "Surface triangulation extracted"
-    //           << std::endl;
-    // std::cout << "time = " << (double(clock() - time0) / CLOCKS_PER_SEC) << " sec" << std::endl;
-    // time0 = clock();
-    
+    }
 
   } // end loop for each alpha
-  
+
+  // time spent building the Delaunay triangulation, and computing the
+  // alpha shapes and extracting the facets
+  timer.stop();
+  if (outTIMES->isRequested) {
+    double *timesOut = matlabExport->AllocateRowVectorInMatlab<double>(outTIMES, 2);
+    timesOut[0] = timeDelaunay;
+    timesOut[1] = timer.time();
+  }
+
 }
 
 #endif /* CGALFIXEDALPHASHAPE3 */
@@ -78,6 +78,26 @@
  *     with the tag Manifold_tag the function template make_surface_mesh
  *     ensures that the output mesh is a manifold surface without boundary".
  *
+ * [TRI, X] = cgal_meshseg(..., MANIFOLD, LABELS)
+ *
+ *   LABELS is a vector of label values. With this syntax, IM is
+ *   considered a multi-label segmentation, and one surface is meshed for
+ *   each label. TRI and X are then cell arrays with one mesh per label,
+ *   i.e. TRI{I}, X{I} is the mesh of the voxels IM==LABELS(I). Labels
+ *   not present in the image produce empty meshes.
+ *
+ *   Each label is meshed as a binary mask (label=1, rest=0), cropped to
+ *   the label's bounding box plus a 2-voxel margin, so ISOVAL should be
+ *   between 0 and 1 (by default, ISOVAL=0.5). The bounding boxes and
+ *   centroids of all labels are computed in a single pass over the
+ *   image, in parallel with OpenMP, and each label is meshed in its
+ *   cropped box. This is faster than calling cgal_meshseg once per
+ *   label. The labels are meshed one after the other, because the CGAL
+ *   surface mesher is not thread-safe.
+ *
+ *   In this mode, C is either empty (the centroid of each label is used)
+ *   or a 3-column matrix with one bounding sphere centre per label.
+ *
  * Important!
  *
  * Note that this function can produce meshes with (1) stray vertices that
@@ -95,7 +115,7 @@
 /*
  * Author: Ramon Casero <rcasero@gmail.com>
  * Copyright © 2013 University of Oxford
- * Version: 0.1.4
+ * Version: 0.3.2
  *
  * University of Oxford means the Chancellor, Masters and Scholars of
  * the University of Oxford, having an administrative office at
@@ -141,6 +161,9 @@
 #include <iostream>
 #include <algorithm>
 #include <limits>
+#include <map>
+#include <utility>
+#include <vector>
 #include <math.h> // DEBUG
 
 /* Gerardus headers */
@@ -169,6 +192,311 @@ typedef Tr::Geom_traits GT;
 typedef CGAL::Gray_level_image_3<GT::FT, GT::Point_3> Gray_level_image;
 typedef CGAL::Implicit_surface_3<GT, Gray_level_image> Surface_3;
 
+/*
+ * LabelBox: number of voxels, sum of voxel indices (to compute the
+ * centroid) and bounding box of one label in a multi-label
+ * segmentation. Indices follow the CGAL convention x <-> rows, y <->
+ * cols
+ */
+struct LabelBox {
+  mwSize nnz;
+  double xc, yc, zc;
+  mwSignedIndex xmin, ymin, zmin;
+  mwSignedIndex xmax, ymax, zmax;
+};
+
+// comparison of (label value, position in LABELS) pairs with a label
+// value, for the binary search of each voxel value in the label list
+struct LabelLess {
+  bool operator()(const std::pair<double, mwIndex> &a, double b) const {
+    return a.first < b;
+  }
+};
+
+/*
+ * MeshLabels(): mesh the surface of each label in a multi-label
+ * segmentation.
+ *
+ * im:        pointer to the Matlab image buffer
+ * imHeader:  image size, spacing and origin
+ * labels:    label values to mesh
+ * isXRequested: if false, the vertex coordinates are not saved to x
+ * x, tri:    output. x[k] has the vertex coordinates of the k-th
+ *            label mesh (Matlab convention, (x,y,z) of each vertex in
+ *            consecutive elements), and tri[k] its triangles (Matlab
+ *            indices 1, 2, 3..., 3 vertices of each triangle in
+ *            consecutive elements)
+ *
+ * The Matlab API is not thread-safe, so this function calls it only
+ * outside the parallel regions (to read input C). CGAL errors in the
+ * mesher are reported returning true.
+ */
+template <class T>
+bool MeshLabels(const T *im, const MatlabImageHeader &imHeader,
+		const std::vector<double> &labels,
+		MatlabImportFilter::Pointer matlabImport,
+		MatlabImportFilter::MatlabInputPointer inC,
+		double isoval, double minalpha, double maxrad, double maxd,
+		bool asManifold, bool isXRequested,
+		std::vector<std::vector<double> > &x,
+		std::vector<std::vector<mwIndex> > &tri) {
+
+  // image dimensions (CGAL convention x <-> rows, y <-> cols)
+  const mwSignedIndex nx = imHeader.size[0];
+  const mwSignedIndex ny = imHeader.size[1];
+  const mwSignedIndex nz = imHeader.size[2];
+  const mwSignedIndex nlabels = labels.size();
+
+  // label values sorted, so that we can find each voxel value with a
+  // binary search. We keep the position of each label in the input
+  // list
+  std::vector<std::pair<double, mwIndex> > sortedLabels(nlabels);
+  for (mwSignedIndex k = 0; k < nlabels; ++k) {
+    if (mxIsNaN(labels[k])) {
+      mexErrMsgTxt("Input LABELS contains NaN values");
+    }
+    sortedLabels[k] = std::make_pair(labels[k], (mwIndex)k);
+  }
+  std::sort(sortedLabels.begin(), sortedLabels.end());
+  for (mwSignedIndex k = 1; k < nlabels; ++k) {
+    if (sortedLabels[k].first == sortedLabels[k-1].first) {
+      mexErrMsgTxt("Input LABELS contains repeated values");
+    }
+  }
+
+  // compute the number of voxels, centroid and bounding box of every
+  // label in a single pass over the image. Each thread accumulates
+  // the slices it visits, and the partial results are merged at the
+  // end
+  LabelBox emptyBox;
+  emptyBox.nnz = 0;
+  emptyBox.xc = emptyBox.yc = emptyBox.zc = 0.0;
+  emptyBox.xmin = emptyBox.ymin = emptyBox.zmin = std::numeric_limits<mwSignedIndex>::max();
+  emptyBox.xmax = emptyBox.ymax = emptyBox.zmax = std::numeric_limits<mwSignedIndex>::min();
+  std::vector<LabelBox> box(nlabels, emptyBox);
+
+#ifdef _OPENMP
+#pragma omp parallel
+#endif
+  {
+    std::vector<LabelBox> threadBox(nlabels, emptyBox);
+
+#ifdef _OPENMP
+#pragma omp for schedule(static)
+#endif
+    for (mwSignedIndex s = 0; s < nz; ++s) {
+      const T *p = im + s * nx * ny;
+      for (mwSignedIndex c = 0; c < ny; ++c) {
+	for (mwSignedIndex r = 0; r < nx; ++r, ++p) {
+
+	  // find voxel value in the list of labels
+	  double v = (double)*p;
+	  std::vector<std::pair<double, mwIndex> >::const_iterator it
+	    = std::lower_bound(sortedLabels.begin(), sortedLabels.end(), v, LabelLess());
+	  if (it == sortedLabels.end() || it->first != v) {
+	    continue;
+	  }
+
+	  // contribution to the label centroid and bounding box
+	  LabelBox &b = threadBox[it->second];
+	  b.nnz++;
+	  b.xc += r;
+	  b.yc += c;
+	  b.zc += s;
+	  b.xmin = std::min(b.xmin, r);
+	  b.ymin = std::min(b.ymin, c);
+	  b.zmin = std::min(b.zmin, s);
+	  b.xmax = std::max(b.xmax, r);
+	  b.ymax = std::max(b.ymax, c);
+	  b.zmax = std::max(b.zmax, s);
+	}
+      }
+    }
+
+#ifdef _OPENMP
+#pragma omp critical
+#endif
+    for (mwSignedIndex k = 0; k < nlabels; ++k) {
+      box[k].nnz += threadBox[k].nnz;
+      box[k].xc += threadBox[k].xc;
+      box[k].yc += threadBox[k].yc;
+      box[k].zc += threadBox[k].zc;
+      box[k].xmin = std::min(box[k].xmin, threadBox[k].xmin);
+      box[k].ymin = std::min(box[k].ymin, threadBox[k].ymin);
+      box[k].zmin = std::min(box[k].zmin, threadBox[k].zmin);
+      box[k].xmax = std::max(box[k].xmax, threadBox[k].xmax);
+      box[k].ymax = std::max(box[k].ymax, threadBox[k].ymax);
+      box[k].zmax = std::max(box[k].zmax, threadBox[k].zmax);
+    }
+  }
+
+  // each label is cropped to its bounding box plus a margin of
+  // background voxels, so that the isosurface is closed
+  const mwSignedIndex margin = 2;
+  const double vx = imHeader.spacing[0];
+  const double vy = imHeader.spacing[1];
+  const double vz = imHeader.spacing[2];
+
+  // if the user provides the centres of the bounding spheres, there
+  // must be one per label
+  if (inC->isProvided && (mwSignedIndex)mxGetM(inC->pm) != nlabels) {
+    mexErrMsgTxt("Input C must have one row per label");
+  }
+
+  // centre of the bounding sphere of each label, referred to the
+  // first voxel of the cropped image, in CGAL convention. This is
+  // computed outside the parallel region, because it reads input C
+  std::vector<GT::Point_3> centre(nlabels);
+  for (mwSignedIndex k = 0; k < nlabels; ++k) {
+
+    if (box[k].nnz == 0) {
+      continue;
+    }
+
+    // real world coordinates of the cropped image first voxel
+    double x0 = imHeader.origin[0] + (box[k].xmin - margin) * vx;
+    double y0 = imHeader.origin[1] + (box[k].ymin - margin) * vy;
+    double z0 = imHeader.origin[2] + (box[k].zmin - margin) * vz;
+
+    // by default, the centre is the label centroid
+    GT::Point_3 defCentroid(imHeader.origin[1] + box[k].yc / box[k].nnz * vy,
+			    imHeader.origin[0] + box[k].xc / box[k].nnz * vx,
+			    imHeader.origin[2] + box[k].zc / box[k].nnz * vz); // *swap to Matlab convention*
+    GT::Point_3 centroid = matlabImport->ReadRowVectorFromMatlab<void, GT::Point_3>
+      (inC, k, defCentroid); // *centroid read with Matlab x/col, y/row convention*
+
+    // *swap centroid to CGAL convention*
+    centre[k] = GT::Point_3(centroid.y() - x0, centroid.x() - y0, centroid.z() - z0);
+  }
+
+  // mesh the labels one after the other. Each label has its own
+  // cropped image, triangulation and complex. The labels are not
+  // meshed in parallel, because the CGAL 4.2 triangulation and
+  // surface mesher are not thread-safe (e.g. the mesher draws its
+  // initial points from the shared CGAL::default_random)
+  x.resize(nlabels);
+  tri.resize(nlabels);
+  bool isCgalError = false;
+  for (mwSignedIndex k = 0; k < nlabels; ++k) {
+
+    // exit if user pressed Ctrl+C
+    ctrlcCheckPoint(__FILE__, __LINE__);
+
+    if (box[k].nnz == 0) {
+      continue;
+    }
+
+    try {
+
+      // limits of the cropped image. The margin can extend beyond the
+      // image, in which case the voxels outside are background
+      const mwSignedIndex x0 = box[k].xmin - margin;
+      const mwSignedIndex y0 = box[k].ymin - margin;
+      const mwSignedIndex z0 = box[k].zmin - margin;
+      const mwSignedIndex cropNx = box[k].xmax - box[k].xmin + 1 + 2 * margin;
+      const mwSignedIndex cropNy = box[k].ymax - box[k].ymin + 1 + 2 * margin;
+      const mwSignedIndex cropNz = box[k].zmax - box[k].zmin + 1 + 2 * margin;
+
+      // binary mask of the label in the cropped box. The image offset
+      // is left as (0,0,0), because CGAL ignores it, and it is added
+      // to the vertex coordinates below
+      _image *crop = _createImage(cropNx, cropNy, cropNz, 1,
+			  vx, vy, vz, sizeof(float), WK_FLOAT, SGN_UNKNOWN);
+      if (crop == NULL || crop->data == NULL) {
+	throw std::bad_alloc();
+      }
+      float *pCrop = (float *)crop->data;
+      for (mwSignedIndex s = z0; s < z0 + cropNz; ++s) {
+	for (mwSignedIndex c = y0; c < y0 + cropNy; ++c) {
+	  for (mwSignedIndex r = x0; r < x0 + cropNx; ++r, ++pCrop) {
+	    if (r < 0 || r >= nx || c < 0 || c >= ny || s < 0 || s >= nz) {
+	      *pCrop = 0.0f;
+	    } else {
+	      *pCrop = ((double)im[r + c * nx + s * nx * ny] == labels[k]) ? 1.0f : 0.0f;
+	    }
+	  }
+	}
+      }
+
+      // wrap as a Gray image so that we can pass it to the
+      // mesher. The Gray image takes ownership of crop
+      Gray_level_image image(crop, isoval);
+
+      // the radius of the bounding sphere is the distance from the
+      // centre to the furthest corner of the cropped box, plus 5%
+      double xmax = (cropNx - 1) * vx;
+      double ymax = (cropNy - 1) * vy;
+      double zmax = (cropNz - 1) * vz;
+      double cx = centre[k].x();
+      double cy = centre[k].y();
+      double cz = centre[k].z();
+      GT::FT bounding_sphere_squared_radius = 1.05 * 
+	(std::max(cx * cx, (xmax - cx) * (xmax - cx))
+	 + std::max(cy * cy, (ymax - cy) * (ymax - cy))
+	 + std::max(cz * cz, (zmax - cz) * (zmax - cz)));
+      GT::Sphere_3 bounding_sphere(centre[k], bounding_sphere_squared_radius);
+
+      // definition of the surface, with 10^-5 as relative precision
+      Surface_3 surface(image, bounding_sphere, 1e-5);
+
+      // variables to store the mesh as a triangulation
+      Tr tr;            // 3D-Delaunay triangulation
+      C2t3 c2t3(tr);    // 2D-complex in 3D-Delaunay triangulation
+
+      // Mesh criteria
+      CGAL::Surface_mesh_default_criteria_3<Tr> criteria(minalpha, maxrad, maxd);
+
+      // Meshing
+      if (asManifold) {
+	CGAL::make_surface_mesh(c2t3, surface, criteria, CGAL::Manifold_tag());
+      } else {
+	CGAL::make_surface_mesh(c2t3, surface, criteria, CGAL::Non_manifold_tag());
+      }
+
+      // vertices coordinates, in Matlab convention and with the
+      // cropped image offset. Assign indices to the vertices by
+      // defining a map between their handles and the index
+      double ox = imHeader.origin[0] + x0 * vx;
+      double oy = imHeader.origin[1] + y0 * vy;
+      double oz = imHeader.origin[2] + z0 * vz;
+      std::map<Tr::Vertex_handle, mwIndex> V;
+      mwIndex inum = 0;
+      if (isXRequested) {
+	x[k].reserve(3 * tr.number_of_vertices());
+      }
+      for (Tr::Finite_vertices_iterator vit = tr.finite_vertices_begin();
+	   vit != tr.finite_vertices_end(); ++vit) {
+	if (isXRequested) {
+	  x[k].push_back(vit->point().y() + oy); // *swap to Matlab convention*
+	  x[k].push_back(vit->point().x() + ox);
+	  x[k].push_back(vit->point().z() + oz);
+	}
+	V[vit] = inum++;
+      }
+
+      // triangles given as (i,j,k), where each index corresponds to a
+      // vertex in x
+      tri[k].reserve(3 * c2t3.number_of_facets());
+      for (C2t3::Facet_iterator fit = c2t3.facets_begin(); fit != c2t3.facets_end(); ++fit) {
+	const Tr::Cell_handle cell = fit->first;
+	const int& index = fit->second;
+	if (cell->is_facet_on_surface(index)==true) {
+	  for (int j = 0; j < 3; ++j) {
+	    tri[k].push_back(1 + V[cell->vertex(tr.vertex_triple_index(index, j))]);
+	  }
+	}
+      }
+
+    } catch (std::exception &e) {
+      isCgalError = true;
+    }
+
+  } // end loop for each label
+
+  return isCgalError;
+
+}
+
 /*
  * mexFunction(): entry point for the mex function
  */
@@ -176,7 +504,8 @@ void mexFunction(int nlhs, mxArray *plhs[], int nrhs, const mxArray *prhs[]) {
 
   // interface to deal with input arguments from Matlab
   enum InputIndexType {IN_IM, IN_ISO, 
-		       IN_MINALPHA, IN_MAXRAD, IN_MAXD, IN_C, IN_MANIFOLD, InputIndexType_MAX};
+		       IN_MINALPHA, IN_MAXRAD, IN_MAXD, IN_C, IN_MANIFOLD, IN_LABELS,
+		       InputIndexType_MAX};
   MatlabImportFilter::Pointer matlabImport = MatlabImportFilter::New();
   matlabImport->ConnectToMatlabFunctionInput(nrhs, prhs);
 
@@ -191,12 +520,15 @@ void mexFunction(int nlhs, mxArray *plhs[], int nrhs, const mxArray *prhs[]) {
   MatlabInputPointer inMAXRAD   = matlabImport->RegisterInput(IN_MAXRAD, "MAXRAD");
   MatlabInputPointer inMAXD     = matlabImport->RegisterInput(IN_MAXD, "MAXD");
   MatlabInputPointer inC        = matlabImport->RegisterInput(IN_C, "C");
-  MatlabInputPointer inMANIFOLD = matlabImport->RegisterInput(IN_MANIFOLD, "C");
+  MatlabInputPointer inMANIFOLD = matlabImport->RegisterInput(IN_MANIFOLD, "MANIFOLD");
+  MatlabInputPointer inLABELS   = matlabImport->RegisterInput(IN_LABELS, "LABELS");
 
   // get input parameters
   double isoval   = matlabImport->ReadScalarFromMatlab<double>(inISO, 0.5);
   double minalpha = matlabImport->ReadScalarFromMatlab<double>(inMINALPHA, 30.0);
   bool asManifold = matlabImport->ReadScalarFromMatlab<bool>(inMANIFOLD, false);
+  std::vector<double> labels = matlabImport
+    ->ReadArrayAsVectorFromMatlab<double, std::vector<double> >(inLABELS, std::vector<double>());
 
   // interface to deal with outputs to Matlab
   enum OutputIndexType {OUT_TRI, OUT_X, OutputIndexType_MAX};
@@ -211,6 +543,126 @@ void mexFunction(int nlhs, mxArray *plhs[], int nrhs, const mxArray *prhs[]) {
   MatlabOutputPointer outTRI = matlabExport->RegisterOutput(OUT_TRI, "TRI");  
   MatlabOutputPointer outX   = matlabExport->RegisterOutput(OUT_X, "X");
 
+  // multi-label mode: one mesh per label
+  if (!labels.empty()) {
+
+    // get image metadata. Labels are read directly from the Matlab
+    // buffer, without duplicating the image
+    MatlabImageHeader imHeader(inIM->pm, inIM->name);
+    if (!mxIsEmpty(inIM->pm) && imHeader.size.size() != 3) {
+      mexErrMsgTxt(("Input " + inIM->name + " must be a 3D image.").c_str());
+    }
+
+    // outputs are cell arrays, with one mesh per label
+    const mwSize cellDims[2] = {1, labels.size()};
+    plhs[OUT_TRI] = mxCreateCellArray(2, cellDims);
+    if (plhs[OUT_TRI] == NULL) {
+      mexErrMsgTxt("Cannot allocate memory for output TRI");
+    }
+    if (outX->isRequested) {
+      plhs[OUT_X] = mxCreateCellArray(2, cellDims);
+      if (plhs[OUT_X] == NULL) {
+	mexErrMsgTxt("Cannot allocate memory for output X");
+      }
+    }
+
+    // vertices and triangles of each label mesh
+    std::vector<std::vector<double> > xLabel(labels.size());
+    std::vector<std::vector<mwIndex> > triLabel(labels.size());
+
+    if (!mxIsEmpty(inIM->pm)) {
+
+      // the default meshing criteria depend on the voxel size
+      double defRadAndD = std::min(std::min(imHeader.spacing[0], imHeader.spacing[1]),
+				   imHeader.spacing[2]);
+      double maxrad = matlabImport->ReadScalarFromMatlab<double>(inMAXRAD, defRadAndD * 0.5);
+      double maxd   = matlabImport->ReadScalarFromMatlab<double>(inMAXD, defRadAndD * 0.5);
+
+      bool isCgalError = false;
+      switch (imHeader.type) {
+      case mxLOGICAL_CLASS:
+	isCgalError = MeshLabels((mxLogical *)mxGetData(imHeader.data), imHeader, labels,
+				 matlabImport, inC, isoval, minalpha, maxrad, maxd,
+				 asManifold, outX->isRequested, xLabel, triLabel);
+	break;
+      case mxDOUBLE_CLASS:
+	isCgalError = MeshLabels((double *)mxGetData(imHeader.data), imHeader, labels,
+				 matlabImport, inC, isoval, minalpha, maxrad, maxd,
+				 asManifold, outX->isRequested, xLabel, triLabel);
+	break;
+      case mxSINGLE_CLASS:
+	isCgalError = MeshLabels((float *)mxGetData(imHeader.data), imHeader, labels,
+				 matlabImport, inC, isoval, minalpha, maxrad, maxd,
+				 asManifold, outX->isRequested, xLabel, triLabel);
+	break;
+      case mxINT8_CLASS:
+	isCgalError = MeshLabels((int8_T *)mxGetData(imHeader.data), imHeader, labels,
+				 matlabImport, inC, isoval, minalpha, maxrad, maxd,
+				 asManifold, outX->isRequested, xLabel, triLabel);
+	break;
+      case mxUINT8_CLASS:
+	isCgalError = MeshLabels((uint8_T *)mxGetData(imHeader.data), imHeader, labels,
+				 matlabImport, inC, isoval, minalpha, maxrad, maxd,
+				 asManifold, outX->isRequested, xLabel, triLabel);
+	break;
+      case mxINT16_CLASS:
+	isCgalError = MeshLabels((int16_T *)mxGetData(imHeader.data), imHeader, labels,
+				 matlabImport, inC, isoval, minalpha, maxrad, maxd,
+				 asManifold, outX->isRequested, xLabel, triLabel);
+	break;
+      case mxUINT16_CLASS:
+	isCgalError = MeshLabels((uint16_T *)mxGetData(imHeader.data), imHeader, labels,
+				 matlabImport, inC, isoval, minalpha, maxrad, maxd,
+				 asManifold, outX->isRequested, xLabel, triLabel);
+	break;
+      case mxINT32_CLASS:
+	isCgalError = MeshLabels((int32_T *)mxGetData(imHeader.data), imHeader, labels,
+				 matlabImport, inC, isoval, minalpha, maxrad, maxd,
+				 asManifold, outX->isRequested, xLabel, triLabel);
+	break;
+      // case mxUINT32_CLASS:
+      // case mxINT64_CLASS:
+      // case mxUINT64_CLASS:
+      default:
+	mexErrMsgTxt(("Input " + inIM->name + " has invalid type.").c_str());
+      }
+      if (isCgalError) {
+	mexErrMsgTxt("CGAL error meshing the labels");
+      }
+
+    }
+
+    // write meshes to Matlab outputs
+    for (mwIndex k = 0; k < labels.size(); ++k) {
+
+      // exit if user pressed Ctrl+C
+      ctrlcCheckPoint(__FILE__, __LINE__);
+
+      mwSize nfacets = triLabel[k].size() / 3;
+      double *triOut = matlabExport->AllocateMatrixInCellInMatlab<double>(outTRI, k, nfacets, 3);
+      for (mwIndex row = 0; row < nfacets; ++row) {
+	triOut[row] = triLabel[k][3*row];
+	triOut[row + nfacets] = triLabel[k][3*row+1];
+	triOut[row + 2*nfacets] = triLabel[k][3*row+2];
+      }
+      std::vector<mwIndex>().swap(triLabel[k]);
+
+      if (outX->isRequested) {
+	mwSize nvertices = xLabel[k].size() / 3;
+	double *xOut = matlabExport->AllocateMatrixInCellInMatlab<double>(outX, k, nvertices, 3);
+	for (mwIndex row = 0; row < nvertices; ++row) {
+	  xOut[row] = xLabel[k][3*row];
+	  xOut[row + nvertices] = xLabel[k][3*row+1];
+	  xOut[row + 2*nvertices] = xLabel[k][3*row+2];
+	}
+      }
+      std::vector<double>().swap(xLabel[k]);
+
+    }
+
+    return;
+  }
+
   // if the image is empty, the output is empty
   if (mxIsEmpty(inIM->pm)) {
     matlabExport->CopyEmptyArrayToMatlab(outTRI);
@@ -386,10 +838,14 @@ void mexFunction(int nlhs, mxArray *plhs[], int nrhs, const mxArray *prhs[]) {
     CGAL::make_surface_mesh(c2t3, surface, criteria, CGAL::Non_manifold_tag());
   }
 
-  // allocate memory for Matlab outputs
+  // allocate memory for Matlab outputs. TRI is always requested,
+  // because it's the first output (returned in ans if nargout == 0)
   double *tri = matlabExport->AllocateMatrixInMatlab<double>(outTRI, c2t3.number_of_facets(), 3);
   mwSize numOfVertices = std::distance(tr.finite_vertices_begin(), tr.finite_vertices_end());
-  double *x = matlabExport->AllocateMatrixInMatlab<double>(outX, numOfVertices, 3);
+  double *x = NULL;
+  if (outX->isRequested) {
+    x = matlabExport->AllocateMatrixInMatlab<double>(outX, numOfVertices, 3);
+  }
 
   // extract the vertices and triangles of the solution
   // snippet copied from include/CGAL/IO/Complex_2_in_triangulation_3_file_writer.h
@@ -423,9 +879,11 @@ void mexFunction(int nlhs, mxArray *plhs[], int nrhs, const mxArray *prhs[]) {
     //
     // Note also that the output of vit->point().[xyz]() ignores the
     // image offset, and is referred to an offset of (0,0,0)
-    x[inum] = vit->point().y() + im->ty;
-    x[inum + numOfVertices] = vit->point().x() + im->tx;
-    x[inum + 2*numOfVertices] = vit->point().z() + im->tz;
+    if (outX->isRequested) {
+      x[inum] = vit->point().y() + im->ty;
+      x[inum + numOfVertices] = vit->point().x() + im->tx;
+      x[inum + 2*numOfVertices] = vit->point().z() + im->tz;
+    }
 
     // save to internal list of vertices
     V[vit] = inum++;
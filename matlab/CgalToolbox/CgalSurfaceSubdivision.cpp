@@ -40,7 +40,7 @@
 /*
  * Author: Ramon Casero <rcasero@gmail.com>
  * Copyright © 2013 University of Oxford
- * Version: 0.1.1
+ * Version: 0.1.2
  *
  * University of Oxford means the Chancellor, Masters and Scholars of
  * the University of Oxford, having an administrative office at
@@ -84,15 +84,16 @@
 #include <CGAL/Simple_cartesian.h>
 #include <CGAL/Exact_predicates_inexact_constructions_kernel.h>
 #include <CGAL/Subdivision_method_3.h>
-#include <CGAL/Polyhedron_incremental_builder_3.h>
 #include <CGAL/Polyhedron_3.h>
 #include <CGAL/triangulate_polyhedron.h>
-#include "PolyhedronBuilder.h"
+#include <CGAL/Polyhedron_items_with_id_3.h>
+#include "HalfedgeMesh.h"
 
 typedef MatlabImportFilter::MatlabInputPointer               MatlabInputPointer;
 
 typedef CGAL::Exact_predicates_inexact_constructions_kernel  Kernel;
-typedef CGAL::Polyhedron_3<Kernel>                           Polyhedron;
+typedef CGAL::Polyhedron_3<Kernel,
+                           CGAL::Polyhedron_items_with_id_3> Polyhedron;
 typedef CGAL::Point_3<Kernel>                                Point;
 typedef Polyhedron::Facet                                    Facet;
 typedef Polyhedron::Facet_iterator                           Facet_iterator;
@@ -140,25 +141,21 @@ void mexFunction(int nlhs, mxArray *plhs[],
     return;
   }
 
-  // polyhedron to contain the input mesh
+  // read input mesh into index arrays, and create the polyhedron from
+  // them
   Polyhedron mesh;
-  PolyhedronBuilder<Polyhedron> builder(matlabImport, inTRI, inX);
-  mesh.delegate(builder);
+  {
+    HalfedgeMesh halfedgeMesh;
+    halfedgeMesh.ReadFromMatlab(matlabImport, inTRI, inX);
+    PolyhedronFromHalfedgeMesh<Polyhedron> builder(halfedgeMesh);
+    mesh.delegate(builder);
+  }
 
-  // get size of input matrix with the points
-  mwSize nrowsTri = mxGetM(inTRI->pm);
-  mwSize nrowsX = mxGetM(inX->pm);
   
   // // DEBUG:
   // std::cout << "Number of facets read = " << mesh.size_of_facets() << std::endl;
   // std::cout << "Number of vertices read = " << mesh.size_of_vertices() << std::endl;
 
-  if (nrowsTri != mesh.size_of_facets()) {
-    mexErrMsgTxt(("Input " + inTRI->name + ": Number of triangles read into mesh different from triangles provided at the input").c_str());
-  }
-  if (nrowsX != mesh.size_of_vertices()) {
-    mexErrMsgTxt(("Input " + inX->name + ": Number of vertices read into mesh different from vertices provided at the input").c_str());
-  }
 
   // read input parameters
   unsigned int iter = matlabImport->ReadScalarFromMatlab<unsigned int>(inITER, 1);
@@ -180,51 +177,10 @@ void mexFunction(int nlhs, mxArray *plhs[],
   // the subdivision mesh may have non-triangular facets. Split all facets to triangles
   CGAL::triangulate_polyhedron<Polyhedron>(mesh);
 
-  // allocate memory for Matlab outputs
-  double *tri = matlabExport->AllocateMatrixInMatlab<double>(outTRI, mesh.size_of_facets(), 3);
-  double *x = matlabExport->AllocateMatrixInMatlab<double>(outX, mesh.size_of_vertices(), 3);
-
-   // extract the vertices and triangles of the solution
-  // snippet adapted from CgalMeshSegmentation.cpp
-
-  // vertices coordinates. Assign indices to the vertices by defining
-  // a map between their handles and the index
-  std::map<Vertex_handle, int> V;
-  int inum = 0;
-  for(Vertex_iterator vit = mesh.vertices_begin(); vit != mesh.vertices_end(); ++vit) {
-
-    // save to Matlab output
-    x[inum] = vit->point().x();
-    x[inum + mesh.size_of_vertices()] = vit->point().y();
-    x[inum + 2*mesh.size_of_vertices()] = vit->point().z();
-
-    // save to internal list of vertices
-    V[vit] = inum++;
-
-  }  
-
-  // triangles given as (i,j,k), where each index corresponds to a vertex in x
-  mwIndex row = 0;
-  for (Facet_iterator fit = mesh.facets_begin(); fit != mesh.facets_end(); ++fit, ++row) {
-
-    if (fit->facet_degree() != 3) {
-      std::cerr << "Facet has " << fit->facet_degree() << " edges" << std::endl;
-      mexErrMsgTxt("Facet does not have 3 edges");
-    }
-
-    // go around the half-edges of the facet, to extract the vertices
-    Halfedge_around_facet_circulator heit = fit->facet_begin();
-    int idx = 0;
-    do {
-      
-      // extract triangle indices and save to Matlab output
-      // note that Matlab indices go like 1, 2, 3..., while C++ indices go like 0, 1, 2...
-      tri[row + idx * mesh.size_of_facets()] = 1 + V[heit->vertex()];
-      idx++;
-
-    } while (++heit != fit->facet_begin());
-    
-  }
+  // write subdivided mesh to Matlab
+  CopyPolyhedronTrianglesToMatlab(mesh, matlabExport, outTRI);
+  CopyPolyhedronVerticesToMatlab(mesh, matlabExport, outX);
+
 }
 
 #endif /* CGALSURFACESUBDIVISION */
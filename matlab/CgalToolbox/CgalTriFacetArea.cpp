@@ -1,11 +1,13 @@
 /* CgalTriFacetArea.cpp
  *
- * CGAL_TRIFACET_AREA  Area of the facets in a triangular mesh
+ * CGAL_TRIFACET_AREA  Area and other measures of the facets in a
+ * triangular mesh
  *
- * A = cgal_trifacet_area(TRI, X)
+ * [A, N, V, LMIN, LMAX, C] = cgal_trifacet_area(TRI, X)
  *
  *   TRI is a 3-column matrix. Each row contains the 3 nodes that form one
- *   triangular facet in the mesh.
+ *   triangular facet in the mesh. TRI can be of any integer or
+ *   floating-point class.
  *
  *   X is a 3-column matrix. X(i, :) contains the xyz-coordinates of the
  *   i-th node in the mesh.
@@ -13,12 +15,33 @@
  *   A is a vector with the same number of rows as TRI. A(i) is the area of
  *   the triangle TRI(i).
  *
+ *   N is a 3-column matrix. N(i, :) is the unit normal vector of triangle
+ *   TRI(i), following the right-hand rule with the order of its
+ *   vertices. Degenerate triangles have NaN normals.
+ *
+ *   V is a vector. V(i) is the signed volume of the tetrahedron formed by
+ *   triangle TRI(i) and the origin of coordinates. If the mesh is closed
+ *   and the facets are oriented with the normals pointing outwards,
+ *   sum(V) is the volume enclosed by the mesh.
+ *
+ *   LMIN, LMAX are vectors. LMIN(i), LMAX(i) are the lengths of the
+ *   shortest and longest edges of triangle TRI(i).
+ *
+ *   C is a 3-column matrix. C(i, :) is the centroid of triangle TRI(i).
+ *
+ * All the measures are computed in a single pass over the mesh, and
+ * only the requested outputs are computed, e.g.
+ *
+ *   [A, N] = cgal_trifacet_area(TRI, X);
+ *
+ * does not compute the volumes, edge lengths or centroids.
+ *
  */
 
  /*
   * Author: Ramon Casero <rcasero@gmail.com>
   * Copyright © 2013 University of Oxford
-  * Version: 0.3.1
+  * Version: 0.4.1
   *
   * University of Oxford means the Chancellor, Masters and Scholars of
   * the University of Oxford, having an administrative office at
@@ -52,20 +75,121 @@
 #include <mex.h>
 
 /* C++ headers */
-#include <iostream>
+#include <algorithm>
+#include <cmath>
+#include <vector>
 
 /* Gerardus headers */
 #include "MatlabImportFilter.h"
 #include "MatlabExportFilter.h"
 
-/* CGAL headers */
-#include <CGAL/Simple_cartesian.h>
+/*
+ * FacetMeasures: pointers to the output buffers. Outputs that have not
+ * been requested by the user are NULL, and are not computed
+ */
+struct FacetMeasures {
+  double *area;     // nf x 1
+  double *normal;   // nf x 3
+  double *volume;   // nf x 1
+  double *lmin;     // nf x 1
+  double *lmax;     // nf x 1
+  double *centroid; // nf x 3
+};
 
-typedef CGAL::Simple_cartesian<double>            K;
-typedef K::FT                                     FT;
-typedef CGAL::Point_3<K>                          Point;
-typedef K::Segment_3                              Segment;
-typedef CGAL::Triangle_3<K>                       Triangle; // size 72 byte
+/*
+ * ComputeFacetMeasures(): compute the measures of each facet in one
+ * pass over the mesh. TRI and X are read directly from the Matlab
+ * buffers. Because Matlab matrices are stored column-wise, each
+ * coordinate of X is a contiguous array (structure of arrays), and the
+ * body of the loop is plain arithmetic that the compiler can
+ * vectorise, instead of constructing a CGAL triangle per facet.
+ *
+ * Returns false if any vertex index in TRI is not an integer between
+ * 1 and the number of vertices.
+ */
+template <class TriType>
+bool ComputeFacetMeasures(const TriType *tri, mwSize nf,
+			  const double *x, mwSize nv,
+			  const FacetMeasures &out) {
+
+  // coordinate arrays
+  const double *px = x;
+  const double *py = x + nv;
+  const double *pz = x + 2 * nv;
+
+  bool isBadIndex = false;
+
+#ifdef _OPENMP
+#pragma omp parallel for schedule(static) reduction(||:isBadIndex)
+#endif
+  for (mwSignedIndex i = 0; i < (mwSignedIndex)nf; ++i) {
+
+    // indices of the 3 vertices of the triangle. These indices follow
+    // Matlab's convention v0 = 1, 2, ..., n
+    double v0d = (double)tri[i];
+    double v1d = (double)tri[i + nf];
+    double v2d = (double)tri[i + 2 * nf];
+    if (!(v0d >= 1 && v0d <= nv && v0d == std::floor(v0d))
+	|| !(v1d >= 1 && v1d <= nv && v1d == std::floor(v1d))
+	|| !(v2d >= 1 && v2d <= nv && v2d == std::floor(v2d))) {
+      isBadIndex = true;
+      continue;
+    }
+    mwIndex v0 = (mwIndex)v0d - 1;
+    mwIndex v1 = (mwIndex)v1d - 1;
+    mwIndex v2 = (mwIndex)v2d - 1;
+
+    // vertex coordinates
+    double x0 = px[v0], y0 = py[v0], z0 = pz[v0];
+    double x1 = px[v1], y1 = py[v1], z1 = pz[v1];
+    double x2 = px[v2], y2 = py[v2], z2 = pz[v2];
+
+    // edge vectors
+    double ax = x1 - x0, ay = y1 - y0, az = z1 - z0;
+    double bx = x2 - x1, by = y2 - y1, bz = z2 - z1;
+    double cx = x0 - x2, cy = y0 - y2, cz = z0 - z2;
+
+    // normal vector with length = 2 * area
+    double nx = ay * (-cz) - az * (-cy);
+    double ny = az * (-cx) - ax * (-cz);
+    double nz = ax * (-cy) - ay * (-cx);
+    double nnorm = std::sqrt(nx * nx + ny * ny + nz * nz);
+
+    if (out.area) {
+      out.area[i] = 0.5 * nnorm;
+    }
+    if (out.normal) {
+      out.normal[i] = nx / nnorm;
+      out.normal[i + nf] = ny / nnorm;
+      out.normal[i + 2 * nf] = nz / nnorm;
+    }
+    if (out.volume) {
+      out.volume[i] = (x0 * (y1 * z2 - z1 * y2)
+		       - y0 * (x1 * z2 - z1 * x2)
+		       + z0 * (x1 * y2 - y1 * x2)) / 6.0;
+    }
+    if (out.lmin || out.lmax) {
+      double la = ax * ax + ay * ay + az * az;
+      double lb = bx * bx + by * by + bz * bz;
+      double lc = cx * cx + cy * cy + cz * cz;
+      if (out.lmin) {
+	out.lmin[i] = std::sqrt(std::min(la, std::min(lb, lc)));
+      }
+      if (out.lmax) {
+	out.lmax[i] = std::sqrt(std::max(la, std::max(lb, lc)));
+      }
+    }
+    if (out.centroid) {
+      out.centroid[i] = (x0 + x1 + x2) / 3.0;
+      out.centroid[i + nf] = (y0 + y1 + y2) / 3.0;
+      out.centroid[i + 2 * nf] = (z0 + z1 + z2) / 3.0;
+    }
+
+  }
+
+  return !isBadIndex;
+
+}
 
 /*
  * mexFunction(): entry point for the mex function
@@ -87,7 +211,8 @@ void mexFunction(int nlhs, mxArray *plhs[],
   MatlabInputPointer inX = matlabImport->RegisterInput(IN_X, "X");
 
   // interface to deal with outputs to Matlab
-  enum OutputIndexType {OUT_A, OutputIndexType_MAX};
+  enum OutputIndexType {OUT_A, OUT_N, OUT_V, OUT_LMIN, OUT_LMAX, OUT_C,
+			OutputIndexType_MAX};
   MatlabExportFilter::Pointer matlabExport = MatlabExportFilter::New();
   matlabExport->ConnectToMatlabFunctionOutput(nlhs, plhs);
 
@@ -97,65 +222,113 @@ void mexFunction(int nlhs, mxArray *plhs[],
   // register the outputs for this function at the export filter
   typedef MatlabExportFilter::MatlabOutputPointer MatlabOutputPointer;
   MatlabOutputPointer outA = matlabExport->RegisterOutput(OUT_A, "A");
-
-  // default coordinates are NaN values, so that the user can spot
-  // whether there was any problem reading them
-  Point def(mxGetNaN(), mxGetNaN(), mxGetNaN());
+  MatlabOutputPointer outN = matlabExport->RegisterOutput(OUT_N, "N");
+  MatlabOutputPointer outV = matlabExport->RegisterOutput(OUT_V, "V");
+  MatlabOutputPointer outLMIN = matlabExport->RegisterOutput(OUT_LMIN, "LMIN");
+  MatlabOutputPointer outLMAX = matlabExport->RegisterOutput(OUT_LMAX, "LMAX");
+  MatlabOutputPointer outC = matlabExport->RegisterOutput(OUT_C, "C");
 
   // if any of the inputs is empty, the output is empty too
   if (mxIsEmpty(prhs[IN_TRI]) || mxIsEmpty(prhs[IN_X])) {
     matlabExport->CopyEmptyArrayToMatlab(outA);
+    matlabExport->CopyEmptyArrayToMatlab(outN);
+    matlabExport->CopyEmptyArrayToMatlab(outV);
+    matlabExport->CopyEmptyArrayToMatlab(outLMIN);
+    matlabExport->CopyEmptyArrayToMatlab(outLMAX);
+    matlabExport->CopyEmptyArrayToMatlab(outC);
     return;
   }
 
   // get size of input matrix
   mwSize nrowsTri = mxGetM(prhs[IN_TRI]);
   mwSize ncolsTri = mxGetN(prhs[IN_TRI]);
+  mwSize nrowsX = mxGetM(prhs[IN_X]);
   mwSize ncolsX = mxGetN(prhs[IN_X]);
   if ((ncolsTri != 3) || (ncolsX != 3)) {
     mexErrMsgTxt("Both input arguments must have 3 columns");
   }
 
-  // initialise output
-  double *area = matlabExport->AllocateColumnVectorInMatlab<double>(outA, nrowsTri);
-  
-  // read triangular mesh from function
-  Triangle tri;
-  mwIndex v0, v1, v2; // indices of the 3 vertices of each triangle
-  Point x0, x1, x2; // coordinates of the 3 vertices of each triangle
-
-  for (mwIndex i = 0; i < nrowsTri; ++i) {
-
-    // exit if user pressed Ctrl+C
-    ctrlcCheckPoint(__FILE__, __LINE__);
-
-    // get indices of the 3 vertices of each triangle. These indices
-    // follow Matlab's convention v0 = 1, 2, ..., n
-    v0 = matlabImport->ReadScalarFromMatlab<mwIndex>(inTRI, i, 0, mxGetNaN());
-    v1 = matlabImport->ReadScalarFromMatlab<mwIndex>(inTRI, i, 1, mxGetNaN());
-    v2 = matlabImport->ReadScalarFromMatlab<mwIndex>(inTRI, i, 2, mxGetNaN());
-    if (mxIsNaN(v0) || mxIsNaN(v1) || mxIsNaN(v2)) {
-      mexErrMsgTxt("Input TRI: Vertex index is NaN");
+  // vertex coordinates. Double coordinates are used directly from the
+  // Matlab buffer, single coordinates are converted
+  std::vector<double> xCopy;
+  const double *x = NULL;
+  switch (mxGetClassID(prhs[IN_X])) {
+  case mxDOUBLE_CLASS:
+    x = (const double *)mxGetData(prhs[IN_X]);
+    break;
+  case mxSINGLE_CLASS:
+    {
+      const float *p = (const float *)mxGetData(prhs[IN_X]);
+      xCopy.assign(p, p + 3 * nrowsX);
+      x = &xCopy[0];
     }
-    
-    // get coordinates of the 3 vertices (substracting 1 so that
-    // indices follow the C++ convention 0, 1, ..., n-1)
-    x0 = matlabImport->ReadRowVectorFromMatlab<void, Point>(inX, v0 - 1, def);
-    x1 = matlabImport->ReadRowVectorFromMatlab<void, Point>(inX, v1 - 1, def);
-    x2 = matlabImport->ReadRowVectorFromMatlab<void, Point>(inX, v2 - 1, def);
-
-    // create triangle from the vertices read at the input
-    tri = Triangle(x0, x1, x2);
-
-    // compute triangle area
-    area[i] = std::sqrt(tri.squared_area());
-    
-    // // DEBUG
-    // std::cout << x0 << "\t" << x1 << "\t" << x2 << "\t" << std::sqrt(tri.squared_area()) << std::endl;
+    break;
+  default:
+    mexErrMsgTxt(("Input " + inX->name + " must be of type double or single").c_str());
+  }
+
+  // initialise outputs. Only the requested outputs are allocated and
+  // computed
+  FacetMeasures out = {NULL, NULL, NULL, NULL, NULL, NULL};
+  if (outA->isRequested) {
+    out.area = matlabExport->AllocateColumnVectorInMatlab<double>(outA, nrowsTri);
+  }
+  if (outN->isRequested) {
+    out.normal = matlabExport->AllocateMatrixInMatlab<double>(outN, nrowsTri, 3);
+  }
+  if (outV->isRequested) {
+    out.volume = matlabExport->AllocateColumnVectorInMatlab<double>(outV, nrowsTri);
+  }
+  if (outLMIN->isRequested) {
+    out.lmin = matlabExport->AllocateColumnVectorInMatlab<double>(outLMIN, nrowsTri);
+  }
+  if (outLMAX->isRequested) {
+    out.lmax = matlabExport->AllocateColumnVectorInMatlab<double>(outLMAX, nrowsTri);
+  }
+  if (outC->isRequested) {
+    out.centroid = matlabExport->AllocateMatrixInMatlab<double>(outC, nrowsTri, 3);
   }
 
+  // compute the facet measures
+  bool isValid = false;
+  switch (mxGetClassID(prhs[IN_TRI])) {
+  case mxDOUBLE_CLASS:
+    isValid = ComputeFacetMeasures((double *)mxGetData(prhs[IN_TRI]), nrowsTri, x, nrowsX, out);
+    break;
+  case mxSINGLE_CLASS:
+    isValid = ComputeFacetMeasures((float *)mxGetData(prhs[IN_TRI]), nrowsTri, x, nrowsX, out);
+    break;
+  case mxINT8_CLASS:
+    isValid = ComputeFacetMeasures((int8_T *)mxGetData(prhs[IN_TRI]), nrowsTri, x, nrowsX, out);
+    break;
+  case mxUINT8_CLASS:
+    isValid = ComputeFacetMeasures((uint8_T *)mxGetData(prhs[IN_TRI]), nrowsTri, x, nrowsX, out);
+    break;
+  case mxINT16_CLASS:
+    isValid = ComputeFacetMeasures((int16_T *)mxGetData(prhs[IN_TRI]), nrowsTri, x, nrowsX, out);
+    break;
+  case mxUINT16_CLASS:
+    isValid = ComputeFacetMeasures((uint16_T *)mxGetData(prhs[IN_TRI]), nrowsTri, x, nrowsX, out);
+    break;
+  case mxINT32_CLASS:
+    isValid = ComputeFacetMeasures((int32_T *)mxGetData(prhs[IN_TRI]), nrowsTri, x, nrowsX, out);
+    break;
+  case mxUINT32_CLASS:
+    isValid = ComputeFacetMeasures((uint32_T *)mxGetData(prhs[IN_TRI]), nrowsTri, x, nrowsX, out);
+    break;
+  case mxINT64_CLASS:
+    isValid = ComputeFacetMeasures((int64_T *)mxGetData(prhs[IN_TRI]), nrowsTri, x, nrowsX, out);
+    break;
+  case mxUINT64_CLASS:
+    isValid = ComputeFacetMeasures((uint64_T *)mxGetData(prhs[IN_TRI]), nrowsTri, x, nrowsX, out);
+    break;
+  default:
+    mexErrMsgTxt(("Input " + inTRI->name + " has invalid type").c_str());
+  }
+  if (!isValid) {
+    mexErrMsgTxt(("Input " + inTRI->name + ": Vertex indices must be integers between 1 and the number of vertices").c_str());
+  }
 
-  
 }
 
 #endif /* CGALTRIFACETAREA */
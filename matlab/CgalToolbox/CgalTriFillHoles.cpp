@@ -32,7 +32,7 @@
 /*
  * Author: Ramon Casero <rcasero@gmail.com>
  * Copyright © 2013 University of Oxford
- * Version: 0.1.1
+ * Version: 0.1.3
  *
  * University of Oxford means the Chancellor, Masters and Scholars of
  * the University of Oxford, having an administrative office at
@@ -75,12 +75,14 @@
 #include <CGAL/Exact_predicates_inexact_constructions_kernel.h>
 #include <CGAL/Polyhedron_3.h>
 #include <CGAL/triangulate_polyhedron.h>
-#include "PolyhedronBuilder.h"
+#include <CGAL/Polyhedron_items_with_id_3.h>
+#include "HalfedgeMesh.h"
 
 typedef MatlabImportFilter::MatlabInputPointer               MatlabInputPointer;
 
 typedef CGAL::Exact_predicates_inexact_constructions_kernel  Kernel;
-typedef CGAL::Polyhedron_3<Kernel>                           Polyhedron;
+typedef CGAL::Polyhedron_3<Kernel,
+                           CGAL::Polyhedron_items_with_id_3> Polyhedron;
 typedef CGAL::Point_3<Kernel>                                Point;
 typedef Polyhedron::Facet                                    Facet;
 typedef Polyhedron::Facet_iterator                           Facet_iterator;
@@ -128,63 +130,46 @@ void mexFunction(int nlhs, mxArray *plhs[],
     return;
   }
 
-  // polyhedron to contain the input mesh
+  // read input mesh into index arrays, and create the polyhedron from
+  // them. The builder keeps a list of the border halfedges
   Polyhedron mesh;
-  PolyhedronBuilder<Polyhedron> builder(matlabImport, inTRI, inX);
+  HalfedgeMesh halfedgeMesh;
+  halfedgeMesh.ReadFromMatlab(matlabImport, inTRI, inX);
+  PolyhedronFromHalfedgeMesh<Polyhedron> builder(halfedgeMesh);
   mesh.delegate(builder);
+  halfedgeMesh = HalfedgeMesh();
 
-  // get size of input matrix with the points
-  mwSize nrowsTri = mxGetM(inTRI->pm);
-  mwSize nrowsX = mxGetM(inX->pm);
 
 #ifdef DEBUG  
   std::cout << "Number of facets read = " << mesh.size_of_facets() << std::endl;
   std::cout << "Number of vertices read = " << mesh.size_of_vertices() << std::endl;
 #endif
 
-  if (nrowsTri != mesh.size_of_facets()) {
-    mexErrMsgTxt(("Input " + inTRI->name + ": Number of triangles read into mesh different from triangles provided at the input").c_str());
-  }
-  if (nrowsX != mesh.size_of_vertices()) {
-    mexErrMsgTxt(("Input " + inX->name + ": Number of vertices read into mesh different from vertices provided at the input").c_str());
-  }
 
-  // sort halfedges such that the non-border edges precede the
-  // border edges. We need to do this before any halfedge iterator
-  // operations are valid
-  mesh.normalize_border();
-  
-#ifdef DEBUG
-  std::cout << "Number of border halfedges = " << mesh.size_of_border_halfedges() << std::endl;
-#endif
-  
   // number of holes we have filled
   mwIndex n = 0;
 
-  // a closed mesh with no holes will have no border edges. What we do
-  // is grab a border halfedge and close the associated hole. This
-  // makes the rest of the iterators invalid, so we have to normalize
-  // the mesh again. Then we iterate, looking for a new border
-  // halfedge, filling the hole, etc.
-  //
-  // Note that confusingly, mesh.border_halfedges_begin() gives a
-  // pointer to the halfedge that is NOT a border in a border
-  // edge. The border halfedge is instead
-  // mesh.border_halfedges_begin()->opposite()
-  while (!mesh.is_closed()) {
-    
+  // each border halfedge created by the builder belongs to a
+  // hole. Filling a hole makes all the halfedges around it
+  // non-border, so the rest of border halfedges of the same hole are
+  // skipped. This way we don't need to call mesh.normalize_border()
+  // after each hole to find the next one
+  for (std::vector<Polyhedron::Halfedge_handle>::iterator it = builder.border.begin();
+       it != builder.border.end(); ++it) {
+
     // exit if user pressed Ctrl+C
     ctrlcCheckPoint(__FILE__, __LINE__);
 
-    // get the first hole we can find, and close it
-    mesh.fill_hole(mesh.border_halfedges_begin()->opposite());
+    if (!(*it)->is_border()) {
+      continue;
+    }
+
+    // close the hole
+    mesh.fill_hole(*it);
 
     // increase the counter of number of holes we have filled
     n++;
 
-    // renormalize mesh so that halfedge iterators are again valid
-    mesh.normalize_border();
-
   }
 
   // split all facets to triangles
@@ -194,43 +179,6 @@ void mexFunction(int nlhs, mxArray *plhs[],
   std::vector<double> nout(1, n);
   matlabExport->CopyVectorOfScalarsToMatlab<double, std::vector<double> >(outN, nout, 1);
 
-  // allocate memory for Matlab outputs
-  double *tri = matlabExport->AllocateMatrixInMatlab<double>(outTRI, mesh.size_of_facets(), 3);
-
-   // extract the triangles of the solution
-  // snippet adapted from CgalMeshSegmentation.cpp
-
-  // vertices coordinates. Assign indices to the vertices by defining
-  // a map between their handles and the index
-  std::map<Vertex_handle, int> V;
-  int inum = 0;
-  for(Vertex_iterator vit = mesh.vertices_begin(); vit != mesh.vertices_end(); ++vit) {
-
-    // save to internal list of vertices
-    V[vit] = inum++;
-
-  }  
-
-  // triangles given as (i,j,k), where each index corresponds to a vertex in x
-  mwIndex row = 0;
-  for (Facet_iterator fit = mesh.facets_begin(); fit != mesh.facets_end(); ++fit, ++row) {
-
-    if (fit->facet_degree() != 3) {
-      std::cerr << "Facet has " << fit->facet_degree() << " edges" << std::endl;
-      mexErrMsgTxt("Facet does not have 3 edges");
-    }
-
-    // go around the half-edges of the facet, to extract the vertices
-    Halfedge_around_facet_circulator heit = fit->facet_begin();
-    int idx = 0;
-    do {
-      
-      // extract triangle indices and save to Matlab output
-      // note that Matlab indices go like 1, 2, 3..., while C++ indices go like 0, 1, 2...
-      tri[row + idx * mesh.size_of_facets()] = 1 + V[heit->vertex()];
-      idx++;
-
-    } while (++heit != fit->facet_begin());
-    
-  }
+  // write triangles to Matlab
+  CopyPolyhedronTrianglesToMatlab(mesh, matlabExport, outTRI);
 }
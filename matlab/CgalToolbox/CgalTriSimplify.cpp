@@ -18,7 +18,7 @@
  * when a user-supplied stop predicate is met, such as reaching the desired
  * number of edges."
  *
- * [TRI2, X2] = cgal_tri_simplify(TRI, X, RATIO)
+ * [TRI2, X2] = cgal_tri_simplify(TRI, X, RATIO, NPATCH)
  *
  *   TRI is a 3-column matrix. Each row contains the 3 nodes that form one
  *   triangular facet in the mesh.
@@ -28,7 +28,19 @@
  *
  *   RATIO is a scalar with the stop criterion. The algorithm will stop when
  *   the number of current undirected edges is RATIO * number of original
- *   undirected edges.
+ *   undirected edges. By default, RATIO=0.1.
+ *
+ *   NPATCH is an integer with the number of patches the mesh is split
+ *   into. By default, NPATCH=1, and the whole mesh is simplified in one
+ *   pass. With NPATCH > 1, the facets are split into NPATCH spatially
+ *   compact patches by recursive bisection of their centroids. The
+ *   patches are simplified one after the other, with the vertices on the
+ *   seams between patches locked. Then a final pass over the whole mesh
+ *   collapses edges across the seams until the stop criterion is met.
+ *   The stop criterion is the same as for NPATCH=1, but the output mesh
+ *   is not identical. The patches are not simplified in parallel,
+ *   because the CGAL 4.2 edge collapse is not thread-safe, so NPATCH > 1
+ *   is not faster than NPATCH=1.
  *
  *   TRI2, X2 is the description of the simplified output mesh.
  *
@@ -38,7 +50,7 @@
 /*
  * Author: Ramon Casero <rcasero@gmail.com>
  * Copyright © 2013 University of Oxford
- * Version: 0.1.0
+ * Version: 0.2.3
  *
  * University of Oxford means the Chancellor, Masters and Scholars of
  * the University of Oxford, having an administrative office at
@@ -71,7 +83,10 @@
 #include <mex.h>
 
 /* C++ headers */
+#include <algorithm>
+#include <cmath>
 #include <iostream>
+#include <vector>
 
 /* Gerardus headers */
 #include "MatlabImportFilter.h"
@@ -80,7 +95,8 @@
 /* CGAL headers */
 #include <CGAL/Simple_cartesian.h>
 #include <CGAL/Polyhedron_3.h>
-#include "PolyhedronBuilder.h"
+#include <CGAL/Polyhedron_items_with_id_3.h>
+#include "HalfedgeMesh.h"
 
 typedef MatlabImportFilter::MatlabInputPointer               MatlabInputPointer;
 
@@ -88,12 +104,16 @@ typedef MatlabImportFilter::MatlabInputPointer               MatlabInputPointer;
 #include <CGAL/Surface_mesh_simplification/HalfedgeGraph_Polyhedron_3.h>
 // Simplification function
 #include <CGAL/Surface_mesh_simplification/edge_collapse.h>
+#include <CGAL/Surface_mesh_simplification/Edge_collapse_visitor_base.h>
 // Stop-condition policy
 //#include <CGAL/Surface_mesh_simplification/Policies/Edge_collapse/Count_stop_predicate.h>
-#include <CGAL/Surface_mesh_simplification/Policies/Edge_collapse/Count_ratio_stop_predicate.h>
+//#include <CGAL/Surface_mesh_simplification/Policies/Edge_collapse/Count_ratio_stop_predicate.h>
+// Cost policy
+#include <CGAL/Surface_mesh_simplification/Policies/Edge_collapse/LindstromTurk_cost.h>
 
 typedef CGAL::Simple_cartesian<double>                       Kernel;
-typedef CGAL::Polyhedron_3<Kernel>                           Polyhedron; 
+typedef CGAL::Polyhedron_3<Kernel,
+                           CGAL::Polyhedron_items_with_id_3> Polyhedron;
 namespace SMS = CGAL::Surface_mesh_simplification;
 
 typedef Polyhedron::Facet_iterator                           Facet_iterator;
@@ -101,6 +121,467 @@ typedef Polyhedron::Vertex_handle                            Vertex_handle;
 typedef Polyhedron::Vertex_iterator                          Vertex_iterator;
 typedef Polyhedron::Halfedge_around_facet_circulator         Halfedge_around_facet_circulator;
 
+/*
+ * InputCountRatioStopPredicate: stop condition for the edge collapse
+ * when the number of undirected edges drops below some portion of the
+ * number of edges of the input mesh. It is the same as
+ * SMS::Count_ratio_stop_predicate, except that the reference count is
+ * given by the user instead of the number of edges when edge_collapse()
+ * is called, so that the final pass after the simplification of
+ * the patches stops at the same point as the simplification of the
+ * whole mesh.
+ *
+ * Optionally, the locked edges that cannot be collapsed can be left
+ * out of the current count. The number of locked edges is read through
+ * a pointer, as it is updated by LockedEdgesVisitor while the mesh is
+ * being simplified.
+ */
+template <class ECM>
+class InputCountRatioStopPredicate {
+
+ public:
+
+  typedef SMS::Edge_profile<ECM>                                  Profile;
+  typedef typename boost::graph_traits<ECM>::edges_size_type      size_type;
+  typedef typename CGAL::halfedge_graph_traits<ECM>::Point        Point;
+  typedef typename CGAL::Kernel_traits<Point>::Kernel::FT         FT;
+
+  InputCountRatioStopPredicate(double _ratio, size_type _inputCount,
+			       const size_type *_lockedCount = NULL)
+    : ratio(_ratio), inputCount(_inputCount), lockedCount(_lockedCount) {}
+
+  bool operator()(const FT &, const Profile &,
+		  size_type, size_type currentCount) const {
+    double count = (double)currentCount;
+    if (this->lockedCount != NULL) {
+      count = std::max(0.0, count - (double)*this->lockedCount);
+    }
+    return (count / (double)inputCount) < ratio;
+  }
+
+ private:
+
+  double ratio;
+  size_type inputCount;
+  const size_type *lockedCount;
+
+};
+
+/*
+ * LockedEdgesVisitor: keeps the count of edges with at least one
+ * locked vertex up to date during the edge collapse. Locked edges are
+ * never collapsed, but collapsing edge v0-v1 also removes edge v0-vL
+ * (or v1-vL) and edge v0-vR (or v1-vR), which are locked if vL or vR
+ * are locked.
+ */
+template <class ECM>
+class LockedEdgesVisitor : public SMS::Edge_collapse_visitor_base<ECM> {
+
+ public:
+
+  typedef SMS::Edge_profile<ECM>                                  Profile;
+  typedef typename boost::graph_traits<ECM>::edges_size_type      size_type;
+  typedef typename CGAL::halfedge_graph_traits<ECM>::Point        Point;
+
+  LockedEdgesVisitor(const std::vector<char> &_locked, size_type &_lockedCount)
+    : locked(&_locked), lockedCount(&_lockedCount) {}
+
+  void OnCollapsing(const Profile &profile, const boost::optional<Point> &) {
+    if (profile.left_face_exists() && (*locked)[profile.vL()->id()]) {
+      --*lockedCount;
+    }
+    if (profile.right_face_exists() && (*locked)[profile.vR()->id()]) {
+      --*lockedCount;
+    }
+  }
+
+ private:
+
+  const std::vector<char> *locked;
+  size_type *lockedCount;
+
+};
+
+/*
+ * LockedVerticesCost: Lindstrom-Turk cost, except for edges with at
+ * least one locked vertex. Those edges have no cost, and the edge
+ * collapse skips them. Vertices are identified by their id().
+ */
+template <class ECM>
+class LockedVerticesCost {
+
+ public:
+
+  typedef SMS::Edge_profile<ECM>                                  Profile;
+  typedef typename SMS::LindstromTurk_cost<ECM>::result_type      result_type;
+
+  LockedVerticesCost(const std::vector<char> &_locked) : locked(&_locked) {}
+
+  template <class Placement>
+  result_type operator()(const Profile &profile,
+			 const Placement &placement) const {
+    if ((*locked)[profile.v0()->id()] || (*locked)[profile.v1()->id()]) {
+      return result_type();
+    }
+    return cost(profile, placement);
+  }
+
+ private:
+
+  const std::vector<char> *locked;
+  SMS::LindstromTurk_cost<ECM> cost;
+
+};
+
+/*
+ * FacetRange, CentroidLess: auxiliary types for the recursive
+ * bisection of the facets in PartitionFacets()
+ */
+
+// facets order[begin], ..., order[end-1] are split into npatch
+// patches numbered from first
+struct FacetRange {
+  mwIndex begin;
+  mwIndex end;
+  mwIndex first;
+  mwSize npatch;
+  FacetRange(mwIndex _begin, mwIndex _end, mwIndex _first, mwSize _npatch)
+    : begin(_begin), end(_end), first(_first), npatch(_npatch) {}
+};
+
+// comparison of two facets by one coordinate of their centroids
+struct CentroidLess {
+  const std::vector<double> *centroid; // nf x 3, column-wise
+  mwSize nf;
+  int dim;
+  CentroidLess(const std::vector<double> *_centroid, mwSize _nf, int _dim)
+    : centroid(_centroid), nf(_nf), dim(_dim) {}
+  bool operator()(mwIndex a, mwIndex b) const {
+    return (*centroid)[a + dim * nf] < (*centroid)[b + dim * nf];
+  }
+};
+
+/*
+ * PartitionFacets(): split the facets of the mesh into npatch
+ * spatially compact patches by recursive coordinate bisection of the
+ * facet centroids. Each group of facets is split across the longest
+ * side of its bounding box, with a number of facets on each side
+ * proportional to the number of patches on that side.
+ *
+ * patch[f] is the patch of facet f, 0, ..., npatch-1.
+ */
+void PartitionFacets(const HalfedgeMesh &mesh, mwSize npatch,
+		     std::vector<mwIndex> &patch) {
+
+  const mwSize nv = mesh.nv;
+  const mwSize nf = mesh.nf;
+
+  // facet centroids
+  std::vector<double> centroid(3 * nf);
+  for (int d = 0; d < 3; ++d) {
+    for (mwIndex f = 0; f < nf; ++f) {
+      centroid[f + d * nf] = (mesh.x[mesh.tri[f] + d * nv]
+			      + mesh.x[mesh.tri[f + nf] + d * nv]
+			      + mesh.x[mesh.tri[f + 2 * nf] + d * nv]) / 3.0;
+    }
+  }
+
+  std::vector<mwIndex> order(nf);
+  for (mwIndex f = 0; f < nf; ++f) {
+    order[f] = f;
+  }
+
+  patch.resize(nf);
+  std::vector<FacetRange> pending(1, FacetRange(0, nf, 0, npatch));
+  while (!pending.empty()) {
+
+    FacetRange r = pending.back();
+    pending.pop_back();
+
+    // this group of facets is a patch
+    if (r.npatch < 2 || r.end - r.begin < 2) {
+      for (mwIndex i = r.begin; i < r.end; ++i) {
+	patch[order[i]] = r.first;
+      }
+      continue;
+    }
+
+    // longest side of the bounding box of the centroids
+    int dim = 0;
+    double maxLength = -1.0;
+    for (int d = 0; d < 3; ++d) {
+      double cmin = centroid[order[r.begin] + d * nf];
+      double cmax = cmin;
+      for (mwIndex i = r.begin + 1; i < r.end; ++i) {
+	cmin = std::min(cmin, centroid[order[i] + d * nf]);
+	cmax = std::max(cmax, centroid[order[i] + d * nf]);
+      }
+      if (cmax - cmin > maxLength) {
+	maxLength = cmax - cmin;
+	dim = d;
+      }
+    }
+
+    // split the facets across that side
+    mwSize npatch1 = r.npatch / 2;
+    mwIndex mid = r.begin
+      + (mwIndex)((double)(r.end - r.begin) * npatch1 / r.npatch);
+    std::nth_element(order.begin() + r.begin, order.begin() + mid,
+		     order.begin() + r.end, CentroidLess(&centroid, nf, dim));
+    pending.push_back(FacetRange(r.begin, mid, r.first, npatch1));
+    pending.push_back(FacetRange(mid, r.end, r.first + npatch1,
+				 r.npatch - npatch1));
+
+  }
+
+}
+
+/*
+ * SimplifyPatches(): split the mesh into npatch patches, and simplify
+ * the patches one by one with the vertices on the seams between
+ * patches locked. The simplified patches are merged back into mesh.
+ *
+ * Each patch is simplified to the same ratio of its own edges, not
+ * counting the edges with a seam vertex. The latter are simplified by
+ * the caller in the final pass over the whole mesh.
+ *
+ * Returns false (and leaves the mesh untouched) if the mesh has
+ * zero-length edges with a seam vertex, as CGAL collapses those edges
+ * regardless of their cost, so seam vertices could not be locked; or
+ * if a patch touches itself at a seam vertex, which a Polyhedron_3
+ * cannot represent. Otherwise, returns true.
+ */
+bool SimplifyPatches(HalfedgeMesh &mesh, double ratio, mwSize npatch) {
+
+  const mwSize nv = mesh.nv;
+  const mwSize nf = mesh.nf;
+
+  // split the facets into patches
+  std::vector<mwIndex> patch;
+  PartitionFacets(mesh, npatch, patch);
+
+  // patch of each vertex, or -2 if the vertex is on a seam between
+  // patches
+  const mwSignedIndex SEAM = -2;
+  std::vector<mwSignedIndex> vertexPatch(nv, -1);
+  for (mwIndex h = 0; h < 3 * nf; ++h) {
+    mwIndex v = mesh.Source(h);
+    mwSignedIndex p = (mwSignedIndex)patch[mesh.Facet(h)];
+    if (vertexPatch[v] == -1) {
+      vertexPatch[v] = p;
+    } else if (vertexPatch[v] != p) {
+      vertexPatch[v] = SEAM;
+    }
+  }
+
+  // zero-length edges with a seam vertex
+  for (mwIndex h = 0; h < 3 * nf; ++h) {
+    mwIndex v0 = mesh.Source(h);
+    mwIndex v1 = mesh.Target(h);
+    if ((vertexPatch[v0] == SEAM || vertexPatch[v1] == SEAM)
+	&& mesh.x[v0] == mesh.x[v1]
+	&& mesh.x[v0 + nv] == mesh.x[v1 + nv]
+	&& mesh.x[v0 + 2 * nv] == mesh.x[v1 + 2 * nv]) {
+      return false;
+    }
+  }
+
+  // facets of each patch, sorted by patch
+  std::vector<mwIndex> first(npatch + 1, 0);
+  for (mwIndex f = 0; f < nf; ++f) {
+    ++first[patch[f] + 1];
+  }
+  for (mwIndex p = 0; p < npatch; ++p) {
+    first[p + 1] += first[p];
+  }
+  std::vector<mwIndex> facets(nf);
+  {
+    std::vector<mwIndex> pos(first.begin(), first.end() - 1);
+    for (mwIndex f = 0; f < nf; ++f) {
+      facets[pos[patch[f]]++] = f;
+    }
+  }
+
+  // build one polyhedron per patch. The id() of each vertex is its
+  // index in patchVertex[p], the sorted list of input vertices in the
+  // patch
+  std::vector<Polyhedron> patchMesh(npatch);
+  std::vector<std::vector<mwIndex> > patchVertex(npatch);
+  std::vector<std::vector<char> > locked(npatch);
+  typedef boost::graph_traits<Polyhedron>::edges_size_type size_type;
+  std::vector<size_type> edgeCount(npatch, 0);
+  std::vector<size_type> lockedCount(npatch, 0);
+  for (mwIndex p = 0; p < npatch; ++p) {
+
+    HalfedgeMesh sub;
+    sub.nf = first[p + 1] - first[p];
+    if (sub.nf == 0) {
+      continue;
+    }
+
+    // vertices in the patch
+    std::vector<mwIndex> &vertex = patchVertex[p];
+    for (mwIndex i = first[p]; i < first[p + 1]; ++i) {
+      for (int k = 0; k < 3; ++k) {
+	vertex.push_back(mesh.tri[facets[i] + k * nf]);
+      }
+    }
+    std::sort(vertex.begin(), vertex.end());
+    vertex.erase(std::unique(vertex.begin(), vertex.end()), vertex.end());
+    sub.nv = vertex.size();
+
+    sub.x.resize(3 * sub.nv);
+    locked[p].resize(sub.nv);
+    for (mwIndex i = 0; i < sub.nv; ++i) {
+      for (int d = 0; d < 3; ++d) {
+	sub.x[i + d * sub.nv] = mesh.x[vertex[i] + d * nv];
+      }
+      locked[p][i] = (vertexPatch[vertex[i]] == SEAM);
+    }
+
+    sub.tri.resize(3 * sub.nf);
+    for (mwIndex i = 0; i < sub.nf; ++i) {
+      for (int k = 0; k < 3; ++k) {
+	sub.tri[i + k * sub.nf] =
+	  std::lower_bound(vertex.begin(), vertex.end(),
+			   mesh.tri[facets[first[p] + i] + k * nf])
+	  - vertex.begin();
+      }
+    }
+
+    // a patch of a valid polyhedron is a valid polyhedron too, except
+    // that it can touch itself at a seam vertex (two fans of the patch
+    // separated by facets of other patches)
+    sub.ComputeOppositeHalfedges("Internal error: patch is not a valid polyhedron",
+				 false);
+    if (!sub.HasManifoldVertices()) {
+      return false;
+    }
+
+    // number of undirected edges, and edges with a locked vertex
+    edgeCount[p] = sub.NumberOfEdges();
+    for (mwIndex h = 0; h < 3 * sub.nf; ++h) {
+      if ((sub.opposite[h] < 0 || (mwSignedIndex)h < sub.opposite[h])
+	  && (locked[p][sub.Source(h)] || locked[p][sub.Target(h)])) {
+	++lockedCount[p];
+      }
+    }
+
+    PolyhedronFromHalfedgeMesh<Polyhedron> builder(sub);
+    patchMesh[p].delegate(builder);
+
+    // the builder pushes vertices in the same order as sub.x
+    mwIndex i = 0;
+    for (Vertex_iterator vit = patchMesh[p].vertices_begin();
+	 vit != patchMesh[p].vertices_end(); ++vit, ++i) {
+      vit->id() = i;
+    }
+
+  }
+
+  // simplify the patches one after the other. The edge collapses are
+  // not run in parallel, because CGAL 4.2 does not guarantee that
+  // Polyhedron_3 and the edge collapse are thread-safe, even on
+  // different polyhedra
+  bool isCgalError = false;
+  for (mwIndex p = 0; p < npatch; ++p) {
+
+    // skip empty patches and patches without collapsible edges
+    if (edgeCount[p] == lockedCount[p]) {
+      continue;
+    }
+
+    // exit if user pressed Ctrl+C
+    ctrlcCheckPoint(__FILE__, __LINE__);
+
+    try {
+
+      InputCountRatioStopPredicate<Polyhedron> stop(ratio,
+						    edgeCount[p] - lockedCount[p],
+						    &lockedCount[p]);
+      SMS::edge_collapse(patchMesh[p], stop,
+			 CGAL::vertex_index_map(boost::get(CGAL::vertex_external_index, patchMesh[p]))
+			 .edge_index_map(boost::get(CGAL::edge_external_index, patchMesh[p]))
+			 .get_cost(LockedVerticesCost<Polyhedron>(locked[p]))
+			 .visitor(LockedEdgesVisitor<Polyhedron>(locked[p], lockedCount[p])));
+
+    } catch (std::exception &e) {
+      isCgalError = true;
+    }
+
+  }
+  if (isCgalError) {
+    mexErrMsgTxt("CGAL error simplifying the mesh patches");
+  }
+
+  // merge the simplified patches. Seam vertices have not been
+  // removed, and they are numbered first, so that all patches can
+  // refer to them
+  std::vector<double> x;   // merged vertices, row-wise
+  std::vector<mwIndex> tri; // merged facets, row-wise
+  std::vector<mwSignedIndex> seamIndex(nv, -1);
+  mwIndex count = 0;
+  for (mwIndex v = 0; v < nv; ++v) {
+    if (vertexPatch[v] == SEAM) {
+      seamIndex[v] = count++;
+      for (int d = 0; d < 3; ++d) {
+	x.push_back(mesh.x[v + d * nv]);
+      }
+    }
+  }
+  for (mwIndex p = 0; p < npatch; ++p) {
+
+    // exit if user pressed Ctrl+C
+    ctrlcCheckPoint(__FILE__, __LINE__);
+
+    std::vector<mwIndex> merged(patchVertex[p].size());
+    for (Vertex_iterator vit = patchMesh[p].vertices_begin();
+	 vit != patchMesh[p].vertices_end(); ++vit) {
+      mwIndex i = vit->id();
+      if (locked[p][i]) {
+	merged[i] = seamIndex[patchVertex[p][i]];
+      } else {
+	merged[i] = count++;
+	x.push_back(CGAL::to_double(vit->point().x()));
+	x.push_back(CGAL::to_double(vit->point().y()));
+	x.push_back(CGAL::to_double(vit->point().z()));
+      }
+    }
+
+    for (Facet_iterator fit = patchMesh[p].facets_begin();
+	 fit != patchMesh[p].facets_end(); ++fit) {
+      Halfedge_around_facet_circulator hcir = fit->facet_begin();
+      for (int k = 0; k < 3; ++k, ++hcir) {
+	tri.push_back(merged[hcir->vertex()->id()]);
+      }
+    }
+
+    // free memory as soon as possible
+    patchMesh[p].clear();
+
+  }
+
+  // copy the merged mesh back, column-wise
+  mesh.nv = count;
+  mesh.nf = tri.size() / 3;
+  mesh.x.resize(3 * mesh.nv);
+  for (mwIndex v = 0; v < mesh.nv; ++v) {
+    for (int d = 0; d < 3; ++d) {
+      mesh.x[v + d * mesh.nv] = x[3 * v + d];
+    }
+  }
+  mesh.tri.resize(3 * mesh.nf);
+  for (mwIndex f = 0; f < mesh.nf; ++f) {
+    for (int k = 0; k < 3; ++k) {
+      mesh.tri[f + k * mesh.nf] = tri[3 * f + k];
+    }
+  }
+  mesh.ComputeOppositeHalfedges("Internal error: merged patches are not a valid polyhedron");
+
+  return true;
+
+}
+
 /*
  * mexFunction(): entry point for the mex function
  */
@@ -108,7 +589,7 @@ void mexFunction(int nlhs, mxArray *plhs[],
 		 int nrhs, const mxArray *prhs[]) {
 
   // interface to deal with input arguments from Matlab
-  enum InputIndexType {IN_TRI, IN_X, IN_R, InputIndexType_MAX};
+  enum InputIndexType {IN_TRI, IN_X, IN_R, IN_NPATCH, InputIndexType_MAX};
   MatlabImportFilter::Pointer matlabImport = MatlabImportFilter::New();
   matlabImport->ConnectToMatlabFunctionInput(nrhs, prhs);
 
@@ -118,7 +599,8 @@ void mexFunction(int nlhs, mxArray *plhs[],
   // register the inputs for this function at the import filter
   MatlabInputPointer inTRI =        matlabImport->RegisterInput(IN_TRI, "TRI");
   MatlabInputPointer inX =          matlabImport->RegisterInput(IN_X, "X");
-  MatlabInputPointer inR =          matlabImport->RegisterInput(IN_R, "R");
+  MatlabInputPointer inR =          matlabImport->RegisterInput(IN_R, "RATIO");
+  MatlabInputPointer inNPATCH =     matlabImport->RegisterInput(IN_NPATCH, "NPATCH");
 
   // interface to deal with outputs to Matlab
   enum OutputIndexType {OUT_TRI, OUT_X, OutputIndexType_MAX};
@@ -142,32 +624,40 @@ void mexFunction(int nlhs, mxArray *plhs[],
 
   // read input parameters
   double ratio = matlabImport->ReadScalarFromMatlab<double>(inR, 0.1);
+  double npatchIn = matlabImport->ReadScalarFromMatlab<double>(inNPATCH, 1.0);
+  if (mxIsNaN(npatchIn) || mxIsInf(npatchIn) || npatchIn < 1.0
+      || npatchIn != std::floor(npatchIn)) {
+    mexErrMsgTxt("Input NPATCH must be an integer >= 1");
+  }
+  mwSize npatch = (mwSize)npatchIn;
 
-  // polyhedron to contain the input mesh
-  Polyhedron mesh;
-  PolyhedronBuilder<Polyhedron> builder(matlabImport, inTRI, inX);
-  mesh.delegate(builder);
+  // read input mesh into index arrays
+  HalfedgeMesh halfedgeMesh;
+  halfedgeMesh.ReadFromMatlab(matlabImport, inTRI, inX);
+
+  // the simplification stops when the number of undirected edges
+  // drops below some portion, e.g. 10%, of the input count
+  InputCountRatioStopPredicate<Polyhedron> stop(ratio, halfedgeMesh.NumberOfEdges());
+
+  // simplify the interior of the patches. If the seams
+  // cannot be locked, the whole mesh is simplified serially
+  if (npatch > 1 && !SimplifyPatches(halfedgeMesh, ratio, npatch)) {
+    mexWarnMsgTxt("Patch seams cannot be locked. Simplifying serially");
+  }
 
-  // get size of input matrix with the points
-  mwSize nrowsTri = mxGetM(inTRI->pm);
-  mwSize nrowsX = mxGetM(inX->pm);
+  // create the polyhedron from the index arrays
+  Polyhedron mesh;
+  {
+    PolyhedronFromHalfedgeMesh<Polyhedron> builder(halfedgeMesh);
+    mesh.delegate(builder);
+  }
+  halfedgeMesh = HalfedgeMesh();
 
 #ifdef DEBUG  
   std::cout << "Number of facets read = " << mesh.size_of_facets() << std::endl;
   std::cout << "Number of vertices read = " << mesh.size_of_vertices() << std::endl;
 #endif
 
-  if (nrowsTri != mesh.size_of_facets()) {
-    mexErrMsgTxt(("Input " + inTRI->name + ": Number of triangles read into mesh different from triangles provided at the input").c_str());
-  }
-  if (nrowsX != mesh.size_of_vertices()) {
-    mexErrMsgTxt(("Input " + inX->name + ": Number of vertices read into mesh different from vertices provided at the input").c_str());
-  }
-
-  // the simplification stops when the number of undirected edges
-  // drops below some portion, e.g. 10%, of the initial count
-  SMS::Count_ratio_stop_predicate<Polyhedron> stop(ratio);
-  
   // This the actual call to the simplification algorithm.
   // The surface and stop conditions are mandatory arguments.
   // The index maps are needed because the vertices and edges
@@ -176,50 +666,8 @@ void mexFunction(int nlhs, mxArray *plhs[],
 		     CGAL::vertex_index_map(boost::get(CGAL::vertex_external_index, mesh)) 
 		     .edge_index_map(boost::get(CGAL::edge_external_index, mesh)));
 
-  // allocate memory for Matlab outputs
-  double *tri = matlabExport->AllocateMatrixInMatlab<double>(outTRI, mesh.size_of_facets(), 3);
-  double *x = matlabExport->AllocateMatrixInMatlab<double>(outX, mesh.size_of_vertices(), 3);
-
-   // extract the triangles of the solution
-  // snippet adapted from CgalMeshSegmentation.cpp
-
-  // vertices coordinates. Assign indices to the vertices by defining
-  // a map between their handles and the index
-  std::map<Vertex_handle, int> V;
-  int inum = 0;
-  for(Vertex_iterator vit = mesh.vertices_begin(); vit != mesh.vertices_end(); ++vit) {
-
-   // save to Matlab output
-    x[inum] = vit->point().x();
-    x[inum + mesh.size_of_vertices()] = vit->point().y();
-    x[inum + 2*mesh.size_of_vertices()] = vit->point().z();
-
-    // save to internal list of vertices
-    V[vit] = inum++;
-
-  }  
-
-  // triangles given as (i,j,k), where each index corresponds to a vertex in x
-  mwIndex row = 0;
-  for (Facet_iterator fit = mesh.facets_begin(); fit != mesh.facets_end(); ++fit, ++row) {
-
-    if (fit->facet_degree() != 3) {
-      std::cerr << "Facet has " << fit->facet_degree() << " edges" << std::endl;
-      mexErrMsgTxt("Facet does not have 3 edges");
-    }
-
-    // go around the half-edges of the facet, to extract the vertices
-    Halfedge_around_facet_circulator heit = fit->facet_begin();
-    int idx = 0;
-    do {
-      
-      // extract triangle indices and save to Matlab output
-      // note that Matlab indices go like 1, 2, 3..., while C++ indices go like 0, 1, 2...
-      tri[row + idx * mesh.size_of_facets()] = 1 + V[heit->vertex()];
-      idx++;
-
-    } while (++heit != fit->facet_begin());
-    
-  }
+  // write simplified mesh to Matlab
+  CopyPolyhedronTrianglesToMatlab(mesh, matlabExport, outTRI);
+  CopyPolyhedronVerticesToMatlab(mesh, matlabExport, outX);
 
 }
@@ -0,0 +1,218 @@
+/*
+ * DelaunayBuilder.h
+ *
+ * Functions to read a set of points from Matlab and insert them into
+ * a CGAL::Delaunay_triangulation_3 whose vertices carry the row index
+ * of each point in the Matlab input as info().
+ *
+ * The points are spatially sorted before insertion (BRIO: random
+ * rounds, each one sorted along a Hilbert curve). Point clouds
+ * extracted from segmentations come in raster order, which is close
+ * to the worst case for incremental Delaunay insertion, because each
+ * new point has to be located walking across the whole triangulation.
+ * After the spatial sort, consecutive points are close to each other,
+ * and the previously inserted vertex is a good hint to locate the
+ * next one.
+ *
+ * The vendored CGAL 4.2 does not provide a concurrent triangulation
+ * data structure, so the triangulation itself is built serially.
+ *
+ * CGAL's range constructor also sorts the points, but it makes three
+ * additional copies of the input (points, infos and indices). Here we
+ * sort the (Point, index) pairs in place.
+ *
+ * An example of how to use these functions in a MEX Matlab function:
+ *
+ *   std::vector<PointWithIndex> x;
+ *   ReadPointsWithIndexFromMatlab(matlabImport, inX, x);
+ *   Delaunay delaunay;
+ *   InsertPointsWithIndexInDelaunay(delaunay, x);
+ *
+ */
+
+/*
+ * Author: Ramon Casero <rcasero@gmail.com>
+ * Copyright © 2013 University of Oxford
+ * Version: 0.1.0
+ *
+ * University of Oxford means the Chancellor, Masters and Scholars of
+ * the University of Oxford, having an administrative office at
+ * Wellington Square, Oxford OX1 2JD, UK.
+ *
+ * This file is part of Gerardus.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details. The offer of this
+ * program under the terms of the License is subject to the License
+ * being interpreted in accordance with English Law and subject to any
+ * action against the University of Oxford being under the jurisdiction
+ * of the English Courts.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see
+ * <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef DELAUNAYBUILDER_H
+#define DELAUNAYBUILDER_H
+
+/* mex headers */
+#include <mex.h>
+
+/* C++ headers */
+#include <utility>
+#include <vector>
+
+/* Gerardus headers */
+#include "MatlabImportFilter.h"
+
+/* CGAL headers */
+#include <CGAL/spatial_sort.h>
+
+/*
+ * PointWithIndexSortTraits: traits class for CGAL::spatial_sort() so
+ * that we can sort std::pair<Point, Info> elements by their first
+ * member, without splitting the points from their indices.
+ *
+ * K:    CGAL kernel
+ * Info: type of the information attached to each point
+ */
+template <class K, class Info>
+class PointWithIndexSortTraits {
+
+ public:
+
+  typedef std::pair<typename K::Point_3, Info>  Point_3;
+
+  struct Less_x_3 {
+    bool operator()(const Point_3 &p, const Point_3 &q) const {
+      return p.first.x() < q.first.x();
+    }
+  };
+  struct Less_y_3 {
+    bool operator()(const Point_3 &p, const Point_3 &q) const {
+      return p.first.y() < q.first.y();
+    }
+  };
+  struct Less_z_3 {
+    bool operator()(const Point_3 &p, const Point_3 &q) const {
+      return p.first.z() < q.first.z();
+    }
+  };
+
+  Less_x_3 less_x_3_object() const { return Less_x_3(); }
+  Less_y_3 less_y_3_object() const { return Less_y_3(); }
+  Less_z_3 less_z_3_object() const { return Less_z_3(); }
+
+};
+
+/*
+ * ReadPointsWithIndexFromMatlab(): read a 3-column matrix X from
+ * Matlab into a vector of (Point, index) pairs. The index is the
+ * Matlab row index of the point, i.e. 1, ..., Nrows.
+ *
+ * NaN or Inf coordinates are rejected with an error, otherwise they
+ * would give a segfault in the triangulation.
+ */
+template <class Point, class Info>
+void ReadPointsWithIndexFromMatlab(MatlabImportFilter::Pointer matlabImport,
+				   MatlabImportFilter::MatlabInputPointer inX,
+				   std::vector<std::pair<Point, Info> > &x) {
+
+  // default coordinates are NaN values, so that the user can spot
+  // whether there was any problem reading them
+  Point xDef(mxGetNaN(), mxGetNaN(), mxGetNaN());
+
+  // get size of input matrix with the points
+  mwSize nrowsX = mxGetM(inX->pm);
+  mwSize ncolsX = mxGetN(inX->pm);
+  if (ncolsX != 3) {
+    mexErrMsgTxt(("Input " + inX->name + " must have 3 columns").c_str());
+  }
+
+  // read points from function
+  x.resize(nrowsX);
+  for (mwIndex i = 0; i < nrowsX; ++i) {
+
+    // exit if user pressed Ctrl+C
+    ctrlcCheckPoint(__FILE__, __LINE__);
+
+    // read i-th row of input matrix as a point
+    x[i] = std::make_pair(
+			  matlabImport->ReadRowVectorFromMatlab<void, Point>(inX, i, xDef),
+			  (Info)(i+1) // because this will be a row index in Matlab, 1, ..., Nrows
+			  );
+
+    // don't accept NaNs or Infs, otherwise they will give a segfault
+    if(mxIsNaN(x[i].first[0])
+       || mxIsNaN(x[i].first[1])
+       || mxIsNaN(x[i].first[2])
+       || mxIsInf(x[i].first[0])
+       || mxIsInf(x[i].first[1])
+       || mxIsInf(x[i].first[2])
+       ) {
+      mexErrMsgTxt(("Input " + inX->name + " contains NaN or Inf values").c_str());
+    }
+
+  }
+
+}
+
+/*
+ * InsertPointsWithIndexInDelaunay(): sort a vector of (Point, index)
+ * pairs spatially, and insert them in a Delaunay triangulation. Each
+ * point is located starting from the vertex inserted immediately
+ * before it. The index of each point is copied to the info() of its
+ * vertex.
+ *
+ * The vector x is reordered by this function.
+ *
+ * delaunay: Delaunay_triangulation_3 with or without Fast_location,
+ *           and a vertex base with info (e.g.
+ *           Triangulation_vertex_base_with_info_3<mwSize, K>)
+ *
+ * x:        vector of (Point, index) pairs
+ */
+template <class Delaunay>
+void InsertPointsWithIndexInDelaunay(Delaunay &delaunay,
+				     std::vector<std::pair<typename Delaunay::Point,
+				     typename Delaunay::Vertex::Info> > &x) {
+
+  typedef typename Delaunay::Geom_traits                     K;
+  typedef typename Delaunay::Vertex::Info                    Info;
+  typedef typename Delaunay::Vertex_handle                   Vertex_handle;
+  typedef std::pair<typename Delaunay::Point, Info>          PointWithInfo;
+  typedef typename std::vector<PointWithInfo>::const_iterator ConstIterator;
+
+  // BRIO spatial sort. The input is randomly shuffled by
+  // spatial_sort(), so points in raster order are not a problem
+  CGAL::spatial_sort(x.begin(), x.end(), PointWithIndexSortTraits<K, Info>());
+
+  // insert the points in the triangulation, using the last inserted
+  // vertex as the starting point to locate the next one
+  Vertex_handle hint;
+  for (ConstIterator it = x.begin(); it != x.end(); ++it) {
+
+    // exit if user pressed Ctrl+C
+    ctrlcCheckPoint(__FILE__, __LINE__);
+
+    hint = delaunay.insert(it->first, hint);
+
+    // duplicated points are merged into the existing vertex, that
+    // takes the index of the last duplicate inserted (same behaviour
+    // as CGAL's range insertion with info)
+    if (hint != Vertex_handle()) {
+      hint->info() = it->second;
+    }
+  }
+
+}
+
+#endif /* DELAUNAYBUILDER_H */
@@ -0,0 +1,612 @@
+/*
+ * HalfedgeMesh.h
+ *
+ * HalfedgeMesh: index-based half-edge representation of a triangular
+ * mesh TRI, X read from Matlab, stored in contiguous arrays.
+ *
+ * Facets and vertices are identified by their 0-based row in TRI and
+ * X. The three halfedges of facet f are numbered h = f, f + nf, f +
+ * 2*nf (nf = number of facets), so that halfedge h goes from vertex
+ * tri[h] to the next vertex in the same row of TRI. That is, arrays
+ * are stored column-wise, in the same order as Matlab matrices, and
+ * they can be copied to and from Matlab with a plain loop.
+ *
+ * The opposite of each halfedge is found in one pass, bucket-sorting
+ * the edges by their lowest vertex index, and then by the highest.
+ * Edges with only one halfedge are on the border of the mesh, and
+ * have opposite = -1. Then the facets around each vertex are walked
+ * through the opposite halfedges, to reject non-manifold (bowtie)
+ * vertices, where two or more fans of facets share the vertex, as the
+ * Polyhedron_incremental_builder_3 does.
+ *
+ * This class replaces building a CGAL::Polyhedron_3 with the
+ * Polyhedron_incremental_builder_3, which needs to look up halfedges
+ * around each vertex as facets are added, and to read TRI, X element
+ * by element. The polyhedron is instead created directly from the
+ * arrays with PolyhedronFromHalfedgeMesh, and written back to Matlab
+ * with CopyPolyhedronTrianglesToMatlab() and
+ * CopyPolyhedronVerticesToMatlab(). The latter require a polyhedron
+ * with vertex ids (CGAL::Polyhedron_items_with_id_3). The polyhedron
+ * is still built in full, as the CGAL algorithms run on it; only the
+ * cost of the incremental builder is saved.
+ *
+ * TRI and X can be of the same classes as with the incremental
+ * builder: logical, double, single or integer up to int32, and also
+ * int64 for TRI.
+ *
+ * The index arrays and the polyhedron coexist while the polyhedron is
+ * created, so the caller should free the HalfedgeMesh as soon as the
+ * polyhedron has been built (e.g. by declaring it in a block).
+ *
+ * An example of how to use this class in a MEX Matlab function:
+ *
+ * #include <CGAL/Exact_predicates_inexact_constructions_kernel.h>
+ * #include <CGAL/Polyhedron_3.h>
+ * #include <CGAL/Polyhedron_items_with_id_3.h>
+ * #include "HalfedgeMesh.h"
+ *
+ * typedef CGAL::Exact_predicates_inexact_constructions_kernel  Kernel;
+ * typedef CGAL::Polyhedron_3<Kernel,
+ *                            CGAL::Polyhedron_items_with_id_3> Polyhedron;
+ *
+ *   // read input mesh into a polyhedron surface
+ *   Polyhedron mesh;
+ *   {
+ *     HalfedgeMesh halfedgeMesh;
+ *     halfedgeMesh.ReadFromMatlab(matlabImport, inTRI, inX);
+ *     PolyhedronFromHalfedgeMesh<Polyhedron> builder(halfedgeMesh);
+ *     mesh.delegate(builder);
+ *   }
+ *
+ *   // ... process mesh ...
+ *
+ *   // write output mesh to Matlab
+ *   CopyPolyhedronTrianglesToMatlab(mesh, matlabExport, outTRI);
+ *   CopyPolyhedronVerticesToMatlab(mesh, matlabExport, outX);
+ *
+ */
+
+/*
+ * Author: Ramon Casero <rcasero@gmail.com>
+ * Copyright © 2013 University of Oxford
+ * Version: 0.1.3
+ *
+ * University of Oxford means the Chancellor, Masters and Scholars of
+ * the University of Oxford, having an administrative office at
+ * Wellington Square, Oxford OX1 2JD, UK.
+ *
+ * This file is part of Gerardus.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details. The offer of this
+ * program under the terms of the License is subject to the License
+ * being interpreted in accordance with English Law and subject to any
+ * action against the University of Oxford being under the jurisdiction
+ * of the English Courts.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see
+ * <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef HALFEDGEMESH_H
+#define HALFEDGEMESH_H
+
+/* mex headers */
+#include <mex.h>
+
+/* C++ headers */
+#include <algorithm>
+#include <string>
+#include <vector>
+
+/* Gerardus headers */
+#include "MatlabImportFilter.h"
+#include "MatlabExportFilter.h"
+
+/* CGAL headers */
+#include <CGAL/Modifier_base.h>
+#include <CGAL/HalfedgeDS_items_decorator.h>
+
+class HalfedgeMesh {
+
+ public:
+
+  typedef MatlabImportFilter::MatlabInputPointer MatlabInputPointer;
+
+  mwSize nv;                            // number of vertices
+  mwSize nf;                            // number of facets
+  std::vector<double> x;                // vertex coordinates (nv x 3, column-wise)
+  std::vector<mwIndex> tri;             // facet vertices, 0-based (nf x 3, column-wise)
+  std::vector<mwSignedIndex> opposite;  // opposite halfedge, or -1 for border halfedges
+
+  HalfedgeMesh() : nv(0), nf(0) {}
+
+  // halfedge after/before h in the same facet
+  mwIndex Next(mwIndex h) const { return (h + nf) % (3 * nf); }
+  mwIndex Prev(mwIndex h) const { return (h + 2 * nf) % (3 * nf); }
+
+  // facet the halfedge belongs to
+  mwIndex Facet(mwIndex h) const { return h % nf; }
+
+  // vertices at the start and end of the halfedge
+  mwIndex Source(mwIndex h) const { return tri[h]; }
+  mwIndex Target(mwIndex h) const { return tri[this->Next(h)]; }
+
+  // number of undirected edges (each border edge has only one
+  // halfedge). Requires the opposite halfedges
+  mwSize NumberOfEdges() const {
+    mwSize nborder = 0;
+    for (mwIndex h = 0; h < 3 * nf; ++h) {
+      nborder += (opposite[h] < 0);
+    }
+    return (3 * nf + nborder) / 2;
+  }
+
+  // read TRI, X from Matlab and compute the opposite halfedges
+  void ReadFromMatlab(MatlabImportFilter::Pointer matlabImport,
+		      MatlabInputPointer inTRI, MatlabInputPointer inX);
+
+  // compute the opposite halfedges of a mesh whose nv, nf, x, tri
+  // have been filled by the caller, and (if checkVertices) check that
+  // all vertices are manifold. errMsg is the beginning of the error
+  // message if the mesh is not a valid polyhedron
+  void ComputeOppositeHalfedges(const std::string &errMsg,
+				bool checkVertices = true);
+
+  // true if each vertex has only one fan of facets around it.
+  // Requires the opposite halfedges
+  bool HasManifoldVertices() const;
+
+ private:
+
+  template <class T>
+    void ReadVertices(const T *p);
+  template <class T>
+    void ReadTriangles(const T *p, const std::string &name);
+
+  // comparison of two halfedges by the highest vertex index of their
+  // edge
+  struct HighestVertexLess {
+    const HalfedgeMesh *mesh;
+    HighestVertexLess(const HalfedgeMesh *_mesh) : mesh(_mesh) {}
+    bool operator()(mwIndex h, mwIndex g) const {
+      return std::max(mesh->Source(h), mesh->Target(h))
+	< std::max(mesh->Source(g), mesh->Target(g));
+    }
+  };
+
+};
+
+// copy vertex coordinates from the Matlab buffer
+template <class T>
+void HalfedgeMesh::ReadVertices(const T *p) {
+  this->x.assign(p, p + 3 * this->nv);
+}
+
+// copy triangle indices from the Matlab buffer, checking that they are
+// valid Matlab indices, and converting them to C++ indices
+template <class T>
+void HalfedgeMesh::ReadTriangles(const T *p, const std::string &name) {
+  this->tri.resize(3 * this->nf);
+  for (mwIndex i = 0; i < 3 * this->nf; ++i) {
+    double v = (double)p[i];
+    if (mxIsNaN(v) || v < 1 || v > this->nv || v != (double)(mwIndex)v) {
+      mexErrMsgTxt(("Input " + name + ": Triangle indices must be integers between 1 and the number of vertices").c_str());
+    }
+    this->tri[i] = (mwIndex)v - 1;
+  }
+}
+
+inline
+void HalfedgeMesh::ReadFromMatlab(MatlabImportFilter::Pointer matlabImport,
+				  MatlabInputPointer inTRI, MatlabInputPointer inX) {
+
+  // get size of input matrices
+  if ((mxGetN(inTRI->pm) != 3) || (mxGetN(inX->pm) != 3)) {
+    mexErrMsgTxt("TRI and X inputs must have 3 columns");
+  }
+  this->nf = mxGetM(inTRI->pm);
+  this->nv = mxGetM(inX->pm);
+
+  // read vertex coordinates
+  switch (mxGetClassID(inX->pm)) {
+  case mxLOGICAL_CLASS:
+    this->ReadVertices((mxLogical *)mxGetData(inX->pm));
+    break;
+  case mxDOUBLE_CLASS:
+    this->ReadVertices((double *)mxGetData(inX->pm));
+    break;
+  case mxSINGLE_CLASS:
+    this->ReadVertices((float *)mxGetData(inX->pm));
+    break;
+  case mxINT8_CLASS:
+    this->ReadVertices((int8_T *)mxGetData(inX->pm));
+    break;
+  case mxUINT8_CLASS:
+    this->ReadVertices((uint8_T *)mxGetData(inX->pm));
+    break;
+  case mxINT16_CLASS:
+    this->ReadVertices((int16_T *)mxGetData(inX->pm));
+    break;
+  case mxUINT16_CLASS:
+    this->ReadVertices((uint16_T *)mxGetData(inX->pm));
+    break;
+  case mxINT32_CLASS:
+    this->ReadVertices((int32_T *)mxGetData(inX->pm));
+    break;
+  // case mxUINT32_CLASS:
+  // case mxINT64_CLASS:
+  // case mxUINT64_CLASS:
+  default:
+    mexErrMsgTxt(("Input " + inX->name + " has invalid type").c_str());
+  }
+  for (mwIndex i = 0; i < 3 * this->nv; ++i) {
+    if (mxIsNaN(this->x[i])) {
+      mexErrMsgTxt(("Input " + inX->name + ": Vertex coordinates are NaN").c_str());
+    }
+  }
+
+  // read triangles
+  switch (mxGetClassID(inTRI->pm)) {
+  case mxLOGICAL_CLASS:
+    this->ReadTriangles((mxLogical *)mxGetData(inTRI->pm), inTRI->name);
+    break;
+  case mxDOUBLE_CLASS:
+    this->ReadTriangles((double *)mxGetData(inTRI->pm), inTRI->name);
+    break;
+  case mxSINGLE_CLASS:
+    this->ReadTriangles((float *)mxGetData(inTRI->pm), inTRI->name);
+    break;
+  case mxINT8_CLASS:
+    this->ReadTriangles((int8_T *)mxGetData(inTRI->pm), inTRI->name);
+    break;
+  case mxUINT8_CLASS:
+    this->ReadTriangles((uint8_T *)mxGetData(inTRI->pm), inTRI->name);
+    break;
+  case mxINT16_CLASS:
+    this->ReadTriangles((int16_T *)mxGetData(inTRI->pm), inTRI->name);
+    break;
+  case mxUINT16_CLASS:
+    this->ReadTriangles((uint16_T *)mxGetData(inTRI->pm), inTRI->name);
+    break;
+  case mxINT32_CLASS:
+    this->ReadTriangles((int32_T *)mxGetData(inTRI->pm), inTRI->name);
+    break;
+  case mxINT64_CLASS:
+    this->ReadTriangles((int64_T *)mxGetData(inTRI->pm), inTRI->name);
+    break;
+  // case mxUINT32_CLASS:
+  // case mxUINT64_CLASS:
+  default:
+    mexErrMsgTxt(("Input " + inTRI->name + " has invalid type").c_str());
+  }
+
+  // connect each halfedge with its opposite
+  this->ComputeOppositeHalfedges("Inputs " + inTRI->name + " and " + inX->name
+				 + " do not form a valid polyhedron");
+
+}
+
+inline
+void HalfedgeMesh::ComputeOppositeHalfedges(const std::string &errMsg,
+					    bool checkVertices) {
+
+  const mwSize nh = 3 * this->nf;
+
+  // bucket sort of the halfedges by the lowest vertex of their
+  // edge. first[v] is the position in bucket of the first halfedge
+  // with lowest vertex v
+  std::vector<mwIndex> first(this->nv + 1, 0);
+  for (mwIndex h = 0; h < nh; ++h) {
+    if (this->Source(h) == this->Target(h)) {
+      mexErrMsgTxt((errMsg + ": Triangle with repeated vertices").c_str());
+    }
+    ++first[std::min(this->Source(h), this->Target(h)) + 1];
+  }
+  for (mwIndex v = 0; v < this->nv; ++v) {
+    first[v + 1] += first[v];
+  }
+  std::vector<mwIndex> bucket(nh);
+  {
+    std::vector<mwIndex> pos(first.begin(), first.end() - 1);
+    for (mwIndex h = 0; h < nh; ++h) {
+      bucket[pos[std::min(this->Source(h), this->Target(h))]++] = h;
+    }
+  }
+
+  // within each bucket, sort by the highest vertex, so that halfedges
+  // of the same edge are consecutive
+  this->opposite.assign(nh, -1);
+  for (mwIndex v = 0; v < this->nv; ++v) {
+
+    // exit if user pressed Ctrl+C
+    ctrlcCheckPoint(__FILE__, __LINE__);
+
+    std::vector<mwIndex>::iterator begin = bucket.begin() + first[v];
+    std::vector<mwIndex>::iterator end = bucket.begin() + first[v + 1];
+    std::sort(begin, end, HighestVertexLess(this));
+
+    // run through the groups of halfedges of the same edge
+    std::vector<mwIndex>::iterator it = begin;
+    while (it != end) {
+      std::vector<mwIndex>::iterator itEnd = it + 1;
+      while (itEnd != end && !HighestVertexLess(this)(*it, *itEnd)) {
+	++itEnd;
+      }
+
+      if (itEnd - it == 2) { // interior edge
+	mwIndex h = *it;
+	mwIndex g = *(it + 1);
+	if (this->Source(h) != this->Target(g)) {
+	  mexErrMsgTxt((errMsg + ": Adjacent triangles with inconsistent orientation").c_str());
+	}
+	this->opposite[h] = g;
+	this->opposite[g] = h;
+      } else if (itEnd - it > 2) {
+	mexErrMsgTxt((errMsg + ": Edge shared by more than two triangles").c_str());
+      }
+      // otherwise, it's a border edge and it has no opposite
+
+      it = itEnd;
+    }
+  }
+
+  if (checkVertices && !this->HasManifoldVertices()) {
+    mexErrMsgTxt((errMsg + ": Non-manifold vertex shared by several fans of triangles").c_str());
+  }
+
+}
+
+inline
+bool HalfedgeMesh::HasManifoldVertices() const {
+
+  const mwSize nh = 3 * this->nf;
+
+  // walk the fan of facets around the target vertex of each halfedge
+  // that has not been visited yet. Each vertex must have only one fan,
+  // otherwise it's a non-manifold vertex that a Polyhedron_3 cannot
+  // represent
+  std::vector<bool> isVisited(nh, false);
+  std::vector<bool> hasFan(this->nv, false);
+  for (mwIndex h = 0; h < nh; ++h) {
+    if (isVisited[h]) {
+      continue;
+    }
+    mwIndex v = this->Target(h);
+    if (hasFan[v]) {
+      return false;
+    }
+    hasFan[v] = true;
+
+    // forward, through the opposite of the halfedge that leaves v in
+    // the same facet, until we return to h or reach the border
+    mwIndex g = h;
+    do {
+      isVisited[g] = true;
+      mwSignedIndex o = this->opposite[this->Next(g)];
+      if (o < 0) {
+	break;
+      }
+      g = (mwIndex)o;
+    } while (g != h);
+
+    // backward, from h to the border, if the fan is open
+    g = h;
+    while (this->opposite[g] >= 0) {
+      g = this->Prev((mwIndex)this->opposite[g]);
+      if (isVisited[g]) {
+	break;
+      }
+      isVisited[g] = true;
+    }
+  }
+
+  return true;
+
+}
+
+/*
+ * PolyhedronFromHalfedgeMesh: modifier to create a CGAL::Polyhedron_3
+ * from a HalfedgeMesh, setting the halfedge pointers directly from
+ * the index arrays.
+ *
+ * After the polyhedron has been created, member border contains one
+ * border halfedge of the polyhedron per border edge of the mesh.
+ */
+template <class Polyhedron>
+class PolyhedronFromHalfedgeMesh : public CGAL::Modifier_base<typename Polyhedron::HalfedgeDS> {
+public:
+  typedef typename Polyhedron::HalfedgeDS                      HalfedgeDS;
+  typedef typename HalfedgeDS::Vertex                          Vertex;
+  typedef typename HalfedgeDS::Halfedge                        Halfedge;
+  typedef typename HalfedgeDS::Face                            Face;
+  typedef typename HalfedgeDS::Vertex_handle                   Vertex_handle;
+  typedef typename HalfedgeDS::Halfedge_handle                 Halfedge_handle;
+  typedef typename HalfedgeDS::Face_handle                     Face_handle;
+  typedef typename Halfedge::Base                              HBase;
+  typedef typename Vertex::Point                               Point;
+
+  const HalfedgeMesh &mesh;
+  std::vector<Halfedge_handle> border;
+
+  PolyhedronFromHalfedgeMesh(const HalfedgeMesh &_mesh) : mesh(_mesh) { }
+  void operator()(HalfedgeDS& hds) {
+
+    CGAL::HalfedgeDS_items_decorator<HalfedgeDS> decorator;
+
+    const mwSize nv = mesh.nv;
+    const mwSize nf = mesh.nf;
+    const mwSize nh = 3 * nf;
+
+    // border halfedges of the mesh, grouped by their end vertex. A
+    // manifold vertex has at most one border halfedge ending at it, so
+    // that the border halfedges can be chained unambiguously
+    std::vector<mwIndex> first(nv + 1, 0);
+    for (mwIndex h = 0; h < nh; ++h) {
+      if (mesh.opposite[h] < 0) {
+	if (++first[mesh.Target(h) + 1] > 1) {
+	  mexErrMsgTxt("Non-manifold vertex with more than one border of the mesh");
+	}
+      }
+    }
+    for (mwIndex v = 0; v < nv; ++v) {
+      first[v + 1] += first[v];
+    }
+    std::vector<mwIndex> borderByTarget(first[nv]);
+    std::vector<mwIndex> pos(first.begin(), first.end() - 1);
+    for (mwIndex h = 0; h < nh; ++h) {
+      if (mesh.opposite[h] < 0) {
+	borderByTarget[pos[mesh.Target(h)]++] = h;
+      }
+    }
+
+    // allocate space in the polyhedron
+    hds.reserve(nv, nh + first[nv], nf);
+
+    // add mesh vertices
+    std::vector<Vertex_handle> V(nv);
+    for (mwIndex v = 0; v < nv; ++v) {
+      V[v] = hds.vertices_push_back(Vertex(Point(mesh.x[v],
+						 mesh.x[v + nv],
+						 mesh.x[v + 2 * nv])));
+      decorator.set_vertex_halfedge(V[v], Halfedge_handle());
+    }
+
+    // add mesh facets
+    std::vector<Face_handle> F(nf);
+    for (mwIndex f = 0; f < nf; ++f) {
+      F[f] = hds.faces_push_back(Face());
+    }
+
+    // add edges. Each edge is a pair of opposite halfedges
+    std::vector<Halfedge_handle> H(nh);
+    std::vector<Halfedge_handle> B(nh); // border halfedge opposite to h
+    for (mwIndex h = 0; h < nh; ++h) {
+      mwSignedIndex g = mesh.opposite[h];
+      if (g < 0) {
+	H[h] = hds.edges_push_back(Halfedge(), Halfedge());
+	B[h] = H[h]->opposite();
+      } else if ((mwIndex)g > h) {
+	H[h] = hds.edges_push_back(Halfedge(), Halfedge());
+	H[g] = H[h]->opposite();
+      }
+    }
+
+    // connect facet halfedges
+    for (mwIndex h = 0; h < nh; ++h) {
+
+      // exit if user pressed Ctrl+C
+      ctrlcCheckPoint(__FILE__, __LINE__);
+
+      H[h]->HBase::set_next(H[mesh.Next(h)]);
+      decorator.set_prev(H[h], H[mesh.Prev(h)]);
+      H[h]->HBase::set_vertex(V[mesh.Target(h)]);
+      decorator.set_face(H[h], F[mesh.Facet(h)]);
+      decorator.set_vertex_halfedge(V[mesh.Target(h)], H[h]);
+    }
+    for (mwIndex f = 0; f < nf; ++f) {
+      decorator.set_face_halfedge(F[f], H[f]);
+    }
+
+    // connect border halfedges. The border halfedge opposite to h goes
+    // from Target(h) to Source(h), and it's followed by the border
+    // halfedge that starts at Source(h), i.e. the one opposite to a
+    // halfedge that ends at Source(h)
+    this->border.clear();
+    this->border.reserve(first[nv]);
+    for (mwIndex h = 0; h < nh; ++h) {
+      if (mesh.opposite[h] >= 0) {
+	continue;
+      }
+      mwIndex v = mesh.Source(h);
+      if (pos[v] == first[v]) {
+	mexErrMsgTxt("Border of the mesh is not a closed loop");
+      }
+      mwIndex g = borderByTarget[--pos[v]];
+      B[h]->HBase::set_next(B[g]);
+      decorator.set_prev(B[g], B[h]);
+      B[h]->HBase::set_vertex(V[v]);
+      decorator.set_face(B[h], Face_handle());
+      decorator.set_vertex_halfedge(V[v], B[h]);
+      this->border.push_back(B[h]);
+    }
+
+  }
+};
+
+/*
+ * CopyPolyhedronTrianglesToMatlab(): write the facets of a triangular
+ * polyhedron to a Matlab output TRI. Vertex indices follow the
+ * vertex order in the polyhedron. Polyhedron vertices must have an
+ * id() field.
+ */
+template <class Polyhedron>
+void CopyPolyhedronTrianglesToMatlab(Polyhedron &mesh,
+				     MatlabExportFilter::Pointer matlabExport,
+				     MatlabExportFilter::MatlabOutputPointer outTRI) {
+
+  // assign indices to the vertices
+  std::size_t inum = 0;
+  for (typename Polyhedron::Vertex_iterator vit = mesh.vertices_begin();
+       vit != mesh.vertices_end(); ++vit) {
+    vit->id() = inum++;
+  }
+
+  // allocate memory for Matlab output
+  const mwSize nf = mesh.size_of_facets();
+  double *tri = matlabExport->AllocateMatrixInMatlab<double>(outTRI, nf, 3);
+
+  // triangles given as (i,j,k), where each index corresponds to a vertex in x
+  // note that Matlab indices go like 1, 2, 3..., while C++ indices go like 0, 1, 2...
+  mwIndex row = 0;
+  for (typename Polyhedron::Facet_iterator fit = mesh.facets_begin();
+       fit != mesh.facets_end(); ++fit, ++row) {
+
+    typename Polyhedron::Halfedge_handle h = fit->halfedge();
+    if (h->next()->next()->next() != h) {
+      mexErrMsgTxt("Facet does not have 3 edges");
+    }
+
+    tri[row]          = 1 + h->vertex()->id();
+    tri[row + nf]     = 1 + h->next()->vertex()->id();
+    tri[row + 2 * nf] = 1 + h->next()->next()->vertex()->id();
+  }
+
+}
+
+/*
+ * CopyPolyhedronVerticesToMatlab(): write the vertex coordinates of a
+ * polyhedron to a Matlab output X.
+ */
+template <class Polyhedron>
+void CopyPolyhedronVerticesToMatlab(Polyhedron &mesh,
+				    MatlabExportFilter::Pointer matlabExport,
+				    MatlabExportFilter::MatlabOutputPointer outX) {
+
+  if (!outX->isRequested) {
+    return;
+  }
+
+  // allocate memory for Matlab output
+  const mwSize nv = mesh.size_of_vertices();
+  double *x = matlabExport->AllocateMatrixInMatlab<double>(outX, nv, 3);
+
+  mwIndex row = 0;
+  for (typename Polyhedron::Vertex_iterator vit = mesh.vertices_begin();
+       vit != mesh.vertices_end(); ++vit, ++row) {
+    x[row]          = CGAL::to_double(vit->point().x());
+    x[row + nv]     = CGAL::to_double(vit->point().y());
+    x[row + 2 * nv] = CGAL::to_double(vit->point().z());
+  }
+
+}
+
+#endif /* HALFEDGEMESH_H */
@@ -22,6 +22,9 @@ function varargout = cgal_alpha_shape3(varargin)
 %
 %     >> trisurf(tri{1}, x)
 %
+%   If TRI is not requested, e.g. ALPHALIM = cgal_alpha_shape3(X), no
+%   surface triangulation is extracted, which is faster.
+%
 %
 % [~, TRI] = cgal_alpha_shape3(X, ALPHA)
 %
@@ -29,6 +32,17 @@ function varargout = cgal_alpha_shape3(varargin)
 %   probe radius. TRI is a cell array of the same length as ALPHA. Cell
 %   TRI{i} contains the alpha shape triangulation for ALPHA{i}.
 %
+% [~, ~, TIMES] = cgal_alpha_shape3(...)
+%
+%   TIMES is a 2-vector with the wall-clock time in seconds spent building the
+%   Delaunay triangulation, TIMES(1), and computing the alpha shape and
+%   extracting the surface triangulations, TIMES(2).
+%
+% The points are sorted spatially (BRIO with a Hilbert curve sort) before
+% they are inserted in the Delaunay triangulation. Thus, the order of the
+% points in X (e.g. raster order in points extracted from a segmentation)
+% does not slow down the triangulation.
+%
 % This function uses CGAL's implementation of non-fixed alpha shapes [1].
 % With non-fixed alpha shapes, the result for all alpha values is computed
 % internally, and then only those the solutions requested by the user are
@@ -46,7 +60,7 @@ function varargout = cgal_alpha_shape3(varargin)
 
 % Author: Ramon Casero <rcasero@gmail.com>
 % Copyright © 2013 University of Oxford
-% Version: 0.1.1
+% Version: 0.2.1
 %
 % University of Oxford means the Chancellor, Masters and Scholars of
 % the University of Oxford, having an administrative office at
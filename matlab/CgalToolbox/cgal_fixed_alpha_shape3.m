@@ -16,6 +16,16 @@ function varargout = cgal_fixed_alpha_shape3(varargin)
 %
 %     >> trisurf(tri{i}, x)
 %
+% [TRI, TIMES] = cgal_fixed_alpha_shape3(X, ALPHA)
+%
+%   TIMES is a 2-vector with the wall-clock time in seconds spent building the
+%   Delaunay triangulation, TIMES(1), and computing the alpha shapes and
+%   extracting the surface triangulations, TIMES(2).
+%
+% The points are sorted spatially (BRIO with a Hilbert curve sort) before
+% they are inserted in the Delaunay triangulation. Thus, the order of the
+% points in X (e.g. raster order in points extracted from a segmentation)
+% does not slow down the triangulation.
 %
 % This function uses CGAL's implementation of fixed alpha shapes [1]. Fixed
 % alpha shapes are more efficient when only the shape for one or a few
@@ -33,7 +43,7 @@ function varargout = cgal_fixed_alpha_shape3(varargin)
 
 % Author: Ramon Casero <rcasero@gmail.com>
 % Copyright © 2013 University of Oxford
-% Version: 0.1.0
+% Version: 0.2.1
 %
 % University of Oxford means the Chancellor, Masters and Scholars of
 % the University of Oxford, having an administrative office at
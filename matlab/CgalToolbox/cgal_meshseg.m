@@ -77,6 +77,26 @@ function varargout = cgal_meshseg(varargin)
 %     with the tag Manifold_tag the function template make_surface_mesh
 %     ensures that the output mesh is a manifold surface without boundary".
 %
+% [TRI, X] = cgal_meshseg(..., MANIFOLD, LABELS)
+%
+%   LABELS is a vector of label values. With this syntax, IM is
+%   considered a multi-label segmentation, and one surface is meshed for
+%   each label. TRI and X are then cell arrays with one mesh per label,
+%   i.e. TRI{I}, X{I} is the mesh of the voxels IM==LABELS(I). Labels
+%   not present in the image produce empty meshes.
+%
+%   Each label is meshed as a binary mask (label=1, rest=0), cropped to
+%   the label's bounding box plus a 2-voxel margin, so ISOVAL should be
+%   between 0 and 1 (by default, ISOVAL=0.5). The bounding boxes and
+%   centroids of all labels are computed in a single pass over the
+%   image, in parallel with OpenMP, and each label is meshed in its
+%   cropped box. This is faster than calling cgal_meshseg once per
+%   label. The labels are meshed one after the other, because the CGAL
+%   surface mesher is not thread-safe.
+%
+%   In this mode, C is either empty (the centroid of each label is used)
+%   or a 3-column matrix with one bounding sphere centre per label.
+%
 % Important!
 %
 % Note that this function can produce meshes with (1) stray vertices that
@@ -92,7 +112,7 @@ function varargout = cgal_meshseg(varargin)
 
 % Author: Ramon Casero <rcasero@gmail.com>
 % Copyright © 2013 University of Oxford
-% Version: 0.1.1
+% Version: 0.2.1
 %
 % University of Oxford means the Chancellor, Masters and Scholars of
 % the University of Oxford, having an administrative office at
@@ -18,7 +18,7 @@ function varargout = cgal_tri_simplify(varargin)
 % when a user-supplied stop predicate is met, such as reaching the desired
 % number of edges."
 %
-% [TRI2, X2] = cgal_tri_simplify(TRI, X, RATIO)
+% [TRI2, X2] = cgal_tri_simplify(TRI, X, RATIO, NPATCH)
 %
 %   TRI is a 3-column matrix. Each row contains the 3 nodes that form one
 %   triangular facet in the mesh.
@@ -28,7 +28,19 @@ function varargout = cgal_tri_simplify(varargin)
 %
 %   RATIO is a scalar with the stop criterion. The algorithm will stop when
 %   the number of current undirected edges is RATIO * number of original
-%   undirected edges.
+%   undirected edges. By default, RATIO=0.1.
+%
+%   NPATCH is an integer with the number of patches the mesh is split
+%   into. By default, NPATCH=1, and the whole mesh is simplified in one
+%   pass. With NPATCH > 1, the facets are split into NPATCH spatially
+%   compact patches by recursive bisection of their centroids. The
+%   patches are simplified one after the other, with the vertices on the
+%   seams between patches locked. Then a final pass over the whole mesh
+%   collapses edges across the seams until the stop criterion is met.
+%   The stop criterion is the same as for NPATCH=1, but the output mesh
+%   is not identical. The patches are not simplified in parallel,
+%   because the CGAL 4.2 edge collapse is not thread-safe, so NPATCH > 1
+%   is not faster than NPATCH=1.
 %
 %   TRI2, X2 is the description of the simplified output mesh.
 %
@@ -36,7 +48,7 @@ function varargout = cgal_tri_simplify(varargin)
 
 % Author: Ramon Casero <rcasero@gmail.com>
 % Copyright © 2013 University of Oxford
-% Version: 0.1.0
+% Version: 0.2.3
 %
 % University of Oxford means the Chancellor, Masters and Scholars of
 % the University of Oxford, having an administrative office at
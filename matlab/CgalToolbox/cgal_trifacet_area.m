@@ -1,20 +1,43 @@
-function a = cgal_trifacet_area(tri, x)
-% CGAL_TRIFACET_AREA  Area of the facets in a triangular mesh
+function [a, n, v, lmin, lmax, c] = cgal_trifacet_area(tri, x)
+% CGAL_TRIFACET_AREA  Area and other measures of the facets in a
+% triangular mesh
 %
-% A = cgal_trifacet_area(TRI, X)
+% [A, N, V, LMIN, LMAX, C] = cgal_trifacet_area(TRI, X)
 %
 %   TRI is a 3-column matrix. Each row contains the 3 nodes that form one
-%   triangular facet in the mesh.
+%   triangular facet in the mesh. TRI can be of any integer or
+%   floating-point class.
 %
 %   X is a 3-column matrix. X(i, :) contains the xyz-coordinates of the
 %   i-th node in the mesh.
 %
 %   A is a vector with the same number of rows as TRI. A(i) is the area of
 %   the triangle TRI(i).
+%
+%   N is a 3-column matrix. N(i, :) is the unit normal vector of triangle
+%   TRI(i), following the right-hand rule with the order of its
+%   vertices. Degenerate triangles have NaN normals.
+%
+%   V is a vector. V(i) is the signed volume of the tetrahedron formed by
+%   triangle TRI(i) and the origin of coordinates. If the mesh is closed
+%   and the facets are oriented with the normals pointing outwards,
+%   sum(V) is the volume enclosed by the mesh.
+%
+%   LMIN, LMAX are vectors. LMIN(i), LMAX(i) are the lengths of the
+%   shortest and longest edges of triangle TRI(i).
+%
+%   C is a 3-column matrix. C(i, :) is the centroid of triangle TRI(i).
+%
+% All the measures are computed in a single pass over the mesh, and
+% only the requested outputs are computed, e.g.
+%
+%   [A, N] = cgal_trifacet_area(TRI, X);
+%
+% does not compute the volumes, edge lengths or centroids.
 
 % Author: Ramon Casero <rcasero@gmail.com>
 % Copyright © 2013 University of Oxford
-% Version: 0.1.0
+% Version: 0.2.1
 %
 % University of Oxford means the Chancellor, Masters and Scholars of
 % the University of Oxford, having an administrative office at
@@ -0,0 +1,426 @@
+/*
+ * TotalVariationDenoiser.h
+ *
+ * TotalVariationDenoiser: denoising of a 2D or 3D image with total
+ * variation (TV) or second order total generalised variation (TGV)
+ * regularisation.
+ *
+ * The denoised image u is the solution of
+ *
+ *   min_u 1/2 ||u - f||^2 + lambda R(u)
+ *
+ * where f is the noisy image, and R(u) is the TV of forward_TV.m or
+ * the TGV of forward_TGV.m (with periodic boundary conditions). The
+ * problem is solved with the accelerated primal-dual algorithm of
+ * Chambolle and Pock (2011) [Algorithm 2], that alternates
+ *
+ *   p  <- proj(p + sigma K ubar)                 (dual ascent)
+ *   u' <- (u - tau K' p + tau f) / (1 + tau)     (primal prox)
+ *   ubar <- u' + theta (u' - u)                  (extrapolation)
+ *
+ * where K is the gradient of the regulariser, K' its adjoint, and
+ * proj clips each dual component to [-lambda w, lambda w], with w = 2
+ * for the mixed derivatives of TGV and w = 1 otherwise.
+ *
+ * All buffers are allocated once. Each half-step is a single fused
+ * sweep through the image with the kernels of TotalVariationKernels,
+ * and the primal sweep also computes the change of u. Images of class
+ * single are denoised in single precision, which halves the memory.
+ *
+ * The algorithm stops on the primal-dual gap
+ *
+ *   G(u, p) = 1/2 ||u - f||^2 + lambda R(u) - 1/2 ||f||^2 + 1/2 ||f - K' p||^2
+ *
+ * As the data term is 1-strongly convex, ||u - u*||^2 <= 2 G(u, p),
+ * where u* is the exact solution. The algorithm stops when this bound
+ * relative to ||f|| is below the tolerance. The gap needs a third
+ * sweep, so it is only computed every few iterations. The bound is an
+ * upper bound, not an estimate: it can be from a few times to about
+ * 100 times larger than the actual error, the more so for TGV in 3D,
+ * so the algorithm can run longer than needed. The change of u between
+ * iterations is not a good criterion either, because the step size
+ * tau decreases with the acceleration, and the change becomes small
+ * long before u is close to u*.
+ *
+ * The dual variable of TGV is stored scaled by the constants of
+ * inverse_TGV.m, so that TotalVariationKernels::SecondOrderDivergence
+ * is the exact adjoint of SecondOrderGradient.
+ *
+ * A. Chambolle and T. Pock, "A first-order primal-dual algorithm for
+ * convex problems with applications to imaging", Journal of
+ * Mathematical Imaging and Vision, 40(1):120-145, 2011.
+ *
+ * An example of how to use this class in a MEX Matlab function:
+ *
+ *   TotalVariationDenoiser<float> denoiser(ndims, dims,
+ *       TotalVariationDenoiser<float>::TV);
+ *   denoiser.SetLambda(0.1);
+ *   denoiser.Denoise(f, u);
+ *
+ */
+
+/*
+ * Author: Ramon Casero <rcasero@gmail.com>
+ * Copyright © 2014 University of Oxford
+ * Version: 0.3.0
+ *
+ * University of Oxford means the Chancellor, Masters and Scholars of
+ * the University of Oxford, having an administrative office at
+ * Wellington Square, Oxford OX1 2JD, UK.
+ *
+ * This file is part of Gerardus.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details. The offer of this
+ * program under the terms of the License is subject to the License
+ * being interpreted in accordance with English Law and subject to any
+ * action against the University of Oxford being under the jurisdiction
+ * of the English Courts.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef TOTALVARIATIONDENOISER_H
+#define TOTALVARIATIONDENOISER_H
+
+/* mex headers */
+#include <mex.h>
+
+/* C++ headers */
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+/* Gerardus headers */
+#include "TotalVariationKernels.h"
+
+template <class T>
+class TotalVariationDenoiser : public TotalVariationKernels<T> {
+
+ public:
+
+  enum RegulariserType {TV, TGV};
+
+  // ndims: number of dimensions of the image (up to 3)
+  // dims:  size of the image, (R, C[, S])
+  // type:  regulariser
+  TotalVariationDenoiser(mwSize ndims, const mwSize *dims, RegulariserType type);
+
+  // weight of the regulariser (default 0.1)
+  void SetLambda(double _lambda) {
+    this->lambda = _lambda;
+  }
+
+  // maximum number of iterations (default 2000 for TV, 20000 for
+  // TGV, which converges more slowly)
+  void SetMaximumNumberOfIterations(mwSize _maxIter) {
+    this->maxIter = _maxIter;
+  }
+
+  // the algorithm stops when sqrt(2 G(u, p)) / ||f|| < tol, a bound of
+  // ||u - u*|| / ||f|| (default 1e-3). With tol = 0, the gap is not
+  // computed, and the algorithm runs the maximum number of iterations
+  void SetTolerance(double _tol) {
+    this->tol = _tol;
+  }
+
+  // the gap is computed every gapInterval iterations, and at the last
+  // iteration (default 10)
+  void SetGapInterval(mwSize _gapInterval) {
+    this->gapInterval = std::max(_gapInterval, (mwSize)1);
+  }
+
+  // f: noisy image
+  // u: denoised image
+  void Denoise(const T *f, T *u);
+
+  // relative change ||u' - u|| / ||f|| at each iteration of the last
+  // call to Denoise()
+  const std::vector<double> &GetChange() const {
+    return this->change;
+  }
+
+  // error bound sqrt(2 G(u, p)) / ||f|| at the iterations where the
+  // gap was computed in the last call to Denoise(), and those
+  // iterations (1, 2, ...). Empty if tol = 0
+  const std::vector<double> &GetErrorBound() const {
+    return this->errorBound;
+  }
+  const std::vector<mwSize> &GetErrorBoundIteration() const {
+    return this->errorBoundIteration;
+  }
+
+  // whether the last call to Denoise() stopped with the error bound
+  // below the tolerance. False if tol = 0
+  bool IsConverged() const {
+    return this->converged;
+  }
+
+ private:
+
+  typedef typename TotalVariationKernels<T>::Neighbourhood Neighbourhood;
+
+  RegulariserType type;
+  double lambda;
+  mwSize maxIter;
+  double tol;
+  mwSize gapInterval;
+  std::vector<double> change;
+  std::vector<double> errorBound;
+  std::vector<mwSize> errorBoundIteration;
+  bool converged;
+
+  // number of components of the dual variable, their bounds
+  // (lambda w) without lambda, and the scaling of the stored dual
+  // variable
+  unsigned int ncomp;
+  double weight[6];
+  double scale[6];
+
+  // squared norm of K
+  double normK2;
+
+  // extrapolated image and dual variable. They are allocated once,
+  // and kept between calls to Denoise()
+  std::vector<T> ubar;
+  std::vector<T> p;
+
+  // p <- proj(p + sigma K ubar)
+  struct DualKernel {
+    const T *ubar; T *p[6];
+    unsigned int ncomp; bool is3D; RegulariserType type;
+    double sigma; double bound[6]; double scale[6];
+    double operator()(const Neighbourhood &nb, mwIndex i) const;
+  };
+
+  // u <- (u - tau K' p + tau f) / (1 + tau), ubar <- u + theta (u - u_old)
+  struct PrimalKernel {
+    const T *p[6]; const T *f; T *u; T *ubar;
+    bool is3D; RegulariserType type;
+    double tau, theta;
+    double operator()(const Neighbourhood &nb, mwIndex i) const;
+  };
+
+  // contribution of voxel i to G(u, p)
+  struct GapKernel {
+    const T *u; const T *f; const T *p[6];
+    unsigned int ncomp; bool is3D; RegulariserType type;
+    double bound[6];
+    double operator()(const Neighbourhood &nb, mwIndex i) const;
+  };
+
+};
+
+/*
+ * Definitions
+ */
+
+template <class T>
+TotalVariationDenoiser<T>::TotalVariationDenoiser(mwSize ndims, const mwSize *dims,
+						  RegulariserType _type)
+  : TotalVariationKernels<T>(ndims, dims), type(_type), lambda(0.1),
+    maxIter((_type == TV) ? 2000 : 20000), tol(1e-3), gapInterval(10),
+    converged(false) {
+
+  // |Dx|^2 <= 4 for a periodic forward difference, so ||K||^2 <= 4
+  // per dimension for TV, and 16 per second order derivative for TGV
+  // (counting the mixed derivatives Dxy = Dyx twice)
+  const unsigned int ndimsImage = this->Is3D() ? 3 : 2;
+  if (this->type == TV) {
+    this->ncomp = 3;
+    for (unsigned int k = 0; k < this->ncomp; ++k) {
+      this->weight[k] = 1.0;
+      this->scale[k] = 1.0;
+    }
+    this->normK2 = 4.0 * ndimsImage;
+  } else {
+    // SecondOrderDivergence() divides by ndimsImage^2 and counts the
+    // mixed derivatives twice, so the dual variable is stored scaled
+    // by ndimsImage^2 (diagonal) or ndimsImage^2 / 2 (mixed)
+    this->ncomp = this->GetNumberOfSecondOrderComponents();
+    const double d2 = (double)(ndimsImage * ndimsImage);
+    for (unsigned int k = 0; k < this->ncomp; ++k) {
+      bool isDiagonal = this->Is3D() ? (k == 0 || k == 3 || k == 5) : (k != 1);
+      this->weight[k] = isDiagonal ? 1.0 : 2.0;
+      this->scale[k] = isDiagonal ? d2 : d2 / 2.0;
+    }
+    this->normK2 = 16.0 * ndimsImage * (ndimsImage + 1) / 2;
+  }
+
+}
+
+template <class T>
+double TotalVariationDenoiser<T>::DualKernel::operator()(const Neighbourhood &nb,
+							  mwIndex i) const {
+
+  double g[6];
+  if (this->type == TV) {
+    TotalVariationKernels<T>::GradientAt(this->ubar, nb, g);
+  } else {
+    TotalVariationKernels<T>::SecondOrderGradientAt(this->ubar, nb, this->is3D, g);
+  }
+  for (unsigned int k = 0; k < this->ncomp; ++k) {
+    double pk = (double)this->p[k][i] + this->sigma * this->scale[k] * g[k];
+    this->p[k][i] = (T)std::min(std::max(pk, -this->bound[k]), this->bound[k]);
+  }
+
+  return 0.0;
+
+}
+
+template <class T>
+double TotalVariationDenoiser<T>::PrimalKernel::operator()(const Neighbourhood &nb,
+							    mwIndex i) const {
+
+  double div;
+  if (this->type == TV) {
+    div = TotalVariationKernels<T>::DivergenceAt(this->p[0], this->p[1], this->p[2], nb);
+  } else {
+    div = TotalVariationKernels<T>::SecondOrderDivergenceAt(this->p, nb, this->is3D);
+  }
+  const double uOld = this->u[i];
+  const double uNew = (uOld - this->tau * div + this->tau * this->f[i]) / (1.0 + this->tau);
+  this->u[i] = (T)uNew;
+  this->ubar[i] = (T)(uNew + this->theta * (uNew - uOld));
+
+  return (uNew - uOld) * (uNew - uOld);
+
+}
+
+template <class T>
+double TotalVariationDenoiser<T>::GapKernel::operator()(const Neighbourhood &nb,
+							 mwIndex i) const {
+
+  // lambda R(u) at the voxel. The bounds of the dual variable are
+  // lambda w
+  double g[6];
+  if (this->type == TV) {
+    TotalVariationKernels<T>::GradientAt(this->u, nb, g);
+  } else {
+    TotalVariationKernels<T>::SecondOrderGradientAt(this->u, nb, this->is3D, g);
+  }
+  double reg = 0.0;
+  for (unsigned int k = 0; k < this->ncomp; ++k) {
+    reg += this->bound[k] * std::fabs(g[k]);
+  }
+
+  // K' p at the voxel
+  double div;
+  if (this->type == TV) {
+    div = TotalVariationKernels<T>::DivergenceAt(this->p[0], this->p[1], this->p[2], nb);
+  } else {
+    div = TotalVariationKernels<T>::SecondOrderDivergenceAt(this->p, nb, this->is3D);
+  }
+
+  // -1/2 f^2 + 1/2 (f - div)^2 is expanded, to avoid the cancellation
+  // of the f^2 terms
+  const double ui = this->u[i];
+  const double fi = this->f[i];
+  return 0.5 * (ui - fi) * (ui - fi) + reg + 0.5 * div * div - fi * div;
+
+}
+
+template <class T>
+void TotalVariationDenoiser<T>::Denoise(const T *f, T *u) {
+
+  const mwSize nvox = this->GetNumberOfVoxels();
+  this->change.clear();
+  this->errorBound.clear();
+  this->errorBoundIteration.clear();
+  this->converged = false;
+
+  // initialise the primal variables with the noisy image, and the dual
+  // variable with zeros
+  double normF2 = 0.0;
+#ifdef _OPENMP
+#pragma omp parallel for reduction(+:normF2)
+#endif
+  for (mwSignedIndex i = 0; i < (mwSignedIndex)nvox; ++i) {
+    u[i] = f[i];
+    normF2 += (double)f[i] * (double)f[i];
+  }
+  if (normF2 == 0.0 || this->lambda <= 0.0) {
+    // u = f is the exact solution
+    this->converged = true;
+    return;
+  }
+  this->ubar.assign(f, f + nvox);
+  this->p.assign(this->ncomp * nvox, (T)0);
+
+  DualKernel dual;
+  dual.ubar = &this->ubar[0];
+  dual.ncomp = this->ncomp;
+  dual.is3D = this->Is3D();
+  dual.type = this->type;
+  for (unsigned int k = 0; k < this->ncomp; ++k) {
+    dual.p[k] = &this->p[k * nvox];
+    dual.bound[k] = this->lambda * this->weight[k] * this->scale[k];
+    dual.scale[k] = this->scale[k];
+  }
+
+  PrimalKernel primal;
+  for (unsigned int k = 0; k < this->ncomp; ++k) {
+    primal.p[k] = &this->p[k * nvox];
+  }
+  primal.f = f;
+  primal.u = u;
+  primal.ubar = &this->ubar[0];
+  primal.is3D = this->Is3D();
+  primal.type = this->type;
+
+  GapKernel gap;
+  gap.u = u;
+  gap.f = f;
+  gap.ncomp = this->ncomp;
+  gap.is3D = this->Is3D();
+  gap.type = this->type;
+  for (unsigned int k = 0; k < this->ncomp; ++k) {
+    gap.p[k] = &this->p[k * nvox];
+    gap.bound[k] = this->lambda * this->weight[k];
+  }
+
+  // step sizes, tau sigma ||K||^2 <= 1. The data term is 1-strongly
+  // convex, so the steps are accelerated with gamma = 1
+  const double gamma = 1.0;
+  double tau = 1.0 / std::sqrt(this->normK2);
+  double sigma = tau;
+  const double normF = std::sqrt(normF2);
+
+  for (mwSize iter = 0; iter < this->maxIter; ++iter) {
+
+    dual.sigma = sigma;
+    this->Sweep(dual);
+
+    const double theta = 1.0 / std::sqrt(1.0 + 2.0 * gamma * tau);
+    primal.tau = tau;
+    primal.theta = theta;
+    const double delta = std::sqrt(this->Sweep(primal)) / normF;
+    this->change.push_back(delta);
+
+    tau *= theta;
+    sigma /= theta;
+
+    if (this->tol > 0.0
+	&& ((iter + 1) % this->gapInterval == 0 || iter + 1 == this->maxIter)) {
+      const double bound = std::sqrt(2.0 * std::max(this->Sweep(gap), 0.0)) / normF;
+      this->errorBound.push_back(bound);
+      this->errorBoundIteration.push_back(iter + 1);
+      if (bound < this->tol) {
+	this->converged = true;
+	break;
+      }
+    }
+
+  }
+
+}
+
+#endif /* TOTALVARIATIONDENOISER_H */
@@ -0,0 +1,441 @@
+/*
+ * TotalVariationKernels.h
+ *
+ * TotalVariationKernels: finite difference operators of total
+ * variation (TV) and second order total generalised variation (TGV)
+ * on 2D and 3D images, with periodic boundary conditions.
+ *
+ * These are the operators of forward_TV.m, inverse_TV.m, forward_TGV.m
+ * and inverse_TGV.m, with the same definitions:
+ *
+ *   Gradient():              Dx = I(r+1,c,s) - I(r,c,s), and the same
+ *                            for Dy, Dz. Returns the TV, sum |Dx| +
+ *                            |Dy| + |Dz|
+ *   Divergence():            adjoint of Gradient(),
+ *                            Dx(r-1,c,s) - Dx(r,c,s) + ...
+ *   SecondOrderGradient():   Dxx, Dxy, Dyy (2D) or Dxx, Dxy, Dxz, Dyy,
+ *                            Dyz, Dzz (3D). Returns the TGV, where the
+ *                            mixed derivatives count double
+ *   SecondOrderDivergence(): the inverse_TGV.m operator
+ *
+ * Each operator is computed in a single sweep through the image. The
+ * differences, the periodic boundaries and the sum are fused, without
+ * intermediate arrays. Image columns are processed in parallel with
+ * OpenMP, and the rows of each column, which are contiguous in
+ * memory, in the inner loop. Only the two rows at each end of a
+ * column need wrapped indices; the interior rows use plain offsets.
+ * Indices are mwIndex, so images can have more than 2^31 voxels.
+ *
+ * Derived classes can fuse their own computations with the operators,
+ * by applying Sweep() with a kernel that calls the per-voxel
+ * GradientAt(), DivergenceAt(), etc. See TotalVariationDenoiser.h.
+ *
+ * An example of how to use this class in a MEX Matlab function:
+ *
+ *   TotalVariationKernels<double> tv(mxGetNumberOfDimensions(prhs[0]),
+ *                                    mxGetDimensions(prhs[0]));
+ *   double TV = tv.Gradient(im, dx, dy, dz);
+ *   tv.Divergence(dx, dy, dz, res);
+ *
+ */
+
+/*
+ * Author: Ramon Casero <rcasero@gmail.com>
+ * Copyright © 2014 University of Oxford
+ * Version: 0.2.0
+ *
+ * University of Oxford means the Chancellor, Masters and Scholars of
+ * the University of Oxford, having an administrative office at
+ * Wellington Square, Oxford OX1 2JD, UK.
+ *
+ * This file is part of Gerardus.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details. The offer of this
+ * program under the terms of the License is subject to the License
+ * being interpreted in accordance with English Law and subject to any
+ * action against the University of Oxford being under the jurisdiction
+ * of the English Courts.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef TOTALVARIATIONKERNELS_H
+#define TOTALVARIATIONKERNELS_H
+
+/* mex headers */
+#include <mex.h>
+
+/* C++ headers */
+#include <cmath>
+
+template <class T>
+class TotalVariationKernels {
+
+ public:
+
+  // ndims: number of dimensions of the image (up to 3)
+  // dims:  size of the image, (R, C[, S])
+  TotalVariationKernels(mwSize ndims, const mwSize *dims);
+
+  mwSize GetNumberOfVoxels() const {
+    return this->n[0] * this->n[1] * this->n[2];
+  }
+
+  // the image is 3D if it has more than one slice
+  bool Is3D() const {
+    return this->n[2] > 1;
+  }
+
+  // number of second order derivatives, 3 in 2D and 6 in 3D
+  unsigned int GetNumberOfSecondOrderComponents() const {
+    return this->Is3D() ? 6 : 3;
+  }
+
+  // im:         input image
+  // dx, dy, dz: forward differences along rows, columns and slices
+  //
+  // returns the total variation of im
+  double Gradient(const T *im, T *dx, T *dy, T *dz) const;
+
+  // dx, dy, dz: forward differences, e.g. from Gradient()
+  // res:        adjoint of the gradient applied to (dx, dy, dz)
+  void Divergence(const T *dx, const T *dy, const T *dz, T *res) const;
+
+  // im: input image
+  // d2: GetNumberOfSecondOrderComponents() arrays with the second
+  //     order derivatives, in the order of forward_TGV.m
+  //
+  // returns the second order total generalised variation of im
+  double SecondOrderGradient(const T *im, T *const *d2) const;
+
+  // d2:  second order derivatives, e.g. from SecondOrderGradient()
+  // res: the inverse_TGV.m operator applied to d2
+  void SecondOrderDivergence(const T *const *d2, T *res) const;
+
+ protected:
+
+  // image size, (R, C, S)
+  mwSize n[3];
+
+  // offsets of the neighbours of a voxel, from -2 to +2 along each
+  // dimension. off[dc + 2][ds + 2] is the offset of the column and
+  // slice, and row[dr + 2] the index of the row
+  struct Neighbourhood {
+    mwIndex off[5][5];
+    mwIndex row[5];
+  };
+
+  // value of the neighbour (dr, dc, ds) of the voxel
+  static T At(const T *p, const Neighbourhood &nb, int dr, int dc, int ds) {
+    return p[nb.off[dc + 2][ds + 2] + nb.row[dr + 2]];
+  }
+
+  // index i + k, with periodic boundary conditions
+  static mwIndex Wrap(mwIndex i, int k, mwSize len) {
+    return (mwIndex)(((mwSignedIndex)i + k + 2 * (mwSignedIndex)len) % (mwSignedIndex)len);
+  }
+
+  // apply kernel to every voxel of the image, and return the sum of
+  // its outputs. A kernel is a functor
+  //
+  //   double operator()(const Neighbourhood &nb, mwIndex i) const
+  //
+  // that computes the output at voxel i, and returns its contribution
+  // to the sum. It can read any neighbour of the voxel in its inputs,
+  // but must only write to voxel i of its outputs
+  template <class TKernel>
+  double Sweep(const TKernel &kernel) const;
+
+  // the operators at one voxel
+  //
+  // g:  3-vector with the forward differences
+  // d2: 3-vector (2D) or 6-vector (3D) with the second order derivatives
+  static void GradientAt(const T *im, const Neighbourhood &nb, double *g);
+  static double DivergenceAt(const T *dx, const T *dy, const T *dz,
+			     const Neighbourhood &nb);
+  static void SecondOrderGradientAt(const T *im, const Neighbourhood &nb,
+				    bool is3D, double *d2);
+  static double SecondOrderDivergenceAt(const T *const *d2, const Neighbourhood &nb,
+					bool is3D);
+
+ private:
+
+  // kernels of the public operators
+  struct GradientKernel {
+    const T *im; T *dx, *dy, *dz;
+    double operator()(const Neighbourhood &nb, mwIndex i) const;
+  };
+  struct DivergenceKernel {
+    const T *dx, *dy, *dz; T *res;
+    double operator()(const Neighbourhood &nb, mwIndex i) const;
+  };
+  struct SecondOrderGradientKernel {
+    const T *im; T *const *d2; bool is3D;
+    double operator()(const Neighbourhood &nb, mwIndex i) const;
+  };
+  struct SecondOrderDivergenceKernel {
+    const T *const *d2; T *res; bool is3D;
+    double operator()(const Neighbourhood &nb, mwIndex i) const;
+  };
+
+};
+
+/*
+ * Definitions
+ */
+
+template <class T>
+TotalVariationKernels<T>::TotalVariationKernels(mwSize ndims, const mwSize *dims) {
+
+  if (ndims > 3) {
+    mexErrMsgTxt("TotalVariationKernels: Image cannot have more than 3 dimensions");
+  }
+  for (mwSize d = 0; d < 3; ++d) {
+    this->n[d] = (d < ndims) ? dims[d] : 1;
+  }
+
+}
+
+template <class T>
+template <class TKernel>
+double TotalVariationKernels<T>::Sweep(const TKernel &kernel) const {
+
+  const mwSize n0 = this->n[0];
+  const mwSize n1 = this->n[1];
+  const mwSize n2 = this->n[2];
+  const mwSize ncols = n1 * n2;
+  double sum = 0.0;
+
+  if (n0 == 0 || ncols == 0) {
+    return sum;
+  }
+
+  // each column of each slice is processed by one thread
+#ifdef _OPENMP
+#pragma omp parallel for reduction(+:sum)
+#endif
+  for (mwSignedIndex k = 0; k < (mwSignedIndex)ncols; ++k) {
+    const mwIndex c = (mwIndex)k % n1;
+    const mwIndex s = (mwIndex)k / n1;
+
+    Neighbourhood nb;
+    for (int dc = -2; dc <= 2; ++dc) {
+      for (int ds = -2; ds <= 2; ++ds) {
+	nb.off[dc + 2][ds + 2] = (Wrap(s, ds, n2) * n1 + Wrap(c, dc, n1)) * n0;
+      }
+    }
+    const mwIndex first = (s * n1 + c) * n0;
+    double colSum = 0.0;
+
+    // first and last two rows, with periodic boundary conditions
+    const mwIndex lo = (n0 < 2) ? n0 : 2;
+    const mwIndex hi = (n0 < 4) ? lo : n0 - 2;
+    for (mwIndex r = 0; r < n0; r = (r + 1 == lo) ? hi : r + 1) {
+      for (int dr = -2; dr <= 2; ++dr) {
+	nb.row[dr + 2] = Wrap(r, dr, n0);
+      }
+      colSum += kernel(nb, first + r);
+    }
+
+    // interior rows
+    for (mwIndex r = lo; r < hi; ++r) {
+      for (int dr = -2; dr <= 2; ++dr) {
+	nb.row[dr + 2] = r + dr;
+      }
+      colSum += kernel(nb, first + r);
+    }
+
+    sum += colSum;
+  }
+
+  return sum;
+
+}
+
+template <class T>
+void TotalVariationKernels<T>::GradientAt(const T *im, const Neighbourhood &nb,
+					  double *g) {
+
+  const double v = At(im, nb, 0, 0, 0);
+  g[0] = At(im, nb, 1, 0, 0) - v;
+  g[1] = At(im, nb, 0, 1, 0) - v;
+  g[2] = At(im, nb, 0, 0, 1) - v;
+
+}
+
+template <class T>
+double TotalVariationKernels<T>::DivergenceAt(const T *dx, const T *dy, const T *dz,
+					      const Neighbourhood &nb) {
+
+  return ((double)At(dx, nb, -1, 0, 0) - At(dx, nb, 0, 0, 0))
+    + ((double)At(dy, nb, 0, -1, 0) - At(dy, nb, 0, 0, 0))
+    + ((double)At(dz, nb, 0, 0, -1) - At(dz, nb, 0, 0, 0));
+
+}
+
+template <class T>
+void TotalVariationKernels<T>::SecondOrderGradientAt(const T *im, const Neighbourhood &nb,
+						     bool is3D, double *d2) {
+
+  // Dxx = Dx - Dx(r+1), Dxy = Dy - Dy(r+1), etc.
+  const double v = At(im, nb, 0, 0, 0);
+  const double vx = At(im, nb, 1, 0, 0);
+  const double vy = At(im, nb, 0, 1, 0);
+  const double dxx = 2.0 * vx - v - At(im, nb, 2, 0, 0);
+  const double dyy = 2.0 * vy - v - At(im, nb, 0, 2, 0);
+  const double dxy = vy - v - At(im, nb, 1, 1, 0) + vx;
+
+  if (!is3D) {
+    d2[0] = dxx;
+    d2[1] = dxy;
+    d2[2] = dyy;
+    return;
+  }
+
+  const double vz = At(im, nb, 0, 0, 1);
+  d2[0] = dxx;
+  d2[1] = dxy;
+  d2[2] = vz - v - At(im, nb, 1, 0, 1) + vx;
+  d2[3] = dyy;
+  d2[4] = vz - v - At(im, nb, 0, 1, 1) + vy;
+  d2[5] = 2.0 * vz - v - At(im, nb, 0, 0, 2);
+
+}
+
+template <class T>
+double TotalVariationKernels<T>::SecondOrderDivergenceAt(const T *const *d2,
+							 const Neighbourhood &nb,
+							 bool is3D) {
+
+  // the first order terms Dx, Dy[, Dz] of inverse_TGV.m are computed
+  // at the voxel (0) and at its previous neighbour (1) along their
+  // dimension, to avoid intermediate arrays
+  if (!is3D) {
+    const T *dxx = d2[0], *dxy = d2[1], *dyy = d2[2];
+    double gx[2], gy[2];
+    for (int k = 0; k < 2; ++k) {
+      gx[k] = ((double)At(dxx, nb, -1 - k, 0, 0) - At(dxx, nb, -k, 0, 0)
+	       + (double)At(dxy, nb, -k, -1, 0) - At(dxy, nb, -k, 0, 0)) / 2.0;
+      gy[k] = ((double)At(dyy, nb, 0, -1 - k, 0) - At(dyy, nb, 0, -k, 0)
+	       + (double)At(dxy, nb, -1, -k, 0) - At(dxy, nb, 0, -k, 0)) / 2.0;
+    }
+    return -((gx[1] - gx[0]) + (gy[1] - gy[0])) / 2.0;
+  }
+
+  const T *dxx = d2[0], *dxy = d2[1], *dxz = d2[2];
+  const T *dyy = d2[3], *dyz = d2[4], *dzz = d2[5];
+  double gx[2], gy[2], gz[2];
+  for (int k = 0; k < 2; ++k) {
+    gx[k] = ((double)At(dxx, nb, -1 - k, 0, 0) - At(dxx, nb, -k, 0, 0)
+	     + (double)At(dxy, nb, -k, -1, 0) - At(dxy, nb, -k, 0, 0)
+	     + (double)At(dxz, nb, -k, 0, -1) - At(dxz, nb, -k, 0, 0)) / 3.0;
+    gy[k] = ((double)At(dxy, nb, -1, -k, 0) - At(dxy, nb, 0, -k, 0)
+	     + (double)At(dyy, nb, 0, -1 - k, 0) - At(dyy, nb, 0, -k, 0)
+	     + (double)At(dyz, nb, 0, -k, -1) - At(dyz, nb, 0, -k, 0)) / 3.0;
+    gz[k] = ((double)At(dxz, nb, -1, 0, -k) - At(dxz, nb, 0, 0, -k)
+	     + (double)At(dyz, nb, 0, -1, -k) - At(dyz, nb, 0, 0, -k)
+	     + (double)At(dzz, nb, 0, 0, -1 - k) - At(dzz, nb, 0, 0, -k)) / 3.0;
+  }
+  return -((gx[1] - gx[0]) + (gy[1] - gy[0]) + (gz[1] - gz[0])) / 3.0;
+
+}
+
+template <class T>
+double TotalVariationKernels<T>::GradientKernel::operator()(const Neighbourhood &nb,
+							     mwIndex i) const {
+
+  double g[3];
+  GradientAt(this->im, nb, g);
+  this->dx[i] = (T)g[0];
+  this->dy[i] = (T)g[1];
+  this->dz[i] = (T)g[2];
+
+  return std::fabs(g[0]) + std::fabs(g[1]) + std::fabs(g[2]);
+
+}
+
+template <class T>
+double TotalVariationKernels<T>::DivergenceKernel::operator()(const Neighbourhood &nb,
+							       mwIndex i) const {
+
+  this->res[i] = (T)DivergenceAt(this->dx, this->dy, this->dz, nb);
+
+  return 0.0;
+
+}
+
+template <class T>
+double TotalVariationKernels<T>::SecondOrderGradientKernel::operator()(const Neighbourhood &nb,
+									mwIndex i) const {
+
+  double d2[6];
+  SecondOrderGradientAt(this->im, nb, this->is3D, d2);
+
+  // the mixed derivatives count double in the sum
+  if (!this->is3D) {
+    for (unsigned int k = 0; k < 3; ++k) {
+      this->d2[k][i] = (T)d2[k];
+    }
+    return std::fabs(d2[0]) + std::fabs(d2[2]) + 2.0 * std::fabs(d2[1]);
+  }
+  for (unsigned int k = 0; k < 6; ++k) {
+    this->d2[k][i] = (T)d2[k];
+  }
+  return std::fabs(d2[0]) + std::fabs(d2[3]) + std::fabs(d2[5])
+    + 2.0 * (std::fabs(d2[1]) + std::fabs(d2[2]) + std::fabs(d2[4]));
+
+}
+
+template <class T>
+double TotalVariationKernels<T>::SecondOrderDivergenceKernel::operator()(const Neighbourhood &nb,
+									  mwIndex i) const {
+
+  this->res[i] = (T)SecondOrderDivergenceAt(this->d2, nb, this->is3D);
+
+  return 0.0;
+
+}
+
+template <class T>
+double TotalVariationKernels<T>::Gradient(const T *im, T *dx, T *dy, T *dz) const {
+
+  GradientKernel kernel = {im, dx, dy, dz};
+  return this->Sweep(kernel);
+
+}
+
+template <class T>
+void TotalVariationKernels<T>::Divergence(const T *dx, const T *dy, const T *dz,
+					  T *res) const {
+
+  DivergenceKernel kernel = {dx, dy, dz, res};
+  this->Sweep(kernel);
+
+}
+
+template <class T>
+double TotalVariationKernels<T>::SecondOrderGradient(const T *im, T *const *d2) const {
+
+  SecondOrderGradientKernel kernel = {im, d2, this->Is3D()};
+  return this->Sweep(kernel);
+
+}
+
+template <class T>
+void TotalVariationKernels<T>::SecondOrderDivergence(const T *const *d2, T *res) const {
+
+  SecondOrderDivergenceKernel kernel = {d2, res, this->Is3D()};
+  this->Sweep(kernel);
+
+}
+
+#endif /* TOTALVARIATIONKERNELS_H */
@@ -0,0 +1,241 @@
+/*
+ * denoise_TV.cpp
+ *
+ * DENOISE_TV  Total variation (TV) or total generalised variation (TGV)
+ * denoising of a 2D or 3D image
+ *
+ * J = denoise_TV(I)
+ *
+ *   I is a 2D or 3D real image, of class single or double.
+ *
+ *   J is the denoised image, the solution of
+ *
+ *     min_J 1/2 ||J - I||^2 + LAMBDA * TV(J)
+ *
+ *   where TV(J) is the total variation computed by forward_TV(), with
+ *   periodic boundary conditions. J has the same size and class as I.
+ *   Images of class single are denoised in single precision.
+ *
+ *   The problem is solved with the accelerated primal-dual algorithm of
+ *   Chambolle and Pock (2011).
+ *
+ * J = denoise_TV(I, LAMBDA, TYPE, MAXITER, TOL)
+ *
+ *   LAMBDA is a scalar with the weight of the regulariser. By default,
+ *   LAMBDA=0.1.
+ *
+ *   TYPE is a string with the regulariser:
+ *
+ *     'TV' (default): total variation, as in forward_TV()
+ *
+ *     'TGV': second order total generalised variation, as in
+ *       forward_TGV(). It preserves intensity ramps instead of turning
+ *       them into steps.
+ *
+ *   MAXITER is a scalar with the maximum number of iterations. By
+ *   default, MAXITER=2000 for 'TV' and MAXITER=20000 for 'TGV', which
+ *   converges more slowly. A warning is issued if MAXITER is reached
+ *   before the stopping criterion is met.
+ *
+ *   TOL is a scalar with the stopping tolerance. The algorithm stops
+ *   when sqrt(2*G_k) / norm(I) < TOL, where G_k is the primal-dual gap
+ *   at iteration k, computed every 10 iterations and at the last one.
+ *   This is an upper bound of the relative error norm(J_k - J) /
+ *   norm(I) to the exact solution J, not an estimate: it can be from a
+ *   few times to about 100 times larger than the actual error, the more
+ *   so for 'TGV' in 3D, so the result is usually more accurate than
+ *   TOL. With TOL=0, the gap is not computed, and the algorithm runs
+ *   MAXITER iterations. By default, TOL=1e-3. Note that the relative
+ *   change of J between iterations becomes small long before J_k is
+ *   close to J, because the step size decreases. In single precision,
+ *   rounding errors can keep the bound above 1e-4.
+ *
+ * [J, INFO] = denoise_TV(...)
+ *
+ *   INFO is a struct with the convergence history of the algorithm:
+ *
+ *     'change':    vector with the relative change of J at each
+ *                  iteration, norm(J_k - J_{k-1}) / norm(I)
+ *     'bound':     vector with the bound sqrt(2*G_k) / norm(I) of the
+ *                  relative error at the iterations where the gap was
+ *                  computed. Empty if TOL=0
+ *     'iterbound': vector with the iterations k of 'bound'
+ *     'converged': true if the algorithm stopped with the bound below
+ *                  TOL, false if it reached MAXITER (or TOL=0)
+ *
+ * A. Chambolle and T. Pock, "A first-order primal-dual algorithm for
+ * convex problems with applications to imaging", Journal of
+ * Mathematical Imaging and Vision, 40(1):120-145, 2011.
+ *
+ * See also: forward_TV, inverse_TV, forward_TGV, inverse_TGV.
+ */
+
+/*
+ * Author: Ramon Casero <rcasero@gmail.com>
+ * Copyright © 2014 University of Oxford
+ * Version: 0.3.0
+ *
+ * University of Oxford means the Chancellor, Masters and Scholars of
+ * the University of Oxford, having an administrative office at
+ * Wellington Square, Oxford OX1 2JD, UK.
+ *
+ * This file is part of Gerardus.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details. The offer of this
+ * program under the terms of the License is subject to the License
+ * being interpreted in accordance with English Law and subject to any
+ * action against the University of Oxford being under the jurisdiction
+ * of the English Courts.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* mex headers */
+#include <mex.h>
+
+/* C++ headers */
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <string>
+#include <vector>
+
+/* Gerardus headers */
+#include "TotalVariationDenoiser.h"
+
+// read an optional real scalar input
+double readScalar(int nrhs, const mxArray *prhs[], int pos,
+		  const char *name, double def) {
+
+  if (nrhs <= pos || mxIsEmpty(prhs[pos])) {
+    return def;
+  }
+  if (!mxIsNumeric(prhs[pos]) || mxIsComplex(prhs[pos])
+      || mxGetNumberOfElements(prhs[pos]) != 1) {
+    mexErrMsgTxt((std::string(name) + " must be a real scalar").c_str());
+  }
+  return mxGetScalar(prhs[pos]);
+
+}
+
+// denoise with the class of the input image
+template <class T>
+void denoise(int nlhs, mxArray *plhs[], const mxArray *im,
+	     typename TotalVariationDenoiser<T>::RegulariserType type,
+	     double lambda, mwSize maxIter, double tol) {
+
+  const mwSize ndims = mxGetNumberOfDimensions(im);
+  const mwSize *dims = mxGetDimensions(im);
+
+  // buffers of the algorithm are allocated once here
+  TotalVariationDenoiser<T> denoiser(ndims, dims, type);
+  denoiser.SetLambda(lambda);
+  denoiser.SetMaximumNumberOfIterations(maxIter);
+  denoiser.SetTolerance(tol);
+
+  plhs[0] = mxCreateNumericArray(ndims, dims, mxGetClassID(im), mxREAL);
+  if (!plhs[0]) {
+    mexErrMsgTxt("Not enough memory for output");
+  }
+  denoiser.Denoise((T *)mxGetData(im), (T *)mxGetData(plhs[0]));
+  if (tol > 0.0 && maxIter > 0 && !denoiser.IsConverged()) {
+    mexWarnMsgTxt("MAXITER reached before the error bound was below TOL");
+  }
+
+  // convergence history
+  if (nlhs > 1) {
+    const std::vector<double> &change = denoiser.GetChange();
+    const std::vector<double> &bound = denoiser.GetErrorBound();
+    const std::vector<mwSize> &iterBound = denoiser.GetErrorBoundIteration();
+    const char *fieldNames[] = {"change", "bound", "iterbound", "converged"};
+    plhs[1] = mxCreateStructMatrix(1, 1, 4, fieldNames);
+    mxArray *field = mxCreateDoubleMatrix(change.size(), 1, mxREAL);
+    std::copy(change.begin(), change.end(), mxGetPr(field));
+    mxSetField(plhs[1], 0, "change", field);
+    field = mxCreateDoubleMatrix(bound.size(), 1, mxREAL);
+    std::copy(bound.begin(), bound.end(), mxGetPr(field));
+    mxSetField(plhs[1], 0, "bound", field);
+    field = mxCreateDoubleMatrix(iterBound.size(), 1, mxREAL);
+    std::copy(iterBound.begin(), iterBound.end(), mxGetPr(field));
+    mxSetField(plhs[1], 0, "iterbound", field);
+    mxSetField(plhs[1], 0, "converged",
+	       mxCreateLogicalScalar(denoiser.IsConverged()));
+  }
+
+}
+
+// entry point for the MEX file
+void mexFunction(int nlhs, mxArray *plhs[],
+		 int nrhs, const mxArray *prhs[]) {
+
+  // check arguments
+  if ((nrhs < 1) || (nrhs > 5)) {
+    mexErrMsgTxt("Wrong number of input arguments");
+  }
+  if (nlhs > 2) {
+    mexErrMsgTxt("Too many output arguments");
+  }
+
+  // image
+  const mxArray *im = prhs[0];
+  if (!mxIsDouble(im) && !mxIsSingle(im)) {
+    mexErrMsgTxt("I must be of class single or double");
+  }
+  if (mxIsComplex(im)) {
+    mexErrMsgTxt("I must be real");
+  }
+  if (mxGetNumberOfDimensions(im) > 3) {
+    mexErrMsgTxt("I must be a 2D image or 3D image volume");
+  }
+
+  // parameters
+  double lambda = readScalar(nrhs, prhs, 1, "LAMBDA", 0.1);
+  if (lambda < 0.0) {
+    mexErrMsgTxt("LAMBDA must be >= 0");
+  }
+  std::string typeName = "tv";
+  if (nrhs > 2 && !mxIsEmpty(prhs[2])) {
+    if (!mxIsChar(prhs[2])) {
+      mexErrMsgTxt("TYPE must be a string");
+    }
+    char *str = mxArrayToString(prhs[2]);
+    typeName = str;
+    mxFree(str);
+    std::transform(typeName.begin(), typeName.end(), typeName.begin(), ::tolower);
+  }
+  if (typeName != "tv" && typeName != "tgv") {
+    mexErrMsgTxt("TYPE must be 'TV' or 'TGV'");
+  }
+  double maxIter = readScalar(nrhs, prhs, 3, "MAXITER",
+				(typeName == "tv") ? 2000.0 : 20000.0);
+  if (mxIsNaN(maxIter) || mxIsInf(maxIter) || maxIter < 0.0
+      || maxIter != std::floor(maxIter)) {
+    mexErrMsgTxt("MAXITER must be a non-negative integer");
+  }
+  double tol = readScalar(nrhs, prhs, 4, "TOL", 1e-3);
+  if (mxIsNaN(tol) || tol < 0.0) {
+    mexErrMsgTxt("TOL must be >= 0");
+  }
+
+  if (mxIsDouble(im)) {
+    denoise<double>(nlhs, plhs, im,
+		    (typeName == "tv") ? TotalVariationDenoiser<double>::TV
+		    : TotalVariationDenoiser<double>::TGV,
+		    lambda, (mwSize)maxIter, tol);
+  } else {
+    denoise<float>(nlhs, plhs, im,
+		   (typeName == "tv") ? TotalVariationDenoiser<float>::TV
+		   : TotalVariationDenoiser<float>::TGV,
+		   lambda, (mwSize)maxIter, tol);
+  }
+
+}
@@ -9,7 +9,7 @@ function [ TGV, TGV_grad ] = forward_TGV( I )
 
 % Author: Darryl McClymont <darryl.mcclymont@gmail.com>
 % Copyright  2015 University of Oxford
-% Version: 0.1.1
+% Version: 0.2.0
 % 
 % University of Oxford means the Chancellor, Masters and Scholars of
 % the University of Oxford, having an administrative office at
@@ -49,6 +49,12 @@ nargoutchk(0, 2);
 
 N = ndims(I);
 
+% Let mex do the work for you
+if exist('forward_TV_aux', 'file') == 3 && isreal(I) && isfloat(I) && N <= 3
+    [TGV, TGV_grad] = forward_TV_aux('tgv', I);
+    return
+end
+
 Dx = I([2:end,1],:,:) - I;
 Dy = I(:,[2:end,1],:) - I;
 
@@ -16,7 +16,7 @@ function [ TV , TV_grad] = forward_TV( I )
 
 % Author: Darryl McClymont <darryl.mcclymont@gmail.com>
 % Copyright  2014 University of Oxford
-% Version: 0.1.3
+% Version: 0.2.0
 % 
 % University of Oxford means the Chancellor, Masters and Scholars of
 % the University of Oxford, having an administrative office at
@@ -54,8 +54,8 @@ end
 
 
 % Let mex do the work for you
-if 0%exist('forward_TV_aux', 'file') && isreal(I)
-    [Dx, Dy, Dz, TV] = forward_TV_aux(double(I), 1);  
+if exist('forward_TV_aux', 'file') == 3 && isreal(I) && isfloat(I) && ndims(I) <= 3
+    [Dx, Dy, Dz, TV] = forward_TV_aux(I);
 else
     
     % This is the equivalent to the above mex function in Matlab, but the
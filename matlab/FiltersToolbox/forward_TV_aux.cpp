@@ -1,17 +1,45 @@
 /*
+ * FORWARD_TV_AUX  Total variation and total generalised variation
+ * operators of a 2D or 3D image
  *
+ *   This function should only be called by forward_TV.m, inverse_TV.m,
+ *   forward_TGV.m and inverse_TGV.m.
  *
- * FORWARD_TV_aux Total variation of a 3D image
- *   This function should only be called by forward_TV.m
- 
- 
+ * [DX, DY, DZ, TV] = forward_TV_aux(I)
+ *
+ *   I is a 2D or 3D real image, of class single or double.
+ *
+ *   DX, DY, DZ are the forward finite differences along rows, columns
+ *   and slices, with periodic boundary conditions. TV is the total
+ *   variation, sum(abs(DX(:)) + abs(DY(:)) + abs(DZ(:))).
+ *
+ * RES = forward_TV_aux('inverse', Y)
+ *
+ *   Y is the TV_GRAD output of forward_TV(), an (R, C, S, 3) array.
+ *   RES is the adjoint of the finite differences, as in inverse_TV.m.
+ *
+ * [TGV, TGV_GRAD] = forward_TV_aux('tgv', I)
+ *
+ *   Second order total generalised variation of I, as in forward_TGV.m.
+ *   TGV_GRAD is (R, C, 3) for a 2D image, and (R, C, S, 6) for a 3D
+ *   image.
+ *
+ * RES = forward_TV_aux('inverse_tgv', TGV_GRAD)
+ *
+ *   Residuals of the total generalised variation, as in inverse_TGV.m.
+ *
+ * The outputs have the same class as the input. Each operator is
+ * computed in a single parallel sweep by TotalVariationKernels.h.
+ */
+
+/*
  * Author: Darryl McClymont <darryl.mcclymont@gmail.com>
  * Copyright  2014 University of Oxford
- * Version: 0.1.1
- * 
+ * Version: 0.2.0
+ *
  * University of Oxford means the Chancellor, Masters and Scholars of
  * the University of Oxford, having an administrative office at
- * Wellington Square, Oxford OX1 2JD, UK. 
+ * Wellington Square, Oxford OX1 2JD, UK.
  *
  * This file is part of Gerardus.
  *
@@ -33,106 +61,180 @@
  * along with this program.  If not, see <http://www.gnu.org/licenses/>.
  */
 
-#include <cmath> 
-//#include <vector> 
-#include <mex.h> 
-#include <math.h> 
-using namespace std; 
-
-
-  
-// Main function 
-void mexFunction( int nlhs, mxArray *plhs[], 
-                  int nrhs, const mxArray *prhs[] ) 
-{ 
-    double *INPUT, *DX, *DY, *DZ, *TV; 
-    mwSize     ndim, ndim_zero; 
-    const mwSize *dims, *dims_zero; 
-  
-  
-    /* The input must be a noncomplex scalar double.*/
-    ndim = mxGetNumberOfDimensions(prhs[0]);   
-    dims = mxGetDimensions(prhs[0]); 
-  
-    
-    // I couldn't work out how to get a single value output, so I'm just using the second input argument!
-    ndim_zero = mxGetNumberOfDimensions(prhs[1]);   
-    dims_zero = mxGetDimensions(prhs[1]); 
-    
-    /* Create matrices for the return arguments. */
-    plhs[0] = mxCreateNumericArray(ndim, dims, mxDOUBLE_CLASS, mxREAL); 
-    plhs[1] = mxCreateNumericArray(ndim, dims, mxDOUBLE_CLASS, mxREAL); 
-    plhs[2] = mxCreateNumericArray(ndim, dims, mxDOUBLE_CLASS, mxREAL); 
-    plhs[3] = mxCreateNumericArray(ndim_zero, dims_zero, mxDOUBLE_CLASS, mxREAL); 
-  
-    /* Assign pointers to each input and output. */
-    DX = mxGetPr(plhs[0]); 
-    DY = mxGetPr(plhs[1]); 
-    DZ = mxGetPr(plhs[2]); 
-    TV = mxGetPr(plhs[3]);
-    INPUT = mxGetPr(prhs[0]); 
-  
-    
-    int dim0 = (int)dims[0];
-    int dim1 = (int)dims[1];
-    int dim2 = (int)dims[2];
-    
-
-    
-    int numel = dim0*dim1*dim2;
-    
-    
-    // I had an implementation with lots of calls to sub2ind, but it was far too slow
-    
-    
-    // Finite differences in the row dimension
-    for (int i = 0; i < numel - 1; i++) 
-    {  
-        DX[i] = INPUT[i+1] - INPUT[i];
+/* mex headers */
+#include <mex.h>
+
+/* C++ headers */
+#include <string>
+#include <vector>
+
+/* Gerardus headers */
+#include "TotalVariationKernels.h"
+
+// check that the input is a real single or double array
+void checkImage(const mxArray *im) {
+    if (!mxIsDouble(im) && !mxIsSingle(im)) {
+        mexErrMsgTxt("Input array must be of class single or double");
+    }
+    if (mxIsComplex(im)) {
+        mexErrMsgTxt("Input array must be real");
     }
+}
 
-    // Column dimension
-    for (int i = 0; i < numel - dim0; i++) 
-    {  
-        DY[i] = INPUT[i + dim0] - INPUT[i];
+// image size of a stack of ncomp components, concatenated along the
+// last dimension
+std::vector<mwSize> getComponentSize(const mxArray *stack, mwSize ndimsImage,
+                                     mwSize ncomp) {
+    const mwSize ndims = mxGetNumberOfDimensions(stack);
+    const mwSize *dims = mxGetDimensions(stack);
+    std::vector<mwSize> size(ndimsImage, 1);
+    for (mwSize d = 0; d < ndims; ++d) {
+        if (d < ndimsImage) {
+            size[d] = dims[d];
+        } else if (d == ndimsImage && dims[d] == ncomp) {
+            continue;
+        } else if (dims[d] != 1) {
+            mexErrMsgTxt("Input array has the wrong number of derivatives");
+        }
     }
-    
-    // Slice dimension
-    for (int i = 0; i < numel - dim0*dim1; i++) 
-    {  
-        DZ[i] = INPUT[i + dim0*dim1] - INPUT[i];
+    if (ndims <= ndimsImage && ncomp != 1) {
+        mexErrMsgTxt("Input array has the wrong number of derivatives");
     }
-    
-    // Due to the indexing, the last row and column have values, but they should be zeros
-    // DZ is fine though - the last slice is already zeros
-
-    // fill the last row with zeros
-    for (int i = dim0-1; i < numel; i+= dim0) 
-    {  
-        DX[i] = 0;
+    return size;
+}
+
+// [DX, DY, DZ, TV] = forward_TV_aux(I)
+template <class T>
+void forwardTV(mxArray *plhs[], const mxArray *im, mxClassID classId) {
+
+    const mwSize ndims = mxGetNumberOfDimensions(im);
+    const mwSize *dims = mxGetDimensions(im);
+    TotalVariationKernels<T> tv(ndims, dims);
+
+    for (int i = 0; i < 3; ++i) {
+        plhs[i] = mxCreateNumericArray(ndims, dims, classId, mxREAL);
     }
-    
-    // do the same with the last column - this one is a bit trickier with the indexing
-    int base_i = dim0 * (dim1-1);
-    int k_index = 0;
-    for (int k = 0; k < dim2; k++) 
-    {  
-        k_index = k * dim0 * dim1;
-        for (int i = 0; i < dims[0]; i++)
-        {
-            // k index gets the slice, base_i gets us to the first row of the final column, and i gets us the rest of the way
-            DY[k_index + base_i + i] = 0;
-        }
+    double TV = tv.Gradient((T *)mxGetData(im), (T *)mxGetData(plhs[0]),
+                            (T *)mxGetData(plhs[1]), (T *)mxGetData(plhs[2]));
+    plhs[3] = mxCreateNumericMatrix(1, 1, classId, mxREAL);
+    ((T *)mxGetData(plhs[3]))[0] = (T)TV;
+
+}
+
+// RES = forward_TV_aux('inverse', Y)
+template <class T>
+void inverseTV(mxArray *plhs[], const mxArray *y, mxClassID classId) {
+
+    std::vector<mwSize> size = getComponentSize(y, 3, 3);
+    TotalVariationKernels<T> tv(3, &size[0]);
+    const mwSize nvox = tv.GetNumberOfVoxels();
+
+    plhs[0] = mxCreateNumericArray(3, &size[0], classId, mxREAL);
+    const T *dx = (T *)mxGetData(y);
+    tv.Divergence(dx, dx + nvox, dx + 2 * nvox, (T *)mxGetData(plhs[0]));
+
+}
+
+// [TGV, TGV_GRAD] = forward_TV_aux('tgv', I)
+template <class T>
+void forwardTGV(mxArray *plhs[], const mxArray *im, mxClassID classId) {
+
+    const mwSize ndims = mxGetNumberOfDimensions(im);
+    const mwSize *dims = mxGetDimensions(im);
+    TotalVariationKernels<T> tv(ndims, dims);
+    const mwSize nvox = tv.GetNumberOfVoxels();
+    const unsigned int ncomp = tv.GetNumberOfSecondOrderComponents();
+
+    // the derivatives are concatenated along the dimension after the
+    // image dimensions, as in forward_TGV.m
+    std::vector<mwSize> size(dims, dims + ndims);
+    size.resize(tv.Is3D() ? 3 : 2, 1);
+    size.push_back(ncomp);
+    plhs[1] = mxCreateNumericArray(size.size(), &size[0], classId, mxREAL);
+    T *grad = (T *)mxGetData(plhs[1]);
+    std::vector<T *> d2(ncomp);
+    for (unsigned int k = 0; k < ncomp; ++k) {
+        d2[k] = grad + k * nvox;
     }
-   
-    
-     // add them up to get the total variation
-    double TV_adder = 0;
-    
-    for (int i = 0; i < numel; i++) 
-    {  
-       TV_adder+= abs(DX[i])+abs(DY[i])+abs(DZ[i]);
+
+    double TGV = tv.SecondOrderGradient((T *)mxGetData(im), &d2[0]);
+    plhs[0] = mxCreateNumericMatrix(1, 1, classId, mxREAL);
+    ((T *)mxGetData(plhs[0]))[0] = (T)TGV;
+
+}
+
+// RES = forward_TV_aux('inverse_tgv', TGV_GRAD)
+template <class T>
+void inverseTGV(mxArray *plhs[], const mxArray *g, mxClassID classId) {
+
+    // 2D images have 3 derivatives, and 3D images have 6
+    const mwSize ndimsImage = mxGetNumberOfDimensions(g) - 1;
+    if (ndimsImage != 2 && ndimsImage != 3) {
+        mexErrMsgTxt("TGV_GRAD must be a 2D or 3D image, with the derivatives concatenated in the last dimension");
+    }
+    const mwSize ncomp = (ndimsImage == 2) ? 3 : 6;
+    std::vector<mwSize> size = getComponentSize(g, ndimsImage, ncomp);
+    TotalVariationKernels<T> tv(ndimsImage, &size[0]);
+    if (tv.GetNumberOfSecondOrderComponents() != ncomp) {
+        mexErrMsgTxt("TGV_GRAD of a 3D image must have 6 derivatives");
     }
-        
-    TV[0] = TV_adder;
-}
\ No newline at end of file
+    const mwSize nvox = tv.GetNumberOfVoxels();
+
+    const T *grad = (T *)mxGetData(g);
+    std::vector<const T *> d2(ncomp);
+    for (mwSize k = 0; k < ncomp; ++k) {
+        d2[k] = grad + k * nvox;
+    }
+    plhs[0] = mxCreateNumericArray(ndimsImage, &size[0], classId, mxREAL);
+    tv.SecondOrderDivergence(&d2[0], (T *)mxGetData(plhs[0]));
+
+}
+
+// run the operator with the class of the input
+template <class T>
+void runOperator(const std::string &mode, mxArray *plhs[],
+                 const mxArray *in, mxClassID classId) {
+    if (mode == "forward") {
+        forwardTV<T>(plhs, in, classId);
+    } else if (mode == "inverse") {
+        inverseTV<T>(plhs, in, classId);
+    } else if (mode == "tgv") {
+        forwardTGV<T>(plhs, in, classId);
+    } else if (mode == "inverse_tgv") {
+        inverseTGV<T>(plhs, in, classId);
+    } else {
+        mexErrMsgTxt(("Unknown operator: " + mode).c_str());
+    }
+}
+
+// Main function
+void mexFunction(int nlhs, mxArray *plhs[],
+                 int nrhs, const mxArray *prhs[])
+{
+
+    // the operator is given as a string before the array; a single
+    // array input computes the TV
+    std::string mode = "forward";
+    const mxArray *in = NULL;
+    if (nrhs == 1) {
+        in = prhs[0];
+    } else if (nrhs == 2 && mxIsChar(prhs[0])) {
+        char *str = mxArrayToString(prhs[0]);
+        mode = str;
+        mxFree(str);
+        in = prhs[1];
+    } else {
+        mexErrMsgTxt("Syntax: forward_TV_aux(I) or forward_TV_aux(OPERATOR, X)");
+    }
+    if (nlhs > ((mode == "forward") ? 4 : (mode == "tgv") ? 2 : 1)) {
+        mexErrMsgTxt("Too many output arguments");
+    }
+
+    checkImage(in);
+    if (mxIsDouble(in)) {
+        runOperator<double>(mode, plhs, in, mxDOUBLE_CLASS);
+    } else {
+        runOperator<float>(mode, plhs, in, mxSINGLE_CLASS);
+    }
+
+}
@@ -6,7 +6,7 @@ function [ res ] = inverse_TGV( TGV )
 %
 % Author: Darryl McClymont <darryl.mcclymont@gmail.com>
 % Copyright  2015 University of Oxford
-% Version: 0.1.1
+% Version: 0.2.1
 % 
 % University of Oxford means the Chancellor, Masters and Scholars of
 % the University of Oxford, having an administrative office at
@@ -37,6 +37,13 @@ nargoutchk(0, 1);
 
 N = ndims(TGV) - 1;
 
+% Let mex do the work for you
+if exist('forward_TV_aux', 'file') == 3 && isreal(TGV) && isfloat(TGV) ...
+        && (N == 2 || N == 3)
+    res = forward_TV_aux('inverse_tgv', TGV);
+    return
+end
+
 if N == 2
     
     Dxx = TGV(:,:,1);
@@ -54,12 +61,12 @@ if N == 2
 
 elseif N == 3
 
-    Dxx = TGV(:,:,1);
-    Dxy = TGV(:,:,2);
-    Dxz = TGV(:,:,3);
-    Dyy = TGV(:,:,4);
-    Dyz = TGV(:,:,5);
-    Dzz = TGV(:,:,6);
+    Dxx = TGV(:,:,:,1);
+    Dxy = TGV(:,:,:,2);
+    Dxz = TGV(:,:,:,3);
+    Dyy = TGV(:,:,:,4);
+    Dyz = TGV(:,:,:,5);
+    Dzz = TGV(:,:,:,6);
     
     Dx = ((Dxx([end, 1:end-1], :, :) - Dxx) + ... % -ve x backwards difference of Dxx
           (Dxy(:, [end, 1:end-1], :) - Dxy) + ... % -ve y backwards difference of Dxy
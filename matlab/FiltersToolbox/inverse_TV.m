@@ -17,7 +17,7 @@ function [ res ] = inverse_TV( y )
 
 % Author: Darryl McClymont <darryl.mcclymont@gmail.com>
 % Copyright  2014 University of Oxford
-% Version: 0.1.1
+% Version: 0.2.0
 % 
 % University of Oxford means the Chancellor, Masters and Scholars of
 % the University of Oxford, having an administrative office at
@@ -53,6 +53,12 @@ if isvector(y)
 end
 
 
+% Let mex do the work for you
+if exist('forward_TV_aux', 'file') == 3 && isreal(y) && isfloat(y)
+    res = forward_TV_aux('inverse', y);
+    return
+end
+
 res = adjDx(y(:,:,:,1)) + adjDy(y(:,:,:,2)) + adjDz(y(:,:,:,3));
 
 
@@ -4,8 +4,14 @@ function im = labmathmorph(type, im, param)
 %
 % This function runs mathematical morphology operations (dilation, erosion,
 % opening, closing) on labelled segmentations. The operator is applied to
-% each label independently. Care has been taken speed up operations for
-% large images.
+% each label independently, but all labels are processed at the same time
+% by thresholding the exact distance transform (see itk_imfilter's
+% 'labdilate' and 'laberode'), so the computing time doesn't depend on the
+% number of labels or the radius.
+%
+% When labels are dilated, background voxels are given to the closest
+% label. Labelled voxels are never overwritten by another label. When
+% labels are closed, all the voxels labelled in IM keep their label.
 %
 % IM2 = LABMATHMORPH(TYPE, IM, PARAM)
 %
@@ -40,7 +46,7 @@ function im = labmathmorph(type, im, param)
 
 % Author: Ramon Casero <rcasero@gmail.com>
 % Copyright © 2011 University of Oxford
-% Version: 0.1.0
+% Version: 0.2.1
 % 
 % University of Oxford means the Chancellor, Masters and Scholars of
 % the University of Oxford, having an administrative office at
@@ -69,125 +75,49 @@ function im = labmathmorph(type, im, param)
 error(nargchk(3, 3, nargin, 'struct'));
 error(nargoutchk(0, 1, nargout, 'struct'));
 
-% image size
-sz = size(im);
-if (length(sz) == 2)
-    sz = [sz 1];
-end
-
 % get parameter values
-% gap: number of voxels we need to leave around the cropped branch. Note
-% that we need to leave at least 1 voxel of empty space, otherwise the ITK
-% morphological operators do weird things at the boundary
 switch type
     case 'dilate'
-        if (length(param) == 1)
-            ndil = param;
-            gap = ndil + 1;
-        else
+        if (length(param) ~= 1)
             error('Dilation operator expects 1 value in PARAM')
         end
     case 'erode'
-        if (length(param) == 1)
-            nero = param;
-            gap = nero + 1;
-        else
+        if (length(param) ~= 1)
             error('Erosion operator expects 1 value in PARAM')
         end
-    case 'close'
-        if (length(param) == 2)
-            ndil = param(1);
-            nero = param(2);
-            gap = ndil + 1;
-        else
-            error('Closing operator expects a 2-vector in PARAM')
-        end
-    case 'open'
-        if (length(param) == 2)
-            nero = param(1);
-            ndil = param(2);
-            gap = ndil + 1;
-        else
-            error('Opening operator expects a 2-vector in PARAM')
+    case {'close', 'open'}
+        if (length(param) ~= 2)
+            error('Closing and opening operators expect a 2-vector in PARAM')
         end
     otherwise
         error('Operator type not implemented')
 end
 
-% get indices and labels of the segmented voxels
-idxlab = find(im);
-lab = nonzeros(im);
-
-% sort the label values
-[lab, idx] = sort(lab);
-idxlab = idxlab(idx);
-
-% find where each label begins. The last index is "fake", i.e. it doesn't
-% correspond to any label, but it is used to know where the last label ends
-idxlab0 = [0 ; find(diff(lab)) ; length(lab)] + 1;
-
-% list of labels with at least 1 voxel in the segmentation
-LAB = unique(lab);
+% radius of the ball in voxels. The ball of radius R used by
+% itk_imfilter('bwdilate'/'bwerode') contains the voxels at distance
+% <= R+0.5 from the centre
+rad = floor(param) + 0.5;
 
-% free some memory
-clear lab
-
-% loop every branch
-for I = 1:length(LAB)
-
-    % list of voxels in current branch. The reason why we are not doing a
-    % simple br = find(nrrd.data == LAB(I)); is because for a large volume,
-    % that's a comparatively very slow operation
-    br = idxlab(idxlab0(I):idxlab0(I+1)-1);
-    
-    % crop the part of the segmentation that contains the branch
-    [r, c, s] = ind2sub(sz, br);
-    
-    from = min([r c s], [], 1);
-    to = max([r c s], [], 1);
-    
-    from = max([from - gap ; 1 1 1], [], 1);
-    to = min([to + gap ; sz], [], 1);
-    
-    imcrop0 = im(from(1):to(1), from(2):to(2), from(3):to(3));
-    
-    % voxels of the current branch
-    imcrop = (imcrop0 == LAB(I));
-    
-    % remove current branch from the rest of the voxels
-    imcrop0(imcrop) = 0;
-    
-    % run operator on the branch
-    switch type
-        case 'dilate'
-            imcrop = itk_imfilter('bwdilate', imcrop, ndil, true);
-
-        case 'erode'
-            imcrop = itk_imfilter('bwerode', imcrop, nero, true);
-            
-        case 'close'
-            imcrop = itk_imfilter('bwdilate', imcrop, ndil, true);
-            imcrop = itk_imfilter('bwerode', imcrop, nero, true);
-            
-        case 'open'
-            imcrop = itk_imfilter('bwerode', imcrop, nero, true);
-            imcrop = itk_imfilter('bwdilate', imcrop, ndil, true);
-    end
-    
-    % remove voxels from other branches from the result
-    imcrop(imcrop0 ~= 0) = 0;
-    
-    % get indices of the resulting voxels
-    [r, c, s] = ind2sub(size(imcrop), find(imcrop));
-    
-    % convert indices from crop to whole segmentation
-    idx = sub2ind(size(im), r + from(1) - 1, c + from(2) - 1, ...
-        s + from(3) - 1);
-    
-    % remove original branch from whole segmentation
-    im(br) = 0;
-    
-    % add filtered branch to whole segmentation
-    im(idx) = LAB(I);
-    
+% run operator on all labels at the same time
+switch type
+    case 'dilate'
+        im = itk_imfilter('labdilate', im, rad);
+        
+    case 'erode'
+        im = itk_imfilter('laberode', im, rad);
+        
+    case 'close'
+        % the erosion of all labels at the same time also erodes the
+        % boundaries between touching labels, so the voxels that were
+        % labelled in the input are put back, as in a closing of each
+        % label
+        idx = find(im);
+        lab = im(idx);
+        im = itk_imfilter('labdilate', im, rad(1));
+        im = itk_imfilter('laberode', im, rad(2));
+        im(idx) = lab;
+        
+    case 'open'
+        im = itk_imfilter('laberode', im, rad(1));
+        im = itk_imfilter('labdilate', im, rad(2));
 end
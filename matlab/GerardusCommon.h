@@ -7,7 +7,7 @@
  /*
   * Author: Ramon Casero <rcasero@gmail.com>
   * Copyright © 2011-2013 University of Oxford
-  * Version: 0.10.2
+  * Version: 0.10.3
   *
   * University of Oxford means the Chancellor, Masters and Scholars of
   * the University of Oxford, having an administrative office at
@@ -259,6 +259,14 @@ template<>
 struct TypeIsInt32< int32_T >
 { static const bool value = true; };
 
+template< class T >
+struct TypeIsUint32
+{ static const bool value = false; };
+
+template<>
+struct TypeIsUint32< uint32_T >
+{ static const bool value = true; };
+
 template< class T >
 struct TypeIsInt64
 { static const bool value = false; };
@@ -267,6 +275,14 @@ template<>
 struct TypeIsInt64< int64_T >
 { static const bool value = true; };
 
+template< class T >
+struct TypeIsUint64
+{ static const bool value = false; };
+
+template<>
+struct TypeIsUint64< uint64_T >
+{ static const bool value = true; };
+
 template< class T >
 struct TypeIsSignedLong
 { static const bool value = false; };
@@ -318,8 +334,12 @@ mxClassID convertCppDataTypeToMatlabCassId() {
     outputVoxelClassId = mxUINT16_CLASS;
   } else if (TypeIsInt16<TPixel>::value) {
     outputVoxelClassId = mxINT16_CLASS;
+  } else if (TypeIsUint32<TPixel>::value) {
+    outputVoxelClassId = mxUINT32_CLASS;
   } else if (TypeIsInt32<TPixel>::value) {
     outputVoxelClassId = mxINT32_CLASS;
+  } else if (TypeIsUint64<TPixel>::value) {
+    outputVoxelClassId = mxUINT64_CLASS;
   } else if (TypeIsInt64<TPixel>::value) {
     outputVoxelClassId = mxINT64_CLASS;
   } else if (TypeIsSignedLong<TPixel>::value) {
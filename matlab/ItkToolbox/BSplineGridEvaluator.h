@@ -0,0 +1,305 @@
+/*
+ * BSplineGridEvaluator.h
+ *
+ * BSplineGridEvaluator: evaluation of a B-spline with a uniform
+ * control point lattice (e.g. the output of
+ * itk::BSplineScatteredDataPointSetToImageFilter::GetPhiLattice()) on
+ * a rectilinear grid of points, e.g. the voxels of an image.
+ *
+ * A B-spline of order k in the parametric domain [0, 1]^D, with n_d
+ * control points phi along dimension d, is
+ *
+ *   f(u) = sum_{j_0,...,j_{D-1}} B(u_0)_{j_0} ... B(u_{D-1})_{j_{D-1}}
+ *                                phi(f_0 + j_0, ..., f_{D-1} + j_{D-1})
+ *
+ * where u_d is scaled to the n_d - k spans of the lattice, f_d is the
+ * span that contains u_d and B(u_d)_j, j=0,...,k are the k+1 uniform
+ * B-spline basis functions that are not zero in that span. This is
+ * the same evaluation as itk::BSplineControlPointImageFunction.
+ *
+ * Evaluating each point of the grid independently costs (k+1)^D
+ * lattice reads and products per point. But on a grid, u_d depends
+ * only on the index of the point along dimension d, so the basis
+ * weights are computed once per row, column and slice, and the tensor
+ * product is contracted one dimension at a time, from the last one to
+ * the first:
+ *
+ *   for each slice:  contract the lattice along z -> 2D lattice
+ *     for each row:  contract along y               -> 1D lattice
+ *       for each column: contract along x           -> value
+ *
+ * which costs about (k+1) products per point, plus a small overhead
+ * per row and slice. Slices (the last dimension) are evaluated in
+ * parallel with OpenMP.
+ *
+ * An example of how to use this class in a MEX Matlab function:
+ *
+ *   // lattice with (3, n0, n1, n2) values, one vector per control point
+ *   BSplineGridEvaluator<3> evaluator(3, latticeSize, lattice);
+ *
+ *   // param[d]: parametric coordinates of the grid along dimension d
+ *   // stride[d]: distance in the output between consecutive grid
+ *   //            points along dimension d
+ *   // compStride: distance in the output between vector components
+ *   evaluator.EvaluateGrid(param, stride, compStride, 1.0, out);
+ *
+ */
+
+/*
+ * Author: Ramon Casero <rcasero@gmail.com>
+ * Copyright © 2014 University of Oxford
+ * Version: 0.1.0
+ *
+ * University of Oxford means the Chancellor, Masters and Scholars of
+ * the University of Oxford, having an administrative office at
+ * Wellington Square, Oxford OX1 2JD, UK.
+ *
+ * This file is part of Gerardus.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details. The offer of this
+ * program under the terms of the License is subject to the License
+ * being interpreted in accordance with English Law and subject to any
+ * action against the University of Oxford being under the jurisdiction
+ * of the English Courts.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see
+ * <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef BSPLINEGRIDEVALUATOR_H
+#define BSPLINEGRIDEVALUATOR_H
+
+/* mex headers */
+#include <mex.h>
+
+/* C++ headers */
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+template <unsigned int VDimension>
+class BSplineGridEvaluator {
+
+ public:
+
+  // order:       B-spline order
+  // latticeSize: VDimension-vector with the number of control points
+  //              along each dimension
+  // lattice:     control points. Each control point is a
+  //              VDimension-vector, and the lattice is stored as a
+  //              (VDimension, n0, n1[, n2]) Matlab array
+  template <class TScalar>
+  BSplineGridEvaluator(unsigned int _order, const mwSize *latticeSize,
+		       const TScalar *lattice);
+
+  // param:      VDimension vectors with the parametric coordinates of
+  //             the grid along each dimension, in [0, 1]
+  // stride:     VDimension-vector with the distance in out between
+  //             grid points that are consecutive along each dimension
+  // compStride: distance in out between the components of the vector
+  //             of a grid point
+  // scale:      factor applied to the output vectors
+  // out:        output array
+  template <class TScalar>
+  void EvaluateGrid(const std::vector<double> *param, const mwSize *stride,
+		    mwSize compStride, double scale, TScalar *out) const;
+
+ private:
+
+  unsigned int order;
+  mwSize latticeSize[VDimension];
+
+  // lattice values, and size of the lattice block that corresponds to
+  // one control point index along each dimension
+  std::vector<double> lattice;
+  mwSize blockSize[VDimension];
+
+  // span and basis weights of each grid point, along one dimension
+  struct AxisWeights {
+    std::vector<mwIndex> first;
+    std::vector<double> weight;
+  };
+
+  // basis functions of the span that contains the parametric
+  // coordinate u, and index of the first control point of the span
+  void ComputeBasis(double u, mwSize nlattice, mwIndex &first, double *w) const;
+
+  // contract the lattice block coeff along dimension d for every grid
+  // point along d, and recurse to the lower dimensions
+  template <class TScalar>
+  void EvaluateLevel(unsigned int d, const double *coeff, mwIndex outOffset,
+		     const AxisWeights *axis, const mwSize *stride,
+		     mwSize compStride, double scale,
+		     std::vector<double> *work, TScalar *out) const;
+
+};
+
+/*
+ * Definitions
+ */
+
+template <unsigned int VDimension>
+template <class TScalar>
+BSplineGridEvaluator<VDimension>::BSplineGridEvaluator(unsigned int _order,
+						       const mwSize *_latticeSize,
+						       const TScalar *_lattice)
+  : order(_order) {
+
+  mwSize nlattice = VDimension;
+  for (unsigned int d = 0; d < VDimension; ++d) {
+    this->latticeSize[d] = _latticeSize[d];
+    this->blockSize[d] = nlattice;
+    nlattice *= _latticeSize[d];
+    if (_latticeSize[d] <= this->order) {
+      mexErrMsgTxt("BSplineGridEvaluator: The lattice needs more control points than the order of the B-spline");
+    }
+  }
+  this->lattice.assign(_lattice, _lattice + nlattice);
+
+}
+
+template <unsigned int VDimension>
+void BSplineGridEvaluator<VDimension>::ComputeBasis(double u, mwSize nlattice,
+						    mwIndex &first, double *w) const {
+
+  // scale u to the spans of the lattice. The last point of the domain
+  // belongs to the last span
+  const mwSize nspans = nlattice - this->order;
+  u *= (double)nspans;
+  double span = std::floor(u);
+  if (span >= (double)nspans) {
+    span = (double)(nspans - 1);
+  }
+  first = (mwIndex)span;
+  const double t = u - span;
+
+  // uniform B-spline basis functions of order k, computed by the
+  // recursion N_{j,k} = ((t + k - j) N_{j-1,k-1} + (j + 1 - t) N_{j,k-1}) / k
+  w[0] = 1.0;
+  for (unsigned int k = 1; k <= this->order; ++k) {
+    w[k] = 0.0;
+    for (unsigned int j = k; j > 0; --j) {
+      w[j] = ((t + k - j) * w[j - 1] + (j + 1 - t) * w[j]) / k;
+    }
+    w[0] = (1.0 - t) * w[0] / k;
+  }
+
+}
+
+template <unsigned int VDimension>
+template <class TScalar>
+void BSplineGridEvaluator<VDimension>::EvaluateGrid(const std::vector<double> *param,
+						    const mwSize *stride,
+						    mwSize compStride, double scale,
+						    TScalar *out) const {
+
+  // basis weights of each row, column and slice
+  AxisWeights axis[VDimension];
+  for (unsigned int d = 0; d < VDimension; ++d) {
+    const mwSize ngrid = param[d].size();
+    axis[d].first.resize(ngrid);
+    axis[d].weight.resize(ngrid * (this->order + 1));
+    for (mwIndex i = 0; i < ngrid; ++i) {
+      if (param[d][i] < 0.0 || param[d][i] > 1.0) {
+	mexErrMsgTxt("BSplineGridEvaluator: Grid outside of the domain of the B-spline");
+      }
+      this->ComputeBasis(param[d][i], this->latticeSize[d], axis[d].first[i],
+			 &axis[d].weight[i * (this->order + 1)]);
+    }
+  }
+
+  // the last dimension is evaluated in parallel, and each thread
+  // contracts the lattice in its own work buffers
+  const unsigned int last = VDimension - 1;
+  const mwSize nlast = param[last].size();
+
+#ifdef _OPENMP
+#pragma omp parallel
+#endif
+  {
+    std::vector<double> work[VDimension];
+    for (unsigned int d = 0; d < VDimension; ++d) {
+      work[d].resize(this->blockSize[d]);
+    }
+
+#ifdef _OPENMP
+#pragma omp for schedule(dynamic)
+#endif
+    for (mwSignedIndex i = 0; i < (mwSignedIndex)nlast; ++i) {
+
+      // contract the lattice along the last dimension
+      std::vector<double> &res = work[last];
+      std::fill(res.begin(), res.end(), 0.0);
+      const double *w = &axis[last].weight[i * (this->order + 1)];
+      const double *coeff = &this->lattice[axis[last].first[i] * this->blockSize[last]];
+      for (unsigned int j = 0; j <= this->order; ++j) {
+	const double *c = coeff + j * this->blockSize[last];
+	for (mwIndex k = 0; k < this->blockSize[last]; ++k) {
+	  res[k] += w[j] * c[k];
+	}
+      }
+
+      // contract the lower dimensions
+      if (last > 0) {
+	this->EvaluateLevel(last - 1, &res[0], i * stride[last], axis, stride,
+			    compStride, scale, work, out);
+      } else {
+	for (unsigned int c = 0; c < VDimension; ++c) {
+	  out[i * stride[last] + c * compStride] = (TScalar)(scale * res[c]);
+	}
+      }
+
+    }
+  }
+
+}
+
+template <unsigned int VDimension>
+template <class TScalar>
+void BSplineGridEvaluator<VDimension>::EvaluateLevel(unsigned int d, const double *coeff,
+						     mwIndex outOffset,
+						     const AxisWeights *axis,
+						     const mwSize *stride,
+						     mwSize compStride, double scale,
+						     std::vector<double> *work,
+						     TScalar *out) const {
+
+  const mwSize ngrid = axis[d].first.size();
+  const mwSize block = this->blockSize[d];
+  double *res = &work[d][0];
+
+  for (mwIndex i = 0; i < ngrid; ++i) {
+
+    std::fill(res, res + block, 0.0);
+    const double *w = &axis[d].weight[i * (this->order + 1)];
+    const double *c0 = coeff + axis[d].first[i] * block;
+    for (unsigned int j = 0; j <= this->order; ++j) {
+      const double *c = c0 + j * block;
+      for (mwIndex k = 0; k < block; ++k) {
+	res[k] += w[j] * c[k];
+      }
+    }
+
+    if (d > 0) {
+      this->EvaluateLevel(d - 1, res, outOffset + i * stride[d], axis, stride,
+			  compStride, scale, work, out);
+    } else {
+      for (unsigned int c = 0; c < VDimension; ++c) {
+	out[outOffset + i * stride[d] + c * compStride] = (TScalar)(scale * res[c]);
+      }
+    }
+
+  }
+
+}
+
+#endif /* BSPLINEGRIDEVALUATOR_H */
@@ -0,0 +1,245 @@
+/*
+ * DistanceMapClosestPoint.h
+ *
+ * DistanceMapClosestPoint: approximate closest point queries on a
+ * fixed point set with a precomputed distance map.
+ *
+ * The fixed point set is rasterised on a grid, and the distance d(p)
+ * from each voxel to the nearest point is computed once (e.g. with
+ * itk::SignedMaurerDistanceMapImageFilter). This class computes the
+ * gradient of the map with central differences, and then answers each
+ * query p with trilinear interpolation of d and its gradient g. As
+ * the gradient of a Euclidean distance map is a unit vector that
+ * points away from the nearest point, the closest point is
+ *
+ *   x = p - d(p) g(p) / |g(p)|
+ *
+ * A query costs the same regardless of the number of fixed points.
+ * The accuracy is limited by the voxel size of the map. Query points
+ * outside the grid are projected onto the grid first, so that they
+ * are still paired with a point near the edge of the fixed set.
+ *
+ * The gradient vanishes on the fixed points and on the medial axis of
+ * the set. Within half a voxel diagonal of the fixed set, the query is
+ * paired with its projection onto the grid. Farther away, on the
+ * medial axis, the direction to the closest point is unknown, and the
+ * query is rejected with an infinite distance, so that it is left out
+ * of the transform estimate by IterativeClosestPoint.
+ *
+ * The query interface is the same as PointKdTree::FindClosestPoint(),
+ * so both classes can be used by IterativeClosestPoint.
+ *
+ * An example of how to use this class in a MEX Matlab function:
+ *
+ *   // dist: distance map with size (n0, n1, n2), stored with the
+ *   //       first index running fastest, as in an itk::Image
+ *   DistanceMapClosestPoint map(size, spacing, origin, dist);
+ *
+ *   // p: 3-vector with the query point
+ *   double x[3], dist2;
+ *   map.FindClosestPoint(p, x, dist2);
+ *
+ */
+
+/*
+ * Author: Ramon Casero <rcasero@gmail.com>
+ * Copyright © 2014 University of Oxford
+ * Version: 0.1.2
+ *
+ * University of Oxford means the Chancellor, Masters and Scholars of
+ * the University of Oxford, having an administrative office at
+ * Wellington Square, Oxford OX1 2JD, UK.
+ *
+ * This file is part of Gerardus.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details. The offer of this
+ * program under the terms of the License is subject to the License
+ * being interpreted in accordance with English Law and subject to any
+ * action against the University of Oxford being under the jurisdiction
+ * of the English Courts.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see
+ * <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef DISTANCEMAPCLOSESTPOINT_H
+#define DISTANCEMAPCLOSESTPOINT_H
+
+/* mex headers */
+#include <mex.h>
+
+/* C++ headers */
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <vector>
+
+class DistanceMapClosestPoint {
+
+ public:
+
+  // size:    3-vector with the number of voxels along each axis
+  // spacing: 3-vector with the voxel size along each axis
+  // origin:  3-vector with the coordinates of the first voxel
+  // dist:    distance from each voxel to the nearest fixed point,
+  //          stored with the first index running fastest. Negative
+  //          values (voxels inside the rasterised set) are taken as 0
+  template <class TScalar>
+  DistanceMapClosestPoint(const mwSize *size, const double *spacing,
+			  const double *origin, const TScalar *dist);
+
+  // p:     3-vector with the query point
+  // x:     3-vector with the approximate closest fixed point
+  // dist2: squared distance from p to x, or infinity if p is on the
+  //        medial axis of the fixed set and x is undefined
+  void FindClosestPoint(const double *p, double *x, double &dist2) const;
+
+ private:
+
+  static const unsigned int Dimension = 3;
+
+  mwSize size[Dimension];
+  double spacing[Dimension];
+  double origin[Dimension];
+  mwSize stride[Dimension];
+
+  // half the voxel diagonal
+  double halfDiagonal;
+
+  // distance map and its gradient. They are stored in single
+  // precision to halve the memory, as they are only as accurate as
+  // the voxel size
+  std::vector<float> dist;
+  std::vector<float> grad[Dimension];
+
+};
+
+/*
+ * Definitions
+ */
+
+template <class TScalar>
+DistanceMapClosestPoint::DistanceMapClosestPoint(const mwSize *_size,
+						 const double *_spacing,
+						 const double *_origin,
+						 const TScalar *_dist) {
+
+  mwSize nvox = 1;
+  this->halfDiagonal = 0.0;
+  for (unsigned int d = 0; d < Dimension; ++d) {
+    this->halfDiagonal += 0.25 * _spacing[d] * _spacing[d];
+    this->size[d] = _size[d];
+    this->spacing[d] = _spacing[d];
+    this->origin[d] = _origin[d];
+    this->stride[d] = nvox;
+    nvox *= _size[d];
+    if (_size[d] < 2) {
+      mexErrMsgTxt("DistanceMapClosestPoint: The distance map must have at least 2 voxels along each axis");
+    }
+  }
+  this->halfDiagonal = std::sqrt(this->halfDiagonal);
+
+  this->dist.resize(nvox);
+  for (mwIndex i = 0; i < nvox; ++i) {
+    this->dist[i] = (float)std::max((double)_dist[i], 0.0);
+  }
+
+  // gradient with central differences, and one-sided differences on
+  // the edges of the grid
+  for (unsigned int d = 0; d < Dimension; ++d) {
+    this->grad[d].resize(nvox);
+  }
+  const mwSize nslices = this->size[Dimension - 1];
+  const mwSize sliceSize = this->stride[Dimension - 1];
+
+#ifdef _OPENMP
+#pragma omp parallel for
+#endif
+  for (mwSignedIndex s = 0; s < (mwSignedIndex)nslices; ++s) {
+    for (mwIndex k = 0; k < sliceSize; ++k) {
+      const mwIndex i = s * sliceSize + k;
+      for (unsigned int d = 0; d < Dimension; ++d) {
+	const mwIndex id = (i / this->stride[d]) % this->size[d];
+	const mwIndex lo = (id > 0) ? i - this->stride[d] : i;
+	const mwIndex hi = (id + 1 < this->size[d]) ? i + this->stride[d] : i;
+	const double h = (double)((hi - lo) / this->stride[d]) * this->spacing[d];
+	this->grad[d][i] = (float)(((double)this->dist[hi] - (double)this->dist[lo]) / h);
+      }
+    }
+  }
+
+}
+
+inline
+void DistanceMapClosestPoint::FindClosestPoint(const double *p, double *x,
+					       double &dist2) const {
+
+  // project the query point onto the grid, and find the voxel at the
+  // corner of the interpolation cell and the weights of the cell
+  double q[Dimension];
+  mwIndex corner = 0;
+  double t[Dimension];
+  for (unsigned int d = 0; d < Dimension; ++d) {
+    double u = (p[d] - this->origin[d]) / this->spacing[d];
+    u = std::min(std::max(u, 0.0), (double)(this->size[d] - 1));
+    q[d] = this->origin[d] + u * this->spacing[d];
+    double cell = std::min(std::floor(u), (double)(this->size[d] - 2));
+    t[d] = u - cell;
+    corner += (mwIndex)cell * this->stride[d];
+  }
+
+  // trilinear interpolation of the distance and its gradient
+  double dq = 0.0;
+  double g[Dimension] = {0.0, 0.0, 0.0};
+  for (unsigned int c = 0; c < (1u << Dimension); ++c) {
+    double w = 1.0;
+    mwIndex i = corner;
+    for (unsigned int d = 0; d < Dimension; ++d) {
+      if (c & (1u << d)) {
+	w *= t[d];
+	i += this->stride[d];
+      } else {
+	w *= 1.0 - t[d];
+      }
+    }
+    dq += w * this->dist[i];
+    for (unsigned int d = 0; d < Dimension; ++d) {
+      g[d] += w * this->grad[d][i];
+    }
+  }
+
+  // step from the query point to the closest point, along the
+  // gradient. Where the gradient vanishes, the projected point is its
+  // own pair if it is on the fixed set. On the medial axis there is no
+  // pair, and the query is rejected
+  double gnorm = std::sqrt(g[0] * g[0] + g[1] * g[1] + g[2] * g[2]);
+  if (gnorm <= 1e-6) {
+    dist2 = 0.0;
+    for (unsigned int d = 0; d < Dimension; ++d) {
+      x[d] = q[d];
+      dist2 += (p[d] - q[d]) * (p[d] - q[d]);
+    }
+    if (dq > this->halfDiagonal) {
+      dist2 = std::numeric_limits<double>::infinity();
+    }
+    return;
+  }
+  double step = dq / gnorm;
+  dist2 = 0.0;
+  for (unsigned int d = 0; d < Dimension; ++d) {
+    x[d] = q[d] - step * g[d];
+    dist2 += (p[d] - x[d]) * (p[d] - x[d]);
+  }
+
+}
+
+#endif /* DISTANCEMAPCLOSESTPOINT_H */
@@ -0,0 +1,275 @@
+/*
+ * DistanceMorphology.h
+ *
+ * Binary and multi-label dilation and erosion with a Euclidean ball,
+ * computed by thresholding the exact distance transform in
+ * ExactDistanceTransform.h, for 2D, 3D or 4D images stored in a
+ * Matlab buffer.
+ *
+ * The cost of a dilation or erosion with a structuring element grows
+ * with the size of the element, whereas the cost of the distance
+ * transform is the same for any radius. Voxel size is taken into
+ * account, so the ball is exact in real world units also for
+ * anisotropic voxels.
+ *
+ * DistanceBinaryMorphology(): dilation or erosion of the voxels with
+ * a foreground value. As in itk::BinaryErodeImageFilter, eroded voxels
+ * are set to a background value, which need not be 0.
+ *
+ * DistanceLabelDilate(): dilation of all the labels of a segmentation
+ * at the same time. Each background voxel within the ball radius of
+ * any label is given the label of the closest labelled voxel.
+ *
+ * DistanceLabelErode(): erosion of all the labels of a segmentation.
+ * A voxel is eroded if it is within the ball radius of a voxel with
+ * a different label (including background). Each label is computed
+ * within its bounding box, expanded by the radius.
+ *
+ * In all functions, voxels outside the image are not considered
+ * background, so the image boundary does not erode labels.
+ */
+
+/*
+ * Author: Ramon Casero <rcasero@gmail.com>
+ * Copyright © 2014 University of Oxford
+ * Version: 0.1.3
+ *
+ * University of Oxford means the Chancellor, Masters and Scholars of
+ * the University of Oxford, having an administrative office at
+ * Wellington Square, Oxford OX1 2JD, UK.
+ *
+ * This file is part of Gerardus.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details. The offer of this
+ * program under the terms of the License is subject to the License
+ * being interpreted in accordance with English Law and subject to any
+ * action against the University of Oxford being under the jurisdiction
+ * of the English Courts.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see
+ * <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef DISTANCEMORPHOLOGY_H
+#define DISTANCEMORPHOLOGY_H
+
+/* mex headers */
+#include <mex.h>
+
+/* C++ headers */
+#include <algorithm>
+#include <cmath>
+#include <map>
+#include <vector>
+
+/* Gerardus headers */
+#include "GerardusCommon.h"
+#include "ExactDistanceTransform.h"
+
+// radius above which 'bwdilate' and 'bwerode' in itk_imfilter()
+// threshold the exact distance transform instead of running the ITK
+// filter
+const unsigned long DISTANCE_MORPHOLOGY_MIN_RADIUS = 4;
+
+/*
+ * DistanceBallRadius(): radius in real world units of the ball that
+ * replaces itk::BinaryBallStructuringElement of radius radius. The
+ * ITK ball contains the voxels at distance <= radius+0.5 voxels from
+ * the centre. The voxel side is the smallest of the image spacing,
+ * so that the ball is the same as ITK's for isotropic voxels
+ */
+inline double DistanceBallRadius(const std::vector<double> &spacing,
+				 unsigned long radius) {
+
+  double side = 1.0;
+  if (!spacing.empty()) {
+    side = *std::min_element(spacing.begin(), spacing.end());
+  }
+  return (radius + 0.5) * side;
+
+}
+
+/*
+ * DistanceBinaryMorphology(): dilation (isDilate == true) or erosion
+ * of the voxels in image a with value foreground, with a ball of
+ * radius radius. Dilated voxels are set to foreground, eroded voxels
+ * are set to background, and all other voxels keep their value in
+ * a. Output image b must have the same size as a
+ */
+template <class TPixel>
+void DistanceBinaryMorphology(const TPixel *a, TPixel *b,
+			      const std::vector<mwSize> &size,
+			      const std::vector<double> &spacing,
+			      double radius, TPixel foreground,
+			      TPixel background, bool isDilate) {
+
+  ExactDistanceTransform edt(size, spacing);
+  const mwSize n = edt.GetNumberOfVoxels();
+
+  // foreground mask
+  std::vector<uint8_T> mask(n);
+  for (mwIndex i = 0; i < n; ++i) {
+    mask[i] = (a[i] == foreground);
+  }
+
+  // dilation: distance from background voxels to the foreground.
+  // Erosion: distance from foreground voxels to the background
+  std::vector<double> sqdist(n);
+  edt.Compute(&mask[0], isDilate, &sqdist[0], NULL);
+
+  const double r2 = radius * radius;
+  for (mwIndex i = 0; i < n; ++i) {
+    if (sqdist[i] > r2) {
+      b[i] = a[i];
+    } else if (isDilate) {
+      b[i] = foreground;
+    } else {
+      b[i] = mask[i] ? background : a[i];
+    }
+  }
+
+}
+
+/*
+ * DistanceLabelDilate(): dilation of all non-zero labels in image a
+ * with a ball of radius radius. Labelled voxels keep their label, and
+ * background voxels get the label of the closest labelled voxel, if
+ * it is within the radius. Output image b must have the same size as
+ * a
+ */
+template <class TPixel>
+void DistanceLabelDilate(const TPixel *a, TPixel *b,
+			 const std::vector<mwSize> &size,
+			 const std::vector<double> &spacing,
+			 double radius) {
+
+  ExactDistanceTransform edt(size, spacing);
+  const mwSize n = edt.GetNumberOfVoxels();
+
+  // distance from each voxel to the closest labelled voxel
+  std::vector<double> sqdist(n);
+  std::vector<int32_T> nearest(n);
+  edt.Compute(a, true, &sqdist[0], &nearest[0]);
+
+  const double r2 = radius * radius;
+  for (mwIndex i = 0; i < n; ++i) {
+    if (a[i] == 0 && nearest[i] >= 0 && sqdist[i] <= r2) {
+      b[i] = a[nearest[i]];
+    } else {
+      b[i] = a[i];
+    }
+  }
+
+}
+
+/*
+ * DistanceLabelErode(): erosion of all non-zero labels in image a with
+ * a ball of radius radius. Voxels within the radius of a voxel with a
+ * different value are set to 0. Output image b must have the same
+ * size as a
+ */
+template <class TPixel>
+void DistanceLabelErode(const TPixel *a, TPixel *b,
+			const std::vector<mwSize> &size,
+			const std::vector<double> &spacing,
+			double radius) {
+
+  const size_t ndim = size.size();
+  mwSize n = 1;
+  for (size_t d = 0; d < ndim; ++d) {
+    n *= size[d];
+  }
+  std::vector<double> sp(spacing);
+  if (sp.size() != ndim) {
+    sp.assign(ndim, 1.0);
+  }
+
+  // bounding box of each label
+  typedef std::pair<std::vector<mwIndex>, std::vector<mwIndex> > BoxType;
+  typedef std::map<TPixel, BoxType> BoxMapType;
+  BoxMapType boxes;
+  std::vector<mwIndex> sub(ndim);
+  for (mwIndex i = 0; i < n; ++i) {
+    b[i] = a[i];
+    if (a[i] == 0) {
+      continue;
+    }
+    mwIndex r = i;
+    for (size_t d = 0; d < ndim; ++d) {
+      sub[d] = r % size[d];
+      r /= size[d];
+    }
+    typename BoxMapType::iterator it = boxes.find(a[i]);
+    if (it == boxes.end()) {
+      boxes[a[i]] = BoxType(sub, sub);
+    } else {
+      for (size_t d = 0; d < ndim; ++d) {
+	it->second.first[d] = std::min(it->second.first[d], sub[d]);
+	it->second.second[d] = std::max(it->second.second[d], sub[d]);
+      }
+    }
+  }
+
+  const double r2 = radius * radius;
+  for (typename BoxMapType::const_iterator it = boxes.begin();
+       it != boxes.end(); ++it) {
+
+    // exit if user pressed Ctrl+C
+    ctrlcCheckPoint(__FILE__, __LINE__);
+
+    // bounding box expanded by the radius, so that it contains all
+    // the voxels that can erode the label
+    std::vector<mwIndex> from(ndim);
+    std::vector<mwSize> cropSize(ndim);
+    mwSize ncrop = 1;
+    for (size_t d = 0; d < ndim; ++d) {
+      const mwIndex margin = (mwIndex)std::ceil(radius / sp[d]);
+      from[d] = (it->second.first[d] > margin) ? it->second.first[d] - margin : 0;
+      const mwIndex to = std::min(it->second.second[d] + margin, size[d] - 1);
+      cropSize[d] = to - from[d] + 1;
+      ncrop *= cropSize[d];
+    }
+
+    // linear index in the image of each voxel in the crop, and mask
+    // of the label
+    std::vector<mwIndex> idx(ncrop);
+    std::vector<uint8_T> mask(ncrop);
+    for (mwIndex j = 0; j < ncrop; ++j) {
+      mwIndex r = j;
+      mwIndex i = 0;
+      mwSize stride = 1;
+      for (size_t d = 0; d < ndim; ++d) {
+	i += (from[d] + r % cropSize[d]) * stride;
+	r /= cropSize[d];
+	stride *= size[d];
+      }
+      idx[j] = i;
+      mask[j] = (a[i] == it->first);
+    }
+
+    // distance from the label voxels to the closest voxel with a
+    // different value
+    ExactDistanceTransform edt(cropSize, sp);
+    std::vector<double> sqdist(ncrop);
+    edt.Compute(&mask[0], false, &sqdist[0], NULL);
+
+    for (mwIndex j = 0; j < ncrop; ++j) {
+      if (mask[j] && sqdist[j] <= r2) {
+	b[idx[j]] = 0;
+      }
+    }
+
+  }
+
+}
+
+#endif /* DISTANCEMORPHOLOGY_H */
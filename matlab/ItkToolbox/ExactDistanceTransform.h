@@ -0,0 +1,265 @@
+/*
+ * ExactDistanceTransform.h
+ *
+ * ExactDistanceTransform: exact Euclidean distance transform of a 2D,
+ * 3D or 4D image stored in a Matlab buffer.
+ *
+ * The squared distance is computed with the separable algorithm of
+ * Felzenszwalb and Huttenlocher (a variant of Meijster et al.'s): a
+ * 1D transform along each axis in turn, where each 1D transform
+ * computes the lower envelope of the parabolas rooted at the values
+ * computed along the previous axes. Each line along an axis is
+ * independent from the others, so the lines are processed in
+ * parallel with OpenMP, if available.
+ *
+ * Voxel size (e.g. from a SCI MAT struct) is taken into account, so
+ * distances are in real world units.
+ *
+ * Optionally, the transform also computes the linear index of the
+ * closest feature voxel to each voxel. The index is carried along
+ * with the parabolas from one axis to the next, so it costs one
+ * int32 array and no extra passes. It is only computed when the
+ * caller provides a buffer for it.
+ *
+ *   P. F. Felzenszwalb and D. P. Huttenlocher, "Distance Transforms of
+ *   Sampled Functions", Theory of Computing, 8(19):415-428, 2012.
+ *
+ *   A. Meijster, J. B. T. M. Roerdink and W. H. Hesselink, "A general
+ *   algorithm for computing distance transforms in linear time",
+ *   Mathematical Morphology and its Applications to Image and Signal
+ *   Processing, pp. 331-340, 2000.
+ *
+ * An example of how to use this class in a MEX Matlab function:
+ *
+ *   MatlabImageHeader im(prhs[1], "A");
+ *   ExactDistanceTransform edt(im.size, im.spacing);
+ *
+ *   // squared distance from each voxel to the closest non-zero voxel,
+ *   // and the index of that voxel
+ *   std::vector<double> sqdist(edt.GetNumberOfVoxels());
+ *   std::vector<int32_T> nearest(edt.GetNumberOfVoxels());
+ *   edt.Compute((uint8_T *)mxGetData(im.data), true, &sqdist[0], &nearest[0]);
+ *
+ */
+
+/*
+ * Author: Ramon Casero <rcasero@gmail.com>
+ * Copyright © 2014 University of Oxford
+ * Version: 0.1.1
+ *
+ * University of Oxford means the Chancellor, Masters and Scholars of
+ * the University of Oxford, having an administrative office at
+ * Wellington Square, Oxford OX1 2JD, UK.
+ *
+ * This file is part of Gerardus.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details. The offer of this
+ * program under the terms of the License is subject to the License
+ * being interpreted in accordance with English Law and subject to any
+ * action against the University of Oxford being under the jurisdiction
+ * of the English Courts.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see
+ * <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef EXACTDISTANCETRANSFORM_H
+#define EXACTDISTANCETRANSFORM_H
+
+/* mex headers */
+#include <mex.h>
+
+/* C++ headers */
+#include <limits>
+#include <vector>
+
+/* Gerardus headers */
+#include "GerardusCommon.h"
+
+class ExactDistanceTransform {
+
+ public:
+
+  // size and voxel size of the image, in Matlab order (row, column,
+  // slice, ...)
+  ExactDistanceTransform(const std::vector<mwSize> &_size,
+			 const std::vector<double> &_spacing)
+    : size(_size), spacing(_spacing) {
+    if (this->spacing.size() != this->size.size()) {
+      this->spacing.assign(this->size.size(), 1.0);
+    }
+  }
+
+  mwSize GetNumberOfVoxels() const {
+    mwSize n = 1;
+    for (size_t d = 0; d < this->size.size(); ++d) {
+      n *= this->size[d];
+    }
+    return n;
+  }
+
+  // compute the squared distance from each voxel to the closest
+  // feature voxel. Feature voxels are the non-zero voxels of im if
+  // isFeatureNonZero == true, and the zero voxels otherwise.
+  //
+  // sqdist:  output buffer with the squared distances. If there are
+  //          no feature voxels, all distances are Inf
+  // nearest: output buffer with the 0-based linear index of the
+  //          closest feature voxel, or -1 if there are no feature
+  //          voxels. If NULL, the closest voxels are not computed
+  template <class TPixel>
+  void Compute(const TPixel *im, bool isFeatureNonZero,
+	       double *sqdist, int32_T *nearest) const;
+
+ private:
+
+  std::vector<mwSize> size;
+  std::vector<double> spacing;
+
+  void TransformAxis(size_t axis, double *sqdist, int32_T *nearest) const;
+
+};
+
+template <class TPixel>
+void ExactDistanceTransform::Compute(const TPixel *im, bool isFeatureNonZero,
+				     double *sqdist, int32_T *nearest) const {
+
+  const mwSize n = this->GetNumberOfVoxels();
+  const double inf = std::numeric_limits<double>::infinity();
+
+  // the closest feature voxel is stored as an int32 linear index
+  if (nearest && n > (mwSize)std::numeric_limits<int32_T>::max()) {
+    mexErrMsgTxt("ExactDistanceTransform: Image too large to compute int32 indices of the closest voxels");
+  }
+
+  // feature voxels are at distance 0 from themselves
+#ifdef _OPENMP
+#pragma omp parallel for schedule(static)
+#endif
+  for (mwSignedIndex i = 0; i < (mwSignedIndex)n; ++i) {
+    bool isFeature = ((im[i] != 0) == isFeatureNonZero);
+    sqdist[i] = isFeature ? 0.0 : inf;
+    if (nearest) {
+      nearest[i] = isFeature ? (int32_T)i : -1;
+    }
+  }
+
+  // 1D transform along each axis
+  for (size_t axis = 0; axis < this->size.size(); ++axis) {
+
+    // exit if user pressed Ctrl+C
+    ctrlcCheckPoint(__FILE__, __LINE__);
+
+    this->TransformAxis(axis, sqdist, nearest);
+  }
+
+}
+
+// 1D transform of all the lines along one axis
+inline
+void ExactDistanceTransform::TransformAxis(size_t axis, double *sqdist,
+					   int32_T *nearest) const {
+
+  const mwSize len = this->size[axis];
+  if (len < 2) {
+    return;
+  }
+
+  // distance between consecutive voxels in the line, in memory and in
+  // real world units
+  mwSize stride = 1;
+  for (size_t d = 0; d < axis; ++d) {
+    stride *= this->size[d];
+  }
+  const double w = this->spacing[axis] * this->spacing[axis];
+  const mwSize nlines = this->GetNumberOfVoxels() / len;
+  const double inf = std::numeric_limits<double>::infinity();
+
+#ifdef _OPENMP
+#pragma omp parallel
+#endif
+  {
+
+    // line buffers, one set per thread
+    std::vector<double> f(len);      // input squared distances
+    std::vector<int32_T> idx(nearest ? len : 0);
+    std::vector<mwIndex> v(len);     // roots of the parabolas in the lower envelope
+    std::vector<double> z(len + 1);  // boundaries between parabolas
+
+#ifdef _OPENMP
+#pragma omp for schedule(static)
+#endif
+    for (mwSignedIndex line = 0; line < (mwSignedIndex)nlines; ++line) {
+
+      // first voxel of the line
+      const mwIndex start = (line % stride) + (line / stride) * stride * len;
+
+      // copy the line to the buffer
+      for (mwIndex q = 0; q < len; ++q) {
+	f[q] = sqdist[start + q * stride];
+      }
+      if (nearest) {
+	for (mwIndex q = 0; q < len; ++q) {
+	  idx[q] = nearest[start + q * stride];
+	}
+      }
+
+      // lower envelope of the parabolas w*(x-q)^2 + f[q]. Voxels at
+      // infinite distance don't contribute any parabola
+      mwSignedIndex k = -1;
+      for (mwIndex q = 0; q < len; ++q) {
+	if (f[q] == inf) {
+	  continue;
+	}
+	double s = -inf;
+	while (k >= 0) {
+	  // intersection of the new parabola with the last one in the
+	  // envelope
+	  const mwIndex p = v[k];
+	  s = ((f[q] + w * q * q) - (f[p] + w * p * p)) / (2.0 * w * (q - p));
+	  if (s > z[k]) {
+	    break;
+	  }
+	  --k;
+	  s = -inf;
+	}
+	++k;
+	v[k] = q;
+	z[k] = s;
+	z[k + 1] = inf;
+      }
+
+      // no feature voxel visible from this line
+      if (k < 0) {
+	continue;
+      }
+
+      // read the distances from the envelope
+      mwIndex j = 0;
+      for (mwIndex q = 0; q < len; ++q) {
+	while (z[j + 1] < (double)q) {
+	  ++j;
+	}
+	const double dq = (double)q - (double)v[j];
+	sqdist[start + q * stride] = w * dq * dq + f[v[j]];
+	if (nearest) {
+	  nearest[start + q * stride] = idx[v[j]];
+	}
+      }
+
+    }
+
+  }
+
+}
+
+#endif /* EXACTDISTANCETRANSFORM_H */
@@ -0,0 +1,271 @@
+/*
+ * HistogramMedian.h
+ *
+ * HistogramMedian(): median filter with a box neighbourhood for 2D,
+ * 3D or 4D images with 8 or 16 bit integer pixels (logical, int8,
+ * uint8, int16, uint16), stored in a Matlab buffer.
+ *
+ * itk::MedianImageFilter copies and partially sorts the whole box
+ * around each voxel, so its cost grows with the cube of the radius in
+ * 3D. Instead, this function keeps a histogram of the box that slides
+ * along the first dimension (Matlab rows, contiguous in memory),
+ * similarly to Huang's and Perreault and Hebert's algorithms. When
+ * the box moves one voxel, the values of the plane of voxels that
+ * leave the box are removed from the histogram, and the values that
+ * enter it are added, so the cost per voxel grows with the square of
+ * the radius.
+ *
+ * The histogram has two tiers (coarse bins of 2^(nbits/2) fine bins)
+ * like Perreault and Hebert's, so that the median can be found
+ * without scanning all the 65536 bins of a 16 bit histogram. The
+ * coarse bin that contains the median is tracked incrementally.
+ *
+ * Column histograms shared between rows, as in Perreault and Hebert's
+ * 2D algorithm, are not used. In 3D they would need one 16 bit
+ * histogram per column of the image, and adding or subtracting a
+ * whole histogram is not cheaper than updating a plane of voxels for
+ * the radii typically used.
+ *
+ * Each row is filtered independently, so rows are processed in
+ * parallel with OpenMP, if available, with one histogram per thread.
+ *
+ * Boundary conditions are the same as in itk::MedianImageFilter (zero
+ * flux Neumann, i.e. voxels outside the image take the value of the
+ * closest voxel inside), so results are identical.
+ *
+ *   T. Huang, G. Yang and G. Tang, "A fast two-dimensional median
+ *   filtering algorithm", IEEE Transactions on Acoustics, Speech and
+ *   Signal Processing, 27(1):13-18, 1979.
+ *
+ *   S. Perreault and P. Hebert, "Median Filtering in Constant Time",
+ *   IEEE Transactions on Image Processing, 16(9):2389-2394, 2007.
+ */
+
+/*
+ * Author: Ramon Casero <rcasero@gmail.com>
+ * Copyright © 2014 University of Oxford
+ * Version: 0.1.0
+ *
+ * University of Oxford means the Chancellor, Masters and Scholars of
+ * the University of Oxford, having an administrative office at
+ * Wellington Square, Oxford OX1 2JD, UK.
+ *
+ * This file is part of Gerardus.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details. The offer of this
+ * program under the terms of the License is subject to the License
+ * being interpreted in accordance with English Law and subject to any
+ * action against the University of Oxford being under the jurisdiction
+ * of the English Courts.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see
+ * <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef HISTOGRAMMEDIAN_H
+#define HISTOGRAMMEDIAN_H
+
+/* mex headers */
+#include <mex.h>
+
+/* C++ headers */
+#include <algorithm>
+#include <limits>
+#include <vector>
+
+/*
+ * SlidingHistogram: two-tier histogram of the values in a sliding
+ * window, that can find the k-th smallest value
+ */
+class SlidingHistogram {
+
+ public:
+
+  SlidingHistogram(unsigned int nbits)
+    : shift(nbits / 2), fine((mwSize)1 << nbits, 0),
+      coarse((mwSize)1 << (nbits - nbits / 2), 0), c(0), below(0) {}
+
+  void Add(mwIndex bin) {
+    ++this->fine[bin];
+    ++this->coarse[bin >> this->shift];
+    if ((bin >> this->shift) < this->c) {
+      ++this->below;
+    }
+  }
+
+  void Remove(mwIndex bin) {
+    --this->fine[bin];
+    --this->coarse[bin >> this->shift];
+    if ((bin >> this->shift) < this->c) {
+      --this->below;
+    }
+  }
+
+  // bin of the k-th smallest value in the window (k = 0, 1, ...). The
+  // window must have more than k values
+  mwIndex Rank(mwSize k) {
+
+    // move the tracked coarse bin until it contains the k-th value
+    while (this->below > k) {
+      --this->c;
+      this->below -= this->coarse[this->c];
+    }
+    while (this->below + this->coarse[this->c] <= k) {
+      this->below += this->coarse[this->c];
+      ++this->c;
+    }
+
+    // scan the fine bins within the coarse bin
+    mwSize acc = this->below;
+    mwIndex bin = this->c << this->shift;
+    while (acc + this->fine[bin] <= k) {
+      acc += this->fine[bin];
+      ++bin;
+    }
+    return bin;
+  }
+
+ private:
+
+  unsigned int shift;         // log2 of number of fine bins per coarse bin
+  std::vector<mwSize> fine;   // one bin per value
+  std::vector<mwSize> coarse; // sum of 2^shift fine bins
+  mwIndex c;                  // coarse bin that contained the last k-th value
+  mwSize below;               // number of values in coarse bins below c
+
+};
+
+/*
+ * HistogramMedian(): median filter of image im, with the box
+ * neighbourhood of half-size radius. size and radius are given in
+ * Matlab order (row, column, slice, ...). The output image out must
+ * have the same size as im.
+ */
+template <class TPixel>
+void HistogramMedian(const TPixel *im, const std::vector<mwSize> &size,
+		     const std::vector<mwSize> &radius, TPixel *out) {
+
+  const size_t ndim = size.size();
+  if (ndim == 0 || radius.size() != ndim) {
+    mexErrMsgTxt("HistogramMedian: radius must have one element per image dimension");
+  }
+
+  // number of voxels in the image and in the box, and the rank of the
+  // median in the box
+  mwSize n = 1;
+  mwSize nbox = 1;
+  for (size_t d = 0; d < ndim; ++d) {
+    n *= size[d];
+    nbox *= 2 * radius[d] + 1;
+  }
+  if (n == 0) {
+    return;
+  }
+  const mwSize k = nbox / 2;
+
+  // values are mapped to bins 0, 1, ..., 2^nbits - 1
+  const unsigned int nbits = 8 * sizeof(TPixel);
+  const long offset = -(long)std::numeric_limits<TPixel>::min();
+
+  // the image is processed as rows along the first dimension
+  const mwSize nx = size[0];
+  const mwSignedIndex rx = (mwSignedIndex)radius[0];
+  const mwSize nrows = n / nx;
+
+#ifdef _OPENMP
+#pragma omp parallel
+#endif
+  {
+
+    SlidingHistogram hist(nbits);
+    std::vector<mwIndex> rows;      // first voxel of the rows in the box
+    std::vector<mwSignedIndex> sub(ndim, 0);  // row subscripts
+    std::vector<mwSignedIndex> off(ndim, 0);  // offsets within the box
+
+#ifdef _OPENMP
+#pragma omp for schedule(static)
+#endif
+    for (mwSignedIndex row = 0; row < (mwSignedIndex)nrows; ++row) {
+
+      // subscripts of this row in dimensions 1, 2, ...
+      mwIndex r = (mwIndex)row;
+      for (size_t d = 1; d < ndim; ++d) {
+	sub[d] = r % size[d];
+	r /= size[d];
+      }
+
+      // rows within the box, with coordinates clamped to the image,
+      // so that rows outside the image repeat the closest row inside
+      rows.clear();
+      for (size_t d = 1; d < ndim; ++d) {
+	off[d] = -(mwSignedIndex)radius[d];
+      }
+      while (true) {
+	mwIndex first = 0;
+	mwSize stride = nx;
+	for (size_t d = 1; d < ndim; ++d) {
+	  mwSignedIndex s = sub[d] + off[d];
+	  s = std::max((mwSignedIndex)0, std::min((mwSignedIndex)size[d] - 1, s));
+	  first += s * stride;
+	  stride *= size[d];
+	}
+	rows.push_back(first);
+
+	// next offset in the box
+	size_t d = 1;
+	while (d < ndim && off[d] == (mwSignedIndex)radius[d]) {
+	  off[d] = -(mwSignedIndex)radius[d];
+	  ++d;
+	}
+	if (d == ndim) {
+	  break;
+	}
+	++off[d];
+      }
+
+      // box around the first voxel of the row
+      for (size_t i = 0; i < rows.size(); ++i) {
+	for (mwSignedIndex x = -rx; x <= rx; ++x) {
+	  mwSignedIndex xc = std::max((mwSignedIndex)0, std::min((mwSignedIndex)nx - 1, x));
+	  hist.Add((mwIndex)((long)im[rows[i] + xc] + offset));
+	}
+      }
+
+      // slide the box along the row
+      const mwIndex first = (mwIndex)row * nx;
+      for (mwSignedIndex x = 0; x < (mwSignedIndex)nx; ++x) {
+	if (x > 0) {
+	  mwSignedIndex xOut = std::max((mwSignedIndex)0, x - rx - 1);
+	  mwSignedIndex xIn = std::min((mwSignedIndex)nx - 1, x + rx);
+	  for (size_t i = 0; i < rows.size(); ++i) {
+	    hist.Remove((mwIndex)((long)im[rows[i] + xOut] + offset));
+	    hist.Add((mwIndex)((long)im[rows[i] + xIn] + offset));
+	  }
+	}
+	out[first + x] = (TPixel)((long)hist.Rank(k) - offset);
+      }
+
+      // empty the histogram for the next row
+      for (size_t i = 0; i < rows.size(); ++i) {
+	for (mwSignedIndex x = (mwSignedIndex)nx - 1 - rx; x <= (mwSignedIndex)nx - 1 + rx; ++x) {
+	  mwSignedIndex xc = std::max((mwSignedIndex)0, std::min((mwSignedIndex)nx - 1, x));
+	  hist.Remove((mwIndex)((long)im[rows[i] + xc] + offset));
+	}
+      }
+
+    }
+
+  }
+
+}
+
+#endif /* HISTOGRAMMEDIAN_H */
@@ -0,0 +1,637 @@
+/*
+ * IterativeClosestPoint.h
+ *
+ * IterativeClosestPoint: Iterative Closest Point (ICP) registration of
+ * a moving point set onto a fixed point set, with a translation,
+ * rigid, similarity or affine transform.
+ *
+ * Each iteration of ICP
+ *
+ *   1. warps the moving points with the current transform,
+ *   2. pairs each warped point with its nearest fixed point,
+ *   3. rejects the pairs with the largest distances (trimmed ICP), and
+ *   4. computes the transform that best maps the moving points onto
+ *      their pairs, in the least squares sense.
+ *
+ * Step 2 is delegated to a closest point class built once for the
+ * fixed set, and the moving points are paired in parallel with OpenMP.
+ * Two classes are provided:
+ *
+ *   PointKdTree:             exact nearest point, with a k-d tree. A
+ *                            query costs about log(n) instead of n
+ *   DistanceMapClosestPoint: approximate closest point, from a
+ *                            precomputed distance map of the fixed set
+ *                            and its gradient. A query costs the same
+ *                            regardless of n, but is only as accurate
+ *                            as the voxel size of the map
+ *
+ * Step 4 has a closed-form solution for each transform:
+ *
+ *   'translation': difference between the centroids. The linear part
+ *                  of the initial transform is kept
+ *   'rigid':       rotation and translation, with Horn's unit
+ *                  quaternion method
+ *   'similarity':  rotation, translation and isotropic scaling, also
+ *                  with Horn's method
+ *   'affine':      linear least squares
+ *
+ *   B.K.P. Horn, "Closed-form solution of absolute orientation using
+ *   unit quaternions", J Opt Soc Am A, 4(4):629-642, 1987.
+ *
+ *   D. Chetverikov, D. Svirko, D. Stepanov and P. Krsek, "The trimmed
+ *   iterative closest point algorithm", ICPR 2002, 3:545-548.
+ *
+ * The trimming fraction is the proportion of pairs kept in step 3, so
+ * that outliers and parts of the moving set without a counterpart in
+ * the fixed set do not pull the transform. Moving points that the
+ * closest point class cannot pair (returned with an infinite
+ * distance) are left out before trimming.
+ *
+ * Registration can be run at several levels of resolution. Level l
+ * uses one in 4^l moving points, and each level starts from the
+ * transform of the previous one, so that most iterations are run with
+ * few points. Levels too coarse to keep enough pairs to determine the
+ * transform after trimming (4 for affine, 3 for rigid or similarity)
+ * are skipped. At each level, iterations stop when the relative change
+ * of the RMS distance between pairs is below a tolerance, or after a
+ * maximum number of iterations.
+ *
+ * The RMS distance and the time of each iteration are stored, for
+ * the user to assess convergence.
+ *
+ * An example of how to use this class in a MEX Matlab function:
+ *
+ *   // x: (nx, 3)-matrix with the fixed points
+ *   // y: (ny, 3)-matrix with the moving points
+ *   PointKdTree<3> tree(nx, x);
+ *   IterativeClosestPoint icp(IterativeClosestPoint::RIGID);
+ *   icp.SetTrimFraction(0.9);
+ *   icp.SetNumberOfLevels(3);
+ *   icp.Register(tree, ny, y);
+ *
+ *   icp.GetTransform(t);            // (4, 4) homogeneous matrix
+ *   icp.TransformPoints(ny, y, y2);
+ *
+ */
+
+/*
+ * Author: Ramon Casero <rcasero@gmail.com>
+ * Copyright © 2014 University of Oxford
+ * Version: 0.2.3
+ *
+ * University of Oxford means the Chancellor, Masters and Scholars of
+ * the University of Oxford, having an administrative office at
+ * Wellington Square, Oxford OX1 2JD, UK.
+ *
+ * This file is part of Gerardus.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details. The offer of this
+ * program under the terms of the License is subject to the License
+ * being interpreted in accordance with English Law and subject to any
+ * action against the University of Oxford being under the jurisdiction
+ * of the English Courts.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see
+ * <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef ITERATIVECLOSESTPOINT_H
+#define ITERATIVECLOSESTPOINT_H
+
+/* mex headers */
+#include <mex.h>
+
+/* C++ headers */
+#include <algorithm>
+#include <cmath>
+#include <ctime>
+#include <limits>
+#include <vector>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+class IterativeClosestPoint {
+
+ public:
+
+  enum TransformType {TRANSLATION, RIGID, SIMILARITY, AFFINE};
+
+  // transformType: type of transform
+  IterativeClosestPoint(TransformType _transformType)
+    : transformType(_transformType), maxIterations(100), tolerance(1e-6), trimFraction(1.0), nlevels(1) {
+    this->SetIdentity();
+  }
+
+  // maximum number of iterations at each level of resolution
+  void SetNumberOfIterations(mwSize niter) {
+    this->maxIterations = niter;
+  }
+
+  // tolerance for the relative change of the RMS distance between pairs
+  void SetTolerance(double tol) {
+    this->tolerance = tol;
+  }
+
+  // proportion of pairs kept at each iteration, in (0, 1]
+  void SetTrimFraction(double trim) {
+    if (!(trim > 0.0 && trim <= 1.0)) {
+      mexErrMsgTxt("IterativeClosestPoint: Trimming fraction must be in (0, 1]");
+    }
+    this->trimFraction = trim;
+  }
+
+  // number of levels of resolution, >= 1
+  void SetNumberOfLevels(unsigned int n) {
+    if (n < 1) {
+      mexErrMsgTxt("IterativeClosestPoint: There must be at least one level of resolution");
+    }
+    this->nlevels = n;
+  }
+
+  // t: (4, 4) homogeneous matrix with the initial transform, stored by
+  //    columns. The last row is ignored
+  template <class TScalar>
+  void SetInitialTransform(const TScalar *t);
+
+  // fixed:   closest point class built on the fixed points, with a
+  //          method FindClosestPoint(p, x, dist2) that is thread-safe
+  //          (e.g. PointKdTree<3> or DistanceMapClosestPoint)
+  // nmoving: number of moving points
+  // moving:  (nmoving, 3)-matrix with the moving points, stored by columns
+  template <class TClosestPoint, class TScalar>
+  void Register(const TClosestPoint &fixed, mwSize nmoving, const TScalar *moving);
+
+  // t: (4, 4) homogeneous matrix with the transform, stored by
+  //    columns. A moving point y, as a column vector, is mapped to
+  //    t(1:3,1:3) * y + t(1:3,4)
+  template <class TScalar>
+  void GetTransform(TScalar *t) const;
+
+  // y:  (n, 3)-matrix with the points to warp
+  // y2: (n, 3)-matrix with the warped points
+  template <class TScalar>
+  void TransformPoints(mwSize n, const TScalar *y, TScalar *y2) const;
+
+  // RMS distance between pairs, time in seconds and level of
+  // resolution of each iteration
+  const std::vector<double> &GetRMS() const {
+    return this->rms;
+  }
+  const std::vector<double> &GetTime() const {
+    return this->time;
+  }
+  const std::vector<unsigned int> &GetLevel() const {
+    return this->level;
+  }
+
+ private:
+
+  static const unsigned int Dimension = 3;
+
+  TransformType transformType;
+  mwSize maxIterations;
+  double tolerance;
+  double trimFraction;
+  unsigned int nlevels;
+
+  // transform y -> a y + b
+  double a[Dimension][Dimension];
+  double b[Dimension];
+
+  // convergence history
+  std::vector<double> rms;
+  std::vector<double> time;
+  std::vector<unsigned int> level;
+
+  void SetIdentity();
+
+  // y2 = a y + b
+  void Warp(const double *y, double *y2) const {
+    for (unsigned int i = 0; i < Dimension; ++i) {
+      y2[i] = this->b[i];
+      for (unsigned int j = 0; j < Dimension; ++j) {
+	y2[i] += this->a[i][j] * y[j];
+      }
+    }
+  }
+
+  // least squares transform from the moving points y to their pairs
+  // x. Returns false if the points are degenerate for the transform
+  bool EstimateTransform(const std::vector<double> &y, const std::vector<double> &x,
+			 const std::vector<mwIndex> &pairs);
+
+  // eigenvector of the largest eigenvalue of a symmetric 4x4 matrix,
+  // with Jacobi rotations
+  static double LargestEigenvector(double m[4][4], double *v);
+
+  static double WallTime() {
+#ifdef _OPENMP
+    return omp_get_wtime();
+#else
+    return (double)std::clock() / CLOCKS_PER_SEC;
+#endif
+  }
+
+  // compare pairs by their squared distance
+  struct DistanceLess {
+    const std::vector<double> &dist2;
+    DistanceLess(const std::vector<double> &_dist2) : dist2(_dist2) {}
+    bool operator()(mwIndex i, mwIndex j) const {
+      return this->dist2[i] < this->dist2[j];
+    }
+  };
+
+};
+
+/*
+ * Definitions
+ */
+
+inline
+void IterativeClosestPoint::SetIdentity() {
+
+  for (unsigned int i = 0; i < Dimension; ++i) {
+    for (unsigned int j = 0; j < Dimension; ++j) {
+      this->a[i][j] = (i == j) ? 1.0 : 0.0;
+    }
+    this->b[i] = 0.0;
+  }
+
+}
+
+template <class TScalar>
+void IterativeClosestPoint::SetInitialTransform(const TScalar *t) {
+
+  for (unsigned int i = 0; i < Dimension; ++i) {
+    for (unsigned int j = 0; j < Dimension; ++j) {
+      this->a[i][j] = (double)t[i + j * (Dimension + 1)];
+    }
+    this->b[i] = (double)t[i + Dimension * (Dimension + 1)];
+  }
+
+}
+
+template <class TScalar>
+void IterativeClosestPoint::GetTransform(TScalar *t) const {
+
+  for (unsigned int i = 0; i <= Dimension; ++i) {
+    for (unsigned int j = 0; j <= Dimension; ++j) {
+      double val;
+      if (i == Dimension) {
+	val = (j == Dimension) ? 1.0 : 0.0;
+      } else if (j == Dimension) {
+	val = this->b[i];
+      } else {
+	val = this->a[i][j];
+      }
+      t[i + j * (Dimension + 1)] = (TScalar)val;
+    }
+  }
+
+}
+
+template <class TScalar>
+void IterativeClosestPoint::TransformPoints(mwSize n, const TScalar *y, TScalar *y2) const {
+
+#ifdef _OPENMP
+#pragma omp parallel for
+#endif
+  for (mwSignedIndex i = 0; i < (mwSignedIndex)n; ++i) {
+    double p[Dimension], q[Dimension];
+    for (unsigned int d = 0; d < Dimension; ++d) {
+      p[d] = (double)y[i + d * n];
+    }
+    this->Warp(p, q);
+    for (unsigned int d = 0; d < Dimension; ++d) {
+      y2[i + d * n] = (TScalar)q[d];
+    }
+  }
+
+}
+
+template <class TClosestPoint, class TScalar>
+void IterativeClosestPoint::Register(const TClosestPoint &fixed, mwSize nmoving,
+				     const TScalar *moving) {
+
+  this->rms.clear();
+  this->time.clear();
+  this->level.clear();
+
+  // minimum number of pairs that can determine the transform
+  mwSize minPairs = 1;
+  if (this->transformType == AFFINE) {
+    minPairs = 4;
+  } else if (this->transformType != TRANSLATION) {
+    minPairs = 3;
+  }
+
+  // levels coarser than the first one with a single moving point would
+  // repeat it, so they are not run. This also bounds 4^l below
+  unsigned int top = 0;
+  for (mwSize s = 1; top + 1 < this->nlevels && s < nmoving; s *= 4) {
+    ++top;
+  }
+
+  for (int l = (int)top; l >= 0; --l) {
+
+    // one in 4^l moving points
+    mwSize stride = 1;
+    for (int k = 0; k < l; ++k) {
+      stride *= 4;
+    }
+    mwSize n = (nmoving + stride - 1) / stride;
+
+    // number of pairs kept after trimming, if all the moving points
+    // are paired
+    mwSize nkeep = (mwSize)std::ceil(this->trimFraction * n);
+    nkeep = std::max(std::min(nkeep, n), (mwSize)1);
+
+    // skip levels too coarse for the transform. The finest level is
+    // always run, and fails below if the points are degenerate
+    if (l > 0 && nkeep < minPairs) {
+      continue;
+    }
+
+    // moving points, stored point by point
+    std::vector<double> y(n * Dimension);
+    for (mwIndex i = 0; i < n; ++i) {
+      for (unsigned int d = 0; d < Dimension; ++d) {
+	y[i * Dimension + d] = (double)moving[i * stride + d * nmoving];
+      }
+    }
+
+    std::vector<double> x(n * Dimension);
+    std::vector<double> dist2(n);
+    std::vector<mwIndex> pairs(n);
+    double rmsOld = std::numeric_limits<double>::max();
+
+    for (mwIndex iter = 0; iter < this->maxIterations; ++iter) {
+
+      double t0 = WallTime();
+
+      // pair each warped moving point with its closest fixed point
+#ifdef _OPENMP
+#pragma omp parallel for schedule(dynamic, 256)
+#endif
+      for (mwSignedIndex i = 0; i < (mwSignedIndex)n; ++i) {
+	double p[Dimension];
+	this->Warp(&y[i * Dimension], p);
+	fixed.FindClosestPoint(p, &x[i * Dimension], dist2[i]);
+      }
+
+      // leave out the rejected moving points, and keep the pairs with
+      // the smallest distances
+      mwSize npaired = 0;
+      for (mwIndex i = 0; i < n; ++i) {
+	if (dist2[i] < std::numeric_limits<double>::infinity()) {
+	  pairs[npaired++] = i;
+	}
+      }
+      if (npaired == 0) {
+	mexErrMsgTxt("IterativeClosestPoint: No moving point could be paired with a fixed point");
+      }
+      pairs.resize(npaired);
+      mwSize npairs = (mwSize)std::ceil(this->trimFraction * npaired);
+      npairs = std::max(std::min(npairs, npaired), (mwSize)1);
+      if (npairs < npaired) {
+	std::nth_element(pairs.begin(), pairs.begin() + npairs, pairs.end(),
+			 DistanceLess(dist2));
+      }
+      pairs.resize(npairs);
+      double sum2 = 0.0;
+      for (mwIndex i = 0; i < npairs; ++i) {
+	sum2 += dist2[pairs[i]];
+      }
+      double rmsNew = std::sqrt(sum2 / npairs);
+
+      // update the transform
+      bool ok = this->EstimateTransform(y, x, pairs);
+      pairs.resize(n);
+
+      this->rms.push_back(rmsNew);
+      this->time.push_back(WallTime() - t0);
+      this->level.push_back((unsigned int)l);
+
+      if (!ok) {
+	mexErrMsgTxt("IterativeClosestPoint: Points are degenerate for the transform (e.g. all coplanar for an affine transform)");
+      }
+
+      // convergence
+      if (rmsOld - rmsNew <= this->tolerance * rmsOld) {
+	break;
+      }
+      rmsOld = rmsNew;
+
+    }
+
+  }
+
+}
+
+inline
+bool IterativeClosestPoint::EstimateTransform(const std::vector<double> &y,
+					      const std::vector<double> &x,
+					      const std::vector<mwIndex> &pairs) {
+
+  const mwSize n = pairs.size();
+
+  // centroids
+  double ym[Dimension] = {0.0, 0.0, 0.0};
+  double xm[Dimension] = {0.0, 0.0, 0.0};
+  for (mwIndex k = 0; k < n; ++k) {
+    for (unsigned int d = 0; d < Dimension; ++d) {
+      ym[d] += y[pairs[k] * Dimension + d];
+      xm[d] += x[pairs[k] * Dimension + d];
+    }
+  }
+  for (unsigned int d = 0; d < Dimension; ++d) {
+    ym[d] /= n;
+    xm[d] /= n;
+  }
+
+  // s = sum (y - ym) (x - xm)^T, c = sum (y - ym) (y - ym)^T
+  double s[Dimension][Dimension], c[Dimension][Dimension];
+  for (unsigned int i = 0; i < Dimension; ++i) {
+    for (unsigned int j = 0; j < Dimension; ++j) {
+      s[i][j] = c[i][j] = 0.0;
+    }
+  }
+  for (mwIndex k = 0; k < n; ++k) {
+    double yc[Dimension], xc[Dimension];
+    for (unsigned int d = 0; d < Dimension; ++d) {
+      yc[d] = y[pairs[k] * Dimension + d] - ym[d];
+      xc[d] = x[pairs[k] * Dimension + d] - xm[d];
+    }
+    for (unsigned int i = 0; i < Dimension; ++i) {
+      for (unsigned int j = 0; j < Dimension; ++j) {
+	s[i][j] += yc[i] * xc[j];
+	c[i][j] += yc[i] * yc[j];
+      }
+    }
+  }
+  const double trace = c[0][0] + c[1][1] + c[2][2];
+  if (trace <= 0.0 && this->transformType != TRANSLATION) {
+    return false;
+  }
+
+  if (this->transformType == TRANSLATION) {
+
+    // the linear part of the initial transform is kept, and only b is
+    // updated below
+
+  } else if (this->transformType == AFFINE) {
+
+    // a = s^T c^{-1}, inverting c by cofactors
+    double inv[Dimension][Dimension];
+    for (unsigned int i = 0; i < Dimension; ++i) {
+      for (unsigned int j = 0; j < Dimension; ++j) {
+	unsigned int i1 = (j + 1) % 3, i2 = (j + 2) % 3;
+	unsigned int j1 = (i + 1) % 3, j2 = (i + 2) % 3;
+	inv[i][j] = c[i1][j1] * c[i2][j2] - c[i1][j2] * c[i2][j1];
+      }
+    }
+    double det = c[0][0] * inv[0][0] + c[0][1] * inv[1][0] + c[0][2] * inv[2][0];
+    if (std::fabs(det) <= 1e-12 * trace * trace * trace) {
+      return false;
+    }
+    for (unsigned int i = 0; i < Dimension; ++i) {
+      for (unsigned int j = 0; j < Dimension; ++j) {
+	this->a[i][j] = 0.0;
+	for (unsigned int k = 0; k < Dimension; ++k) {
+	  this->a[i][j] += s[k][i] * inv[k][j];
+	}
+	this->a[i][j] /= det;
+      }
+    }
+
+  } else {
+
+    // Horn's method: the rotation is the unit quaternion that is the
+    // eigenvector of the largest eigenvalue of m
+    double m[4][4] = {
+      {s[0][0] + s[1][1] + s[2][2], s[1][2] - s[2][1], s[2][0] - s[0][2], s[0][1] - s[1][0]},
+      {s[1][2] - s[2][1], s[0][0] - s[1][1] - s[2][2], s[0][1] + s[1][0], s[2][0] + s[0][2]},
+      {s[2][0] - s[0][2], s[0][1] + s[1][0], -s[0][0] + s[1][1] - s[2][2], s[1][2] + s[2][1]},
+      {s[0][1] - s[1][0], s[2][0] + s[0][2], s[1][2] + s[2][1], -s[0][0] - s[1][1] + s[2][2]}
+    };
+    double q[4];
+    double lambda = LargestEigenvector(m, q);
+    const double q0 = q[0], qx = q[1], qy = q[2], qz = q[3];
+    double r[Dimension][Dimension] = {
+      {q0*q0 + qx*qx - qy*qy - qz*qz, 2.0 * (qx*qy - q0*qz), 2.0 * (qx*qz + q0*qy)},
+      {2.0 * (qy*qx + q0*qz), q0*q0 - qx*qx + qy*qy - qz*qz, 2.0 * (qy*qz - q0*qx)},
+      {2.0 * (qz*qx - q0*qy), 2.0 * (qz*qy + q0*qx), q0*q0 - qx*qx - qy*qy + qz*qz}
+    };
+
+    // the largest eigenvalue is sum (x - xm)^T r (y - ym), so the
+    // least squares scale is lambda / sum |y - ym|^2
+    double scale = 1.0;
+    if (this->transformType == SIMILARITY) {
+      scale = lambda / trace;
+      if (scale <= 0.0) {
+	return false;
+      }
+    }
+    for (unsigned int i = 0; i < Dimension; ++i) {
+      for (unsigned int j = 0; j < Dimension; ++j) {
+	this->a[i][j] = scale * r[i][j];
+      }
+    }
+
+  }
+
+  // b = xm - a ym
+  for (unsigned int i = 0; i < Dimension; ++i) {
+    this->b[i] = xm[i];
+    for (unsigned int j = 0; j < Dimension; ++j) {
+      this->b[i] -= this->a[i][j] * ym[j];
+    }
+  }
+
+  return true;
+
+}
+
+inline
+double IterativeClosestPoint::LargestEigenvector(double m[4][4], double *v) {
+
+  // cyclic Jacobi method: m is diagonalised by rotations accumulated in e
+  double e[4][4];
+  for (unsigned int i = 0; i < 4; ++i) {
+    for (unsigned int j = 0; j < 4; ++j) {
+      e[i][j] = (i == j) ? 1.0 : 0.0;
+    }
+  }
+
+  for (unsigned int sweep = 0; sweep < 50; ++sweep) {
+
+    double off = 0.0, diag = 0.0;
+    for (unsigned int i = 0; i < 4; ++i) {
+      diag += m[i][i] * m[i][i];
+      for (unsigned int j = i + 1; j < 4; ++j) {
+	off += m[i][j] * m[i][j];
+      }
+    }
+    if (off <= 1e-30 * diag || off == 0.0) {
+      break;
+    }
+
+    for (unsigned int p = 0; p < 3; ++p) {
+      for (unsigned int q = p + 1; q < 4; ++q) {
+	if (m[p][q] == 0.0) {
+	  continue;
+	}
+
+	// rotation that zeroes m[p][q]
+	double theta = (m[q][q] - m[p][p]) / (2.0 * m[p][q]);
+	double t = ((theta >= 0.0) ? 1.0 : -1.0)
+	  / (std::fabs(theta) + std::sqrt(theta * theta + 1.0));
+	double cs = 1.0 / std::sqrt(t * t + 1.0);
+	double sn = t * cs;
+
+	for (unsigned int k = 0; k < 4; ++k) {
+	  double mkp = m[k][p], mkq = m[k][q];
+	  m[k][p] = cs * mkp - sn * mkq;
+	  m[k][q] = sn * mkp + cs * mkq;
+	}
+	for (unsigned int k = 0; k < 4; ++k) {
+	  double mpk = m[p][k], mqk = m[q][k];
+	  m[p][k] = cs * mpk - sn * mqk;
+	  m[q][k] = sn * mpk + cs * mqk;
+	}
+	for (unsigned int k = 0; k < 4; ++k) {
+	  double ekp = e[k][p], ekq = e[k][q];
+	  e[k][p] = cs * ekp - sn * ekq;
+	  e[k][q] = sn * ekp + cs * ekq;
+	}
+      }
+    }
+
+  }
+
+  unsigned int imax = 0;
+  for (unsigned int i = 1; i < 4; ++i) {
+    if (m[i][i] > m[imax][imax]) {
+      imax = i;
+    }
+  }
+  for (unsigned int k = 0; k < 4; ++k) {
+    v[k] = e[k][imax];
+  }
+
+  return m[imax][imax];
+
+}
+
+#endif /* ITERATIVECLOSESTPOINT_H */
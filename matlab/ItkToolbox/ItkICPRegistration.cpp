@@ -3,7 +3,83 @@
  *
  * ITK_ICP_REGISTRATION  Iterative Closest Point registration
  *
- * This function is a derived work of IterativeClosestPoint3.cxx
+ * [Y2, T, INFO] = itk_icp_registration(X, Y, TRANSFORM, NITER, TOL, TRIM, NLEVELS, T0, RES)
+ *
+ *   X is a 3-column matrix with the fixed point set. Each row contains
+ *   the coordinates of a point.
+ *
+ *   Y is a 3-column matrix with the moving point set, that is
+ *   registered onto X. X and Y can have a different number of points.
+ *
+ *   TRANSFORM is a string with the type of transform. By default,
+ *   TRANSFORM='rigid'.
+ *
+ *     'translation': translation only
+ *     'rigid':       rotation and translation
+ *     'similarity':  rotation, translation and isotropic scaling
+ *     'affine':      affine transform
+ *
+ *   NITER is the maximum number of iterations at each level of
+ *   resolution. By default, NITER=100.
+ *
+ *   TOL is the tolerance for the relative change of the RMS distance
+ *   between paired points. Iterations at each level stop when the
+ *   change is below TOL. By default, TOL=1e-6.
+ *
+ *   TRIM is the proportion of pairs used to compute the transform at
+ *   each iteration, in (0, 1]. The pairs with the largest distances are
+ *   rejected as outliers (trimmed ICP). By default, TRIM=1, all pairs
+ *   are used.
+ *
+ *   NLEVELS is the number of levels of resolution. Level l uses one in
+ *   4^l points of Y, starting from level NLEVELS-1, and the last level
+ *   uses all the points. Levels with too few points to determine the
+ *   transform (4 for 'affine', 3 for 'rigid' or 'similarity'), after
+ *   trimming, are skipped. By default, NLEVELS=1.
+ *
+ *   T0 is a (4, 4) homogeneous matrix with the initial transform. By
+ *   default, T0=eye(4). With TRANSFORM='translation', the rotation,
+ *   scaling and shear of T0 are kept, and only its translation is
+ *   optimised.
+ *
+ *   RES is a scalar or 3-vector with a voxel size. If RES is given, the
+ *   closest points are found with a distance map of X instead of a
+ *   k-d tree (see below). By default, RES=[], and the k-d tree is used.
+ *
+ *   Y2 is the moving point set after registration.
+ *
+ *   T is a (4, 4) homogeneous matrix with the transform. A point y,
+ *   as a column vector, is mapped to T(1:3,1:3)*y+T(1:3,4), i.e.
+ *   Y2 = [Y ones(size(Y, 1), 1)] * T(1:3, :)'.
+ *
+ *   INFO is a struct with the convergence history of the
+ *   registration, with one element per iteration:
+ *
+ *     'rms':   RMS distance between the pairs kept after trimming
+ *     'time':  time of the iteration, in seconds
+ *     'level': level of resolution of the iteration
+ *
+ * Each iteration pairs each point of Y with its nearest point in X. X
+ * is stored in a k-d tree built once, and points are paired in
+ * parallel.
+ *
+ * With RES, X is instead rasterised once on a grid with voxel size
+ * RES that covers the bounding box of X, extended by 10% of its
+ * largest side. A distance map of the grid is computed with
+ * itk::SignedMaurerDistanceMapImageFilter, and the closest point to
+ * each point of Y is looked up in the map and its gradient by
+ * trilinear interpolation. The time of each iteration does not depend
+ * on the number of points in X, which pays off for large X. The
+ * accuracy of the registration is limited by RES, and memory grows
+ * with the number of voxels. Points of Y on the medial axis of X,
+ * where the gradient of the map vanishes and the closest point is
+ * undefined, are left out of the iteration, as if trimmed.
+ *
+ * The transform is then computed in closed form from the
+ * pairs (Horn's quaternion method for 'rigid' and 'similarity', and
+ * linear least squares for 'affine'). Before v0.1.0, this function was
+ * an unfinished wrapper of itk::PointSetToPointSetRegistrationMethod
+ * with a translation transform, derived from
  * https://github.com/Kitware/ITK/blob/master/Examples/Registration/IterativeClosestPoint3.cxx
  *
  */
@@ -11,7 +87,7 @@
  /*
   * Author: Ramon Casero <rcasero@gmail.com>
   * Copyright © 2013 University of Oxford
-  * Version: 0.0.5
+  * Version: 0.2.4
   *
   * University of Oxford means the Chancellor, Masters and Scholars of
   * the University of Oxford, having an administrative office at
@@ -41,32 +117,115 @@
 #ifndef ITKICPREGISTRATION
 #define ITKICPREGISTRATION
 
-#define DEBUG
-
 /* mex headers */
 #include <mex.h>
 
 /* C++ headers */
-#include <iostream>
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <string>
+#include <vector>
 
 /* Gerardus headers */
 #include "MatlabImportFilter.h"
 #include "MatlabExportFilter.h"
+#include "IterativeClosestPoint.h"
+#include "PointKdTree.h"
+#include "DistanceMapClosestPoint.h"
 
 /* ITK headers */
-#include "itkTranslationTransform.h"
-#include "itkEuclideanDistancePointMetric.h"
-#include "itkLevenbergMarquardtOptimizer.h"
 #include "itkPointSet.h"
-#include "itkPointSetToPointSetRegistrationMethod.h"
-//#include "itkDanielssonDistanceMapImageFilter.h"
 #include "itkPointSetToImageFilter.h"
+#include "itkSignedMaurerDistanceMapImageFilter.h"
 
 // type definitions
 static const unsigned int Dimension = 3;
 typedef double CoordinateType;
 typedef itk::PointSet<CoordinateType, Dimension> PointSetType;
 typedef PointSetType::PointType PointType;
+typedef itk::Image<unsigned char, Dimension> BinaryImageType;
+typedef itk::Image<float, Dimension> DistanceImageType;
+
+// registerWithDistanceMap(): run the registration pairing the moving
+// points with a distance map of the fixed points
+void registerWithDistanceMap(MatlabImportFilter::Pointer matlabImport,
+			     MatlabImportFilter::MatlabInputPointer inX,
+			     IterativeClosestPoint &icp,
+			     mwSize nx, const std::vector<double> &x,
+			     const std::vector<double> &res,
+			     mwSize ny, const std::vector<double> &y) {
+
+  // bounding box of the fixed points
+  double lo[Dimension], hi[Dimension];
+  for (unsigned int d = 0; d < Dimension; ++d) {
+    lo[d] = std::numeric_limits<double>::max();
+    hi[d] = -std::numeric_limits<double>::max();
+    for (mwIndex i = 0; i < nx; ++i) {
+      lo[d] = std::min(lo[d], x[i + d * nx]);
+      hi[d] = std::max(hi[d], x[i + d * nx]);
+    }
+  }
+  double lenmax = 0.0;
+  for (unsigned int d = 0; d < Dimension; ++d) {
+    lenmax = std::max(lenmax, hi[d] - lo[d]);
+  }
+
+  // grid that covers the bounding box, with a margin so that moving
+  // points near the edge of the fixed set are paired correctly
+  BinaryImageType::SizeType size;
+  BinaryImageType::SpacingType spacing;
+  BinaryImageType::PointType origin;
+  double mapSpacing[Dimension], mapOrigin[Dimension];
+  mwSize mapSize[Dimension];
+  for (unsigned int d = 0; d < Dimension; ++d) {
+    spacing[d] = mapSpacing[d] = res[d];
+    origin[d] = mapOrigin[d] = lo[d] - 0.1 * lenmax;
+    size[d] = mapSize[d] = (mwSize)std::ceil((hi[d] - lo[d] + 0.2 * lenmax) / res[d]) + 1;
+  }
+
+  // duplicate the fixed points in PointSet format so that we can
+  // pass them to ITK
+  PointSetType::Pointer pointSet = PointSetType::New();
+  matlabImport->ReadPointsContainerFromMatlab(inX, pointSet->GetPoints());
+
+  // rasterise the fixed points
+  typedef itk::PointSetToImageFilter<PointSetType, BinaryImageType> RasterizeFilterType;
+  RasterizeFilterType::Pointer rasterize = RasterizeFilterType::New();
+  rasterize->SetInput(pointSet);
+  rasterize->SetSize(size);
+  rasterize->SetSpacing(spacing);
+  rasterize->SetOrigin(origin);
+  rasterize->SetInsideValue(1);
+  rasterize->SetOutsideValue(0);
+
+  // distance from each voxel to the nearest rasterised point. Voxels
+  // that contain a point are at distance 0
+  typedef itk::SignedMaurerDistanceMapImageFilter<BinaryImageType, 
+						  DistanceImageType> DistanceFilterType;
+  DistanceFilterType::Pointer distance = DistanceFilterType::New();
+  distance->SetInput(rasterize->GetOutput());
+  distance->SetUseImageSpacing(true);
+  distance->SquaredDistanceOff();
+  distance->InsideIsPositiveOff();
+
+  try {
+    distance->Update();
+  }
+  catch (itk::ExceptionObject &e) {
+    mexErrMsgTxt(e.GetDescription());
+  }
+
+  // the distance map is copied into the closest point class, and the
+  // ITK images can be released before the registration
+  DistanceMapClosestPoint map(mapSize, mapSpacing, mapOrigin,
+			      distance->GetOutput()->GetBufferPointer());
+  distance = NULL;
+  rasterize = NULL;
+
+  icp.Register(map, ny, &y[0]);
+
+}
 
 /*
  * mexFunction(): entry point for the mex function
@@ -76,7 +235,7 @@ void mexFunction(int nlhs, mxArray *plhs[],
 
   // interface to deal with input arguments from Matlab
   enum InputIndexType {IN_X, IN_Y, IN_TRANSFORM, 
-		       IN_NITER, IN_GRADTOL, IN_VALTOL, IN_EPSFUN, InputIndexType_MAX};
+		       IN_NITER, IN_TOL, IN_TRIM, IN_NLEVELS, IN_T0, IN_RES, InputIndexType_MAX};
   MatlabImportFilter::Pointer matlabImport = MatlabImportFilter::New();
   matlabImport->ConnectToMatlabFunctionInput(nrhs, prhs);
 
@@ -89,13 +248,14 @@ void mexFunction(int nlhs, mxArray *plhs[],
   MatlabInputPointer inY = matlabImport->RegisterInput(IN_Y, "Y");
   MatlabInputPointer inTRANSFORM = matlabImport->RegisterInput(IN_TRANSFORM, "TRANSFORM");
   MatlabInputPointer inNITER = matlabImport->RegisterInput(IN_NITER, "NITER");
-  MatlabInputPointer inGRADTOL = matlabImport->RegisterInput(IN_GRADTOL, "GRADTOL");
-  MatlabInputPointer inVALTOL = matlabImport->RegisterInput(IN_VALTOL, "VALTOL");
-  MatlabInputPointer inEPSFUN = matlabImport->RegisterInput(IN_EPSFUN, "EPSFUN");
-
+  MatlabInputPointer inTOL = matlabImport->RegisterInput(IN_TOL, "TOL");
+  MatlabInputPointer inTRIM = matlabImport->RegisterInput(IN_TRIM, "TRIM");
+  MatlabInputPointer inNLEVELS = matlabImport->RegisterInput(IN_NLEVELS, "NLEVELS");
+  MatlabInputPointer inT0 = matlabImport->RegisterInput(IN_T0, "T0");
+  MatlabInputPointer inRES = matlabImport->RegisterInput(IN_RES, "RES");
 
   // interface to deal with outputs to Matlab
-  enum OutputIndexType {OUT_YY, OUT_T, OutputIndexType_MAX};
+  enum OutputIndexType {OUT_YY, OUT_T, OUT_INFO, OutputIndexType_MAX};
   MatlabExportFilter::Pointer matlabExport = MatlabExportFilter::New();
   matlabExport->ConnectToMatlabFunctionOutput(nlhs, plhs);
   
@@ -106,11 +266,13 @@ void mexFunction(int nlhs, mxArray *plhs[],
   typedef MatlabExportFilter::MatlabOutputPointer MatlabOutputPointer;
   MatlabOutputPointer outYY = matlabExport->RegisterOutput(OUT_YY, "Y2");
   MatlabOutputPointer outT  = matlabExport->RegisterOutput(OUT_T, "T");
+  MatlabOutputPointer outINFO = matlabExport->RegisterOutput(OUT_INFO, "INFO");
 
   // if any input point set is empty, the outputs are empty too
   if (mxIsEmpty(prhs[IN_X]) || mxIsEmpty(prhs[IN_Y])) {
     matlabExport->CopyEmptyArrayToMatlab(outYY);
     matlabExport->CopyEmptyArrayToMatlab(outT);
+    matlabExport->CopyEmptyArrayToMatlab(outINFO);
     return;
   }
 
@@ -123,207 +285,121 @@ void mexFunction(int nlhs, mxArray *plhs[],
     mexErrMsgTxt("X and Y must have 3 columns");
   }
 
-  // if there's some problem reading the point, default is NaN
-  PointType def;
-  def.Fill(mxGetNaN());
-
-  // read point sets
-  PointSetType::Pointer fixedPointSet = PointSetType::New();
-  // fixedPointSet->GetPoints()->CastToSTLContainer().resize(nrowsX);
-  PointSetType::Pointer xDef = PointSetType::New();
-  // fixedPointSet->GetPoints()->CastToSTLContainer()
-  //   = matlabImport->ReadVectorOfVectorsFromMatlab<PointType::ValueType, PointType>
-  //   (IN_X, "X", xDef->CastToSTLContainer());
-  //@@
-  // matlabImport->ReadMatrixFromMatlabIntoVectorOfVectors<PointType::ValueType, std::vector<PointType> >
-  //   (IN_X, "X", 
-  //    fixedPointSet->GetPoints()->CastToSTLContainer(), fixedPointSet->GetNumberOfPoints(), Dimension);
-
-  PointSetType::Pointer movingPointSet = PointSetType::New();
-  movingPointSet->GetPoints()->CastToSTLContainer().resize(nrowsY);
-  //@@
-  // matlabImport->ReadMatrixFromMatlabIntoVectorOfVectors<PointType::ValueType, std::vector<PointType> >
-  //   (IN_Y, "Y", 
-  //    movingPointSet->GetPoints()->CastToSTLContainer(), movingPointSet->GetNumberOfPoints(), Dimension);
-
-#ifdef DEBUG
-  // debug
-  std::cout << "Number of points in X = " << fixedPointSet->GetNumberOfPoints() << std::endl;
-  std::cout << "Number of points in Y = " << movingPointSet->GetNumberOfPoints() << std::endl;
-#endif
-  
-  /*
-   * registration method
-   */
-
-  typedef itk::PointSetToPointSetRegistrationMethod<PointSetType, 
-						    PointSetType> RegistrationType;
-
-  RegistrationType::Pointer registration = RegistrationType::New();
-
-  registration->SetFixedPointSet(fixedPointSet);
-  registration->SetMovingPointSet(movingPointSet);
-
-  /*
-   * metric
-   */
-
-  // generic metric to use for common methods
-  typedef itk::PointSetToPointSetMetric<PointSetType, PointSetType> GenericPointSetToPointSetMetricType;
-  GenericPointSetToPointSetMetricType::Pointer metric;
-
-  // specific metrics that can be chosen by the user
-  static enum MetricEnum {
-    METRIC_Unknown,
-    METRIC_EuclideanDistancePoint
-  } metricLabel = METRIC_Unknown;
-
-  typedef itk::EuclideanDistancePointMetric<PointSetType, PointSetType> 
-    EuclideanDistancePointMetricType;
-
-  EuclideanDistancePointMetricType::Pointer metricEuclideanDistancePoint;
-
-  // read metric chosen by the user
-  metricLabel = METRIC_EuclideanDistancePoint;
-
-  switch (metricLabel) {
-  case METRIC_EuclideanDistancePoint:
-    metricEuclideanDistancePoint = EuclideanDistancePointMetricType::New();
-    registration->SetMetric(metricEuclideanDistancePoint);
-    metric = dynamic_cast<GenericPointSetToPointSetMetricType*>(metricEuclideanDistancePoint.GetPointer());
-    break;
-  default:
-    mexErrMsgTxt("Metric not implemented");
-    break;
+  // read point sets as flat arrays, stored by columns
+  std::vector<double> x = matlabImport->
+    ReadArrayAsVectorFromMatlab<double, std::vector<double> >(inX, std::vector<double>());
+  std::vector<double> y = matlabImport->
+    ReadArrayAsVectorFromMatlab<double, std::vector<double> >(inY, std::vector<double>());
+
+  // read type of transform
+  std::string transformName = matlabImport->ReadStringFromMatlab(inTRANSFORM, "rigid");
+  IterativeClosestPoint::TransformType transformType;
+  if (transformName == "translation") {
+    transformType = IterativeClosestPoint::TRANSLATION;
+  } else if (transformName == "rigid") {
+    transformType = IterativeClosestPoint::RIGID;
+  } else if (transformName == "similarity") {
+    transformType = IterativeClosestPoint::SIMILARITY;
+  } else if (transformName == "affine") {
+    transformType = IterativeClosestPoint::AFFINE;
+  } else {
+    mexErrMsgTxt("TRANSFORM must be 'translation', 'rigid', 'similarity' or 'affine'");
+    return;
   }
 
-  /*
-   * transform
-   */
-
-  // generic transform to use for common methods
-  typedef itk::Transform<CoordinateType, Dimension> GenericTransformType;
-  GenericTransformType::Pointer transform;
-
-  // specific transforms that can be chosen by the user
-  static enum TransformEnum {
-    TRANSFORM_Unknown,
-    TRANSFORM_Translation
-  } transformLabel = TRANSFORM_Unknown;
-
-  typedef itk::TranslationTransform<CoordinateType, Dimension> TranslationTransformType;
-
-  TranslationTransformType::Pointer transformTranslation;
-
-  // read transform chosen by the user
-  transformLabel = TRANSFORM_Translation;
-
-  switch (transformLabel) {
-  case TRANSFORM_Translation:
-    transformTranslation = TranslationTransformType::New();
-    transformTranslation->SetIdentity();
-    registration->SetTransform(transformTranslation);
-    registration->SetInitialTransformParameters(transformTranslation->GetParameters());
-    transform = dynamic_cast<GenericTransformType *>(transformTranslation.GetPointer());
-    break;
-  default:
-    mexErrMsgTxt("Transform not implemented");
-    break;
+  // read registration parameters
+  // the integer parameters are read as double, as a negative value
+  // would wrap around if cast to an unsigned type
+  double niter = matlabImport->ReadScalarFromMatlab<double>(inNITER, 100.0);
+  if (mxIsNaN(niter) || mxIsInf(niter) || niter < 0.0 || niter != std::floor(niter)) {
+    mexErrMsgTxt("NITER must be a non-negative integer");
   }
-
-  /*
-   * optimizer
-   */
-
-  // generic optimizer to use for common methods
-  typedef itk::Optimizer GenericOptimizerType;
-  GenericOptimizerType::Pointer optimizer;
-  GenericOptimizerType::ScalesType scales(transform->GetNumberOfParameters());
-
-  // specific optimizers that can be chosen by the user
-  static enum OptimizerEnum {
-    OPTIMIZER_Unknown,
-    OPTIMIZER_LevenbergMarquardt
-  } optimizerLabel = OPTIMIZER_Unknown;
-
-  typedef itk::LevenbergMarquardtOptimizer LevenbergMarquardtOptimizerType;
-
-  LevenbergMarquardtOptimizerType::Pointer optimizerLevenbergMarquardt;
-
-  // read optimizer chosen by the user
-  optimizerLabel = OPTIMIZER_LevenbergMarquardt;
-
-  switch (optimizerLabel) {
-  case OPTIMIZER_LevenbergMarquardt:
-    // register the fields from the optimizer struct
-    //    matlabImport->RegisterInputArgumentFromMatlab(mxGetField());
-
-
-    optimizerLevenbergMarquardt = LevenbergMarquardtOptimizerType::New();
-    optimizerLevenbergMarquardt->SetUseCostFunctionGradient(false);
-
-
-
-    // optimizerLevenbergMarquardt->SetNumberOfIterations
-    //   (matlabImport->ReadScalarFromMatlab<double>()
-    //    );
-
-
-    optimizerLevenbergMarquardt->SetValueTolerance(1e-5);
-    optimizerLevenbergMarquardt->SetGradientTolerance(1e-5);
-    optimizerLevenbergMarquardt->SetEpsilonFunction(1e-6);
-    scales.Fill(1.0);
-    optimizerLevenbergMarquardt->SetScales(scales);
-    registration->SetOptimizer(optimizerLevenbergMarquardt);
-    optimizer = dynamic_cast<GenericOptimizerType *>(optimizerLevenbergMarquardt.GetPointer());
-    break;
-  default:
-    mexErrMsgTxt("Optimizer not implemented");
-    break;
+  double tol = matlabImport->ReadScalarFromMatlab<double>(inTOL, 1e-6);
+  double trim = matlabImport->ReadScalarFromMatlab<double>(inTRIM, 1.0);
+  double nlevels = matlabImport->ReadScalarFromMatlab<double>(inNLEVELS, 1.0);
+  if (mxIsNaN(nlevels) || mxIsInf(nlevels) || nlevels < 1.0
+      || nlevels != std::floor(nlevels)) {
+    mexErrMsgTxt("NLEVELS must be a positive integer");
+  }
+  std::vector<double> t0 = matlabImport->
+    ReadArrayAsVectorFromMatlab<double, std::vector<double> >(inT0, std::vector<double>());
+  if (inT0->isProvided 
+      && (mxGetM(inT0->pm) != Dimension + 1 || mxGetN(inT0->pm) != Dimension + 1)) {
+    mexErrMsgTxt("T0 must be a (4, 4) matrix");
+  }
+  std::vector<double> res = matlabImport->
+    ReadArrayAsVectorFromMatlab<double, std::vector<double> >(inRES, std::vector<double>());
+  if (res.size() == 1) {
+    res.resize(Dimension, res[0]);
+  }
+  if (inRES->isProvided) {
+    if (res.size() != Dimension) {
+      mexErrMsgTxt("RES must be a scalar or a 3-vector");
+    }
+    for (unsigned int d = 0; d < Dimension; ++d) {
+      if (!(res[d] > 0.0)) {
+	mexErrMsgTxt("RES must be positive");
+      }
+    }
   }
 
   /*
    * run registration
    */
 
-  try 
-    {
-      registration->Update();
-    }
-  catch( itk::ExceptionObject & e )
-    {
-      mexErrMsgTxt(e.GetDescription());
-    }
+  IterativeClosestPoint icp(transformType);
+  icp.SetNumberOfIterations((mwSize)niter);
+  icp.SetTolerance(tol);
+  icp.SetTrimFraction(trim);
+  // 4^32 is more than any number of points, so further levels would
+  // not be run
+  icp.SetNumberOfLevels((unsigned int)std::min(nlevels, 32.0));
+  if (inT0->isProvided) {
+    icp.SetInitialTransform(&t0[0]);
+  }
+
+  // the fixed point set is put in a distance map or a k-d tree
+  if (inRES->isProvided) {
+    registerWithDistanceMap(matlabImport, inX, icp, nrowsX, x, res, nrowsY, y);
+  } else {
+    PointKdTree<Dimension> tree(nrowsX, &x[0]);
+    icp.Register(tree, nrowsY, &y[0]);
+  }
 
   /*
    * export results
    */
-  
-  std::cout << "Solution = " << transform->GetParameters() << std::endl;
-  std::cout << "Stop condition = " << optimizer->GetStopConditionDescription() << std::endl;
 
   // warp the moving points according to the solution
-  PointSetType::Pointer warpedMovingPointSet = movingPointSet;
-  for (mwIndex i = 0; i < movingPointSet->GetNumberOfPoints(); ++i) {
-    warpedMovingPointSet->SetPoint(i, transform->TransformPoint(movingPointSet->GetPoint(i)));
+  if (outYY->isRequested) {
+    double *yy = matlabExport->AllocateMatrixInMatlab<double>(outYY, nrowsY, Dimension);
+    icp.TransformPoints(nrowsY, &y[0], yy);
   }
 
-  // copy to Matlab the moving points after warping
-  matlabExport->CopyVectorOfVectorsToMatlab<CoordinateType, 
-  					    const std::vector<PointType> 
-					    >
-    (outYY,
-     warpedMovingPointSet->GetPoints()->CastToSTLConstContainer(), 
-     warpedMovingPointSet->GetNumberOfPoints(), Dimension);
-
-  // registration parameters
-  matlabExport->CopyVectorOfScalarsToMatlab<CoordinateType, 
-					    GenericTransformType::ParametersType>
-    (outT, 
-     registration->GetTransform()->GetParameters(), 
-     transform->GetNumberOfParameters());
-
+  // registration transform
+  if (outT->isRequested) {
+    double *t = matlabExport->AllocateMatrixInMatlab<double>(outT, Dimension + 1, Dimension + 1);
+    icp.GetTransform(t);
+  }
 
+  // convergence history
+  if (outINFO->isRequested) {
+    *outINFO->ppm = mxCreateStructMatrix(1, 1, 0, NULL);
+    const std::vector<double> &rms = icp.GetRMS();
+    const std::vector<double> &time = icp.GetTime();
+    const std::vector<unsigned int> &level = icp.GetLevel();
+    double *rmsOut = matlabExport->
+      AllocateMatrixInStructFieldInMatlab<double>(outINFO, "rms", rms.size(), 1);
+    double *timeOut = matlabExport->
+      AllocateMatrixInStructFieldInMatlab<double>(outINFO, "time", time.size(), 1);
+    double *levelOut = matlabExport->
+      AllocateMatrixInStructFieldInMatlab<double>(outINFO, "level", level.size(), 1);
+    for (mwIndex i = 0; i < rms.size(); ++i) {
+      rmsOut[i] = rms[i];
+      timeOut[i] = time[i];
+      levelOut[i] = (double)level[i];
+    }
+  }
 
 }
 
@@ -23,7 +23,9 @@
  *     int16
  *     uint16
  *     int32
+ *     uint32
  *     int64
+ *     uint64
  *
  *   A can also be a SCI MAT struct, A = scimat, with the following fields:
  *
@@ -86,6 +88,42 @@
  *   foreground voxel from A(i,j,k). The vector coordinates are given
  *   in voxel units, and as (R,C,S), instead of (x,y,z).
  *
+ *   For exact distances in a fraction of the time, see 'edt' below.
+ *
+ * -------------------------------------------------------------------------
+ *
+ * [B, V, W] = itk_imfilter('edt', A)
+ * [B, V, W] = itk_imfilter('signedt', A)
+ *
+ *   (Not an ITK filter, but Gerardus' ExactDistanceTransform)
+ *   Compute unsigned/signed exact Euclidean distance map for a binary
+ *   mask. Distance values are given in real world coordinates, if the
+ *   input image is given as a SCI MAT struct, or in voxel units, if the
+ *   input image is a normal array.
+ *
+ *   The transform is separable (Felzenszwalb and Huttenlocher), and the
+ *   lines along each axis are processed in parallel. Outputs V and W are
+ *   only computed if they are requested.
+ *
+ *   A is a segmentation. Non-zero voxels are foreground.
+ *
+ *   B has the same size as A and type single. For 'edt', each element in
+ *   B is the distance from that voxel to the closest foreground voxel
+ *   (0 for foreground voxels). For 'signedt', background voxels have the
+ *   distance to the closest foreground voxel, and foreground voxels have
+ *   minus the distance to the closest background voxel. If there are no
+ *   foreground (or background) voxels, distances are Inf.
+ *
+ *   V has the same size as A and type int32. V(i) is the linear index of
+ *   the closest foreground voxel to voxel i (for 'signedt', the closest
+ *   voxel of the opposite class), or 0 if there is none. A(V) gives the
+ *   Voronoi partition of A.
+ *
+ *   W has size (R,C,S,3) if A has size (R,C,S), and type int32. Each
+ *   vector W(i,j,k,:) points from voxel (i,j,k) to the closest voxel
+ *   V(i,j,k). The vector coordinates are given in voxel units, and as
+ *   (R,C,S), instead of (x,y,z).
+ *
  * -------------------------------------------------------------------------
  *
  * B = itk_imfilter('maudist', A)
@@ -139,6 +177,43 @@
  *   FOREGROUND is a scalar. Voxels with that value will be the only ones
  *   dilated. By default, FOREGROUND=1.
  *
+ *   Eroded voxels are set to the lowest value of the class of A, as in
+ *   ITK: 0 for unsigned integers, intmin for signed integers, and
+ *   -realmax for single and double. Other voxels keep their value.
+ *
+ *   For RADIUS >= 4, the ITK filter is replaced by a threshold of the
+ *   exact distance transform (see 'edt' below), which takes the same time
+ *   for any radius. The distance is measured with the voxel size of A,
+ *   and the ball contains the voxels at distance <= (RADIUS+0.5)*S from
+ *   the centre, where S is the smallest voxel side. For isotropic voxels
+ *   this is the same ball as ITK's, so the result doesn't change. For
+ *   anisotropic voxels, the ball is round in real world units, whereas
+ *   the ITK ball is round in voxel units.
+ *
+ * -------------------------------------------------------------------------
+ *
+ * B = itk_imfilter('labdilate', A, RADIUS)
+ * B = itk_imfilter('laberode', A, RADIUS)
+ *
+ *   (Not ITK filters, but Gerardus' DistanceMorphology)
+ *   Dilation/erosion of all the labels of a segmentation at the same time,
+ *   with a Euclidean ball, computed by thresholding the exact distance
+ *   transform (see 'edt' below).
+ *
+ *   A is a segmentation. Voxels with value 0 are background, and each
+ *   other value is a label.
+ *
+ *   RADIUS is a scalar with the radius of the ball. It is given in real
+ *   world units, if A is given as a SCI MAT struct (so the ball is exact
+ *   also for anisotropic voxels), or in voxel units, if A is a normal
+ *   array. By default, RADIUS=0 and the image doesn't change.
+ *
+ *   B has the same size and class as A. For 'labdilate', labelled voxels
+ *   keep their label, and background voxels get the label of the closest
+ *   labelled voxel, if it is within RADIUS. For 'laberode', voxels within
+ *   RADIUS of a voxel with a different value (background or another
+ *   label) are set to 0. Voxels outside the image are not background.
+ *
  * -------------------------------------------------------------------------
  *
  * B = itk_imfilter('advess', A, SIGMAMIN, SIGMAMAX, NUMSIGMASTEPS, NUMITERATIONS,
@@ -165,6 +240,12 @@
  *   results seem better if run directly on the image. The
  *   filter doesn't seem to be spacing invariant.
  *
+ *   Note: At each iteration, the diffusion tensor of a voxel has its
+ *   largest eigenvalue along the vessel direction, i.e. the eigenvector
+ *   of the Hessian eigenvalue with the smallest magnitude (Manniesing
+ *   et al., 2006). Hessians are computed in single precision, and
+ *   eigenvalues and eigenvectors with a closed-form solver.
+ *
  *   SIGMAMIN, SIGMAMAX are scalars with the limits of the multiscale
  *   scheme, in the same units as the image. They should be set to
  *   roughly the diameters of the smallest and largest vessels in the
@@ -238,6 +319,10 @@
  *   median is computed in a rectangular neighbourhood of [5, 7, 9]
  *   voxels.
  *
+ *   For images of class logical, (u)int8 or (u)int16, the median is
+ *   computed with a sliding histogram instead of itk::MedianImageFilter,
+ *   which is much faster for large radii. The result is the same.
+ *
  * -------------------------------------------------------------------------
  *
  * B = itk_imfilter('mrf', A, MU)
@@ -283,6 +368,29 @@
  *   TOL is a scalar with the error tolerance that will be used as a
  *   criterion for convergence. By default, TOL=1e-7.
  *
+ * [B, STATS] = itk_imfilter(..., METHOD)
+ *
+ *   METHOD is a string with the optimisation method:
+ *
+ *     'itk' (default): itk::MRFImageFilter (Iterated Conditional Modes,
+ *     ICM, with a raster sweep). Single-threaded.
+ *
+ *     'icm': Gerardus' MrfSegmentation. The same ICM, but voxels are
+ *     relabelled in parallel by colours (red-black checkerboard if WEIGHTS
+ *     only has face neighbours), so the result can be slightly different.
+ *
+ *     'alphaexp': Gerardus' MrfSegmentation with alpha-expansion graph
+ *     cuts (Boykov et al., 2001). Usually finds a lower energy than ICM,
+ *     but it's slower and needs a lot more memory for large images.
+ *
+ *   For 'icm' and 'alphaexp', the fraction of voxels that change label in
+ *   an iteration is compared to TOL, and NITER is the maximum number of
+ *   ICM sweeps or alpha-expansion cycles.
+ *
+ *   STATS is a matrix with one row per iteration. STATS(:,1) is the number
+ *   of voxels that changed label, and STATS(:,2) is the energy after the
+ *   iteration. For 'itk', STATS is empty.
+ *
  * -------------------------------------------------------------------------
  *
  * B = itk_imfilter('voteholefill', A)
@@ -313,6 +421,12 @@
  *   foreground voxels, respectively. By default, BACKGROUND=0,
  *   FOREGROUND=1.
  *
+ *   The filter is computed with an active set instead of
+ *   itk::VotingBinaryIterativeHoleFillingImageFilter. After the first
+ *   iteration, only background voxels close to voxels that have just
+ *   become foreground are evaluated, which is much faster for large values
+ *   of MAXITER. The result is the same.
+ *
  * -------------------------------------------------------------------------
  *
  * [B, C] = itk_imfilter('canny', A)
@@ -366,7 +480,7 @@
  /*
   * Author: Ramon Casero <rcasero@gmail.com>
   * Copyright © 2011-2014 University of Oxford
-  * Version: 1.6.2
+  * Version: 1.10.4
   *
   * University of Oxford means the Chancellor, Masters and Scholars of
   * the University of Oxford, having an administrative office at
@@ -404,1429 +518,65 @@
 #include <mex.h>
 
 /* C++ headers */
-#include <iostream>
-#include <cmath>
-#include <matrix.h>
-#include <vector>
 #include <climits>
-
-/* ITK dependencies */
-#include "itkImage.h"
-#include "itkComposeImageFilter.h"
-#include "itkFixedArray.h"
-#include "itkDistanceToCentroidMembershipFunction.h"
-#include "itkMinimumDecisionRule.h"
-
-/* ITK filter headers */
-#include "itkCannyEdgeDetectionImageFilter.h"
-#include "itkVotingBinaryIterativeHoleFillingImageFilter.h"
-#include "itkApproximateSignedDistanceMapImageFilter.h"
-#include "itkMedianImageFilter.h"
-#include "itkMultiScaleHessianSmoothed3DToVesselnessMeasureImageFilter.h"
-#include "itkAnisotropicDiffusionVesselEnhancementImageFilter.h"
-#include "itkBinaryThinningImageFilter3D.h"
-#include "itkSignedDanielssonDistanceMapImageFilter.h"
-#include "itkDanielssonDistanceMapImageFilter.h"
-#include "itkSignedMaurerDistanceMapImageFilter.h"
-#include "itkBinaryBallStructuringElement.h"
-#include "itkBinaryDilateImageFilter.h"
-#include "itkBinaryErodeImageFilter.h"
-#include "itkMRFImageFilter.h"
+#include <string>
 
 /* Gerardus headers */
-#include "GerardusCommon.h"
 #include "MatlabImageHeader.h"
 #include "MatlabImportFilter.h"
 #include "MatlabExportFilter.h"
+#include "MexFilter/MexFilterRegistry.h"
 
-// common types
-typedef MatlabImportFilter::MatlabInputPointer MatlabInputPointer;
-
-// list of supported filters. It has to be an enum so that we can pass
-// it as a template constant parameter
-enum SupportedFilter {
-  nCannyEdgeDetectionImageFilter,
-  nVotingBinaryIterativeHoleFillingImageFilter,
-  nApproximateSignedDistanceMapImageFilter,
-  nMedianImageFilter,
-  nMultiScaleHessianSmoothed3DToVesselnessMeasureImageFilter,
-  nAnisotropicDiffusionVesselEnhancementImageFilter,
-  nBinaryThinningImageFilter3D,
-  nSignedDanielssonDistanceMapImageFilter,
-  nDanielssonDistanceMapImageFilter,
-  nSignedMaurerDistanceMapImageFilter,
-  nBinaryDilateImageFilter,
-  nBinaryErodeImageFilter,
-  nMRFImageFilter
-};
-
-// FilterWrapper():
+// Filter registration functions.
 //
-// This block contains one FilterWrapper partial specialisation per
-// filter. In this class, the filter acquires the inputs from Matlab,
-// parameters are set, and the outputs are grafted onto Matlab.
-//
-// The reason to use an encapsulating class like this FilterWrapper is
-// because some filters do not accept certains dimensions or input
-// types. Thus, we can use partial template specialisation to give a
-// runtime error in those cases and avoid instantiating the ITK
-// filter, which would give a compilation error
-template <class TPixelIn, unsigned int VImageDimension,
-	  unsigned int FilterEnum>
-class FilterWrapper {
-public:
-  FilterWrapper(MatlabImportFilter::Pointer matlabImport,
-		MatlabExportFilter::Pointer matlabExport,
-		MatlabImageHeader &im) {
-    mexErrMsgTxt("Unsupported filter type");
+// Each filter is wrapped in its own translation unit
+// MexFilter/Mex<FilterName>.cpp, that instantiates the filter only
+// for the pixel types and dimensions that it accepts. Adding a new
+// filter only requires a new translation unit, and a call to its
+// registration function in GetFilterRegistry()
+void RegisterCannyEdgeDetectionImageFilter(FilterRegistry &registry);
+void RegisterVotingBinaryIterativeHoleFillingImageFilter(FilterRegistry &registry);
+void RegisterApproximateSignedDistanceMapImageFilter(FilterRegistry &registry);
+void RegisterMedianImageFilter(FilterRegistry &registry);
+void RegisterMultiScaleHessianSmoothed3DToVesselnessMeasureImageFilter(FilterRegistry &registry);
+void RegisterAnisotropicDiffusionVesselEnhancementImageFilter(FilterRegistry &registry);
+void RegisterBinaryThinningImageFilter3D(FilterRegistry &registry);
+void RegisterSignedDanielssonDistanceMapImageFilter(FilterRegistry &registry);
+void RegisterDanielssonDistanceMapImageFilter(FilterRegistry &registry);
+void RegisterSignedMaurerDistanceMapImageFilter(FilterRegistry &registry);
+void RegisterExactDistanceTransform(FilterRegistry &registry);
+void RegisterBinaryDilateImageFilter(FilterRegistry &registry);
+void RegisterBinaryErodeImageFilter(FilterRegistry &registry);
+void RegisterLabelMorphology(FilterRegistry &registry);
+void RegisterMRFImageFilter(FilterRegistry &registry);
+
+// GetFilterRegistry(): registry with all the filters, built the first
+// time it's needed
+FilterRegistry &GetFilterRegistry() {
+
+  static FilterRegistry registry;
+  static bool isRegistered = false;
+
+  if (!isRegistered) {
+    RegisterCannyEdgeDetectionImageFilter(registry);
+    RegisterVotingBinaryIterativeHoleFillingImageFilter(registry);
+    RegisterApproximateSignedDistanceMapImageFilter(registry);
+    RegisterMedianImageFilter(registry);
+    RegisterMultiScaleHessianSmoothed3DToVesselnessMeasureImageFilter(registry);
+    RegisterAnisotropicDiffusionVesselEnhancementImageFilter(registry);
+    RegisterBinaryThinningImageFilter3D(registry);
+    RegisterSignedDanielssonDistanceMapImageFilter(registry);
+    RegisterDanielssonDistanceMapImageFilter(registry);
+    RegisterSignedMaurerDistanceMapImageFilter(registry);
+    RegisterExactDistanceTransform(registry);
+    RegisterBinaryDilateImageFilter(registry);
+    RegisterBinaryErodeImageFilter(registry);
+    RegisterLabelMorphology(registry);
+    RegisterMRFImageFilter(registry);
+    isRegistered = true;
   }
-};
-
-// CannyEdgeDetectionImageFilter
-template <class TPixelIn, unsigned int VImageDimension>
-class FilterWrapper<TPixelIn, VImageDimension, 
-		    nCannyEdgeDetectionImageFilter> {
-public:
-  
-  FilterWrapper(MatlabImportFilter::Pointer matlabImport,
-		MatlabExportFilter::Pointer matlabExport,
-		MatlabImageHeader &im) {
-
-    // inputs/outputs interfaces
-    enum InputIndexType {IN_TYPE, IN_A, IN_VAR, IN_UPPTHR, IN_LOWTHR, IN_MAXERR, InputIndexType_MAX};
-    enum OutputIndexType {OUT_B, OUT_C, OutputIndexType_MAX};
-    
-    // check number of input and output arguments
-    matlabImport->CheckNumberOfArguments(2, InputIndexType_MAX);
-    matlabExport->CheckNumberOfArguments(0, OutputIndexType_MAX);
-
-    // get pointer to image input
-    MatlabInputPointer inA      = matlabImport->GetRegisteredInput("A");
-  
-    // register the inputs exclusive to this function
-    MatlabInputPointer inVAR    = matlabImport->RegisterInput(IN_VAR, "VAR");
-    MatlabInputPointer inUPPTHR = matlabImport->RegisterInput(IN_UPPTHR, "UPPTHR");
-    MatlabInputPointer inLOWTHR = matlabImport->RegisterInput(IN_LOWTHR, "LOWTHR");
-    MatlabInputPointer inMAXERR = matlabImport->RegisterInput(IN_MAXERR, "MAXERR");
-
-    // register the outputs for this function at the export filter
-    typedef MatlabExportFilter::MatlabOutputPointer MatlabOutputPointer;
-    MatlabOutputPointer outB = matlabExport->RegisterOutput(OUT_B, "B");
-    MatlabOutputPointer outC = matlabExport->RegisterOutput(OUT_C, "C");
-    
-    // instantiate the filter
-    typedef TPixelIn TPixelOut;
-    typedef typename itk::Image<TPixelIn, VImageDimension> InImageType;
-    typedef InImageType OutImageType;
-    typedef itk::CannyEdgeDetectionImageFilter<InImageType, OutImageType>
-      FilterType;
-    typename FilterType::Pointer filter = FilterType::New();
-    
-    // connect Matlab inputs to ITK filter
-    filter->SetInput(matlabImport->
-		     GetImagePointerFromMatlab<TPixelIn, VImageDimension>(inA));
-    
-    // The variance for the discrete Gaussian kernel. Sets the
-    // variance independently for each dimension. The default is 0.0
-    // in each dimension (ITK)
-    typename FilterType::ArrayType defVariance;
-    defVariance.Fill(0.0);
-    filter->SetVariance(matlabImport->
-    			ReadRowVectorFromMatlab<typename FilterType::ArrayType::ValueType, 
-    					     typename FilterType::ArrayType>(inVAR, defVariance));
-
-    // Usually, the upper tracking threshold can be set quite high,
-    // and the lower threshold quite low for good results. Setting the
-    // lower threshold too high will cause noisy edges to break
-    // up. Setting the upper threshold too low increases the number of
-    // spurious and undesirable edge fragments appearing in the
-    // output.
-    // http://homepages.inf.ed.ac.uk/rbf/HIPR2/canny.htm
-    filter->SetUpperThreshold(matlabImport->template
-			      ReadScalarFromMatlab<TPixelIn>(inUPPTHR, 
-							     std::numeric_limits<TPixelIn>::max()));
-
-    // Threshold is the lowest allowed value in the output image. Its
-    // data type is the same as the data type of the output image. Any
-    // values below the Threshold level will be replaced with the
-    // OutsideValue parameter value, whose default is zero.
-    filter->SetLowerThreshold(matlabImport->template
-			      ReadScalarFromMatlab<TPixelIn>(inLOWTHR, 
-							     filter->GetUpperThreshold() / 2.0));
-
-    // The algorithm will size the discrete kernel so that the error
-    // resulting from truncation of the kernel is no greater than
-    // MaximumError. The default is 0.01 in each dimension.
-    typename FilterType::ArrayType defMaximumError;
-    defMaximumError.Fill(0.01);
-    filter->SetMaximumError(matlabImport->
-			    ReadRowVectorFromMatlab<typename FilterType::ArrayType::ValueType, 
-						 typename FilterType::ArrayType>(inMAXERR, defMaximumError));
-
-    // graft ITK filter outputs onto Matlab outputs
-    matlabExport->GraftItkImageOntoMatlab<TPixelOut, VImageDimension>
-      (outB, filter->GetOutputs()[0], im.size);
-
-    // run filter
-    filter->Update();
-
-    // copy ITK filter outputs to Matlab outputs
-    matlabExport->CopyItkImageToMatlab<TPixelOut, VImageDimension>
-      (outC, filter->GetNonMaximumSuppressionImage(), im.size);
-
-  }
-};
-
-template <unsigned int VImageDimension>
-class FilterWrapper<mxLogical, VImageDimension,
-		    nCannyEdgeDetectionImageFilter> {
-public:
-  FilterWrapper(MatlabImportFilter::Pointer, MatlabExportFilter::Pointer,
-		MatlabImageHeader &) {
-    mexErrMsgTxt("CannyEdgeDetectionImageFilter only accepts input images with floating type (double or single)");
-  }
-};
-
-template <unsigned int VImageDimension>
-class FilterWrapper<int8_T, VImageDimension,
-		    nCannyEdgeDetectionImageFilter> {
-public:
-  FilterWrapper(MatlabImportFilter::Pointer, MatlabExportFilter::Pointer,
-		MatlabImageHeader &) {
-    mexErrMsgTxt("CannyEdgeDetectionImageFilter only accepts input images with floating type (double or single)");
-  }
-};
-
-template <unsigned int VImageDimension>
-class FilterWrapper<uint8_T, VImageDimension,
-		    nCannyEdgeDetectionImageFilter> {
-public:
-  FilterWrapper(MatlabImportFilter::Pointer, MatlabExportFilter::Pointer,
-		MatlabImageHeader &) {
-    mexErrMsgTxt("CannyEdgeDetectionImageFilter only accepts input images with floating type (double or single)");
-  }
-};
-
-template <unsigned int VImageDimension>
-class FilterWrapper<int16_T, VImageDimension,
-		    nCannyEdgeDetectionImageFilter> {
-public:
-  FilterWrapper(MatlabImportFilter::Pointer, MatlabExportFilter::Pointer,
-		MatlabImageHeader &) {
-    mexErrMsgTxt("CannyEdgeDetectionImageFilter only accepts input images with floating type (double or single)");
-  }
-};
-
-template <unsigned int VImageDimension>
-class FilterWrapper<uint16_T, VImageDimension,
-		    nCannyEdgeDetectionImageFilter> {
-public:
-  FilterWrapper(MatlabImportFilter::Pointer, MatlabExportFilter::Pointer,
-		MatlabImageHeader &) {
-    mexErrMsgTxt("CannyEdgeDetectionImageFilter only accepts input images with floating type (double or single)");
-  }
-};
-
-template <unsigned int VImageDimension>
-class FilterWrapper<int32_T, VImageDimension,
-		    nCannyEdgeDetectionImageFilter> {
-public:
-  FilterWrapper(MatlabImportFilter::Pointer, MatlabExportFilter::Pointer,
-		MatlabImageHeader &) {
-    mexErrMsgTxt("CannyEdgeDetectionImageFilter only accepts input images with floating type (double or single)");
-  }
-};
-
-template <unsigned int VImageDimension>
-class FilterWrapper<int64_T, VImageDimension,
-		    nCannyEdgeDetectionImageFilter> {
-public:
-  FilterWrapper(MatlabImportFilter::Pointer, MatlabExportFilter::Pointer,
-		MatlabImageHeader &) {
-    mexErrMsgTxt("CannyEdgeDetectionImageFilter only accepts input images with floating type (double or single)");
-  }
-};
-
-// VotingBinaryIterativeHoleFillingImageFilter
-template <class TPixelIn, unsigned int VImageDimension>
-class FilterWrapper<TPixelIn, VImageDimension,
-		    nVotingBinaryIterativeHoleFillingImageFilter> {
-
-public:
-  
-  FilterWrapper(MatlabImportFilter::Pointer matlabImport,
-		MatlabExportFilter::Pointer matlabExport,
-		MatlabImageHeader &im) {
-    
-    // inputs/outputs interfaces
-    enum InputIndexType {IN_TYPE, IN_A, IN_RADIUS, IN_MAXITER, IN_THR, 
-			 IN_BACKGROUND, IN_FOREGROUND, InputIndexType_MAX};
-    enum OutputIndexType {OUT_B, OutputIndexType_MAX};
-    
-    // check number of input and output arguments
-    matlabImport->CheckNumberOfArguments(2, InputIndexType_MAX);
-    matlabExport->CheckNumberOfArguments(0, OutputIndexType_MAX);
-
-    // get pointer to image input
-    MatlabInputPointer inA          = matlabImport->GetRegisteredInput("A");
-  
-    // register the inputs exclusive to this function
-    MatlabInputPointer inRADIUS     = matlabImport->RegisterInput(IN_RADIUS, "RADIUS");
-    MatlabInputPointer inMAXITER    = matlabImport->RegisterInput(IN_MAXITER, "MAXITER");
-    MatlabInputPointer inTHR        = matlabImport->RegisterInput(IN_THR, "THR");
-    MatlabInputPointer inBACKGROUND = matlabImport->RegisterInput(IN_BACKGROUND, "BACKGROUND");
-    MatlabInputPointer inFOREGROUND = matlabImport->RegisterInput(IN_FOREGROUND, "FOREGROUND");
-
-    // register the outputs for this function at the export filter
-    typedef MatlabExportFilter::MatlabOutputPointer MatlabOutputPointer;
-    MatlabOutputPointer outB = matlabExport->RegisterOutput(OUT_B, "B");
-
-    // instantiate the filter
-    typedef TPixelIn TPixelOut;
-    typedef typename itk::Image<TPixelIn, VImageDimension> InImageType;
-    typedef itk::VotingBinaryIterativeHoleFillingImageFilter<InImageType>
-      FilterType;
-    typename FilterType::Pointer filter = FilterType::New();
-
-    // connect Matlab inputs to ITK filter
-    filter->SetInput(matlabImport->
-		     GetImagePointerFromMatlab<TPixelIn, VImageDimension>(inA));
-
-    // default parameters
-    typename InImageType::SizeType radiusDef;
-    radiusDef.Fill(1);
-
-    // filter parameters
-    filter->SetRadius(matlabImport->template
-		      ReadRowVectorFromMatlab<typename InImageType::SizeValueType,
-					   typename InImageType::SizeType>(inRADIUS, radiusDef));
-    filter->SetMaximumNumberOfIterations(matlabImport->template
-					 ReadScalarFromMatlab<unsigned int>(inMAXITER, 1));
-    filter->SetMajorityThreshold(matlabImport->template
-				 ReadScalarFromMatlab<unsigned int>(inTHR, 2));
-    filter->SetBackgroundValue(matlabImport->template
-			       ReadScalarFromMatlab<TPixelIn>(inBACKGROUND, 0));
-    filter->SetForegroundValue(matlabImport->template
-			       ReadScalarFromMatlab<TPixelIn>(inFOREGROUND, 1));
-
-    // run filter
-    filter->Update();
-
-    // copy ITK filter outputs to Matlab outputs
-    matlabExport->CopyItkImageToMatlab<TPixelOut, VImageDimension>
-      (outB, filter->GetOutputs()[0], im.size);
-
-  }
-};
-
-// ApproximateSignedDistanceMapImageFilter
-template <class TPixelIn, unsigned int VImageDimension>
-class FilterWrapper<TPixelIn, VImageDimension,
-		    nApproximateSignedDistanceMapImageFilter> {
-public:
-  
-  FilterWrapper(MatlabImportFilter::Pointer matlabImport,
-		MatlabExportFilter::Pointer matlabExport,
-		MatlabImageHeader &im) {
-    
-    // inputs/outputs interfaces
-    enum InputIndexType {IN_TYPE, IN_A, InputIndexType_MAX};
-    enum OutputIndexType {OUT_B, OutputIndexType_MAX};
-    
-    // check number of input and output arguments
-    matlabImport->CheckNumberOfArguments(2, InputIndexType_MAX);
-    matlabExport->CheckNumberOfArguments(0, OutputIndexType_MAX);
-    
-    // get pointer to image input
-    MatlabInputPointer inA         = matlabImport->GetRegisteredInput("A");
-  
-    // register the outputs for this function at the export filter
-    typedef MatlabExportFilter::MatlabOutputPointer MatlabOutputPointer;
-    MatlabOutputPointer outB = matlabExport->RegisterOutput(OUT_B, "B");
-
-    // instantiate the filter
-    typedef float TPixelOut;
-    typedef typename itk::Image<TPixelIn, VImageDimension> InImageType;
-    typedef typename itk::Image<TPixelOut, VImageDimension> OutImageType;
-    typedef itk::ApproximateSignedDistanceMapImageFilter<InImageType, OutImageType>
-      FilterType;
-    typename FilterType::Pointer filter = FilterType::New();
-
-    // expect segmented object of 1s over background of 0s
-    filter->SetInsideValue(1);
-    filter->SetOutsideValue(0);
-    
-    // connect Matlab inputs to ITK filter
-    filter->SetInput(matlabImport->
-		     GetImagePointerFromMatlab<TPixelIn, VImageDimension>(inA));
-
-    // connect ITK filter outputs to Matlab outputs
-
-    // distance map
-    matlabExport->GraftItkImageOntoMatlab<TPixelOut, VImageDimension>
-      (outB, filter->GetOutputs()[0], im.size);
-
-    // run filter
-    filter->Update();
-
-  }
-};
-
-// MedianImageFilter
-template <class TPixelIn, unsigned int VImageDimension>
-class FilterWrapper<TPixelIn, VImageDimension, 
-		    nMedianImageFilter> {
-public:
-  
-  FilterWrapper(MatlabImportFilter::Pointer matlabImport,
-		MatlabExportFilter::Pointer matlabExport,
-		MatlabImageHeader &im) {
-    
-    // inputs/outputs interfaces
-    enum InputIndexType {IN_TYPE, IN_A, IN_RADIUS, InputIndexType_MAX};
-    enum OutputIndexType {OUT_B, OutputIndexType_MAX};
-    
-    // check number of input and output arguments
-    matlabImport->CheckNumberOfArguments(2, InputIndexType_MAX);
-    matlabExport->CheckNumberOfArguments(0, OutputIndexType_MAX);
-    
-    // get pointer to image input
-    MatlabInputPointer inA      = matlabImport->GetRegisteredInput("A");
-  
-    // register the inputs exclusive to this function
-    MatlabInputPointer inRADIUS = matlabImport->RegisterInput(IN_RADIUS, "RADIUS");
-
-    // register the outputs for this function at the export filter
-    typedef MatlabExportFilter::MatlabOutputPointer MatlabOutputPointer;
-    MatlabOutputPointer outB = matlabExport->RegisterOutput(OUT_B, "B");
-
-    // instantiate the filter
-    typedef TPixelIn TPixelOut;
-    typedef typename itk::Image<TPixelIn, VImageDimension> InImageType;
-    typedef InImageType OutImageType;
-    typedef itk::MedianImageFilter<InImageType, OutImageType>
-      FilterType;
-    typename FilterType::Pointer filter = FilterType::New();
-    
-    // connect Matlab inputs to ITK filter
-    filter->SetInput(matlabImport->
-		     GetImagePointerFromMatlab<TPixelIn, VImageDimension>(inA));
-    
-    // set half size of the filter's box
-    typedef typename itk::BoxImageFilter<
-      itk::Image<TPixelIn, VImageDimension>,
-      itk::Image<TPixelOut, VImageDimension> > BoxFilterType;
-    typename BoxFilterType::RadiusType radius;
-    radius.Fill(0);
-    filter->SetRadius(matlabImport->
-		      ReadRowVectorFromMatlab<typename BoxFilterType::RadiusValueType, 
-					      typename BoxFilterType::RadiusType>(inRADIUS, radius));
-    
-    // graft ITK filter outputs onto Matlab outputs
-    matlabExport->GraftItkImageOntoMatlab<TPixelOut, VImageDimension>
-      (outB, filter->GetOutputs()[0], im.size);
-
-    // run filter
-    filter->Update();
-
-  }
-};
-
-// MultiScaleHessianSmoothed3DToVesselnessMeasureImageFilter
-template <class TPixelIn, unsigned int VImageDimension>
-class FilterWrapper<TPixelIn, VImageDimension,
-		    nMultiScaleHessianSmoothed3DToVesselnessMeasureImageFilter> {
-public:
-  
-  FilterWrapper(MatlabImportFilter::Pointer matlabImport,
-		MatlabExportFilter::Pointer matlabExport,
-		MatlabImageHeader &im) {
-
-
-    
-    // inputs/outputs interfaces
-    enum InputIndexType {IN_TYPE, IN_A, IN_SIGMAMIN, IN_SIGMAMAX, IN_NUMSIGMASTEPS, 
-			 IN_ISSIGMASTEPLOG, InputIndexType_MAX};
-    enum OutputIndexType {OUT_B, OutputIndexType_MAX};
-    
-    // check number of input and output arguments
-    matlabImport->CheckNumberOfArguments(2, InputIndexType_MAX);
-    matlabExport->CheckNumberOfArguments(0, OutputIndexType_MAX);
-    
-    // get pointer to image input
-    MatlabInputPointer inA              = matlabImport->GetRegisteredInput("A");
-  
-    // register the inputs exclusive to this function
-    MatlabInputPointer inSIGMAMIN       = matlabImport->RegisterInput(IN_SIGMAMIN, "SIGMAMIN");
-    MatlabInputPointer inSIGMAMAX       = matlabImport->RegisterInput(IN_SIGMAMAX, "SIGMAMAX");
-    MatlabInputPointer inNUMSIGMASTEPS  = matlabImport->RegisterInput(IN_NUMSIGMASTEPS, "NUMSIGMASTEPS");
-    MatlabInputPointer inISSIGMASTEPLOG = matlabImport->RegisterInput(IN_ISSIGMASTEPLOG, "ISSIGMASTEPLOG");
-
-    // register the outputs for this function at the export filter
-    typedef MatlabExportFilter::MatlabOutputPointer MatlabOutputPointer;
-    MatlabOutputPointer outB = matlabExport->RegisterOutput(OUT_B, "B");
-
-    // instantiate the filter
-    typedef double TPixelOut;
-    typedef typename itk::Image<TPixelIn, VImageDimension> InImageType;
-    typedef typename itk::Image<TPixelOut, VImageDimension> OutImageType;
-    typedef itk::MultiScaleHessianSmoothed3DToVesselnessMeasureImageFilter
-      <InImageType, OutImageType> FilterType;
-    typename FilterType::Pointer filter = FilterType::New();
-    
-    // connect Matlab inputs to ITK filter
-    filter->SetInput(matlabImport->
-		     GetImagePointerFromMatlab<TPixelIn, VImageDimension>(inA));
-    
-    // filter parameters
-    filter->SetSigmaMin(matlabImport->template
-			ReadScalarFromMatlab<double>(inSIGMAMIN, 0.2));
-    filter->SetSigmaMax(matlabImport->template
-			ReadScalarFromMatlab<double>(inSIGMAMAX, 2.0));
-    filter->SetNumberOfSigmaSteps(matlabImport->template
-			ReadScalarFromMatlab<int>(inNUMSIGMASTEPS, 10));
-    filter->SetIsSigmaStepLog(matlabImport->template
-			ReadScalarFromMatlab<bool>(inISSIGMASTEPLOG, true));
-
-    // connect ITK filter outputs to Matlab outputs
-    matlabExport->GraftItkImageOntoMatlab<TPixelOut, VImageDimension>
-      (outB, filter->GetOutputs()[0], im.size);
-
-    // run filter
-    filter->Update();
-
-  }
-};
-
-template <class TPixelIn>
-class FilterWrapper<TPixelIn, 2,
-		    nMultiScaleHessianSmoothed3DToVesselnessMeasureImageFilter> {
-public:
-  FilterWrapper(MatlabImportFilter::Pointer, MatlabExportFilter::Pointer,
-		MatlabImageHeader &) {
-    mexErrMsgTxt("MultiScaleHessianSmoothed3DToVesselnessMeasureImageFilter only accepts 3D input images");
-  }
-};
-
-template <class TPixelIn>
-class FilterWrapper<TPixelIn, 4,
-		    nMultiScaleHessianSmoothed3DToVesselnessMeasureImageFilter> {
-public:
-  FilterWrapper(MatlabImportFilter::Pointer, MatlabExportFilter::Pointer,
-		MatlabImageHeader &) {
-    mexErrMsgTxt("MultiScaleHessianSmoothed3DToVesselnessMeasureImageFilter only accepts 3D input images");
-  }
-};
-
-// AnisotropicDiffusionVesselEnhancementImageFilter
-template <class TPixelIn, unsigned int VImageDimension>
-class FilterWrapper<TPixelIn, VImageDimension,
-		    nAnisotropicDiffusionVesselEnhancementImageFilter> {
-public:
-
-  FilterWrapper(MatlabImportFilter::Pointer matlabImport,
-		MatlabExportFilter::Pointer matlabExport,
-		MatlabImageHeader &im) {
-    
-    // inputs/outputs interfaces
-    enum InputIndexType {IN_TYPE, IN_A, IN_SIGMAMIN, IN_SIGMAMAX, IN_NUMSIGMASTEPS, 
-			 IN_ISSIGMASTEPLOG, IN_NUMITERATIONS, IN_WSTRENGTH, IN_SENSITIVITY, IN_TIMESTEP, 
-			 IN_EPSILON, InputIndexType_MAX};
-    enum OutputIndexType {OUT_B, OutputIndexType_MAX};
-    
-    // check number of input and output arguments
-    matlabImport->CheckNumberOfArguments(2, InputIndexType_MAX);
-    matlabExport->CheckNumberOfArguments(0, OutputIndexType_MAX);
-
-    // get pointer to image input
-    MatlabInputPointer inA              = matlabImport->GetRegisteredInput("A");
-  
-    // register the inputs exclusive to this function
-    MatlabInputPointer inSIGMAMIN       = matlabImport->RegisterInput(IN_SIGMAMIN, "SIGMAMIN");
-    MatlabInputPointer inSIGMAMAX       = matlabImport->RegisterInput(IN_SIGMAMAX, "SIGMAMAX");
-    MatlabInputPointer inNUMSIGMASTEPS  = matlabImport->RegisterInput(IN_NUMSIGMASTEPS, "NUMSIGMASTEPS");
-    MatlabInputPointer inISSIGMASTEPLOG = matlabImport->RegisterInput(IN_ISSIGMASTEPLOG, "ISSIGMASTEPLOG");
-    MatlabInputPointer inNUMITERATIONS  = matlabImport->RegisterInput(IN_NUMITERATIONS, "NUMITERATIONS");
-    MatlabInputPointer inWSTRENGTH      = matlabImport->RegisterInput(IN_WSTRENGTH, "WSTRENGTH");
-    MatlabInputPointer inSENSITIVITY    = matlabImport->RegisterInput(IN_SENSITIVITY, "SENSITIVITY");
-    MatlabInputPointer inTIMESTEP       = matlabImport->RegisterInput(IN_TIMESTEP, "TIMESTEP");
-    MatlabInputPointer inEPSILON        = matlabImport->RegisterInput(IN_EPSILON, "EPSILON");
-
-    // register the outputs for this function at the export filter
-    typedef MatlabExportFilter::MatlabOutputPointer MatlabOutputPointer;
-    MatlabOutputPointer outB = matlabExport->RegisterOutput(OUT_B, "B");
-
-    // instantiate the filter
-    typedef TPixelIn TPixelOut;
-    typedef typename itk::Image<TPixelIn, VImageDimension> InImageType;
-    typedef InImageType OutImageType;
-    typedef itk::AnisotropicDiffusionVesselEnhancementImageFilter<InImageType, OutImageType>
-      FilterType;
-    typename FilterType::Pointer filter = FilterType::New();
-    
-    // connect Matlab inputs to ITK filter
-    filter->SetInput(matlabImport->GetImagePointerFromMatlab<TPixelIn, VImageDimension>(inA));
-
-    filter->SetSigmaMin(matlabImport->
-		       ReadScalarFromMatlab<double>(inSIGMAMIN, 0.2));
-    filter->SetSigmaMax(matlabImport->
-		       ReadScalarFromMatlab<double>(inSIGMAMAX, 2.0));
-    filter->SetNumberOfSigmaSteps(matlabImport->
-		       ReadScalarFromMatlab<int>   (inNUMSIGMASTEPS, 10));
-    filter->SetIsSigmaStepLog(matlabImport->
-		       ReadScalarFromMatlab<bool>  (inISSIGMASTEPLOG, true));
-    filter->SetNumberOfIterations(matlabImport->
-		       ReadScalarFromMatlab<int>   (inNUMITERATIONS, 1));
-    filter->SetWStrength(matlabImport->
-		       ReadScalarFromMatlab<double>(inWSTRENGTH, 25.0));
-    filter->SetSensitivity(matlabImport->
-		       ReadScalarFromMatlab<double>(inSENSITIVITY, 5.0));
-    filter->SetTimeStep(matlabImport->
-		       ReadScalarFromMatlab<double>(inTIMESTEP, 1e-3));
-    filter->SetEpsilon(matlabImport->
-		       ReadScalarFromMatlab<double>(inEPSILON, 1e-2));
-    
-    // connect ITK filter outputs to Matlab outputs
-    matlabExport->GraftItkImageOntoMatlab<TPixelOut, VImageDimension>
-      (outB, filter->GetOutputs()[0], im.size);
-
-    // run filter
-    filter->Update();
-
-  }
-};
-
-template <class TPixelIn>
-class FilterWrapper<TPixelIn, 2,
-		    nAnisotropicDiffusionVesselEnhancementImageFilter> {
-public:
-  FilterWrapper(MatlabImportFilter::Pointer, MatlabExportFilter::Pointer,
-		MatlabImageHeader &) {
-    mexErrMsgTxt("AnisotropicDiffusionVesselEnhancementImageFilter only accepts 3D input images");
-  }
-};
-
-template <class TPixelIn>
-class FilterWrapper<TPixelIn, 4,
-	      nAnisotropicDiffusionVesselEnhancementImageFilter> {
-public:
-  FilterWrapper(MatlabImportFilter::Pointer, MatlabExportFilter::Pointer,
-		MatlabImageHeader &) {
-    mexErrMsgTxt("AnisotropicDiffusionVesselEnhancementImageFilter only accepts 3D input images");
-  }
-};
-
-// BinaryThinningImageFilter3D
-template <class TPixelIn, unsigned int VImageDimension>
-class FilterWrapper<TPixelIn, VImageDimension,
-		    nBinaryThinningImageFilter3D> {
-public:
-  
-  FilterWrapper(MatlabImportFilter::Pointer matlabImport,
-		MatlabExportFilter::Pointer matlabExport,
-		MatlabImageHeader &im) {
-    
-    // inputs/outputs interfaces
-    enum InputIndexType {IN_TYPE, IN_A, InputIndexType_MAX};
-    enum OutputIndexType {OUT_B, OutputIndexType_MAX};
-
-    // check number of input and output arguments
-    matlabImport->CheckNumberOfArguments(2, InputIndexType_MAX);
-    matlabExport->CheckNumberOfArguments(0, OutputIndexType_MAX);
-    
-    // get pointer to image input
-    MatlabInputPointer inA              = matlabImport->GetRegisteredInput("A");
-  
-    // register the outputs for this function at the export filter
-    typedef MatlabExportFilter::MatlabOutputPointer MatlabOutputPointer;
-    MatlabOutputPointer outB = matlabExport->RegisterOutput(OUT_B, "B");
-
-    // instantiate the filter
-    typedef TPixelIn TPixelOut;
-    typedef typename itk::Image<TPixelIn, VImageDimension> InImageType;
-    typedef InImageType OutImageType;
-    typedef itk::BinaryThinningImageFilter3D<InImageType, OutImageType>
-      FilterType;
-    typename FilterType::Pointer filter = FilterType::New();
-    
-    // connect Matlab inputs to ITK filter
-    filter->SetInput(matlabImport->
-		     GetImagePointerFromMatlab<TPixelIn, VImageDimension>(inA));
-
-    // connect ITK filter outputs to Matlab outputs
-    matlabExport->GraftItkImageOntoMatlab<TPixelOut, VImageDimension>
-      (outB, filter->GetOutputs()[0], im.size);
-
-    // run filter
-    filter->Update();
-
-  }
-};
-
-template <class TPixelIn>
-class FilterWrapper<TPixelIn, 2,
-		    nBinaryThinningImageFilter3D> {
-public:
-  FilterWrapper(MatlabImportFilter::Pointer, MatlabExportFilter::Pointer,
-		MatlabImageHeader &) {
-    mexErrMsgTxt("BinaryThinningImageFilter3D only accepts 3D input images");
-  }
-};
-
-template <class TPixelIn>
-class FilterWrapper<TPixelIn, 4,
-		    nBinaryThinningImageFilter3D> {
-public:
-  FilterWrapper(MatlabImportFilter::Pointer, MatlabExportFilter::Pointer,
-		MatlabImageHeader &) {
-    mexErrMsgTxt("BinaryThinningImageFilter3D only accepts 3D input images");
-  }
-};
-
-// SignedDanielssonDistanceMapImageFilter
-template <class TPixelIn, unsigned int VImageDimension>
-class FilterWrapper<TPixelIn, VImageDimension,
-		    nSignedDanielssonDistanceMapImageFilter> {
-public:
-  
-  FilterWrapper(MatlabImportFilter::Pointer matlabImport,
-		MatlabExportFilter::Pointer matlabExport,
-		MatlabImageHeader &im) {
-    
-    // inputs/outputs interfaces
-    enum InputIndexType {IN_TYPE, IN_A, InputIndexType_MAX};
-    enum OutputIndexType {OUT_B, OUT_V, OUT_W, OutputIndexType_MAX};
-
-    // check number of input and output arguments
-    matlabImport->CheckNumberOfArguments(2, InputIndexType_MAX);
-    matlabExport->CheckNumberOfArguments(0, OutputIndexType_MAX);
-    
-    // get pointer to image input
-    MatlabInputPointer inA              = matlabImport->GetRegisteredInput("A");
-  
-    // register the outputs for this function at the export filter
-    typedef MatlabExportFilter::MatlabOutputPointer MatlabOutputPointer;
-    MatlabOutputPointer outB = matlabExport->RegisterOutput(OUT_B, "B");
-    MatlabOutputPointer outV = matlabExport->RegisterOutput(OUT_V, "V");
-    MatlabOutputPointer outW = matlabExport->RegisterOutput(OUT_W, "W");
-
-    // instantiate the filter
-    typedef float TPixelOut;
-    typedef typename itk::Image<TPixelIn, VImageDimension> InImageType;
-    typedef typename itk::Image<TPixelOut, VImageDimension> OutImageType;
-    typedef itk::SignedDanielssonDistanceMapImageFilter<InImageType, OutImageType>
-      FilterType;
-    typename FilterType::Pointer filter = FilterType::New();
-    
-    // connect Matlab inputs to ITK filter
-    filter->SetInput(matlabImport->
-		     GetImagePointerFromMatlab<TPixelIn, VImageDimension>(inA));
-
-    // connect ITK filter outputs to Matlab outputs
-
-    // distance map
-    matlabExport->GraftItkImageOntoMatlab<TPixelOut, VImageDimension>
-      (outB, filter->GetOutputs()[0], im.size);
-
-    // Voronoi map
-    matlabExport->GraftItkImageOntoMatlab<TPixelIn, VImageDimension>
-      (outV, filter->GetOutputs()[1], im.size);
-
-    // vectors pointing to closest foreground voxel
-    matlabExport->GraftItkImageOntoMatlab<typename InImageType::OffsetType::OffsetValueType,
-					  VImageDimension,
-					  typename InImageType::OffsetType::OffsetType>
-      (outW, filter->GetOutputs()[2], im.size);
 
-    // run filter
-    filter->Update();
-
-  }
-};
-
-// DanielssonDistanceMapImageFilter
-template <class TPixelIn, unsigned int VImageDimension>
-class FilterWrapper<TPixelIn, VImageDimension,
-		    nDanielssonDistanceMapImageFilter> {
-public:
-  
-  FilterWrapper(MatlabImportFilter::Pointer matlabImport,
-		MatlabExportFilter::Pointer matlabExport,
-		MatlabImageHeader &im) {
-    
-    // inputs/outputs interfaces
-    enum InputIndexType {IN_TYPE, IN_A, InputIndexType_MAX};
-    enum OutputIndexType {OUT_B, OUT_V, OUT_W, OutputIndexType_MAX};
-
-    // check number of input and output arguments
-    matlabImport->CheckNumberOfArguments(2, InputIndexType_MAX);
-    matlabExport->CheckNumberOfArguments(0, OutputIndexType_MAX);
-    
-    // get pointer to image input
-    MatlabInputPointer inA   = matlabImport->GetRegisteredInput("A");
-  
-    // register the outputs for this function at the export filter
-    typedef MatlabExportFilter::MatlabOutputPointer MatlabOutputPointer;
-    MatlabOutputPointer outB = matlabExport->RegisterOutput(OUT_B, "B");
-    MatlabOutputPointer outV = matlabExport->RegisterOutput(OUT_V, "V");
-    MatlabOutputPointer outW = matlabExport->RegisterOutput(OUT_W, "W");
-
-    // instantiate the filter
-    typedef double TPixelOut;
-    typedef typename itk::Image<TPixelIn, VImageDimension> InImageType;
-    typedef typename itk::Image<TPixelOut, VImageDimension> OutImageType;
-    typedef itk::DanielssonDistanceMapImageFilter<InImageType, OutImageType>
-      FilterType;
-    typename FilterType::Pointer filter = FilterType::New();
-    
-    // connect Matlab inputs to ITK filter
-    filter->SetInput(matlabImport->
-		     GetImagePointerFromMatlab<TPixelIn, VImageDimension>(inA));
-
-    // connect ITK filter outputs to Matlab outputs
-
-    // distance map
-    matlabExport->GraftItkImageOntoMatlab<TPixelOut, VImageDimension>
-      (outB, filter->GetOutputs()[0], im.size);
-
-    // Voronoi map
-    matlabExport->GraftItkImageOntoMatlab<TPixelIn, VImageDimension>
-      (outV, filter->GetOutputs()[1], im.size);
-
-    // vectors pointing to closest foreground voxel
-    matlabExport->GraftItkImageOntoMatlab<typename InImageType::OffsetType::OffsetValueType,
-					  VImageDimension,
-					  typename InImageType::OffsetType::OffsetType>
-      (outW, filter->GetOutputs()[2], im.size);
-
-    // run filter
-    filter->Update();
-
-  }
-};
-
-// SignedMaurerDistanceMapImageFilter
-template <class TPixelIn, unsigned int VImageDimension>
-class FilterWrapper<TPixelIn, VImageDimension,
-		    nSignedMaurerDistanceMapImageFilter> {
-public:
-  
-  FilterWrapper(MatlabImportFilter::Pointer matlabImport,
-		MatlabExportFilter::Pointer matlabExport,
-		MatlabImageHeader &im) {
-    
-    // inputs/outputs interfaces
-    enum InputIndexType {IN_TYPE, IN_A, InputIndexType_MAX};
-    enum OutputIndexType {OUT_B, OutputIndexType_MAX};
-
-    // check number of input and output arguments
-    matlabImport->CheckNumberOfArguments(2, InputIndexType_MAX);
-    matlabExport->CheckNumberOfArguments(0, OutputIndexType_MAX);
-    
-    // get pointer to image input
-    MatlabInputPointer inA              = matlabImport->GetRegisteredInput("A");
-  
-    // register the outputs for this function at the export filter
-    typedef MatlabExportFilter::MatlabOutputPointer MatlabOutputPointer;
-    MatlabOutputPointer outB = matlabExport->RegisterOutput(OUT_B, "B");
-    
-    // instantiate the filter
-    typedef float TPixelOut;
-    typedef typename itk::Image<TPixelIn, VImageDimension> InImageType;
-    typedef typename itk::Image<TPixelOut, VImageDimension> OutImageType;
-    typedef itk::SignedMaurerDistanceMapImageFilter<InImageType, OutImageType>
-      FilterType;
-    typename FilterType::Pointer filter = FilterType::New();
-    
-    // compute distances using real world coordinates, instead of voxel
-    // indices
-    filter->SetUseImageSpacing(true);
-    
-    // give output as actual distances
-    filter->SquaredDistanceOff();
-    
-    // connect Matlab inputs to ITK filter
-    filter->SetInput(matlabImport->
-		     GetImagePointerFromMatlab<TPixelIn, VImageDimension>(inA));
-
-    // run filter
-    filter->Update();
-
-    // copy ITK filter outputs to Matlab outputs
-
-    // distance map
-    matlabExport->CopyItkImageToMatlab<TPixelOut, VImageDimension>
-      (outB, filter->GetOutputs()[0], im.size);
-
-  }
-};
-
-template <unsigned int VImageDimension>
-class FilterWrapper<mxLogical, VImageDimension,
-		    nSignedMaurerDistanceMapImageFilter> {
-public:
-  FilterWrapper(MatlabImportFilter::Pointer, MatlabExportFilter::Pointer,
-		MatlabImageHeader &) {
-    mexErrMsgTxt("SignedMaurerDistanceMapImageFilter does not accept input image with type boolean");
-  }
-};
-
-// BinaryDilateImageFilter
-template <class TPixelIn, unsigned int VImageDimension>
-class FilterWrapper<TPixelIn, VImageDimension,
-		    nBinaryDilateImageFilter> {
-public:
-  
-  FilterWrapper(MatlabImportFilter::Pointer matlabImport,
-		MatlabExportFilter::Pointer matlabExport,
-		MatlabImageHeader &im) {
-    
-    // inputs/outputs interfaces
-    enum InputIndexType {IN_TYPE, IN_A, IN_RADIUS, IN_FOREGROUND, InputIndexType_MAX};
-    enum OutputIndexType {OUT_B, OutputIndexType_MAX};
-
-    // check number of input and output arguments
-    matlabImport->CheckNumberOfArguments(2, InputIndexType_MAX);
-    matlabExport->CheckNumberOfArguments(0, OutputIndexType_MAX);
-    
-    // get pointer to image input
-    MatlabInputPointer inA          = matlabImport->GetRegisteredInput("A");
-  
-    // register the inputs exclusive to this function
-    MatlabInputPointer inRADIUS     = matlabImport->RegisterInput(IN_RADIUS, "RADIUS");
-    MatlabInputPointer inFOREGROUND = matlabImport->RegisterInput(IN_FOREGROUND, "FOREGROUND");
-
-    // register the outputs for this function at the export filter
-    typedef MatlabExportFilter::MatlabOutputPointer MatlabOutputPointer;
-    MatlabOutputPointer outB = matlabExport->RegisterOutput(OUT_B, "B");
-    
-    // instantiate the filter
-    typedef TPixelIn TPixelOut;
-    typedef itk::BinaryBallStructuringElement<TPixelIn, VImageDimension>
-      StructuringElementType;
-    typedef typename itk::Image<TPixelIn, VImageDimension> InImageType;
-    typedef InImageType OutImageType;
-    typedef itk::BinaryDilateImageFilter<InImageType, OutImageType, StructuringElementType>
-      FilterType;
-    typename FilterType::Pointer filter = FilterType::New();
-    
-    // connect Matlab inputs to ITK filter
-    filter->SetInput(matlabImport->
-		     GetImagePointerFromMatlab<TPixelIn, VImageDimension>(inA));
-    
-    // instantiate structuring element
-    // (comp) radius of the ball in voxels
-    StructuringElementType structuringElement;
-    structuringElement.SetRadius(matlabImport->
-				 ReadScalarFromMatlab<unsigned long>(inRADIUS, 0));
-    structuringElement.CreateStructuringElement();
-    filter->SetKernel(structuringElement);
-    
-    // pass other parameters to filter
-    // (opt) voxels with this value will be dilated.
-    filter->SetForegroundValue(matlabImport->template
-			       ReadScalarFromMatlab<TPixelIn>(inFOREGROUND, 1));
-    
-    // connect ITK filter outputs to Matlab outputs
-    matlabExport->GraftItkImageOntoMatlab<TPixelOut, VImageDimension>
-      (outB, filter->GetOutputs()[0], im.size);
-
-    // run filter
-    filter->Update();
-
-  }
-};
-
-// BinaryErodeImageFilter
-template <class TPixelIn, unsigned int VImageDimension>
-class FilterWrapper<TPixelIn, VImageDimension,
-		    nBinaryErodeImageFilter> {
-public:
-  
-  FilterWrapper(MatlabImportFilter::Pointer matlabImport,
-		MatlabExportFilter::Pointer matlabExport,
-		MatlabImageHeader &im) {
-    
-    // inputs/outputs interfaces
-    enum InputIndexType {IN_TYPE, IN_A, IN_RADIUS, IN_FOREGROUND, InputIndexType_MAX};
-    enum OutputIndexType {OUT_B, OutputIndexType_MAX};
-
-    // check number of input and output arguments
-    matlabImport->CheckNumberOfArguments(2, InputIndexType_MAX);
-    matlabExport->CheckNumberOfArguments(0, OutputIndexType_MAX);
-    
-    // get pointer to image input
-    MatlabInputPointer inA          = matlabImport->GetRegisteredInput("A");
-  
-    // register the inputs exclusive to this function
-    MatlabInputPointer inRADIUS     = matlabImport->RegisterInput(IN_RADIUS, "RADIUS");
-    MatlabInputPointer inFOREGROUND = matlabImport->RegisterInput(IN_FOREGROUND, "FOREGROUND");
-
-    // register the outputs for this function at the export filter
-    typedef MatlabExportFilter::MatlabOutputPointer MatlabOutputPointer;
-    MatlabOutputPointer outB = matlabExport->RegisterOutput(OUT_B, "B");
-    
-    // instantiate the filter
-    typedef TPixelIn TPixelOut;
-    typedef itk::BinaryBallStructuringElement<TPixelIn, VImageDimension>
-      StructuringElementType;
-    typedef typename itk::Image<TPixelIn, VImageDimension> InImageType;
-    typedef InImageType OutImageType;
-    typedef itk::BinaryErodeImageFilter<InImageType, OutImageType, StructuringElementType>
-      FilterType;
-    typename FilterType::Pointer filter = FilterType::New();
-    
-    // connect Matlab inputs to ITK filter
-    filter->SetInput(matlabImport->
-		     GetImagePointerFromMatlab<TPixelIn, VImageDimension>(inA));
-    
-    // instantiate structuring element
-    // (comp) radius of the ball in voxels
-    StructuringElementType structuringElement;
-    structuringElement.SetRadius(matlabImport->
-				 ReadScalarFromMatlab<unsigned long>(inRADIUS, 0));
-    structuringElement.CreateStructuringElement();
-    filter->SetKernel(structuringElement);
-
-    // pass other parameters to filter
-    // (opt) voxels with this value will be dilated. Default, maximum
-    // value of the pixel type (this is the ITK default, so we
-    // reproduce it here, even if it "1" would be more convenient)
-    filter->SetForegroundValue(matlabImport->template
-			       ReadScalarFromMatlab<TPixelIn>(inFOREGROUND, 1));
-    
-    // connect ITK filter outputs to Matlab outputs
-    matlabExport->GraftItkImageOntoMatlab<TPixelOut, VImageDimension>
-      (outB, filter->GetOutputs()[0], im.size);
-
-    // run filter
-    filter->Update();
-
-  }
-};
-
-// MRFImageFilter
-template <class TPixelIn, unsigned int VImageDimension>
-class FilterWrapper<TPixelIn, VImageDimension,
-		    nMRFImageFilter> {
-public:
-  
-  FilterWrapper(MatlabImportFilter::Pointer matlabImport,
-		MatlabExportFilter::Pointer matlabExport,
-		MatlabImageHeader &im) {
-    
-    // inputs/outputs interfaces
-    enum InputIndexType {IN_TYPE, IN_A, IN_MU, IN_WEIGHTS, IN_SMOOTH, 
-			 IN_NITER, IN_TOL, InputIndexType_MAX};
-    enum OutputIndexType {OUT_B, OutputIndexType_MAX};
-
-    // check number of input and output arguments
-    matlabImport->CheckNumberOfArguments(3, InputIndexType_MAX);
-    matlabExport->CheckNumberOfArguments(0, OutputIndexType_MAX);
-    
-    // get pointer to image input
-    MatlabInputPointer inA       = matlabImport->GetRegisteredInput("A");
-  
-    // register the inputs exclusive to this function
-    MatlabInputPointer inMU      = matlabImport->RegisterInput(IN_MU, "MU");
-    MatlabInputPointer inWEIGHTS = matlabImport->RegisterInput(IN_WEIGHTS, "WEIGHTS");
-    MatlabInputPointer inSMOOTH  = matlabImport->RegisterInput(IN_SMOOTH, "SMOOTH");
-    MatlabInputPointer inNITER   = matlabImport->RegisterInput(IN_NITER, "NITER");
-    MatlabInputPointer inTOL     = matlabImport->RegisterInput(IN_TOL, "TOL");
-
-    // register the outputs for this function at the export filter
-    typedef MatlabExportFilter::MatlabOutputPointer MatlabOutputPointer;
-    MatlabOutputPointer outB = matlabExport->RegisterOutput(OUT_B, "B");
-    
-    /* type definitions */
-
-    // input image
-    typedef typename itk::Image<TPixelIn, VImageDimension> InImageType;
-    
-    // segmentation masks
-    typedef unsigned char LabelPixelType;
-    typedef itk::Image<LabelPixelType, VImageDimension> LabelImageType;
-
-    // output pixel type
-    typedef LabelPixelType TPixelOut;
-
-    // dummy compose filter to convert the scalar image into a 1-vector image
-    typedef itk::FixedArray<TPixelIn, 1> ArrayPixelType;
-    typedef itk::Image<ArrayPixelType, VImageDimension> ArrayImageType;
-    typedef itk::ComposeImageFilter<
-      InImageType, ArrayImageType> ScalarToArrayFilterType;
-
-    // filter
-    typedef itk::MRFImageFilter<ArrayImageType, LabelImageType>
-      FilterType;
-
-    // classifier
-    typedef itk::ImageClassifierBase<ArrayImageType, LabelImageType> SupervisedClassifierType;
-
-    // decision rule
-    typedef itk::Statistics::MinimumDecisionRule DecisionRuleType;
-
-    // membership function
-    typedef itk::Statistics::DistanceToCentroidMembershipFunction<ArrayPixelType>
-      MembershipFunctionType;
-    typedef typename MembershipFunctionType::Pointer MembershipFunctionPointer;
-
-    /* filter actions */    
-
-    // instantiate the filter
-    typename FilterType::Pointer filter = FilterType::New();
-
-    /*    
-     * get input arguments (grouped here for clarity)
-     */
-    
-    // from the ITK guide: "Since the Markov Random Field algorithm is
-    // defined in general for images whose pixels have multiple
-    // components, that is, images of vector type, we must adapt our
-    // scalar image in order to satisfy the interface expected by the
-    // \code{MRFImageFilter}. We do this by using the
-    // \doxygen{ComposeImageFilter}. With this filter we will present
-    // our scalar image as a vector image whose vector pixels contain
-    // a single component"
-    typename ScalarToArrayFilterType::Pointer
-      scalarToArrayFilter = ScalarToArrayFilterType::New();
-    scalarToArrayFilter->SetInput(matlabImport->
-    				  GetImagePointerFromMatlab<TPixelIn, VImageDimension>(inA));
-
-    // vector of centroids
-    std::vector<TPixelIn> centroid = matlabImport->template
-      ReadRowVectorFromMatlab<TPixelIn, std::vector<TPixelIn> >(inMU, std::vector<TPixelIn>(0));
-    unsigned int numberOfClasses = centroid.size();
-
-    // by default, the neighbourhood is a hypercube with 1 voxel to
-    // either side of the centre, i.e. a hypercube with side 3. All
-    // elements of the default hypercube are 1.0, except for the
-    // central pixel, that is 0.0
-    mwSize neighLength = (mwSize)std::pow(3.0, (double)VImageDimension);
-    std::vector<double> weights(neighLength, 1.0);
-    weights[(neighLength-1)/2] = 0.0;
-    typename InImageType::SizeType neighHalfSize;
-    neighHalfSize.Fill(1);
-
-    // read neighbourhood weights provided by the user, but as a vector
-    weights = matlabImport->template
-      ReadArrayAsVectorFromMatlab<std::vector<double> >(inWEIGHTS, weights);
-    
-    // get size of neighbourhood weights array as provided by the
-    // user. We get the half-size, as required by this filter (size =
-    // 2 * halfsize + 1)
-    neighHalfSize = matlabImport->template
-      ReadMatlabArrayHalfSize<typename InImageType::SizeValueType, 
-		       typename InImageType::SizeType,
-		       VImageDimension>(inWEIGHTS, neighHalfSize);
-
-    double smoothingFactor = matlabImport->template
-      ReadScalarFromMatlab<double>(inSMOOTH, 1e-7);
-    unsigned int maximumNumberOfIterations = matlabImport->template
-      ReadScalarFromMatlab<unsigned int>(inNITER, 100);
-    double errorTolerance = matlabImport->template
-      ReadScalarFromMatlab<double>(inTOL, 1e-7);
-
-    // ITK guide: "number of classes to be used during the
-    // classification, the maximum number of iterations to be run in
-    // this filter and the error tolerance that will be used as a
-    // criterion for convergence"
-    //
-    // ITK guide: "the smoothing factor represents the tradeoff
-    // between fidelity to the observed image and the smoothness of
-    // the segmented image. Typical smoothing factors have values
-    // between 1~5. This factor will multiply the weights that define
-    // the influence of neighbors on the classification of a given
-    // pixel.  The higher the value, the more uniform will be the
-    // regions resulting from the classification refinement"
-    filter->SetNumberOfClasses(numberOfClasses);
-    filter->SetSmoothingFactor(smoothingFactor);
-    filter->SetMaximumNumberOfIterations(maximumNumberOfIterations);
-    filter->SetErrorTolerance(errorTolerance);
-
-    // ITK guide: "Given that the MRF filter need to continually
-    // relabel the pixels, it needs access to a set of membership
-    // functions that will measure to what degree every pixel belongs
-    // to a particular class.  The classification is performed by the
-    // \doxygen{ImageClassifierBase} class, that is instantiated using
-    // the type of the input vector image and the type of the labeled
-    // image
-    typename SupervisedClassifierType::Pointer classifier 
-      = SupervisedClassifierType::New();
-
-    // ITK guide: "The classifier needs a decision rule to be set by
-    // the user. Note that we must use \code{GetPointer()} in the call
-    // of the \code{SetDecisionRule()} method because we are passing a
-    // SmartPointer, and smart pointers cannot perform polymorphism,
-    // we must then extract the raw pointer that is associated to the
-    // smart pointer. This extraction is done with the GetPointer()
-    // method"
-    //
-    // MinimumDecisionRule returns the class label with the smallest
-    // discriminant score
-    typename DecisionRuleType::Pointer classifierDecisionRule 
-      = DecisionRuleType::New();
-    classifier->SetDecisionRule(classifierDecisionRule.GetPointer());
-
-    // ITK guide: "we now instantiate the membership functions. In
-    // this case we use the
-    // \subdoxygen{Statistics}{DistanceToCentroidMembershipFunction}
-    // class templated over the pixel type of the vector image, that
-    // in our example happens to be a vector of dimension 1"
-    double meanDistance = 0.0;
-    typename MembershipFunctionType::CentroidType centroidAux(1);
-    for(unsigned int i=0; i < numberOfClasses; i++) {
-      MembershipFunctionPointer membershipFunction =
-    	MembershipFunctionType::New();
-      
-      centroidAux[0] = centroid[i];
-      
-      membershipFunction->SetCentroid(centroidAux);
-      
-      classifier->AddMembershipFunction(membershipFunction);
-      meanDistance += static_cast<double>(centroid[i]);
-    }
-    meanDistance /= numberOfClasses;
-    
-    // ITK guide: "and we set the neighborhood radius that will define
-    // the size of the clique to be used in the computation of the
-    // neighbors' influence in the classification of any given
-    // pixel. Note that despite the fact that we call this a radius,
-    // it is actually the half size of an hypercube. That is, the
-    // actual region of influence will not be circular but rather an
-    // N-Dimensional box. For example, a neighborhood radius of 2 in a
-    // 3D image will result in a clique of size 5x5x5 pixels, and a
-    // radius of 1 will result in a clique of size 3x3x3 pixels."
-    filter->SetNeighborhoodRadius(neighHalfSize);
-
-    // ITK guide: "We now scale weights so that the smoothing function
-    // and the image fidelity functions have comparable value. This is
-    // necessary since the label image and the input image can have
-    // different dynamic ranges. The fidelity function is usually
-    // computed using a distance function, such as the
-    // \doxygen{DistanceToCentroidMembershipFunction} or one of the
-    // other membership functions. They tend to have values in the
-    // order of the means specified."
-    double totalWeight = 0;
-    for(std::vector<double>::const_iterator wcIt = weights.begin();
-	wcIt != weights.end(); ++wcIt ) {
-      totalWeight += *wcIt;
-    }
-    for(std::vector<double>::iterator wIt = weights.begin();
-	wIt != weights.end(); wIt++) {
-      *wIt = static_cast<double> ((*wIt) * meanDistance / (2 * totalWeight));
-    }
-
-    filter->SetMRFNeighborhoodWeight(weights);
-    
-    // ITK guide: "Finally, the classifier class is connected to the Markof Random Fields filter."
-    filter->SetClassifier(classifier);
-
-    // connect Matlab inputs to ITK filter
-    filter->SetInput(scalarToArrayFilter->GetOutput());
-    
-    // connect ITK filter outputs to Matlab outputs
-    matlabExport->GraftItkImageOntoMatlab<TPixelOut, VImageDimension>
-      (outB, filter->GetOutputs()[0], im.size);
-
-    // run filter
-    filter->Update();
-
-  }
-};
-
-
-
-
-
-
-
-/*
- * Argument Parsers
- *
- * These functions are used to be able to map between the input/output
- * data types that are only know at run-time, and the input/output
- * data templates that ITK requires and must be know at compilation
- * time.
- */
-
-// parseOutputImageTypeToTemplate()
-template <class TPixelIn, unsigned int VImageDimension>
-void parseOutputImageTypeToTemplate(MatlabImportFilter::Pointer matlabImport,
-				    MatlabExportFilter::Pointer matlabExport,
-				    MatlabImageHeader &im) {
-
-  // input image type
-  typedef typename itk::Image<TPixelIn, VImageDimension> InImageType;
-
-  // get pointer to type input
-  MatlabInputPointer inTYPE = matlabImport->GetRegisteredInput("TYPE");
-
-  // name of the filter
-  std::string filterName = matlabImport->ReadStringFromMatlab(inTYPE, "Unknown");
-
-  // select the output type corresponding to each filter
-  if (filterName == "canny" 
-  	     || filterName == "CannyEdgeDetectionImageFilter") {
-
-    FilterWrapper<TPixelIn, VImageDimension, nCannyEdgeDetectionImageFilter> 
-      filterWrapper(matlabImport, matlabExport, im);
-
-  } else if (filterName == "appsigndist" 
-  	     || filterName == "ApproximateSignedDistanceMapImageFilter") {
-
-    FilterWrapper<TPixelIn, VImageDimension, nApproximateSignedDistanceMapImageFilter> 
-      filterWrapper(matlabImport, matlabExport, im);
-
-  } else if (filterName == "median" 
-  	     || filterName == "MedianImageFilter") {
-
-    FilterWrapper<TPixelIn, VImageDimension, nMedianImageFilter> 
-      filterWrapper(matlabImport, matlabExport, im);
-
-  } else if (filterName == "advess" 
-      || filterName == "AnisotropicDiffusionVesselEnhancementImageFilter") {
-
-    FilterWrapper<TPixelIn, VImageDimension, nAnisotropicDiffusionVesselEnhancementImageFilter> 
-      wrapper(matlabImport, matlabExport, im);
-
-  } else if (filterName == "bwdilate" 
-  	     || filterName == "BinaryDilateImageFilter") {
-
-    FilterWrapper<TPixelIn, VImageDimension, nBinaryDilateImageFilter> 
-      filterWrapper(matlabImport, matlabExport, im);
-
-  } else if (filterName == "bwerode" 
-  	     || filterName == "BinaryErodeImageFilter") {
-
-    FilterWrapper<TPixelIn, VImageDimension, nBinaryErodeImageFilter> 
-      filterWrapper(matlabImport, matlabExport, im);
-
-  } else if (filterName == "skel" 
-  	     || filterName == "BinaryThinningImageFilter3D") {
-
-    FilterWrapper<TPixelIn, VImageDimension, nBinaryThinningImageFilter3D>
-      filterWrapper(matlabImport, matlabExport, im);
-
-  } else if (filterName == "signdandist" 
-  	     || filterName == "SignedDanielssonDistanceMapImageFilter") {
-
-    FilterWrapper<TPixelIn, VImageDimension, nSignedDanielssonDistanceMapImageFilter>
-      filterWrapper(matlabImport, matlabExport, im);
-
-  } else if (filterName == "dandist" 
-  	     || filterName == "DanielssonDistanceMapImageFilter") {
-
-    FilterWrapper<TPixelIn, VImageDimension, nDanielssonDistanceMapImageFilter>
-      filterWrapper(matlabImport, matlabExport, im);
-
-  } else if (filterName == "hesves" 
-  	     || filterName == "MultiScaleHessianSmoothed3DToVesselnessMeasureImageFilter") {
-
-    FilterWrapper<TPixelIn, VImageDimension, nMultiScaleHessianSmoothed3DToVesselnessMeasureImageFilter>
-      filterWrapper(matlabImport, matlabExport, im);
-
-  } else if (filterName == "maudist" 
-  	     || filterName == "SignedMaurerDistanceMapImageFilter") {
-
-    FilterWrapper<TPixelIn, VImageDimension, nSignedMaurerDistanceMapImageFilter>
-      filterWrapper(matlabImport, matlabExport, im);
-
-  } else if (filterName == "mrf" 
-      || filterName == "MRFImageFilter") {
-    
-    FilterWrapper<TPixelIn, VImageDimension, nMRFImageFilter> 
-      filterWrapper(matlabImport, matlabExport, im);
-    
-  } else if (filterName == "voteholefill" 
-      || filterName == "VotingBinaryIterativeHoleFillingImageFilter") {
-    
-    FilterWrapper<TPixelIn, VImageDimension, nVotingBinaryIterativeHoleFillingImageFilter> 
-      filterWrapper(matlabImport, matlabExport, im);
-    
-  } else {
-    mexErrMsgTxt("Invalid filter type");    
-  }  
-
-}
-  
-// parseInputImageTypeToTemplate()
-template <unsigned int VImageDimension>
-void parseInputImageTypeToTemplate(MatlabImportFilter::Pointer matlabImport,
-				   MatlabExportFilter::Pointer matlabExport,
-				   MatlabImageHeader &im) {
-  
-  // input image type
-  switch(im.type)  {
-  case mxLOGICAL_CLASS:
-    parseOutputImageTypeToTemplate<mxLogical, VImageDimension>(matlabImport, matlabExport, im);
-    break;
-  case mxDOUBLE_CLASS:
-    parseOutputImageTypeToTemplate<double, VImageDimension>(matlabImport, matlabExport, im);
-    break;
-  case mxSINGLE_CLASS:
-    parseOutputImageTypeToTemplate<float, VImageDimension>(matlabImport, matlabExport, im);
-    break;
-  case mxINT8_CLASS:
-    parseOutputImageTypeToTemplate<int8_T, VImageDimension>(matlabImport, matlabExport, im);
-    break;
-  case mxUINT8_CLASS:
-    parseOutputImageTypeToTemplate<uint8_T, VImageDimension>(matlabImport, matlabExport, im);
-    break;
-  case mxINT16_CLASS:
-    parseOutputImageTypeToTemplate<int16_T, VImageDimension>(matlabImport, matlabExport, im);
-    break;
-  case mxUINT16_CLASS:
-    parseOutputImageTypeToTemplate<uint16_T, VImageDimension>(matlabImport, matlabExport, im);
-    break;
-  case mxINT32_CLASS:
-    parseOutputImageTypeToTemplate<int32_T, VImageDimension>(matlabImport, matlabExport, im);
-    break;
-  // case mxUINT32_CLASS:
-  //   break;
-  case mxINT64_CLASS:
-    parseOutputImageTypeToTemplate<int64_T, VImageDimension>(matlabImport, matlabExport, im);
-    break;
-  // case mxUINT64_CLASS:
-  //   break;
-  case mxUNKNOWN_CLASS:
-    mexErrMsgTxt("Input matrix has unknown type.");
-    break;
-  default:
-    mexErrMsgTxt("Input matrix has invalid type.");
-    break;
-  }
-
-  // exit successfully
-  return;
-
-}
-
-void parseInputImageDimensionToTemplate(MatlabImportFilter::Pointer matlabImport,
-					MatlabExportFilter::Pointer matlabExport) {
-
-  // get pointer to image input
-  MatlabInputPointer inA = matlabImport->GetRegisteredInput("A");
-  
-  // the 2nd input argument is the input image. It can be given as an
-  // array, or a SCI MAT struct, so it's necessary to pre-process the
-  // pointer to do checks and extract the meta information
-  MatlabImageHeader im(inA->pm, inA->name);
-
-  switch (im.GetNumberOfDimensions()) {
-  case 2:
-    parseInputImageTypeToTemplate<2>(matlabImport, matlabExport, im);
-    break;
-  case 3:
-    parseInputImageTypeToTemplate<3>(matlabImport, matlabExport, im);
-    break;
-  case 4:
-    parseInputImageTypeToTemplate<4>(matlabImport, matlabExport, im);
-    break;
-  default:
-    mexErrMsgTxt("Input image can only have 2 to 4 dimensions");
-    break;
-  }
+  return registry;
 
 }
 
@@ -1854,11 +604,26 @@ void mexFunction(int nlhs, mxArray *plhs[],
   MatlabExportFilter::Pointer matlabExport = MatlabExportFilter::New();
   matlabExport->ConnectToMatlabFunctionOutput(nlhs, plhs);
   
-  // run filter (this function starts a cascade of functions designed
-  // to translate the run-time type variables like inputVoxelClassId
-  // to templates, so that we don't need to nest lots of "switch" or
-  // "if" statements)
-  parseInputImageDimensionToTemplate(matlabImport, matlabExport);
+  // the 2nd input argument is the input image. It can be given as an
+  // array, or a SCI MAT struct, so it's necessary to pre-process the
+  // pointer to do checks and extract the meta information
+  MatlabImageHeader im(inA->pm, inA->name);
+
+  if (im.GetNumberOfDimensions() < 2 || im.GetNumberOfDimensions() > 4) {
+    mexErrMsgTxt("Input image can only have 2 to 4 dimensions");
+  }
+  if (im.type == mxUNKNOWN_CLASS) {
+    mexErrMsgTxt("Input matrix has unknown type.");
+  }
+
+  // name of the filter
+  std::string filterName = matlabImport->ReadStringFromMatlab(inTYPE, "Unknown");
+
+  // run filter. The registry maps the run-time filter name, input
+  // voxel class and image dimension to the function that runs the
+  // filter instantiated with the corresponding templates
+  FilterRunnerType runner = GetFilterRegistry().GetRunner(filterName, im);
+  (*runner)(matlabImport, matlabExport, im);
 
   // exit successfully
   return;
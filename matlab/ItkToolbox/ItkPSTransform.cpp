@@ -45,6 +45,17 @@
  *   pts_tps_map(), as it implements the classic kernel proposed by
  *   Bookstein, r^2 ln(r^2).
  *
+ * YI = itk_pstransform(..., TOL)
+ *
+ *   TOL is a scalar with the error tolerance of the warp, relative to the
+ *   largest displacement. By default, TOL=0, and the warp is computed
+ *   exactly, although in parallel and much faster than ITK's
+ *   TransformPoint(). If TOL>0, the contribution of groups of landmarks
+ *   that are far from the point is approximated with a treecode. This is
+ *   much faster than the exact warp when there are many landmarks (e.g.
+ *   more than 10,000) and points to warp. The treecode error stays below
+ *   TOL. Values of TOL below 2e-8 give the exact warp.
+ *
  * YI = itk_pstransform('bspline', X, Y, XI, ORDER, LEVELS)
  *
  *   'bspline':  itk::BSplineScatteredDataPointSetToImageFilter
@@ -59,14 +70,63 @@
  *   in the algorithm. A higher number of levels will make the spline
  *   more flexible and match the landmarks better. By default, LEVELS=5.
  *
- * See also: pts_tps_map, pts_tps_weights.
+ * YI = itk_pstransform(S, XI)
+ * YI = itk_pstransform(S, XI, TOL)
+ * [YI, S] = itk_pstransform(TRANSFORM, X, Y, XI, ...)
+ *
+ *   S is a struct with the fitted transform. When S is requested, the
+ *   transform fitted to X, Y is returned, so that it can be applied to
+ *   other sets of points XI without fitting it again. XI can be empty
+ *   when only S is needed. S is a plain struct that can be saved to a
+ *   .mat file. Its fields have the same class as X:
+ *
+ *     S.type:        TRANSFORM string
+ *     kernel transforms:
+ *       S.landmarks:   source landmarks X
+ *       S.weights:     (N, D)-matrix with the kernel weights
+ *       S.affine:      (D, D)-matrix of the affine part of the warp
+ *       S.translation: (1, D)-vector of the translation part
+ *       S.alpha:       kernel constant of 'elastic' and 'elasticr'
+ *     'bspline':
+ *       S.order:       ORDER
+ *       S.lattice:     (D, n1, n2[, n3])-array of control point
+ *                      displacements
+ *       S.origin:      (1, D)-vector with the origin of the bounding box
+ *       S.scale:       length of the largest side of the bounding box
+ *
+ *   The B-spline is only defined within the bounding box of the X, Y
+ *   and XI points used to fit it. Points outside of it give an error,
+ *   so they must be included in XI when the B-spline is fitted.
+ *
+ * DX = itk_pstransform(S, SCIMAT)
+ *
+ *   SCIMAT is a struct with an image (see "help scimat" for details).
+ *   Only the size, spacing and origin of the image are used. DX is the
+ *   displacement field of the fitted transform S at the voxel centres.
+ *   It is an (R, C, D) array for 2D and an (R, C, P, D) array for 3D,
+ *   where R, C, P are the rows, columns and slices of the image, and D
+ *   is the dimension. DX(:,:,:,1), DX(:,:,:,2), DX(:,:,:,3) are the x-, y-
+ *   and z-displacements. Note that x changes with the columns of the
+ *   image, and y with the rows, as in scimat_ndgrid().
+ *
+ *   For 'bspline', the field is computed with a separable evaluation of
+ *   the B-spline: the basis weights are computed once for each row,
+ *   column and slice, and slices are evaluated in parallel. This is much
+ *   faster than warping the coordinates of every voxel as points XI.
+ *   The voxel centres must be within the domain of the B-spline (see
+ *   above).
+ *
+ *   To warp an image, interpolate it at the coordinates of the voxels
+ *   plus DX, e.g. with interpn().
+ *
+ * See also: pts_tps_map, pts_tps_weights, scimat_ndgrid.
  *
  */
 
  /*
   * Author: Ramon Casero <rcasero@gmail.com>
   * Copyright © 2011-2013 University of Oxford
-  * Version: 0.5.0
+  * Version: 0.8.2
   *
   * University of Oxford means the Chancellor, Masters and Scholars of
   * the University of Oxford, having an administrative office at
@@ -108,6 +168,7 @@
 #include <cmath>
 #include <limits>
 #include <algorithm>
+#include <vector>
 
 /* ITK headers */
 #include "itkImage.h"
@@ -126,14 +187,116 @@
 #include "GerardusCommon.h"
 #include "MatlabImportFilter.h"
 #include "MatlabExportFilter.h"
+#include "MatlabImageHeader.h"
+#include "KernelTransformEvaluator.h"
+#include "BSplineGridEvaluator.h"
 
 /* Inputs/outputs interfaces */
 enum InputIndexType {IN_TRANSFORM, IN_X, IN_Y, IN_XI, 
 		     IN_ORDER, IN_LEVELS, InputIndexType_MAX}; // IN_ORDER, IN_LEVELS only for B-spline
-enum OutputIndexType {OUT_YI, OutputIndexType_MAX};
+enum KernelInputIndexType {IN_TOL = IN_XI + 1, KernelInputIndexType_MAX}; // kernel transforms
+enum FittedInputIndexType {IN_S, IN_S_XI, IN_S_TOL, FittedInputIndexType_MAX}; // fitted transform
+enum OutputIndexType {OUT_YI, OUT_S, OutputIndexType_MAX};
+
+/* Classes */
+
+// KernelTransformAccess<TransformType>: kernel transform that gives
+// access to the weights and kernel that ITK uses internally, so that
+// the transform can be evaluated by KernelTransformEvaluator
+template <class TTransform>
+class KernelTransformAccess : public TTransform {
+public:
+  typedef KernelTransformAccess Self;
+  typedef TTransform Superclass;
+  typedef itk::SmartPointer<Self> Pointer;
+  typedef itk::SmartPointer<const Self> ConstPointer;
+  itkNewMacro(Self);
+
+  const typename Superclass::DMatrixType &GetDMatrix() const {
+    return this->m_DMatrix;
+  }
+  const typename Superclass::AMatrixType &GetAMatrix() const {
+    return this->m_AMatrix;
+  }
+  const typename Superclass::BMatrixType &GetBVector() const {
+    return this->m_BVector;
+  }
+
+  // kernel matrix G(x)
+  typename Superclass::GMatrixType EvaluateG(const typename Superclass::InputVectorType &x) const {
+#if ITK_VERSION_MAJOR>=4
+    typename Superclass::GMatrixType g;
+    this->ComputeG(x, g);
+    return g;
+#else
+    return this->ComputeG(x);
+#endif
+  }
+};
 
 /* Functions */
 
+#if ITK_VERSION_MAJOR>=4
+// warpWithBSplineLattice<TScalarType, Dimension>(): warp points XI
+// with the B-spline given by its control point lattice. Points are
+// mapped to the parametric domain [0, 1] x [0, 1] x [0,1] with the
+// origin and scale of the bounding box that was used to fit the
+// B-spline
+//
+// from ITK v4.x, we need to instantiate a function to evaluate
+// points of the B-spline, as the Evaluate() method has been removed
+// from the TransformType
+template <class TScalarType, unsigned int Dimension>
+void warpWithBSplineLattice(const itk::Image<itk::Vector<TScalarType, Dimension>, 
+			    Dimension> *lattice,
+			    unsigned int splineOrder,
+			    const TScalarType *orig, TScalarType lenmax,
+			    mwSize Mxi, const TScalarType *xi, TScalarType *yi) {
+
+  typedef itk::Vector<TScalarType, Dimension> DataType;
+  typedef itk::Image<DataType, Dimension> ImageType;
+
+  // Note: in the following, we have to use TCoordRep=double, because
+  // ITK gives a compilation error of an abstract class not having
+  // been implemented. Otherwise, we would use
+  // TCoordRep=TScalar=float, as in the rest of this program
+  typedef typename 
+    itk::BSplineControlPointImageFunction<ImageType, double> EvalFunctionType;
+  typename EvalFunctionType::Pointer function = EvalFunctionType::New();
+
+  // parametric domain, see runBSplineTransform()
+  typename ImageType::PointType origZero;
+  typename ImageType::SpacingType spacing;
+  typename ImageType::SizeType sz;
+  origZero.Fill(0.0);
+  spacing.Fill(1.0);
+  sz.Fill(2);
+
+  function->SetSplineOrder(splineOrder);
+  function->SetOrigin(origZero);
+  function->SetSpacing(spacing);
+  function->SetSize(sz);
+  function->SetInputImage(lattice);
+
+  // sample the warp field
+  DataType vi; // warp field sample
+  typename EvalFunctionType::PointType xiParam; // sampling coordinates
+  for (mwSize row=0; row < Mxi; ++row) {
+    for (mwSize col=0; col < (mwSize)Dimension; ++col) {
+      xiParam[CAST2MWSIZE(col)] = (xi[Mxi * col + row] - orig[col]) / lenmax;
+      if (xiParam[CAST2MWSIZE(col)] < 0.0 || xiParam[CAST2MWSIZE(col)] > 1.0) {
+	mexErrMsgTxt("XI outside of the domain of the B-spline. Include these points in XI when the transform is fitted");
+      }
+    }
+    vi = function->Evaluate(xiParam);
+    for (mwSize col=0; col < (mwSize)Dimension; ++col) {
+      yi[Mxi * col + row] = xi[Mxi * col + row] + vi[CAST2MWSIZE(col)] * lenmax;
+    }
+  }
+
+}
+#endif
+
 // runBSplineTransform<TScalarType, Dimension>()
 template <class TScalarType, unsigned int Dimension>
 void runBSplineTransform(MatlabImportFilter::Pointer matlabImport,
@@ -150,6 +313,7 @@ void runBSplineTransform(MatlabImportFilter::Pointer matlabImport,
   // register the output for this function at the export filter
   typedef MatlabExportFilter::MatlabOutputPointer MatlabOutputPointer;
   MatlabOutputPointer outYI = matlabExport->RegisterOutput(OUT_YI, "YI");
+  MatlabOutputPointer outS  = matlabExport->RegisterOutput(OUT_S, "S");
 
   // spline order (input argument): default or user-provided
   unsigned int splineOrder = matlabImport->ReadScalarFromMatlab<unsigned int>(inORDER, 3);
@@ -174,7 +338,7 @@ void runBSplineTransform(MatlabImportFilter::Pointer matlabImport,
   if (y == NULL) {
     mexErrMsgTxt("Cannot get a pointer to input Y");
   }
-  if (xi == NULL) {
+  if (xi == NULL && Mxi > 0) {
     mexErrMsgTxt("Cannot get a pointer to input XI");
   }
 
@@ -282,6 +446,41 @@ void runBSplineTransform(MatlabImportFilter::Pointer matlabImport,
   // run transform
   transform->Update();
 
+  // origin of the bounding box as a plain vector
+  std::vector<TScalarType> origVec(Dimension);
+  for (mwSize col=0; col < (mwSize)Dimension; ++col) {
+    origVec[col] = orig[CAST2MWSIZE(col)];
+  }
+
+  // fitted transform, so that it can be applied to other points
+  // without fitting it again
+  if (outS->isRequested) {
+    const ImageType *lattice = transform->GetPhiLattice();
+    std::vector<mwSize> latticeSize(1, Dimension);
+    for (unsigned int i = 0; i < Dimension; ++i) {
+      latticeSize.push_back(lattice->GetLargestPossibleRegion().GetSize()[i]);
+    }
+    mwSize nLattice = lattice->GetLargestPossibleRegion().GetNumberOfPixels();
+
+    *outS->ppm = mxCreateStructMatrix(1, 1, 0, NULL);
+    matlabExport->CopyStringToStructFieldInMatlab(outS, "type", "bspline");
+    *matlabExport->AllocateMatrixInStructFieldInMatlab<TScalarType>(outS, "order", 1, 1)
+      = splineOrder;
+    TScalarType *origS = matlabExport->
+      AllocateMatrixInStructFieldInMatlab<TScalarType>(outS, "origin", 1, Dimension);
+    std::copy(origVec.begin(), origVec.end(), origS);
+    *matlabExport->AllocateMatrixInStructFieldInMatlab<TScalarType>(outS, "scale", 1, 1)
+      = lenmax;
+    TScalarType *latticeS = matlabExport->
+      AllocateNDArrayInStructFieldInMatlab<TScalarType>(outS, "lattice", latticeSize);
+    const DataType *latticeBuffer = lattice->GetBufferPointer();
+    for (mwIndex i = 0; i < nLattice; ++i) {
+      for (mwSize col=0; col < (mwSize)Dimension; ++col) {
+	latticeS[i * Dimension + col] = latticeBuffer[i][CAST2MWSIZE(col)];
+      }
+    }
+  }
+
   // create output vector and pointer to populate it
   mwSize ndimxi = mxGetNumberOfDimensions(inXI->pm); 
   const mwSize *dimsxi = mxGetDimensions(inXI->pm);
@@ -292,25 +491,10 @@ void runBSplineTransform(MatlabImportFilter::Pointer matlabImport,
   TScalarType *yi 
     = matlabExport->AllocateNDArrayInMatlab<TScalarType>(outYI, size);
 
-  // from ITK v4.x, we need to instantiate a function to evaluate
-  // points of the B-spline, as the Evaluate() method has been removed
-  // from the TransformType
 #if ITK_VERSION_MAJOR>=4
-  // Note: in the following, we have to use TCoordRep=double, because
-  // ITK gives a compilation error of an abstract class not having
-  // been implemented. Otherwise, we would use
-  // TCoordRep=TScalar=float, as in the rest of this program
-  typedef typename 
-    itk::BSplineControlPointImageFunction<ImageType, double> EvalFunctionType;
-  typename EvalFunctionType::Pointer function = EvalFunctionType::New();
-
-  function->SetSplineOrder(splineOrder);
-  function->SetOrigin(origZero);
-  function->SetSpacing(spacing);
-  function->SetSize(sz);
-  function->SetInputImage(transform->GetPhiLattice());
-#endif
-
+  warpWithBSplineLattice<TScalarType, Dimension>(transform->GetPhiLattice(), splineOrder,
+						 &origVec[0], lenmax, Mxi, xi, yi);
+#else
   // sample the warp field
   DataType vi; // warp field sample
   typename PointSetType::PointType xiParam; // sampling coordinates
@@ -318,15 +502,12 @@ void runBSplineTransform(MatlabImportFilter::Pointer matlabImport,
     for (mwSize col=0; col < (mwSize)Dimension; ++col) {
       xiParam[CAST2MWSIZE(col)] = (xi[Mxi * col + row] - orig[CAST2MWSIZE(col)]) / lenmax;
     }
-#if ITK_VERSION_MAJOR<4
     transform->Evaluate(xiParam, vi);
-#else
-    vi = function->Evaluate(xiParam);
-#endif
     for (mwSize col=0; col < (mwSize)Dimension; ++col) {
       yi[Mxi * col + row] = xi[Mxi * col + row] + vi[CAST2MWSIZE(col)] * lenmax;
     }
   }
+#endif
 
   // exit function
   return;
@@ -336,11 +517,13 @@ void runBSplineTransform(MatlabImportFilter::Pointer matlabImport,
 // runKernelTransform<TScalarType, Dimension, TransformType>()
 template <class TScalarType, unsigned int Dimension, class TransformType>
 void runKernelTransform(MatlabImportFilter::Pointer matlabImport,
-			MatlabExportFilter::Pointer matlabExport) {
+			MatlabExportFilter::Pointer matlabExport,
+			typename KernelTransformEvaluator<Dimension>::KernelType kernel,
+			const char *transformName) {
 
   // check number of input arguments (the kernel transform syntax
-  // accepts up to 4 arguments only. Thus, we cannot use InputIndexType_MAX)
-  matlabImport->CheckNumberOfArguments(4, 4);
+  // accepts up to 5 arguments only. Thus, we cannot use InputIndexType_MAX)
+  matlabImport->CheckNumberOfArguments(4, KernelInputIndexType_MAX);
 
   // retrieve pointers to the inputs that we are going to need here
   typedef MatlabImportFilter::MatlabInputPointer MatlabInputPointer; 
@@ -348,9 +531,16 @@ void runKernelTransform(MatlabImportFilter::Pointer matlabImport,
   MatlabInputPointer inY         = matlabImport->GetRegisteredInput("Y");
   MatlabInputPointer inXI        = matlabImport->GetRegisteredInput("XI");
 
+  // register the inputs exclusive to kernel transforms
+  MatlabInputPointer inTOL       = matlabImport->RegisterInput(IN_TOL, "TOL");
+
+  // error tolerance (input argument): default or user-provided
+  double tol = matlabImport->ReadScalarFromMatlab<double>(inTOL, 0.0);
+
   // register the outputs for this function at the export filter
   typedef MatlabExportFilter::MatlabOutputPointer MatlabOutputPointer;
   MatlabOutputPointer outYI = matlabExport->RegisterOutput(OUT_YI, "YI");
+  MatlabOutputPointer outS  = matlabExport->RegisterOutput(OUT_S, "S");
 
   // get size of input arguments
   mwSize Mx = mxGetM(inX->pm); // number of source points
@@ -371,7 +561,7 @@ void runKernelTransform(MatlabImportFilter::Pointer matlabImport,
   if (y == NULL) {
     mexErrMsgTxt("Cannot get a pointer to input Y");
   }
-  if (xi == NULL) {
+  if (xi == NULL && Mxi > 0) {
     mexErrMsgTxt("Cannot get a pointer to input XI");
   }
 
@@ -379,38 +569,70 @@ void runKernelTransform(MatlabImportFilter::Pointer matlabImport,
   typedef typename TransformType::PointSetType PointSetType;
   typename PointSetType::Pointer fixedPointSet = PointSetType::New();
   typename PointSetType::Pointer movingPointSet = PointSetType::New();
-  typename PointSetType::Pointer toWarpPointSet = PointSetType::New();
   typedef typename PointSetType::PointsContainer PointsContainer;
   typename PointsContainer::Pointer fixedPointContainer = PointsContainer::New();
   typename PointsContainer::Pointer movingPointContainer = PointsContainer::New();
-  typedef typename PointSetType::PointType PointType;
-  PointType fixedPoint;
-  PointType movingPoint;
-  PointType toWarpPoint;
-  PointType warpedPoint;
 
   // duplicate the input x and y matrices to PointSet format so that
   // we can pass it to the ITK function
-  mwSize pointId=0;
-  for (mwSize row=0; row < Mx; ++row) {
-    for (mwSize col=0; col < (mwSize)Dimension; ++col) {
-      fixedPoint[CAST2MWSIZE(col)] = y[Mx * col + row];
-      movingPoint[CAST2MWSIZE(col)] = x[Mx * col + row];
-    }
-    fixedPointContainer->InsertElement(pointId, fixedPoint);
-    movingPointContainer->InsertElement(pointId, movingPoint);
-    ++pointId;
-  }
+  matlabImport->ReadPointsContainerFromMatlab(inY, fixedPointContainer.GetPointer());
+  matlabImport->ReadPointsContainerFromMatlab(inX, movingPointContainer.GetPointer());
   fixedPointSet->SetPoints(fixedPointContainer);
   movingPointSet->SetPoints(movingPointContainer);
 
   // compute the transform
-  typename TransformType::Pointer transform;
-  transform = TransformType::New();
+  typedef KernelTransformAccess<TransformType> AccessTransformType;
+  typename AccessTransformType::Pointer transform;
+  transform = AccessTransformType::New();
   
   transform->SetSourceLandmarks(movingPointSet);
   transform->SetTargetLandmarks(fixedPointSet);
   transform->ComputeWMatrix();
+
+  // copy the fitted weights to the evaluator. The constant alpha of
+  // the elastic body kernels is G(e_0)(1,1), i.e. radial(1)
+  std::vector<double> landmarks(x, x + Mx * Dimension);
+  std::vector<double> weights(Mx * Dimension);
+  std::vector<double> a(Dimension * Dimension);
+  std::vector<double> b(Dimension);
+  for (mwSize col=0; col < (mwSize)Dimension; ++col) {
+    for (mwSize row=0; row < Mx; ++row) {
+      weights[Mx * col + row] = transform->GetDMatrix()(col, row);
+    }
+    for (mwSize row=0; row < (mwSize)Dimension; ++row) {
+      a[Dimension * col + row] = transform->GetAMatrix()(row, col);
+    }
+    b[col] = transform->GetBVector()[col];
+  }
+  typename TransformType::InputVectorType e0;
+  e0.Fill(0.0);
+  e0[0] = 1.0;
+  double alpha = transform->EvaluateG(e0)(1, 1);
+
+  // fitted transform, so that it can be applied to other points
+  // without fitting it again
+  if (outS->isRequested) {
+    *outS->ppm = mxCreateStructMatrix(1, 1, 0, NULL);
+    matlabExport->CopyStringToStructFieldInMatlab(outS, "type", transformName);
+    TScalarType *landmarksS = matlabExport->
+      AllocateMatrixInStructFieldInMatlab<TScalarType>(outS, "landmarks", Mx, Dimension);
+    TScalarType *weightsS = matlabExport->
+      AllocateMatrixInStructFieldInMatlab<TScalarType>(outS, "weights", Mx, Dimension);
+    TScalarType *affineS = matlabExport->
+      AllocateMatrixInStructFieldInMatlab<TScalarType>(outS, "affine", Dimension, Dimension);
+    TScalarType *translationS = matlabExport->
+      AllocateMatrixInStructFieldInMatlab<TScalarType>(outS, "translation", 1, Dimension);
+    std::copy(landmarks.begin(), landmarks.end(), landmarksS);
+    std::copy(weights.begin(), weights.end(), weightsS);
+    std::copy(a.begin(), a.end(), affineS);
+    std::copy(b.begin(), b.end(), translationS);
+    *matlabExport->AllocateMatrixInStructFieldInMatlab<TScalarType>(outS, "alpha", 1, 1)
+      = alpha;
+  }
+
+  KernelTransformEvaluator<Dimension> evaluator(kernel, alpha);
+  evaluator.SetTolerance(tol);
+  evaluator.SetParameters(Mx, &landmarks[0], &weights[0], &a[0], &b[0]);
   
   // create output vector and pointer to populate it
   ndimxi = mxGetNumberOfDimensions(inXI->pm);
@@ -421,17 +643,11 @@ void runKernelTransform(MatlabImportFilter::Pointer matlabImport,
   }
 
   TScalarType *yi 
-    = matlabExport->AllocateNDArrayInMatlab<TScalarType>(outYI, size);
+    = matlabExport->AllocateUninitialisedNDArrayInMatlab<TScalarType>(outYI, size);
 
   // transform points
-  for (mwSize row=0; row < Mxi; ++row) {
-    for (mwSize col=0; col < (mwSize)Dimension; ++col) {
-      toWarpPoint[CAST2MWSIZE(col)] = xi[Mxi * col + row];
-    }
-    warpedPoint = transform->TransformPoint(toWarpPoint);
-    for (mwSize col=0; col < (mwSize)Dimension; ++col) {
-      yi[Mxi * col + row] = warpedPoint[CAST2MWSIZE(col)];
-    }
+  if (Mxi > 0) {
+    evaluator.TransformPoints(Mxi, xi, yi);
   }
   
   // exit function
@@ -466,23 +682,29 @@ void parseTransformType(MatlabImportFilter::Pointer matlabImport,
     TpsR2LogRTransformType;
   typedef itk::VolumeSplineKernelTransform<TScalarType, Dimension> 
     VolumeTransformType;
+  typedef KernelTransformEvaluator<Dimension> EvaluatorType;
 
   // select transform function
   if (!strcmp(transform, "elastic")) {
     runKernelTransform<TScalarType, Dimension, 
-		       ElasticTransformType>(matlabImport, matlabExport);
+		       ElasticTransformType>(matlabImport, matlabExport,
+					EvaluatorType::ELASTIC, transform);
   } else if (!strcmp(transform, "elasticr")) {
     runKernelTransform<TScalarType, Dimension, 
-		       ElasticReciprocalTransformType>(matlabImport, matlabExport);
+		       ElasticReciprocalTransformType>(matlabImport, matlabExport,
+					EvaluatorType::ELASTIC_RECIPROCAL, transform);
   } else if (!strcmp(transform, "tps")) {
     runKernelTransform<TScalarType, Dimension, 
-		       TpsTransformType>(matlabImport, matlabExport);
+		       TpsTransformType>(matlabImport, matlabExport,
+					EvaluatorType::THIN_PLATE, transform);
   } else if (!strcmp(transform, "tpsr2")) {
     runKernelTransform<TScalarType, Dimension, 
-		       TpsR2LogRTransformType>(matlabImport, matlabExport);
+		       TpsR2LogRTransformType>(matlabImport, matlabExport,
+					EvaluatorType::THIN_PLATE_R2LOGR, transform);
   } else if (!strcmp(transform, "volume")) {
     runKernelTransform<TScalarType, Dimension, 
-		       VolumeTransformType>(matlabImport, matlabExport);
+		       VolumeTransformType>(matlabImport, matlabExport,
+					EvaluatorType::VOLUME, transform);
   } else if (!strcmp(transform, "bspline")) {
     runBSplineTransform<TScalarType, Dimension>(matlabImport, matlabExport);
   } else if (!strcmp(transform, "")) {
@@ -545,7 +767,7 @@ void parseInputTypeToTemplate(MatlabImportFilter::Pointer matlabImport,
   // check that all point coordinates have the same type (it simplifies
   // things with templates)
   if ((pointCoordClassId != mxGetClassID(inY->pm))
-      | (pointCoordClassId != mxGetClassID(inXI->pm))) {
+      | (pointCoordClassId != mxGetClassID(inXI->pm) && !mxIsEmpty(inXI->pm))) {
     mexErrMsgTxt("Input arguments X, Y and XI must have the same type");
   }
   
@@ -570,6 +792,332 @@ void parseInputTypeToTemplate(MatlabImportFilter::Pointer matlabImport,
   
 }
 
+// readStructField(): get a field of the fitted transform struct S,
+// checking that it exists and has the type of the points to be warped
+inline
+const mxArray *readStructField(MatlabImportFilter::MatlabInputPointer inS,
+			       const char *field, mxClassID classId) {
+
+  const mxArray *pm = mxGetField(inS->pm, 0, field);
+  if (pm == NULL) {
+    mexErrMsgTxt(("S: Struct format error: Missing field " + std::string(field)).c_str());
+  }
+  if (mxGetClassID(pm) != classId) {
+    mexErrMsgTxt(("S: Field " + std::string(field) 
+		  + " must have the same type as XI").c_str());
+  }
+  return pm;
+
+}
+
+// runFittedTransform<TScalarType, Dimension>(): warp points with a
+// transform that has been fitted previously, without fitting it
+// again, or compute its displacement field on an image grid
+template <class TScalarType, unsigned int Dimension>
+void runFittedTransform(MatlabImportFilter::Pointer matlabImport,
+			MatlabExportFilter::Pointer matlabExport,
+			const std::string &transformName, mxClassID classId) {
+
+  // retrieve pointers to the inputs that we are going to need here
+  typedef MatlabImportFilter::MatlabInputPointer MatlabInputPointer; 
+  MatlabInputPointer inS         = matlabImport->GetRegisteredInput("S");
+  MatlabInputPointer inXI        = matlabImport->GetRegisteredInput("XI");
+  MatlabInputPointer inTOL       = matlabImport->GetRegisteredInput("TOL");
+
+  // register the output for this function at the export filter
+  typedef MatlabExportFilter::MatlabOutputPointer MatlabOutputPointer;
+  MatlabOutputPointer outYI = matlabExport->RegisterOutput(OUT_YI, "YI");
+
+  // XI is either a matrix of points to be warped, or a SCIMAT image
+  // that defines a grid of voxels
+  const bool isGrid = mxIsStruct(inXI->pm);
+  mwSize Mxi = 0;
+  TScalarType *xi = NULL;
+  std::vector<mwSize> size;
+
+  // grid mode: coordinates of the voxels along each dimension, and
+  // distance between consecutive voxels along each dimension in the
+  // output. Point coordinates are (x, y, z), and note that x changes
+  // with the columns of the image, and y with the rows
+  std::vector<double> gridCoord[Dimension];
+  mwSize gridStride[Dimension];
+  mwSize gridNumel = 1;
+
+  if (isGrid) {
+    MatlabImageHeader header(inXI->pm, "XI");
+    if (header.GetNumberOfDimensions() > Dimension) {
+      mexErrMsgTxt("XI: Image has more dimensions than the transform S");
+    }
+    header.size.resize(Dimension, 1);
+    header.spacing.resize(Dimension, 1.0);
+    header.origin.resize(Dimension, 0.0);
+    
+    std::vector<mwSize> imStride(Dimension);
+    for (unsigned int i = 0; i < Dimension; ++i) {
+      imStride[i] = gridNumel;
+      gridNumel *= header.size[i];
+    }
+    for (unsigned int d = 0; d < Dimension; ++d) {
+      unsigned int axis = (d == 0) ? 1 : ((d == 1) ? 0 : d); // (x, y, z) -> (col, row, slice)
+      gridStride[d] = imStride[axis];
+      gridCoord[d].resize(header.size[axis]);
+      for (mwIndex i = 0; i < header.size[axis]; ++i) {
+	gridCoord[d][i] = header.origin[axis] + i * header.spacing[axis];
+      }
+    }
+
+    // the output is a (R, C[, S], Dimension) displacement field
+    size = header.size;
+    size.push_back(Dimension);
+
+  } else {
+    Mxi = mxGetM(inXI->pm);
+    xi = (TScalarType *)mxGetData(inXI->pm);
+    if (xi == NULL) {
+      mexErrMsgTxt("Cannot get a pointer to input XI");
+    }
+
+    // the output has the size of XI
+    mwSize ndimxi = mxGetNumberOfDimensions(inXI->pm);
+    const mwSize *dimsxi = mxGetDimensions(inXI->pm);
+    for (mwIndex i = 0; i < ndimxi; ++i) {
+      size.push_back(dimsxi[i]);
+    }
+  }
+
+  if (transformName == "bspline") {
+
+    if (inTOL->isProvided) {
+      mexErrMsgTxt("TOL can only be used with kernel transforms");
+    }
+
+    const mxArray *orderMx = mxGetField(inS->pm, 0, "order");
+    if (orderMx == NULL) {
+      mexErrMsgTxt("S: Struct format error: Missing field order");
+    }
+    unsigned int splineOrder = (unsigned int)mxGetScalar(orderMx);
+    const TScalarType *orig = (TScalarType *)mxGetData(readStructField(inS, "origin", classId));
+    TScalarType lenmax = *(TScalarType *)mxGetData(readStructField(inS, "scale", classId));
+    const mxArray *latticeMx = readStructField(inS, "lattice", classId);
+
+    // the lattice is a (Dimension, n1, n2[, n3]) array, with one
+    // control point vector per column
+    const mwSize *dimsLattice = mxGetDimensions(latticeMx);
+    if (mxGetNumberOfDimensions(latticeMx) != Dimension + 1 
+	|| dimsLattice[0] != Dimension) {
+      mexErrMsgTxt("S: Field lattice has wrong dimensions");
+    }
+    const TScalarType *latticeS = (TScalarType *)mxGetData(latticeMx);
+
+    if (isGrid) {
+
+      // the B-spline is separable, so instead of evaluating each
+      // voxel independently, the lattice is contracted one dimension
+      // at a time, with the basis weights of each row, column and
+      // slice computed only once
+      std::vector<double> param[Dimension];
+      for (unsigned int d = 0; d < Dimension; ++d) {
+	param[d].resize(gridCoord[d].size());
+	for (mwIndex i = 0; i < gridCoord[d].size(); ++i) {
+	  param[d][i] = (gridCoord[d][i] - orig[d]) / lenmax;
+	  if (param[d][i] < 0.0 || param[d][i] > 1.0) {
+	    mexErrMsgTxt("XI: Image outside of the domain of the B-spline. Include the image corners in XI when the transform is fitted");
+	  }
+	}
+      }
+
+      BSplineGridEvaluator<Dimension> evaluator(splineOrder, dimsLattice + 1, latticeS);
+      TScalarType *yi 
+	= matlabExport->AllocateUninitialisedNDArrayInMatlab<TScalarType>(outYI, size);
+      evaluator.EvaluateGrid(param, gridStride, gridNumel, lenmax, yi);
+
+    } else {
+
+#if ITK_VERSION_MAJOR>=4
+      // rebuild the control point lattice
+      typedef itk::Vector<TScalarType, Dimension> DataType;
+      typedef itk::Image<DataType, Dimension> ImageType;
+      typename ImageType::Pointer lattice = ImageType::New();
+      typename ImageType::RegionType region;
+      typename ImageType::SizeType sz;
+      typename ImageType::IndexType start;
+      for (unsigned int i = 0; i < Dimension; ++i) {
+	sz[i] = dimsLattice[i + 1];
+      }
+      start.Fill(0);
+      region.SetSize(sz);
+      region.SetIndex(start);
+      lattice->SetRegions(region);
+      lattice->Allocate();
+      DataType *latticeBuffer = lattice->GetBufferPointer();
+      mwSize nLattice = region.GetNumberOfPixels();
+      for (mwIndex i = 0; i < nLattice; ++i) {
+	for (mwSize col=0; col < (mwSize)Dimension; ++col) {
+	  latticeBuffer[i][CAST2MWSIZE(col)] = latticeS[i * Dimension + col];
+	}
+      }
+
+      TScalarType *yi 
+	= matlabExport->AllocateUninitialisedNDArrayInMatlab<TScalarType>(outYI, size);
+      warpWithBSplineLattice<TScalarType, Dimension>(lattice, splineOrder,
+						     orig, lenmax, Mxi, xi, yi);
+#else
+      mexErrMsgTxt("Fitted B-spline transforms require ITK v4 or later");
+#endif
+
+    }
+
+  } else { // kernel transforms
+
+    typedef KernelTransformEvaluator<Dimension> EvaluatorType;
+    typename EvaluatorType::KernelType kernel;
+    if (transformName == "elastic") {
+      kernel = EvaluatorType::ELASTIC;
+    } else if (transformName == "elasticr") {
+      kernel = EvaluatorType::ELASTIC_RECIPROCAL;
+    } else if (transformName == "tps") {
+      kernel = EvaluatorType::THIN_PLATE;
+    } else if (transformName == "tpsr2") {
+      kernel = EvaluatorType::THIN_PLATE_R2LOGR;
+    } else if (transformName == "volume") {
+      kernel = EvaluatorType::VOLUME;
+    } else {
+      mexErrMsgTxt("S: Transform not implemented");
+      return;
+    }
+
+    // error tolerance (input argument): default or user-provided
+    double tol = matlabImport->ReadScalarFromMatlab<double>(inTOL, 0.0);
+
+    // parameters of the fitted transform
+    const mxArray *landmarksMx = readStructField(inS, "landmarks", classId);
+    const mxArray *weightsMx = readStructField(inS, "weights", classId);
+    const mxArray *affineMx = readStructField(inS, "affine", classId);
+    const mxArray *translationMx = readStructField(inS, "translation", classId);
+    const mxArray *alphaMx = readStructField(inS, "alpha", classId);
+    mwSize Mx = mxGetM(landmarksMx);
+    if (mxGetN(landmarksMx) != Dimension
+	|| mxGetM(weightsMx) != Mx || mxGetN(weightsMx) != Dimension
+	|| mxGetM(affineMx) != Dimension || mxGetN(affineMx) != Dimension
+	|| mxGetNumberOfElements(translationMx) != Dimension
+	|| mxGetNumberOfElements(alphaMx) != 1) {
+      mexErrMsgTxt("S: Fields landmarks, weights, affine, translation or alpha have wrong size");
+    }
+    if (Mx == 0) {
+      mexErrMsgTxt("S: Transform has no landmarks");
+    }
+
+    const TScalarType *landmarksS = (TScalarType *)mxGetData(landmarksMx);
+    const TScalarType *weightsS = (TScalarType *)mxGetData(weightsMx);
+    const TScalarType *affineS = (TScalarType *)mxGetData(affineMx);
+    const TScalarType *translationS = (TScalarType *)mxGetData(translationMx);
+    double alpha = *(TScalarType *)mxGetData(alphaMx);
+
+    KernelTransformEvaluator<Dimension> evaluator(kernel, alpha);
+    evaluator.SetTolerance(tol);
+    evaluator.SetParameters(Mx, landmarksS, weightsS, affineS, translationS);
+
+    TScalarType *yi 
+      = matlabExport->AllocateUninitialisedNDArrayInMatlab<TScalarType>(outYI, size);
+
+    if (isGrid) {
+
+      // kernel transforms are not separable, so we warp the coordinates
+      // of every voxel, and subtract them to get the displacement
+      std::vector<TScalarType> xiGrid(gridNumel * Dimension);
+      for (unsigned int d = 0; d < Dimension; ++d) {
+	const mwSize ngrid = gridCoord[d].size();
+	for (mwIndex i = 0; i < gridNumel; ++i) {
+	  xiGrid[d * gridNumel + i] = gridCoord[d][(i / gridStride[d]) % ngrid];
+	}
+      }
+      evaluator.TransformPoints(gridNumel, &xiGrid[0], yi);
+      for (mwIndex i = 0; i < gridNumel * Dimension; ++i) {
+	yi[i] -= xiGrid[i];
+      }
+
+    } else {
+      evaluator.TransformPoints(Mxi, xi, yi);
+    }
+
+  }
+
+  // exit function
+  return;
+
+}
+
+// parseFittedTransform(): syntax YI = itk_pstransform(S, XI, TOL)
+void parseFittedTransform(MatlabImportFilter::Pointer matlabImport,
+			  MatlabExportFilter::Pointer matlabExport) {
+
+  // retrieve pointers to the inputs that we are going to need here
+  typedef MatlabImportFilter::MatlabInputPointer MatlabInputPointer; 
+  MatlabInputPointer inS         = matlabImport->GetRegisteredInput("S");
+  MatlabInputPointer inXI        = matlabImport->GetRegisteredInput("XI");
+
+  // type of transform
+  const mxArray *typeMx = mxGetField(inS->pm, 0, "type");
+  if (typeMx == NULL) {
+    mexErrMsgTxt("S: Struct format error: Missing field type");
+  }
+  char *type = mxArrayToString(typeMx);
+  if (type == NULL) {
+    mexErrMsgTxt("S: Cannot read type string");
+  }
+  std::string transformName(type);
+  mxFree(type);
+
+  // dimension and type of the points to warp. If XI is an image
+  // grid, they are given by the fitted transform
+  mwSize dimxi;
+  mxClassID pointCoordClassId;
+  if (mxIsStruct(inXI->pm)) {
+    const mxArray *pm = mxGetField(inS->pm, 0, 
+				   (transformName == "bspline") ? "lattice" : "landmarks");
+    if (pm == NULL) {
+      mexErrMsgTxt("S: Struct format error: Missing field lattice or landmarks");
+    }
+    dimxi = (transformName == "bspline") ? mxGetDimensions(pm)[0] : mxGetN(pm);
+    pointCoordClassId = mxGetClassID(pm);
+  } else {
+    dimxi = mxGetN(inXI->pm);
+    pointCoordClassId = mxGetClassID(inXI->pm);
+  }
+
+#define RUNFITTEDTRANSFORM(T, D)					\
+  runFittedTransform<T, D>(matlabImport, matlabExport, transformName, pointCoordClassId)
+
+  if (dimxi != 2 && dimxi != 3) {
+    mexErrMsgTxt("Input points can only have dimensions 2 or 3");
+  }
+  switch(pointCoordClassId) {
+  case mxDOUBLE_CLASS:
+    if (dimxi == 2) {
+      RUNFITTEDTRANSFORM(double, 2);
+    } else {
+      RUNFITTEDTRANSFORM(double, 3);
+    }
+    break;
+  case mxSINGLE_CLASS:
+    if (dimxi == 2) {
+      RUNFITTEDTRANSFORM(float, 2);
+    } else {
+      RUNFITTEDTRANSFORM(float, 3);
+    }
+    break;
+  default:
+    mexErrMsgTxt("Point coordinates can only be of type single or double");
+    break;
+  }
+
+#undef RUNFITTEDTRANSFORM
+
+  // exit function
+  return;
+
+}
+
 /*
  * mexFunction(): entry point for the mex function
  */
@@ -580,8 +1128,36 @@ void mexFunction(int nlhs, mxArray *plhs[],
   MatlabImportFilter::Pointer matlabImport = MatlabImportFilter::New();
   matlabImport->ConnectToMatlabFunctionInput(nrhs, prhs);
 
-  // register all possible inputs for this function at the import filter
+  // interface to deal with output arguments from Matlab
+  MatlabExportFilter::Pointer matlabExport = MatlabExportFilter::New();
+  matlabExport->ConnectToMatlabFunctionOutput(nlhs, plhs);
+    
+  // register the outputs for this function at the export filter
+  typedef MatlabExportFilter::MatlabOutputPointer MatlabOutputPointer;
+  MatlabOutputPointer outYI = matlabExport->RegisterOutput(OUT_YI, "YI");
+
+  // syntax YI = itk_pstransform(S, XI, TOL), with a transform that
+  // has already been fitted
   typedef MatlabImportFilter::MatlabInputPointer MatlabInputPointer;
+  if (nrhs > 0 && mxIsStruct(prhs[0])) {
+    MatlabInputPointer inS         = matlabImport->RegisterInput(IN_S, "S");
+    MatlabInputPointer inXI        = matlabImport->RegisterInput(IN_S_XI, "XI");
+    MatlabInputPointer inTOL       = matlabImport->RegisterInput(IN_S_TOL, "TOL");
+
+    matlabImport->CheckNumberOfArguments(2, FittedInputIndexType_MAX);
+    matlabExport->CheckNumberOfArguments(0, 1);
+
+    // if there are no points to warp, return empty array
+    if (mxIsEmpty(inXI->pm) && !mxIsStruct(inXI->pm)) {
+      matlabExport->CopyEmptyArrayToMatlab(outYI);
+      return;
+    }
+
+    parseFittedTransform(matlabImport, matlabExport);
+    return;
+  }
+
+  // register all possible inputs for this function at the import filter
   MatlabInputPointer inTRANSFORM = matlabImport->RegisterInput(IN_TRANSFORM, "TRANSFORM");
   MatlabInputPointer inX         = matlabImport->RegisterInput(IN_X, "X");
   MatlabInputPointer inY         = matlabImport->RegisterInput(IN_Y, "Y");
@@ -589,20 +1165,16 @@ void mexFunction(int nlhs, mxArray *plhs[],
   MatlabInputPointer inORDER     = matlabImport->RegisterInput(IN_ORDER, "ORDER");
   MatlabInputPointer inLEVELS    = matlabImport->RegisterInput(IN_LEVELS, "LEVELS");
 
-  // interface to deal with output arguments from Matlab
-  MatlabExportFilter::Pointer matlabExport = MatlabExportFilter::New();
-  matlabExport->ConnectToMatlabFunctionOutput(nlhs, plhs);
-    
-  // register the outputs for this function at the export filter
-  typedef MatlabExportFilter::MatlabOutputPointer MatlabOutputPointer;
-  MatlabOutputPointer outYI = matlabExport->RegisterOutput(OUT_YI, "YI");
+  // the fitted transform can only be returned with this syntax
+  MatlabOutputPointer outS = matlabExport->RegisterOutput(OUT_S, "S");
 
   // check number of input and output arguments
   matlabImport->CheckNumberOfArguments(4, InputIndexType_MAX);
   matlabExport->CheckNumberOfArguments(0, OutputIndexType_MAX);
     
-  // if there are no points to warp, return empty array
-  if (mxIsEmpty(inXI->pm)) {
+  // if there are no points to warp and the fitted transform is not
+  // requested, return empty array
+  if (mxIsEmpty(inXI->pm) && !outS->isRequested) {
     matlabExport->CopyEmptyArrayToMatlab(outYI);
     return;
   }
@@ -623,12 +1195,15 @@ void mexFunction(int nlhs, mxArray *plhs[],
   // if there are no landmarks, we apply no transformation to the
   // points to warp
   if (mxIsEmpty(inX->pm)) {
+    if (outS->isRequested) {
+      mexErrMsgTxt("Transform S cannot be fitted without landmarks");
+    }
     *outYI->ppm = mxDuplicateArray(inXI->pm);
     return;
   }
 
   // if there are landmarks and points to warp, all must have the same dimension
-  if (Dimension != dimy || Dimension != dimxi) {
+  if (Dimension != dimy || (Dimension != dimxi && !mxIsEmpty(inXI->pm))) {
     mexErrMsgTxt("X, Y and XI must all have the same dimension (i.e. number of columns).");
   }
 
@@ -2,8 +2,8 @@
  * ITK_TRI_RASTERIZATION  Rasterization of triangular mesh to binary
  * segmentation
  *
- * This function provides a Matlab interface to
- * itk::TriangleMeshToBinaryImageFilter.
+ * This function rasterizes a closed triangular mesh, i.e. it
+ * computes which voxels of an image grid are inside the mesh.
  *
  * BW = itk_tri_rasterization(TRI, X, RES, SIZE, ORIGIN)
  *
@@ -25,37 +25,49 @@
  *   bottom-left image voxel, in (x, y, z) format.
  *
  *   BW is the output uint8 binary segmentation. Voxels inside the mesh will
- *   be set to 1, and voxels outside to 0. Note that voxels with their
- *   centre exactly on the mesh offer different results depending on whether
- *   they are at the left, right, top or bottom of the mesh. This is a
- *   limitation in itk::TriangleMeshToBinaryImageFilter. See
- *   test_itk_tri_rasterization.m in Gerardus for an example.
- */
-
-/*
- * Important programming note:
+ *   be set to 1, and voxels outside to 0. A voxel is inside if its
+ *   centre is inside the mesh. Voxels with their centre exactly on the
+ *   mesh are resolved consistently: the voxel is inside if the mesh is
+ *   on its side of increasing column or, if that is a tie, of
+ *   increasing row, and then slice. Voxels on the same face of a
+ *   closed mesh are all treated the same way, and the result does not
+ *   depend on the triangulation of the surface.
+ *
+ *   The mesh is rasterized natively with scanlines along the image
+ *   rows. Triangles are binned by slice, and slices are processed in
+ *   parallel. Before v0.2.0, this function used
+ *   itk::TriangleMeshToBinaryImageFilter, which is single-threaded
+ *   and gives results that depend on the side of the mesh for voxels
+ *   with their centre on the surface.
+ *
+ * IM = itk_tri_rasterization(MESHES, RES, SIZE, ORIGIN, LABELS, PRIORITY)
  *
- * Matlab saves images first by row and then by column. ITK expects
- * the opposite, but this generally doesn't matter, because what
- * happens is that ITK reads the image with rows and columns transpose
- * with respect to Matlab, processes it, and transposes back the
- * result.
+ *   MESHES is a cell array with one mesh per row, {TRI1, X1; TRI2, X2;
+ *   ...}. All meshes are rasterized in a single pass onto one label
+ *   image IM. Empty meshes are allowed, and leave no voxels.
  *
- * When apart from an image we also have to provide a parameter as a
- * (row, colum, slice) vector, there's no problem either.
+ *   LABELS is a vector with the label of each mesh, given as positive
+ *   integers. By default, LABELS=1:N, where N is the number of meshes.
  *
- * However, when the parameter we provide is in (x, y, z) format,
- * after reading it into a vector of vectors in C++, we need to swap
- * (x, y, z) to (y, x, z), so account for that transposition we
- * mentioned above. In Gerardus, we do that with
- * SwapXYInVectorOfVectors() and SwapXYInVector() from the
- * MatlabImportFilter.
+ *   PRIORITY is a string with the rule for voxels inside more than one
+ *   mesh. By default, PRIORITY='last'.
+ *
+ *     'last':  the label of the last mesh in MESHES
+ *     'first': the label of the first mesh in MESHES
+ *     'max':   the largest label
+ *     'min':   the smallest label
+ *
+ *   IM is the output label image, with 0 for voxels outside all
+ *   meshes. IM is of class uint8, uint16 or uint32, the smallest class
+ *   that can hold max(LABELS). The result is the same as rasterizing
+ *   each mesh separately and merging the binary images with PRIORITY,
+ *   but without the memory and time of one image per mesh.
  */
 
  /*
   * Author: Ramon Casero <rcasero@gmail.com>
   * Copyright © 2013 University of Oxford
-  * Version: 0.1.2
+  * Version: 0.3.1
   *
   * University of Oxford means the Chancellor, Masters and Scholars of
   * the University of Oxford, having an administrative office at
@@ -82,37 +94,172 @@
   * <http://www.gnu.org/licenses/>.
   */
 
-//#define DEBUG
-
 /* mex headers */
 #include <mex.h>
 
 /* C++ headers */
-#include <iostream>
+#include <cmath>
+#include <string>
+#include <vector>
+
+/* Boost headers */
+#include <boost/lexical_cast.hpp> // doesn't need linking
 
 /* Gerardus headers */
 #include "MatlabImportFilter.h"
 #include "MatlabExportFilter.h"
-
-/* ITK headers */
-#include <itkImage.h>
-#include <itkMesh.h>
-#include <itkTriangleMeshToBinaryImageFilter.h>
-#include <itkTriangleCell.h>
+#include "TriangleMeshRasterizer.h"
 
 // type definitions
 static const unsigned int                       Dimension = 3;
 typedef uint8_T                                 PixelType;
-typedef float                                   MeshDataType;
-typedef itk::PointSet<MeshDataType, Dimension>  PointSetType;
-typedef PointSetType::CoordRepType              CoordType;
-typedef itk::Mesh<MeshDataType, Dimension>      MeshType;
-typedef itk::Image<PixelType, Dimension>        ImageType;
-typedef PointSetType::PointType                 PointType;
-typedef MeshType::CellType                      CellType;
-typedef itk::TriangleCell<CellType>             TriangleType;
-typedef CellType::CellAutoPointer               CellAutoPointer;
-typedef itk::TriangleMeshToBinaryImageFilter<MeshType, ImageType> MeshFilterType;
+
+// readImageGeometry(): read the voxel size, size and origin of the
+// output image
+void readImageGeometry(MatlabImportFilter::Pointer matlabImport,
+		       MatlabImportFilter::MatlabInputPointer inRES,
+		       MatlabImportFilter::MatlabInputPointer inSIZE,
+		       MatlabImportFilter::MatlabInputPointer inORIGIN,
+		       std::vector<double> &spacing,
+		       std::vector<mwSize> &size,
+		       std::vector<double> &origin) {
+
+  spacing = matlabImport->
+    ReadRowVectorFromMatlab<double, std::vector<double> >(inRES, std::vector<double>(Dimension, 1.0));
+  size = matlabImport->
+    ReadRowVectorFromMatlab<mwSize, std::vector<mwSize> >(inSIZE, std::vector<mwSize>(Dimension, 10));
+  origin = matlabImport->
+    ReadRowVectorFromMatlab<double, std::vector<double> >(inORIGIN, std::vector<double>(Dimension, 0.0));
+  if (spacing.size() != Dimension || size.size() != Dimension || origin.size() != Dimension) {
+    mexErrMsgTxt("RES, SIZE and ORIGIN must be 3-vectors");
+  }
+
+}
+
+// rasterizeLabels<TPixel>(): rasterize all the meshes onto a label
+// image with pixel type TPixel
+template <class TPixel>
+void rasterizeLabels(const TriangleMeshRasterizer &rasterizer,
+		     const std::vector<double> &labels,
+		     TriangleMeshRasterizer::PriorityType priority,
+		     MatlabExportFilter::Pointer matlabExport,
+		     MatlabExportFilter::MatlabOutputPointer outIM,
+		     const std::vector<mwSize> &size) {
+
+  std::vector<TPixel> labelsPixel(labels.begin(), labels.end());
+
+  // the output image is fully written by the rasterizer
+  TPixel *im = matlabExport->AllocateUninitialisedNDArrayInMatlab<TPixel>(outIM, size);
+  rasterizer.Rasterize(im, &labelsPixel[0], priority);
+
+}
+
+// rasterizeMultipleMeshes(): syntax 
+// IM = itk_tri_rasterization(MESHES, RES, SIZE, ORIGIN, LABELS, PRIORITY)
+void rasterizeMultipleMeshes(MatlabImportFilter::Pointer matlabImport,
+			     MatlabExportFilter::Pointer matlabExport) {
+
+  // register the inputs for this function at the import filter
+  enum InputIndexType {IN_MESHES, IN_RES, IN_SIZE, IN_ORIGIN, IN_LABELS, IN_PRIORITY, 
+		       InputIndexType_MAX};
+  matlabImport->CheckNumberOfArguments(1, InputIndexType_MAX);
+  typedef MatlabImportFilter::MatlabInputPointer MatlabInputPointer;
+  MatlabInputPointer inMESHES = matlabImport->RegisterInput(IN_MESHES, "MESHES");
+  MatlabInputPointer inRES = matlabImport->RegisterInput(IN_RES, "RES"); // (r, c, s)
+  MatlabInputPointer inSIZE = matlabImport->RegisterInput(IN_SIZE, "SIZE"); // (r, c, s)
+  MatlabInputPointer inORIGIN = matlabImport->RegisterInput(IN_ORIGIN, "ORIGIN"); // (x, y, z)
+  MatlabInputPointer inLABELS = matlabImport->RegisterInput(IN_LABELS, "LABELS");
+  MatlabInputPointer inPRIORITY = matlabImport->RegisterInput(IN_PRIORITY, "PRIORITY");
+
+  // register the outputs for this function at the export filter
+  enum OutputIndexType {OUT_IM, OutputIndexType_MAX};
+  matlabExport->CheckNumberOfArguments(0, OutputIndexType_MAX);
+  typedef MatlabExportFilter::MatlabOutputPointer MatlabOutputPointer;
+  MatlabOutputPointer outIM = matlabExport->RegisterOutput(OUT_IM, "IM");
+
+  // MESHES is a cell array with one {TRI, X} mesh per row
+  mwSize nmeshes = mxGetM(inMESHES->pm);
+  if (nmeshes > 0 && mxGetN(inMESHES->pm) != 2) {
+    mexErrMsgTxt("MESHES must be a cell array with 2 columns, {TRI, X}");
+  }
+
+  // label of each mesh: default 1, 2, ..., N
+  std::vector<double> labelsDef(nmeshes);
+  for (mwIndex i = 0; i < nmeshes; ++i) {
+    labelsDef[i] = (double)(i + 1);
+  }
+  std::vector<double> labels = matlabImport->
+    ReadArrayAsVectorFromMatlab<double, std::vector<double> >(inLABELS, labelsDef);
+  if (labels.size() != nmeshes) {
+    mexErrMsgTxt("LABELS must have one element per mesh");
+  }
+  double maxLabel = 0.0;
+  for (mwIndex i = 0; i < nmeshes; ++i) {
+    if (!(labels[i] >= 1.0) || labels[i] != std::floor(labels[i])
+	|| labels[i] > 4294967295.0) {
+      mexErrMsgTxt("LABELS must be positive integers that fit in uint32");
+    }
+    maxLabel = std::max(maxLabel, labels[i]);
+  }
+
+  // rule for voxels inside more than one mesh
+  std::string priorityStr = matlabImport->ReadStringFromMatlab(inPRIORITY, "last");
+  TriangleMeshRasterizer::PriorityType priority;
+  if (priorityStr == "last") {
+    priority = TriangleMeshRasterizer::LAST;
+  } else if (priorityStr == "first") {
+    priority = TriangleMeshRasterizer::FIRST;
+  } else if (priorityStr == "max") {
+    priority = TriangleMeshRasterizer::MAX;
+  } else if (priorityStr == "min") {
+    priority = TriangleMeshRasterizer::MIN;
+  } else {
+    mexErrMsgTxt("PRIORITY must be 'last', 'first', 'max' or 'min'");
+    return;
+  }
+
+  // get user input parameters for the output rasterization
+  std::vector<double> spacing, origin;
+  std::vector<mwSize> size;
+  readImageGeometry(matlabImport, inRES, inSIZE, inORIGIN, spacing, size, origin);
+
+  // read all meshes into the rasterizer. Empty meshes are kept, so
+  // that mesh indices match LABELS
+  TriangleMeshRasterizer rasterizer(&size[0], &spacing[0], &origin[0]);
+  for (mwIndex i = 0; i < nmeshes; ++i) {
+    // input names follow the Matlab convention, MESHES{1,1}, MESHES{2,1}...
+    const std::string row = boost::lexical_cast<std::string>(i + 1);
+    MatlabInputPointer inTRI 
+      = matlabImport->RegisterInput(mxGetCell(inMESHES->pm, i), "MESHES{" + row + ",1}");
+    MatlabInputPointer inX 
+      = matlabImport->RegisterInput(mxGetCell(inMESHES->pm, i + nmeshes), "MESHES{" + row + ",2}");
+    if (!inTRI->isProvided || !inX->isProvided) {
+      rasterizer.AddMesh(0, NULL, 0, NULL);
+      continue;
+    }
+    if (mxGetN(inTRI->pm) != 3 || mxGetN(inX->pm) != Dimension) {
+      mexErrMsgTxt("Each mesh in MESHES must have a 3-column TRI and a 3-column X");
+    }
+
+    // read vertices and triangles as flat arrays, stored by columns
+    std::vector<double> x = matlabImport->
+      ReadArrayAsVectorFromMatlab<double, std::vector<double> >(inX, std::vector<double>());
+    std::vector<double> tri = matlabImport->
+      ReadArrayAsVectorFromMatlab<double, std::vector<double> >(inTRI, std::vector<double>());
+    rasterizer.AddMesh(mxGetM(inTRI->pm), &tri[0], mxGetM(inX->pm), &x[0]);
+  }
+
+  // all meshes are rasterized in one pass onto one label image, with
+  // the smallest type that can hold all the labels
+  if (maxLabel <= 255.0) {
+    rasterizeLabels<uint8_T>(rasterizer, labels, priority, matlabExport, outIM, size);
+  } else if (maxLabel <= 65535.0) {
+    rasterizeLabels<uint16_T>(rasterizer, labels, priority, matlabExport, outIM, size);
+  } else {
+    rasterizeLabels<uint32_T>(rasterizer, labels, priority, matlabExport, outIM, size);
+  }
+
+}
 
 /*
  * mexFunction(): entry point for the mex function
@@ -124,6 +271,14 @@ void mexFunction(int nlhs, mxArray *plhs[], int nrhs, const mxArray *prhs[]) {
   MatlabImportFilter::Pointer matlabImport = MatlabImportFilter::New();
   matlabImport->ConnectToMatlabFunctionInput(nrhs, prhs);
 
+  // syntax for several meshes, IM = itk_tri_rasterization(MESHES, ...)
+  if (nrhs > 0 && mxIsCell(prhs[0])) {
+    MatlabExportFilter::Pointer matlabExport = MatlabExportFilter::New();
+    matlabExport->ConnectToMatlabFunctionOutput(nlhs, plhs);
+    rasterizeMultipleMeshes(matlabImport, matlabExport);
+    return;
+  }
+
   // check the number of input arguments
   matlabImport->CheckNumberOfArguments(2, InputIndexType_MAX);
 
@@ -156,126 +311,30 @@ void mexFunction(int nlhs, mxArray *plhs[], int nrhs, const mxArray *prhs[]) {
   // get number of rows in inputs X and TRI
   mwSize nrowsX = mxGetM(inX->pm);
   mwSize nrowsTRI = mxGetM(inTRI->pm);
-
-  // instantiate mesh
-  MeshType::Pointer mesh = MeshType::New();
-
-  // read vertices
-  PointSetType::Pointer xDef = PointSetType::New(); // default: empty point set
-  PointSetType::Pointer x = PointSetType::New();
-  x->GetPoints()->CastToSTLContainer()
-    = matlabImport->ReadVectorOfVectorsFromMatlab<PointType::CoordRepType, PointType>
-    (inX, xDef->GetPoints()->CastToSTLContainer());
-
-#ifdef DEBUG
-  std::cout << "Number of X points read = " << x->GetNumberOfPoints() << std::endl;
-#endif
-
-  // assertion check
-  if (nrowsX != x->GetNumberOfPoints()) {
-    mexErrMsgTxt(("Input " + inX->name 
-		  + ": Number of points read different from number of points provided by user").c_str()); 
+  if (mxGetN(inX->pm) != Dimension) {
+    mexErrMsgTxt(("Input " + inX->name + " must have 3 columns").c_str());
   }
-
-  // swap XY coordinates to make them compliant with ITK convention
-  // (see important programming note at the help header above)
-  matlabImport->SwapXYInVectorOfVectors<PointType::CoordRepType, std::vector<PointType> >
-    (x->GetPoints()->CastToSTLContainer(), x->GetNumberOfPoints());
-
-  // populate mesh with vertices
-  mesh->SetPoints(x->GetPoints());
-
-  // read triangles
-  PointType triDef;
-  triDef.Fill(mxGetNaN());
-  for (mwIndex i = 0; i < nrowsTRI; ++i) {
-
-    PointType triangle = matlabImport->ReadRowVectorFromMatlab<CoordType, PointType>(inTRI, i, triDef);
-
-    // create a triangle cell to read the vertex indices of the current input triangle
-    CellAutoPointer cell;
-    cell.TakeOwnership(new TriangleType);
-
-    // assign to the 0, 1, 2 elements in the triangle cell the vertex
-    // indices that we have just read. Note that we have to substract
-    // 1 to convert Matlab's index convention 1, 2, 3, ... to C++
-    // convention 0, 1, 2, ...
-    cell->SetPointId(0, triangle[0] - 1);
-    cell->SetPointId(1, triangle[1] - 1);
-    cell->SetPointId(2, triangle[2] - 1);
-
-    // insert cell into the mesh
-    mesh->SetCell(i, cell);
+  if (mxGetN(inTRI->pm) != 3) {
+    mexErrMsgTxt(("Input " + inTRI->name + " must have 3 columns").c_str());
   }
 
-#ifdef DEBUG
-  std::cout << "Number of triangles read = " << mesh->GetNumberOfCells() << std::endl;
-#endif
-
-  // assertion check
-  if (nrowsTRI != mesh->GetNumberOfCells()) {
-    mexErrMsgTxt(("Input " + inTRI->name 
-		  + ": Number of triangles read different from number of triangles provided by user").c_str()); 
-  }
+  // read vertices and triangles as flat arrays, stored by columns
+  std::vector<double> x = matlabImport->
+    ReadArrayAsVectorFromMatlab<double, std::vector<double> >(inX, std::vector<double>());
+  std::vector<double> tri = matlabImport->
+    ReadArrayAsVectorFromMatlab<double, std::vector<double> >(inTRI, std::vector<double>());
 
   // get user input parameters for the output rasterization
-  ImageType::SpacingType spacingDef;
-  spacingDef.Fill(1.0);
-  ImageType::SpacingType spacing = matlabImport->
-    ReadRowVectorFromMatlab<ImageType::SpacingValueType, ImageType::SpacingType>(inRES, spacingDef);
-
-  ImageType::SizeType sizeDef;
-  sizeDef.Fill(10);
-  ImageType::SizeType size = matlabImport->
-    ReadRowVectorFromMatlab<ImageType::SizeValueType, ImageType::SizeType>(inSIZE, sizeDef);
-
-  ImageType::PointType originDef;
-  originDef.Fill(0.0);
-  ImageType::PointType origin = matlabImport->
-    ReadRowVectorFromMatlab<ImageType::PointType::ValueType, ImageType::PointType>(inORIGIN, originDef);
-  // (see important programming note at the help header above)
-  matlabImport->SwapXYInVector<ImageType::PointType::ValueType, ImageType::PointType>(origin);
-
-  // instantiate rasterization filter
-  MeshFilterType::Pointer meshFilter = MeshFilterType::New();
-
-  // smallest voxel side length
-  ImageType::SpacingValueType minSpacing = spacing[0];
-  for (mwIndex i = 1; i < Dimension; ++i) {
-    minSpacing = std::min(minSpacing, spacing[i]);
-  }
-
-  // pass input parameters to the filter
-  meshFilter->SetInput(mesh);
-  meshFilter->SetSpacing(spacing);
-  meshFilter->SetSize(size);
-  meshFilter->SetOrigin(origin);
-  meshFilter->SetTolerance(minSpacing / 10.0);
-  meshFilter->SetInsideValue(1);
-  meshFilter->SetOutsideValue(0);
-
-  ImageType::IndexType start;
-  start.Fill(0);
-  meshFilter->SetIndex(start);
-
-  // convert image size from itk::Size format to std::vector<mwSize>
-  // so that we can use it in GraftItkImageOntoMatlab
-  std::vector<mwSize> sizeStdVector(Dimension);
-  for (unsigned int i = 0; i < Dimension; ++i) {
-    sizeStdVector[i] = size[i];
-  }
+  std::vector<double> spacing, origin;
+  std::vector<mwSize> size;
+  readImageGeometry(matlabImport, inRES, inSIZE, inORIGIN, spacing, size, origin);
 
-  // graft ITK filter output onto Matlab output
-  matlabExport->GraftItkImageOntoMatlab<PixelType, Dimension>
-    (outIM, meshFilter->GetOutput(), sizeStdVector);
+  // the output image is fully written by the rasterizer
+  PixelType *im = matlabExport->AllocateUninitialisedNDArrayInMatlab<PixelType>(outIM, size);
 
-#ifdef DEBUG
-  std::cout << "Resolution (spacing) = " << meshFilter->GetSpacing() << std::endl;
-  std::cout << "Size = " << meshFilter->GetSize() << std::endl;
-  std::cout << "Origin = " << meshFilter->GetOrigin() << std::endl;
-#endif
-  
   // run rasterization
-  meshFilter->Update();
+  TriangleMeshRasterizer rasterizer(&size[0], &spacing[0], &origin[0]);
+  rasterizer.SetMesh(nrowsTRI, &tri[0], nrowsX, &x[0]);
+  rasterizer.Rasterize(im, (PixelType)1);
 
 }
@@ -0,0 +1,670 @@
+/*
+ * KernelTransformEvaluator.h
+ *
+ * KernelTransformEvaluator: evaluation of a fitted ITK kernel
+ * transform (itk::ThinPlateSplineKernelTransform,
+ * itk::ElasticBodySplineKernelTransform, etc.) at many points.
+ *
+ * A kernel transform with source landmarks p_j, j=1,...,N maps a point
+ * x to
+ *
+ *   T(x) = x + A x + b + sum_j G(x - p_j) w_j
+ *
+ * where A, b are the affine part, w_j are the deformation weights of
+ * each landmark (the D matrix in ITK), and G(x) is the kernel matrix
+ *
+ *   G(x) = radial(r) I + factor(r) x x^T,   r = |x|
+ *
+ *   'tps':      radial = r,             factor = 0
+ *   'tpsr2':    radial = r^2 log(r),    factor = 0
+ *   'volume':   radial = r^3,           factor = 0
+ *   'elastic':  radial = alpha r^3,     factor = -3 r
+ *   'elasticr': radial = alpha r,       factor = -1/r
+ *
+ * itk::KernelTransform::TransformPoint() evaluates one point at a time
+ * on one core, so warping M points costs M*N kernel evaluations with
+ * virtual calls to ComputeG(). This class keeps landmarks and weights
+ * in contiguous arrays, one per coordinate, and offers two methods:
+ *
+ *   Exact: the sum is computed in blocks of points and blocks of
+ *   landmarks that fit in the cache, with an inner loop without
+ *   function calls or branches that the compiler can vectorise.
+ *   Blocks of points are evaluated in parallel with OpenMP. The result
+ *   is the same as ITK's, up to rounding errors.
+ *
+ *   Treecode: the landmarks are organised in a tree of boxes. The
+ *   contribution of a box of landmarks that is far from the point is
+ *   approximated by interpolating the kernel at Chebyshev points of
+ *   the box (barycentric Lagrange treecode). This works for any of the
+ *   kernels above, and its cost grows as M log N instead of M*N. The
+ *   interpolation degree is chosen from a tolerance for the error
+ *   relative to the size of the deformation.
+ *
+ *   L. Wang, R. Krasny and S. Tlupova, "A kernel-independent treecode
+ *   based on barycentric Lagrange interpolation", Communications in
+ *   Computational Physics, 28(4):1415-1436, 2020.
+ *
+ * The fitted transform can be reused to warp any number of point sets.
+ *
+ * An example of how to use this class in a MEX Matlab function:
+ *
+ *   KernelTransformEvaluator<3> evaluator(KernelTransformEvaluator<3>::THIN_PLATE);
+ *   evaluator.SetParameters(N, landmarks, weights, a, b);
+ *   evaluator.SetTolerance(1e-6);
+ *   evaluator.TransformPoints(M, xi, yi);
+ *
+ */
+
+/*
+ * Author: Ramon Casero <rcasero@gmail.com>
+ * Copyright © 2014 University of Oxford
+ * Version: 0.1.1
+ *
+ * University of Oxford means the Chancellor, Masters and Scholars of
+ * the University of Oxford, having an administrative office at
+ * Wellington Square, Oxford OX1 2JD, UK.
+ *
+ * This file is part of Gerardus.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details. The offer of this
+ * program under the terms of the License is subject to the License
+ * being interpreted in accordance with English Law and subject to any
+ * action against the University of Oxford being under the jurisdiction
+ * of the English Courts.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see
+ * <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef KERNELTRANSFORMEVALUATOR_H
+#define KERNELTRANSFORMEVALUATOR_H
+
+/* mex headers */
+#include <mex.h>
+
+/* C++ headers */
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+/* kernels of the ITK kernel transforms, G(x) = radial(r) I + factor(r) x x^T */
+struct ThinPlateKernel {
+  static const bool isRadial = true;
+  static double Radial(double r, double) { return r; }
+  static double Factor(double) { return 0.0; }
+};
+
+struct ThinPlateR2LogRKernel {
+  static const bool isRadial = true;
+  static double Radial(double r, double) { return (r > 1e-8) ? r * r * std::log(r) : 0.0; }
+  static double Factor(double) { return 0.0; }
+};
+
+struct VolumeKernel {
+  static const bool isRadial = true;
+  static double Radial(double r, double) { return r * r * r; }
+  static double Factor(double) { return 0.0; }
+};
+
+struct ElasticBodyKernel {
+  static const bool isRadial = false;
+  static double Radial(double r, double alpha) { return alpha * r * r * r; }
+  static double Factor(double r) { return -3.0 * r; }
+};
+
+struct ElasticBodyReciprocalKernel {
+  static const bool isRadial = false;
+  static double Radial(double r, double alpha) { return alpha * r; }
+  static double Factor(double r) { return (r > 1e-8) ? (-1.0 / r) : 0.0; }
+};
+
+template <unsigned int VDimension>
+class KernelTransformEvaluator {
+
+ public:
+
+  enum KernelType {ELASTIC, ELASTIC_RECIPROCAL, THIN_PLATE, THIN_PLATE_R2LOGR, VOLUME};
+
+  // kernel: type of kernel
+  // alpha:  constant of the elastic body kernels (ignored by the others)
+  KernelTransformEvaluator(KernelType _kernel, double _alpha = 0.0)
+    : kernel(_kernel), alpha(_alpha), n(0), tolerance(0.0), degree(0) {}
+
+  // n:         number of landmarks
+  // landmarks: (n, VDimension)-matrix with the source landmarks
+  // weights:   (n, VDimension)-matrix with the deformation weight of
+  //            each landmark (the transpose of ITK's D matrix)
+  // a:         (VDimension, VDimension)-matrix with the affine part
+  // b:         VDimension-vector with the translation part
+  //
+  // Matrices are stored by columns, as in Matlab
+  template <class TScalar>
+  void SetParameters(mwSize _n, const TScalar *landmarks, const TScalar *weights,
+		     const TScalar *a, const TScalar *b);
+
+  // tol = 0:  exact evaluation
+  // tol > 0:  treecode approximation, with an error below tol
+  //           relative to the size of the deformation. Tolerances
+  //           below 2e-8 are computed exactly
+  void SetTolerance(double tol);
+
+  double GetTolerance() const {
+    return this->tolerance;
+  }
+
+  // xi: (m, VDimension)-matrix with the points to warp
+  // yi: (m, VDimension)-matrix with the warped points
+  template <class TScalar>
+  void TransformPoints(mwSize m, const TScalar *xi, TScalar *yi) const;
+
+ private:
+
+  // box of landmarks in the treecode
+  struct Node {
+    mwIndex begin, end;             // landmarks in the box (permuted order)
+    double lo[VDimension];          // bounding box
+    double hi[VDimension];
+    double centre[VDimension];
+    double radius;                  // half diagonal of the box
+    int child[2];                   // -1 if leaf
+    mwIndex proxyBegin, proxyEnd;   // interpolation points, if any
+  };
+
+  KernelType kernel;
+  double alpha;
+  mwSize n;
+  double tolerance;
+
+  // landmarks, weights and interpolation points and weights, one
+  // array per coordinate. In the treecode, landmarks are sorted so that
+  // the landmarks in a box are contiguous
+  std::vector<double> landmark[VDimension];
+  std::vector<double> weight[VDimension];
+  std::vector<double> proxy[VDimension];
+  std::vector<double> proxyWeight[VDimension];
+
+  // affine part
+  double a[VDimension][VDimension];
+  double b[VDimension];
+
+  // treecode
+  std::vector<Node> tree;
+  unsigned int degree;              // interpolation degree, 0 if exact
+  double theta;                     // box radius / distance to the point
+
+  // sizes of the blocks for the exact evaluation
+  static const mwSize pointBlockSize = 64;
+  static const mwSize landmarkBlockSize = 1024;
+
+  // u += sum_{j < count} G(x - p_j) w_j
+  template <class TKernel>
+  static void AddSum(const double *x, mwSize count,
+		     const double *const *p, const double *const *w,
+		     double alpha, double *u);
+  void AddSum(const double *x, mwSize count,
+	      const double *const *p, const double *const *w, double *u) const;
+
+  // compare landmarks by one of their coordinates
+  struct CoordinateLess {
+    const std::vector<double> &coord;
+    CoordinateLess(const std::vector<double> &_coord) : coord(_coord) {}
+    bool operator()(mwIndex i, mwIndex j) const {
+      return this->coord[i] < this->coord[j];
+    }
+  };
+
+  // treecode
+  void BuildTree();
+  int BuildNode(std::vector<mwIndex> &perm, mwIndex begin, mwIndex end,
+		mwSize leafSize);
+  void ComputeProxyWeights(Node &node);
+  void AddTreecodeSum(const double *x, std::vector<int> &stack, double *u) const;
+
+};
+
+template <unsigned int VDimension>
+const mwSize KernelTransformEvaluator<VDimension>::pointBlockSize;
+template <unsigned int VDimension>
+const mwSize KernelTransformEvaluator<VDimension>::landmarkBlockSize;
+
+template <unsigned int VDimension>
+template <class TScalar>
+void KernelTransformEvaluator<VDimension>::SetParameters(mwSize _n,
+							 const TScalar *landmarks,
+							 const TScalar *weights,
+							 const TScalar *_a,
+							 const TScalar *_b) {
+
+  this->n = _n;
+  for (unsigned int d = 0; d < VDimension; ++d) {
+    this->landmark[d].assign(landmarks + d * this->n, landmarks + (d + 1) * this->n);
+    this->weight[d].assign(weights + d * this->n, weights + (d + 1) * this->n);
+    this->b[d] = (double)_b[d];
+    for (unsigned int e = 0; e < VDimension; ++e) {
+      this->a[d][e] = (double)_a[d + e * VDimension];
+    }
+  }
+
+  if (this->degree > 0) {
+    this->BuildTree();
+  }
+
+}
+
+template <unsigned int VDimension>
+void KernelTransformEvaluator<VDimension>::SetTolerance(double tol) {
+
+  if (tol < 0.0 || mxIsNaN(tol)) {
+    mexErrMsgTxt("KernelTransformEvaluator: Tolerance must be >= 0");
+  }
+  this->tolerance = tol;
+  this->degree = 0;
+  this->tree.clear();
+  if (this->tolerance == 0.0) {
+    return;
+  }
+
+  // boxes are approximated if they are at least 1/theta times their
+  // radius away from the point. With theta = 0.5, the error relative to
+  // the largest deformation is below 1.5 * 0.2^degree for all kernels in
+  // 2D and 3D. This was measured with random landmarks and weights
+  // orthogonal to the affine part, as in a fitted transform, which
+  // give larger relative errors than unconstrained weights. The degree
+  // is chosen with an extra safety factor of 3, i.e. 0.2^degree <=
+  // tol/5
+  this->theta = 0.5;
+  const double degree = std::ceil(std::log(0.2 * tol) / std::log(0.2));
+
+  // tolerances that need a degree above 12 are computed exactly, as
+  // the interpolation would not be faster
+  if (degree > 12.0) {
+    return;
+  }
+  this->degree = (unsigned int)std::max(2.0, degree);
+
+  if (this->n > 0) {
+    this->BuildTree();
+  }
+
+}
+
+template <unsigned int VDimension>
+template <class TKernel>
+void KernelTransformEvaluator<VDimension>::AddSum(const double *x, mwSize count,
+						  const double *const *p,
+						  const double *const *w,
+						  double alpha, double *u) {
+
+  double acc[VDimension];
+  for (unsigned int d = 0; d < VDimension; ++d) {
+    acc[d] = 0.0;
+  }
+
+  for (mwIndex j = 0; j < count; ++j) {
+    double dx[VDimension];
+    double r2 = 0.0;
+    for (unsigned int d = 0; d < VDimension; ++d) {
+      dx[d] = x[d] - p[d][j];
+      r2 += dx[d] * dx[d];
+    }
+    const double r = std::sqrt(r2);
+    const double radial = TKernel::Radial(r, alpha);
+    if (TKernel::isRadial) {
+      for (unsigned int d = 0; d < VDimension; ++d) {
+	acc[d] += radial * w[d][j];
+      }
+    } else {
+      double s = 0.0;
+      for (unsigned int d = 0; d < VDimension; ++d) {
+	s += dx[d] * w[d][j];
+      }
+      s *= TKernel::Factor(r);
+      for (unsigned int d = 0; d < VDimension; ++d) {
+	acc[d] += radial * w[d][j] + s * dx[d];
+      }
+    }
+  }
+
+  for (unsigned int d = 0; d < VDimension; ++d) {
+    u[d] += acc[d];
+  }
+
+}
+
+template <unsigned int VDimension>
+void KernelTransformEvaluator<VDimension>::AddSum(const double *x, mwSize count,
+						  const double *const *p,
+						  const double *const *w,
+						  double *u) const {
+  switch (this->kernel) {
+  case ELASTIC:
+    AddSum<ElasticBodyKernel>(x, count, p, w, this->alpha, u);
+    break;
+  case ELASTIC_RECIPROCAL:
+    AddSum<ElasticBodyReciprocalKernel>(x, count, p, w, this->alpha, u);
+    break;
+  case THIN_PLATE:
+    AddSum<ThinPlateKernel>(x, count, p, w, this->alpha, u);
+    break;
+  case THIN_PLATE_R2LOGR:
+    AddSum<ThinPlateR2LogRKernel>(x, count, p, w, this->alpha, u);
+    break;
+  case VOLUME:
+    AddSum<VolumeKernel>(x, count, p, w, this->alpha, u);
+    break;
+  default:
+    mexErrMsgTxt("KernelTransformEvaluator: Invalid kernel type");
+  }
+}
+
+template <unsigned int VDimension>
+void KernelTransformEvaluator<VDimension>::BuildTree() {
+
+  this->tree.clear();
+  if (this->n == 0) {
+    return;
+  }
+
+  // boxes with fewer landmarks than interpolation points are not
+  // worth approximating
+  mwSize numberOfProxies = 1;
+  for (unsigned int d = 0; d < VDimension; ++d) {
+    numberOfProxies *= this->degree + 1;
+  }
+  const mwSize leafSize = std::max((mwSize)64, numberOfProxies);
+
+  std::vector<mwIndex> perm(this->n);
+  for (mwIndex j = 0; j < this->n; ++j) {
+    perm[j] = j;
+  }
+  this->BuildNode(perm, 0, this->n, leafSize);
+
+  // sort landmarks and weights so that each box is contiguous
+  for (unsigned int d = 0; d < VDimension; ++d) {
+    std::vector<double> aux(this->n);
+    for (mwIndex j = 0; j < this->n; ++j) {
+      aux[j] = this->landmark[d][perm[j]];
+    }
+    this->landmark[d].swap(aux);
+    for (mwIndex j = 0; j < this->n; ++j) {
+      aux[j] = this->weight[d][perm[j]];
+    }
+    this->weight[d].swap(aux);
+  }
+
+  // interpolation points of the boxes with more landmarks than
+  // interpolation points
+  mwIndex proxyCount = 0;
+  for (size_t k = 0; k < this->tree.size(); ++k) {
+    Node &node = this->tree[k];
+    node.proxyBegin = node.proxyEnd = proxyCount;
+    if (node.end - node.begin > numberOfProxies) {
+      proxyCount += numberOfProxies;
+      node.proxyEnd = proxyCount;
+    }
+  }
+  for (unsigned int d = 0; d < VDimension; ++d) {
+    this->proxy[d].resize(proxyCount);
+    this->proxyWeight[d].resize(proxyCount);
+  }
+
+#ifdef _OPENMP
+#pragma omp parallel for schedule(dynamic)
+#endif
+  for (mwSignedIndex k = 0; k < (mwSignedIndex)this->tree.size(); ++k) {
+    if (this->tree[k].proxyEnd > this->tree[k].proxyBegin) {
+      this->ComputeProxyWeights(this->tree[k]);
+    }
+  }
+
+}
+
+template <unsigned int VDimension>
+int KernelTransformEvaluator<VDimension>::BuildNode(std::vector<mwIndex> &perm,
+						    mwIndex begin, mwIndex end,
+						    mwSize leafSize) {
+
+  const int idx = (int)this->tree.size();
+  this->tree.push_back(Node());
+
+  Node node;
+  node.begin = begin;
+  node.end = end;
+  node.child[0] = node.child[1] = -1;
+  node.proxyBegin = node.proxyEnd = 0;
+
+  // bounding box
+  unsigned int longest = 0;
+  node.radius = 0.0;
+  for (unsigned int d = 0; d < VDimension; ++d) {
+    node.lo[d] = node.hi[d] = this->landmark[d][perm[begin]];
+    for (mwIndex j = begin + 1; j < end; ++j) {
+      node.lo[d] = std::min(node.lo[d], this->landmark[d][perm[j]]);
+      node.hi[d] = std::max(node.hi[d], this->landmark[d][perm[j]]);
+    }
+    node.centre[d] = 0.5 * (node.lo[d] + node.hi[d]);
+    node.radius += 0.25 * (node.hi[d] - node.lo[d]) * (node.hi[d] - node.lo[d]);
+    if (node.hi[d] - node.lo[d] > node.hi[longest] - node.lo[longest]) {
+      longest = d;
+    }
+  }
+  node.radius = std::sqrt(node.radius);
+
+  // split the box at the median of its longest side
+  if (end - begin > leafSize && node.radius > 0.0) {
+    const mwIndex mid = begin + (end - begin) / 2;
+    std::nth_element(perm.begin() + begin, perm.begin() + mid, perm.begin() + end,
+		     CoordinateLess(this->landmark[longest]));
+    node.child[0] = this->BuildNode(perm, begin, mid, leafSize);
+    node.child[1] = this->BuildNode(perm, mid, end, leafSize);
+  }
+
+  this->tree[idx] = node;
+  return idx;
+}
+
+template <unsigned int VDimension>
+void KernelTransformEvaluator<VDimension>::ComputeProxyWeights(Node &node) {
+
+  const unsigned int p = this->degree;
+  const double pi = std::acos(-1.0);
+
+  // Chebyshev points of the second kind in each side of the box, and
+  // barycentric weights. Flat sides have a single point
+  std::vector<double> s[VDimension];
+  std::vector<double> bw[VDimension];
+  unsigned int np[VDimension];
+  for (unsigned int d = 0; d < VDimension; ++d) {
+    const double h = 0.5 * (node.hi[d] - node.lo[d]);
+    np[d] = (h > 0.0) ? p + 1 : 1;
+    s[d].resize(np[d]);
+    bw[d].resize(np[d]);
+    for (unsigned int k = 0; k < np[d]; ++k) {
+      s[d][k] = (np[d] == 1) ? node.centre[d]
+	: node.centre[d] + h * std::cos(pi * k / p);
+      bw[d][k] = ((k % 2) ? -1.0 : 1.0) * ((k == 0 || k == p) ? 0.5 : 1.0);
+    }
+  }
+
+  // tensor product of the 1D points. Boxes that are flat in some side
+  // repeat the same point with zero weight
+  const mwIndex nproxy = node.proxyEnd - node.proxyBegin;
+  for (mwIndex k = 0; k < nproxy; ++k) {
+    mwIndex r = k;
+    for (unsigned int d = 0; d < VDimension; ++d) {
+      const unsigned int kd = r % (p + 1);
+      r /= p + 1;
+      this->proxy[d][node.proxyBegin + k] = s[d][std::min(kd, np[d] - 1)];
+      this->proxyWeight[d][node.proxyBegin + k] = 0.0;
+    }
+  }
+
+  // the weight of each interpolation point is the sum of the landmark
+  // weights times the Lagrange polynomial of the point at the landmark
+  std::vector<double> L[VDimension];
+  for (unsigned int d = 0; d < VDimension; ++d) {
+    L[d].resize(p + 1);
+  }
+  for (mwIndex j = node.begin; j < node.end; ++j) {
+    for (unsigned int d = 0; d < VDimension; ++d) {
+      std::fill(L[d].begin(), L[d].end(), 0.0);
+      const double y = this->landmark[d][j];
+      if (np[d] == 1) {
+	L[d][0] = 1.0;
+	continue;
+      }
+      double denom = 0.0;
+      unsigned int exact = p + 1;
+      for (unsigned int k = 0; k <= p; ++k) {
+	const double diff = y - s[d][k];
+	if (diff == 0.0) {
+	  exact = k;
+	  break;
+	}
+	L[d][k] = bw[d][k] / diff;
+	denom += L[d][k];
+      }
+      if (exact <= p) {
+	std::fill(L[d].begin(), L[d].end(), 0.0);
+	L[d][exact] = 1.0;
+      } else {
+	for (unsigned int k = 0; k <= p; ++k) {
+	  L[d][k] /= denom;
+	}
+      }
+    }
+    for (mwIndex k = 0; k < nproxy; ++k) {
+      mwIndex r = k;
+      double l = 1.0;
+      for (unsigned int d = 0; d < VDimension; ++d) {
+	l *= L[d][r % (p + 1)];
+	r /= p + 1;
+      }
+      for (unsigned int d = 0; d < VDimension; ++d) {
+	this->proxyWeight[d][node.proxyBegin + k] += l * this->weight[d][j];
+      }
+    }
+  }
+
+}
+
+template <unsigned int VDimension>
+void KernelTransformEvaluator<VDimension>::AddTreecodeSum(const double *x,
+							  std::vector<int> &stack,
+							  double *u) const {
+
+  const double *p[VDimension];
+  const double *w[VDimension];
+
+  stack.clear();
+  stack.push_back(0);
+  while (!stack.empty()) {
+    const Node &node = this->tree[stack.back()];
+    stack.pop_back();
+
+    // distance from the point to the centre of the box
+    double dist2 = 0.0;
+    for (unsigned int d = 0; d < VDimension; ++d) {
+      dist2 += (x[d] - node.centre[d]) * (x[d] - node.centre[d]);
+    }
+
+    if (node.proxyEnd > node.proxyBegin
+	&& node.radius * node.radius < this->theta * this->theta * dist2) {
+      // far box: interpolation points
+      for (unsigned int d = 0; d < VDimension; ++d) {
+	p[d] = &this->proxy[d][node.proxyBegin];
+	w[d] = &this->proxyWeight[d][node.proxyBegin];
+      }
+      this->AddSum(x, node.proxyEnd - node.proxyBegin, p, w, u);
+    } else if (node.child[0] < 0) {
+      // near leaf: landmarks
+      for (unsigned int d = 0; d < VDimension; ++d) {
+	p[d] = &this->landmark[d][node.begin];
+	w[d] = &this->weight[d][node.begin];
+      }
+      this->AddSum(x, node.end - node.begin, p, w, u);
+    } else {
+      stack.push_back(node.child[0]);
+      stack.push_back(node.child[1]);
+    }
+  }
+
+}
+
+template <unsigned int VDimension>
+template <class TScalar>
+void KernelTransformEvaluator<VDimension>::TransformPoints(mwSize m, const TScalar *xi,
+							   TScalar *yi) const {
+
+  const mwSize nblocks = (m + pointBlockSize - 1) / pointBlockSize;
+
+#ifdef _OPENMP
+#pragma omp parallel
+#endif
+  {
+    std::vector<double> x(pointBlockSize * VDimension);
+    std::vector<double> u(pointBlockSize * VDimension);
+    std::vector<int> stack;
+    const double *p[VDimension];
+    const double *w[VDimension];
+
+#ifdef _OPENMP
+#pragma omp for schedule(dynamic)
+#endif
+    for (mwSignedIndex block = 0; block < (mwSignedIndex)nblocks; ++block) {
+
+      const mwIndex first = block * pointBlockSize;
+      const mwSize count = std::min(pointBlockSize, m - first);
+
+      // points of the block, and their affine transformation
+      for (mwIndex i = 0; i < count; ++i) {
+	for (unsigned int d = 0; d < VDimension; ++d) {
+	  x[i * VDimension + d] = (double)xi[first + i + d * m];
+	}
+	for (unsigned int d = 0; d < VDimension; ++d) {
+	  double &ud = u[i * VDimension + d];
+	  ud = x[i * VDimension + d] + this->b[d];
+	  for (unsigned int e = 0; e < VDimension; ++e) {
+	    ud += this->a[d][e] * x[i * VDimension + e];
+	  }
+	}
+      }
+
+      // deformation
+      if (this->tree.empty()) {
+	for (mwIndex j0 = 0; j0 < this->n; j0 += landmarkBlockSize) {
+	  const mwSize nj = std::min(landmarkBlockSize, this->n - j0);
+	  for (unsigned int d = 0; d < VDimension; ++d) {
+	    p[d] = &this->landmark[d][j0];
+	    w[d] = &this->weight[d][j0];
+	  }
+	  for (mwIndex i = 0; i < count; ++i) {
+	    this->AddSum(&x[i * VDimension], nj, p, w, &u[i * VDimension]);
+	  }
+	}
+      } else {
+	for (mwIndex i = 0; i < count; ++i) {
+	  this->AddTreecodeSum(&x[i * VDimension], stack, &u[i * VDimension]);
+	}
+      }
+
+      for (mwIndex i = 0; i < count; ++i) {
+	for (unsigned int d = 0; d < VDimension; ++d) {
+	  yi[first + i + d * m] = (TScalar)u[i * VDimension + d];
+	}
+      }
+    }
+  }
+
+}
+
+#endif /* KERNELTRANSFORMEVALUATOR_H */
@@ -0,0 +1,115 @@
+/* MexApproximateSignedDistanceMapImageFilter.cpp
+ *
+ * itk_imfilter() wrapper for itk::ApproximateSignedDistanceMapImageFilter.
+ *
+ * See ItkImFilter.cpp or itk_imfilter.m for help.
+ */
+
+ /*
+  * Author: Ramon Casero <rcasero@gmail.com>
+  * Copyright © 2011-2014 University of Oxford
+  * Version: 0.1.0
+  *
+  * University of Oxford means the Chancellor, Masters and Scholars of
+  * the University of Oxford, having an administrative office at
+  * Wellington Square, Oxford OX1 2JD, UK. 
+  *
+  * This file is part of Gerardus.
+  *
+  * This program is free software: you can redistribute it and/or modify
+  * it under the terms of the GNU General Public License as published by
+  * the Free Software Foundation, either version 3 of the License, or
+  * (at your option) any later version.
+  *
+  * This program is distributed in the hope that it will be useful,
+  * but WITHOUT ANY WARRANTY; without even the implied warranty of
+  * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  * GNU General Public License for more details. The offer of this
+  * program under the terms of the License is subject to the License
+  * being interpreted in accordance with English Law and subject to any
+  * action against the University of Oxford being under the jurisdiction
+  * of the English Courts.
+  *
+  * You should have received a copy of the GNU General Public License
+  * along with this program.  If not, see
+  * <http://www.gnu.org/licenses/>.
+  */
+
+#ifndef MEXAPPROXIMATESIGNEDDISTANCEMAPIMAGEFILTER_CPP
+#define MEXAPPROXIMATESIGNEDDISTANCEMAPIMAGEFILTER_CPP
+
+#ifdef _MSC_VER
+#pragma warning ( disable : 4786 )
+#endif
+
+/* mex headers */
+#include <mex.h>
+
+/* ITK headers */
+#include "itkImage.h"
+#include "itkApproximateSignedDistanceMapImageFilter.h"
+
+/* Gerardus headers */
+#include "MexFilterRegistry.h"
+
+// ApproximateSignedDistanceMapImageFilter
+template <class TPixelIn, unsigned int VImageDimension>
+class ApproximateSignedDistanceMapImageFilterWrapper {
+public:
+  
+  ApproximateSignedDistanceMapImageFilterWrapper(MatlabImportFilter::Pointer matlabImport,
+						 MatlabExportFilter::Pointer matlabExport,
+						 MatlabImageHeader &im) {
+    
+    // inputs/outputs interfaces
+    enum InputIndexType {IN_TYPE, IN_A, InputIndexType_MAX};
+    enum OutputIndexType {OUT_B, OutputIndexType_MAX};
+    
+    // check number of input and output arguments
+    matlabImport->CheckNumberOfArguments(2, InputIndexType_MAX);
+    matlabExport->CheckNumberOfArguments(0, OutputIndexType_MAX);
+    
+    // get pointer to image input
+    MatlabInputPointer inA         = matlabImport->GetRegisteredInput("A");
+  
+    // register the outputs for this function at the export filter
+    typedef MatlabExportFilter::MatlabOutputPointer MatlabOutputPointer;
+    MatlabOutputPointer outB = matlabExport->RegisterOutput(OUT_B, "B");
+
+    // instantiate the filter
+    typedef float TPixelOut;
+    typedef typename itk::Image<TPixelIn, VImageDimension> InImageType;
+    typedef typename itk::Image<TPixelOut, VImageDimension> OutImageType;
+    typedef itk::ApproximateSignedDistanceMapImageFilter<InImageType, OutImageType>
+      FilterType;
+    typename FilterType::Pointer filter = FilterType::New();
+
+    // expect segmented object of 1s over background of 0s
+    filter->SetInsideValue(1);
+    filter->SetOutsideValue(0);
+    
+    // connect Matlab inputs to ITK filter
+    filter->SetInput(matlabImport->
+		     GetImagePointerFromMatlab<TPixelIn, VImageDimension>(inA));
+
+    // connect ITK filter outputs to Matlab outputs
+
+    // distance map
+    matlabExport->GraftItkImageOntoMatlab<TPixelOut, VImageDimension>
+      (outB, filter->GetOutputs()[0], im.size);
+
+    // run filter
+    filter->Update();
+
+  }
+};
+
+// add the filter to the registry of itk_imfilter()
+void RegisterApproximateSignedDistanceMapImageFilter(FilterRegistry &registry) {
+
+  registry.AddFilter("appsigndist", "ApproximateSignedDistanceMapImageFilter");
+  AddFilterWrapperAllTypesAndDimensions<ApproximateSignedDistanceMapImageFilterWrapper>(registry, "appsigndist");
+
+}
+
+#endif /* MEXAPPROXIMATESIGNEDDISTANCEMAPIMAGEFILTER_CPP */
@@ -0,0 +1,153 @@
+/* MexBinaryDilateImageFilter.cpp
+ *
+ * itk_imfilter() wrapper for itk::BinaryDilateImageFilter, and the
+ * dilation by thresholding the distance transform in
+ * DistanceMorphology.h for large radii.
+ *
+ * See ItkImFilter.cpp or itk_imfilter.m for help.
+ */
+
+ /*
+  * Author: Ramon Casero <rcasero@gmail.com>
+  * Copyright © 2011-2014 University of Oxford
+  * Version: 0.1.3
+  *
+  * University of Oxford means the Chancellor, Masters and Scholars of
+  * the University of Oxford, having an administrative office at
+  * Wellington Square, Oxford OX1 2JD, UK. 
+  *
+  * This file is part of Gerardus.
+  *
+  * This program is free software: you can redistribute it and/or modify
+  * it under the terms of the GNU General Public License as published by
+  * the Free Software Foundation, either version 3 of the License, or
+  * (at your option) any later version.
+  *
+  * This program is distributed in the hope that it will be useful,
+  * but WITHOUT ANY WARRANTY; without even the implied warranty of
+  * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  * GNU General Public License for more details. The offer of this
+  * program under the terms of the License is subject to the License
+  * being interpreted in accordance with English Law and subject to any
+  * action against the University of Oxford being under the jurisdiction
+  * of the English Courts.
+  *
+  * You should have received a copy of the GNU General Public License
+  * along with this program.  If not, see
+  * <http://www.gnu.org/licenses/>.
+  */
+
+#ifndef MEXBINARYDILATEIMAGEFILTER_CPP
+#define MEXBINARYDILATEIMAGEFILTER_CPP
+
+#ifdef _MSC_VER
+#pragma warning ( disable : 4786 )
+#endif
+
+/* mex headers */
+#include <mex.h>
+
+/* C++ headers */
+#include <vector>
+
+/* ITK headers */
+#include "itkImage.h"
+#include "itkBinaryBallStructuringElement.h"
+#include "itkBinaryDilateImageFilter.h"
+
+/* Gerardus headers */
+#include "MexFilterRegistry.h"
+#include "DistanceMorphology.h"
+
+// BinaryDilateImageFilter
+template <class TPixelIn, unsigned int VImageDimension>
+class BinaryDilateImageFilterWrapper {
+public:
+  
+  BinaryDilateImageFilterWrapper(MatlabImportFilter::Pointer matlabImport,
+				 MatlabExportFilter::Pointer matlabExport,
+				 MatlabImageHeader &im) {
+    
+    // inputs/outputs interfaces
+    enum InputIndexType {IN_TYPE, IN_A, IN_RADIUS, IN_FOREGROUND, InputIndexType_MAX};
+    enum OutputIndexType {OUT_B, OutputIndexType_MAX};
+
+    // check number of input and output arguments
+    matlabImport->CheckNumberOfArguments(2, InputIndexType_MAX);
+    matlabExport->CheckNumberOfArguments(0, OutputIndexType_MAX);
+    
+    // get pointer to image input
+    MatlabInputPointer inA          = matlabImport->GetRegisteredInput("A");
+  
+    // register the inputs exclusive to this function
+    MatlabInputPointer inRADIUS     = matlabImport->RegisterInput(IN_RADIUS, "RADIUS");
+    MatlabInputPointer inFOREGROUND = matlabImport->RegisterInput(IN_FOREGROUND, "FOREGROUND");
+
+    // register the outputs for this function at the export filter
+    typedef MatlabExportFilter::MatlabOutputPointer MatlabOutputPointer;
+    MatlabOutputPointer outB = matlabExport->RegisterOutput(OUT_B, "B");
+    
+    // (comp) radius of the ball in voxels
+    const unsigned long radius = matlabImport->
+      ReadScalarFromMatlab<unsigned long>(inRADIUS, 0);
+
+    // (opt) voxels with this value will be dilated
+    const TPixelIn foreground = matlabImport->template
+      ReadScalarFromMatlab<TPixelIn>(inFOREGROUND, 1);
+
+    // for large radii, threshold the exact distance transform
+    // instead. The ball is measured with the image spacing, and it is
+    // the same as the ITK ball for isotropic voxels
+    if (radius >= DISTANCE_MORPHOLOGY_MIN_RADIUS) {
+      if (outB->isRequested) {
+	TPixelIn *b = matlabExport->
+	  AllocateUninitialisedNDArrayInMatlab<TPixelIn>(outB, im.size);
+	DistanceBinaryMorphology((const TPixelIn *)mxGetData(im.data), b, im.size,
+				 im.spacing, DistanceBallRadius(im.spacing, radius),
+				 foreground, (TPixelIn)0, true);
+      }
+      return;
+    }
+
+    // instantiate the filter
+    typedef TPixelIn TPixelOut;
+    typedef itk::BinaryBallStructuringElement<TPixelIn, VImageDimension>
+      StructuringElementType;
+    typedef typename itk::Image<TPixelIn, VImageDimension> InImageType;
+    typedef InImageType OutImageType;
+    typedef itk::BinaryDilateImageFilter<InImageType, OutImageType, StructuringElementType>
+      FilterType;
+    typename FilterType::Pointer filter = FilterType::New();
+    
+    // connect Matlab inputs to ITK filter
+    filter->SetInput(matlabImport->
+		     GetImagePointerFromMatlab<TPixelIn, VImageDimension>(inA));
+    
+    // instantiate structuring element
+    StructuringElementType structuringElement;
+    structuringElement.SetRadius(radius);
+    structuringElement.CreateStructuringElement();
+    filter->SetKernel(structuringElement);
+    
+    // pass other parameters to filter
+    filter->SetForegroundValue(foreground);
+    
+    // connect ITK filter outputs to Matlab outputs
+    matlabExport->GraftItkImageOntoMatlab<TPixelOut, VImageDimension>
+      (outB, filter->GetOutputs()[0], im.size);
+
+    // run filter
+    filter->Update();
+
+  }
+};
+
+// add the filter to the registry of itk_imfilter()
+void RegisterBinaryDilateImageFilter(FilterRegistry &registry) {
+
+  registry.AddFilter("bwdilate", "BinaryDilateImageFilter");
+  AddFilterWrapperAllTypesAndDimensions<BinaryDilateImageFilterWrapper>(registry, "bwdilate");
+
+}
+
+#endif /* MEXBINARYDILATEIMAGEFILTER_CPP */
@@ -0,0 +1,167 @@
+/* MexCannyEdgeDetectionImageFilter.cpp
+ *
+ * itk_imfilter() wrapper for itk::CannyEdgeDetectionImageFilter.
+ *
+ * See ItkImFilter.cpp or itk_imfilter.m for help.
+ */
+
+ /*
+  * Author: Ramon Casero <rcasero@gmail.com>
+  * Copyright © 2011-2014 University of Oxford
+  * Version: 0.1.0
+  *
+  * University of Oxford means the Chancellor, Masters and Scholars of
+  * the University of Oxford, having an administrative office at
+  * Wellington Square, Oxford OX1 2JD, UK. 
+  *
+  * This file is part of Gerardus.
+  *
+  * This program is free software: you can redistribute it and/or modify
+  * it under the terms of the GNU General Public License as published by
+  * the Free Software Foundation, either version 3 of the License, or
+  * (at your option) any later version.
+  *
+  * This program is distributed in the hope that it will be useful,
+  * but WITHOUT ANY WARRANTY; without even the implied warranty of
+  * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  * GNU General Public License for more details. The offer of this
+  * program under the terms of the License is subject to the License
+  * being interpreted in accordance with English Law and subject to any
+  * action against the University of Oxford being under the jurisdiction
+  * of the English Courts.
+  *
+  * You should have received a copy of the GNU General Public License
+  * along with this program.  If not, see
+  * <http://www.gnu.org/licenses/>.
+  */
+
+#ifndef MEXCANNYEDGEDETECTIONIMAGEFILTER_CPP
+#define MEXCANNYEDGEDETECTIONIMAGEFILTER_CPP
+
+#ifdef _MSC_VER
+#pragma warning ( disable : 4786 )
+#endif
+
+/* mex headers */
+#include <mex.h>
+
+/* C++ headers */
+#include <limits>
+
+/* ITK headers */
+#include "itkImage.h"
+#include "itkCannyEdgeDetectionImageFilter.h"
+
+/* Gerardus headers */
+#include "MexFilterRegistry.h"
+
+// CannyEdgeDetectionImageFilter
+template <class TPixelIn, unsigned int VImageDimension>
+class CannyEdgeDetectionImageFilterWrapper {
+public:
+  
+  CannyEdgeDetectionImageFilterWrapper(MatlabImportFilter::Pointer matlabImport,
+				       MatlabExportFilter::Pointer matlabExport,
+				       MatlabImageHeader &im) {
+
+    // inputs/outputs interfaces
+    enum InputIndexType {IN_TYPE, IN_A, IN_VAR, IN_UPPTHR, IN_LOWTHR, IN_MAXERR, InputIndexType_MAX};
+    enum OutputIndexType {OUT_B, OUT_C, OutputIndexType_MAX};
+    
+    // check number of input and output arguments
+    matlabImport->CheckNumberOfArguments(2, InputIndexType_MAX);
+    matlabExport->CheckNumberOfArguments(0, OutputIndexType_MAX);
+
+    // get pointer to image input
+    MatlabInputPointer inA      = matlabImport->GetRegisteredInput("A");
+  
+    // register the inputs exclusive to this function
+    MatlabInputPointer inVAR    = matlabImport->RegisterInput(IN_VAR, "VAR");
+    MatlabInputPointer inUPPTHR = matlabImport->RegisterInput(IN_UPPTHR, "UPPTHR");
+    MatlabInputPointer inLOWTHR = matlabImport->RegisterInput(IN_LOWTHR, "LOWTHR");
+    MatlabInputPointer inMAXERR = matlabImport->RegisterInput(IN_MAXERR, "MAXERR");
+
+    // register the outputs for this function at the export filter
+    typedef MatlabExportFilter::MatlabOutputPointer MatlabOutputPointer;
+    MatlabOutputPointer outB = matlabExport->RegisterOutput(OUT_B, "B");
+    MatlabOutputPointer outC = matlabExport->RegisterOutput(OUT_C, "C");
+    
+    // instantiate the filter
+    typedef TPixelIn TPixelOut;
+    typedef typename itk::Image<TPixelIn, VImageDimension> InImageType;
+    typedef InImageType OutImageType;
+    typedef itk::CannyEdgeDetectionImageFilter<InImageType, OutImageType>
+      FilterType;
+    typename FilterType::Pointer filter = FilterType::New();
+    
+    // connect Matlab inputs to ITK filter
+    filter->SetInput(matlabImport->
+		     GetImagePointerFromMatlab<TPixelIn, VImageDimension>(inA));
+    
+    // The variance for the discrete Gaussian kernel. Sets the
+    // variance independently for each dimension. The default is 0.0
+    // in each dimension (ITK)
+    typename FilterType::ArrayType defVariance;
+    defVariance.Fill(0.0);
+    filter->SetVariance(matlabImport->
+    			ReadRowVectorFromMatlab<typename FilterType::ArrayType::ValueType, 
+    					     typename FilterType::ArrayType>(inVAR, defVariance));
+
+    // Usually, the upper tracking threshold can be set quite high,
+    // and the lower threshold quite low for good results. Setting the
+    // lower threshold too high will cause noisy edges to break
+    // up. Setting the upper threshold too low increases the number of
+    // spurious and undesirable edge fragments appearing in the
+    // output.
+    // http://homepages.inf.ed.ac.uk/rbf/HIPR2/canny.htm
+    filter->SetUpperThreshold(matlabImport->template
+			      ReadScalarFromMatlab<TPixelIn>(inUPPTHR, 
+							     std::numeric_limits<TPixelIn>::max()));
+
+    // Threshold is the lowest allowed value in the output image. Its
+    // data type is the same as the data type of the output image. Any
+    // values below the Threshold level will be replaced with the
+    // OutsideValue parameter value, whose default is zero.
+    filter->SetLowerThreshold(matlabImport->template
+			      ReadScalarFromMatlab<TPixelIn>(inLOWTHR, 
+							     filter->GetUpperThreshold() / 2.0));
+
+    // The algorithm will size the discrete kernel so that the error
+    // resulting from truncation of the kernel is no greater than
+    // MaximumError. The default is 0.01 in each dimension.
+    typename FilterType::ArrayType defMaximumError;
+    defMaximumError.Fill(0.01);
+    filter->SetMaximumError(matlabImport->
+			    ReadRowVectorFromMatlab<typename FilterType::ArrayType::ValueType, 
+						 typename FilterType::ArrayType>(inMAXERR, defMaximumError));
+
+    // graft ITK filter outputs onto Matlab outputs
+    matlabExport->GraftItkImageOntoMatlab<TPixelOut, VImageDimension>
+      (outB, filter->GetOutputs()[0], im.size);
+
+    // run filter
+    filter->Update();
+
+    // copy ITK filter outputs to Matlab outputs
+    matlabExport->CopyItkImageToMatlab<TPixelOut, VImageDimension>
+      (outC, filter->GetNonMaximumSuppressionImage(), im.size);
+
+  }
+};
+
+// add the filter to the registry of itk_imfilter()
+void RegisterCannyEdgeDetectionImageFilter(FilterRegistry &registry) {
+
+  registry.AddFilter("canny", "CannyEdgeDetectionImageFilter");
+
+  // this filter only accepts images with floating type
+  AddFilterWrapper<CannyEdgeDetectionImageFilterWrapper, double, 2>(registry, "canny");
+  AddFilterWrapper<CannyEdgeDetectionImageFilterWrapper, float, 2>(registry, "canny");
+  AddFilterWrapper<CannyEdgeDetectionImageFilterWrapper, double, 3>(registry, "canny");
+  AddFilterWrapper<CannyEdgeDetectionImageFilterWrapper, float, 3>(registry, "canny");
+  AddFilterWrapper<CannyEdgeDetectionImageFilterWrapper, double, 4>(registry, "canny");
+  AddFilterWrapper<CannyEdgeDetectionImageFilterWrapper, float, 4>(registry, "canny");
+
+}
+
+#endif /* MEXCANNYEDGEDETECTIONIMAGEFILTER_CPP */
@@ -0,0 +1,123 @@
+/* MexDanielssonDistanceMapImageFilter.cpp
+ *
+ * itk_imfilter() wrapper for itk::DanielssonDistanceMapImageFilter.
+ *
+ * See ItkImFilter.cpp or itk_imfilter.m for help.
+ */
+
+ /*
+  * Author: Ramon Casero <rcasero@gmail.com>
+  * Copyright © 2011-2014 University of Oxford
+  * Version: 0.1.0
+  *
+  * University of Oxford means the Chancellor, Masters and Scholars of
+  * the University of Oxford, having an administrative office at
+  * Wellington Square, Oxford OX1 2JD, UK. 
+  *
+  * This file is part of Gerardus.
+  *
+  * This program is free software: you can redistribute it and/or modify
+  * it under the terms of the GNU General Public License as published by
+  * the Free Software Foundation, either version 3 of the License, or
+  * (at your option) any later version.
+  *
+  * This program is distributed in the hope that it will be useful,
+  * but WITHOUT ANY WARRANTY; without even the implied warranty of
+  * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  * GNU General Public License for more details. The offer of this
+  * program under the terms of the License is subject to the License
+  * being interpreted in accordance with English Law and subject to any
+  * action against the University of Oxford being under the jurisdiction
+  * of the English Courts.
+  *
+  * You should have received a copy of the GNU General Public License
+  * along with this program.  If not, see
+  * <http://www.gnu.org/licenses/>.
+  */
+
+#ifndef MEXDANIELSSONDISTANCEMAPIMAGEFILTER_CPP
+#define MEXDANIELSSONDISTANCEMAPIMAGEFILTER_CPP
+
+#ifdef _MSC_VER
+#pragma warning ( disable : 4786 )
+#endif
+
+/* mex headers */
+#include <mex.h>
+
+/* ITK headers */
+#include "itkImage.h"
+#include "itkDanielssonDistanceMapImageFilter.h"
+
+/* Gerardus headers */
+#include "MexFilterRegistry.h"
+
+// DanielssonDistanceMapImageFilter
+template <class TPixelIn, unsigned int VImageDimension>
+class DanielssonDistanceMapImageFilterWrapper {
+public:
+  
+  DanielssonDistanceMapImageFilterWrapper(MatlabImportFilter::Pointer matlabImport,
+					  MatlabExportFilter::Pointer matlabExport,
+					  MatlabImageHeader &im) {
+    
+    // inputs/outputs interfaces
+    enum InputIndexType {IN_TYPE, IN_A, InputIndexType_MAX};
+    enum OutputIndexType {OUT_B, OUT_V, OUT_W, OutputIndexType_MAX};
+
+    // check number of input and output arguments
+    matlabImport->CheckNumberOfArguments(2, InputIndexType_MAX);
+    matlabExport->CheckNumberOfArguments(0, OutputIndexType_MAX);
+    
+    // get pointer to image input
+    MatlabInputPointer inA   = matlabImport->GetRegisteredInput("A");
+  
+    // register the outputs for this function at the export filter
+    typedef MatlabExportFilter::MatlabOutputPointer MatlabOutputPointer;
+    MatlabOutputPointer outB = matlabExport->RegisterOutput(OUT_B, "B");
+    MatlabOutputPointer outV = matlabExport->RegisterOutput(OUT_V, "V");
+    MatlabOutputPointer outW = matlabExport->RegisterOutput(OUT_W, "W");
+
+    // instantiate the filter
+    typedef double TPixelOut;
+    typedef typename itk::Image<TPixelIn, VImageDimension> InImageType;
+    typedef typename itk::Image<TPixelOut, VImageDimension> OutImageType;
+    typedef itk::DanielssonDistanceMapImageFilter<InImageType, OutImageType>
+      FilterType;
+    typename FilterType::Pointer filter = FilterType::New();
+    
+    // connect Matlab inputs to ITK filter
+    filter->SetInput(matlabImport->
+		     GetImagePointerFromMatlab<TPixelIn, VImageDimension>(inA));
+
+    // connect ITK filter outputs to Matlab outputs
+
+    // distance map
+    matlabExport->GraftItkImageOntoMatlab<TPixelOut, VImageDimension>
+      (outB, filter->GetOutputs()[0], im.size);
+
+    // Voronoi map
+    matlabExport->GraftItkImageOntoMatlab<TPixelIn, VImageDimension>
+      (outV, filter->GetOutputs()[1], im.size);
+
+    // vectors pointing to closest foreground voxel
+    matlabExport->GraftItkImageOntoMatlab<typename InImageType::OffsetType::OffsetValueType,
+					  VImageDimension,
+					  typename InImageType::OffsetType::OffsetType>
+      (outW, filter->GetOutputs()[2], im.size);
+
+    // run filter
+    filter->Update();
+
+  }
+};
+
+// add the filter to the registry of itk_imfilter()
+void RegisterDanielssonDistanceMapImageFilter(FilterRegistry &registry) {
+
+  registry.AddFilter("dandist", "DanielssonDistanceMapImageFilter");
+  AddFilterWrapperAllTypesAndDimensions<DanielssonDistanceMapImageFilterWrapper>(registry, "dandist");
+
+}
+
+#endif /* MEXDANIELSSONDISTANCEMAPIMAGEFILTER_CPP */
@@ -0,0 +1,185 @@
+/* MexExactDistanceTransform.cpp
+ *
+ * itk_imfilter() wrapper for the exact Euclidean distance transform in
+ * ExactDistanceTransform.h ('edt' and 'signedt').
+ *
+ * See ItkImFilter.cpp or itk_imfilter.m for help.
+ */
+
+ /*
+  * Author: Ramon Casero <rcasero@gmail.com>
+  * Copyright © 2011-2014 University of Oxford
+  * Version: 0.1.1
+  *
+  * University of Oxford means the Chancellor, Masters and Scholars of
+  * the University of Oxford, having an administrative office at
+  * Wellington Square, Oxford OX1 2JD, UK. 
+  *
+  * This file is part of Gerardus.
+  *
+  * This program is free software: you can redistribute it and/or modify
+  * it under the terms of the GNU General Public License as published by
+  * the Free Software Foundation, either version 3 of the License, or
+  * (at your option) any later version.
+  *
+  * This program is distributed in the hope that it will be useful,
+  * but WITHOUT ANY WARRANTY; without even the implied warranty of
+  * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  * GNU General Public License for more details. The offer of this
+  * program under the terms of the License is subject to the License
+  * being interpreted in accordance with English Law and subject to any
+  * action against the University of Oxford being under the jurisdiction
+  * of the English Courts.
+  *
+  * You should have received a copy of the GNU General Public License
+  * along with this program.  If not, see
+  * <http://www.gnu.org/licenses/>.
+  */
+
+#ifndef MEXEXACTDISTANCETRANSFORM_CPP
+#define MEXEXACTDISTANCETRANSFORM_CPP
+
+#ifdef _MSC_VER
+#pragma warning ( disable : 4786 )
+#endif
+
+/* mex headers */
+#include <mex.h>
+
+/* C++ headers */
+#include <cmath>
+#include <vector>
+
+/* Gerardus headers */
+#include "MexFilterRegistry.h"
+#include "ExactDistanceTransform.h"
+
+// ExactDistanceTransform, SignedExactDistanceTransform
+//
+// These are not ITK filters. Both wrappers run the exact Euclidean
+// distance transform in ExactDistanceTransform.h directly on the
+// Matlab buffers
+template <class TPixelIn>
+void RunExactDistanceTransform(MatlabImportFilter::Pointer matlabImport,
+			       MatlabExportFilter::Pointer matlabExport,
+			       MatlabImageHeader &im, bool isSigned) {
+
+  // inputs/outputs interfaces
+  enum InputIndexType {IN_TYPE, IN_A, InputIndexType_MAX};
+  enum OutputIndexType {OUT_B, OUT_V, OUT_W, OutputIndexType_MAX};
+
+  // check number of input and output arguments
+  matlabImport->CheckNumberOfArguments(2, InputIndexType_MAX);
+  matlabExport->CheckNumberOfArguments(0, OutputIndexType_MAX);
+
+  // register the outputs for this function at the export filter
+  typedef MatlabExportFilter::MatlabOutputPointer MatlabOutputPointer;
+  MatlabOutputPointer outB = matlabExport->RegisterOutput(OUT_B, "B");
+  MatlabOutputPointer outV = matlabExport->RegisterOutput(OUT_V, "V");
+  MatlabOutputPointer outW = matlabExport->RegisterOutput(OUT_W, "W");
+
+  // input image
+  const TPixelIn *a = (const TPixelIn *)mxGetData(im.data);
+  ExactDistanceTransform edt(im.size, im.spacing);
+  const mwSize n = edt.GetNumberOfVoxels();
+
+  // the closest voxels are only computed if V or W are requested
+  int32_T *v = NULL;
+  std::vector<int32_T> vBuffer;
+  if (outV->isRequested) {
+    v = matlabExport->
+      AllocateUninitialisedNDArrayInMatlab<int32_T>(outV, im.size);
+  } else if (outW->isRequested) {
+    vBuffer.resize(n);
+    v = &vBuffer[0];
+  }
+
+  // distance to the closest foreground voxel
+  std::vector<double> sqdist(n);
+  edt.Compute(a, true, &sqdist[0], v);
+
+  float *b = NULL;
+  if (outB->isRequested) {
+    b = matlabExport->
+      AllocateUninitialisedNDArrayInMatlab<float>(outB, im.size);
+    for (mwIndex i = 0; i < n; ++i) {
+      b[i] = (float)std::sqrt(sqdist[i]);
+    }
+  }
+
+  // signed distance: foreground voxels get minus the distance to the
+  // closest background voxel
+  if (isSigned) {
+    std::vector<int32_T> vIn(v ? n : 0);
+    edt.Compute(a, false, &sqdist[0], v ? &vIn[0] : NULL);
+    for (mwIndex i = 0; i < n; ++i) {
+      if (a[i] != 0) {
+	if (b) {
+	  b[i] = -(float)std::sqrt(sqdist[i]);
+	}
+	if (v) {
+	  v[i] = vIn[i];
+	}
+      }
+    }
+  }
+
+  // vectors pointing to the closest voxel, in voxel units
+  if (outW->isRequested) {
+    std::vector<mwSize> sizeW(im.size);
+    sizeW.push_back(im.size.size());
+    int32_T *w = matlabExport->
+      AllocateUninitialisedNDArrayInMatlab<int32_T>(outW, sizeW);
+    mwSize stride = 1;
+    for (size_t d = 0; d < im.size.size(); ++d) {
+      for (mwIndex i = 0; i < n; ++i) {
+	w[i + d * n] = (v[i] < 0) ? 0 :
+	  (int32_T)(((mwIndex)v[i] / stride) % im.size[d])
+	  - (int32_T)((i / stride) % im.size[d]);
+      }
+      stride *= im.size[d];
+    }
+  }
+
+  // convert closest voxel indices to Matlab indices (-1 becomes 0,
+  // no closest voxel)
+  if (outV->isRequested) {
+    for (mwIndex i = 0; i < n; ++i) {
+      ++v[i];
+    }
+  }
+
+}
+
+template <class TPixelIn, unsigned int VImageDimension>
+class ExactDistanceTransformWrapper {
+public:
+  ExactDistanceTransformWrapper(MatlabImportFilter::Pointer matlabImport,
+				MatlabExportFilter::Pointer matlabExport,
+				MatlabImageHeader &im) {
+    RunExactDistanceTransform<TPixelIn>(matlabImport, matlabExport, im, false);
+  }
+};
+
+template <class TPixelIn, unsigned int VImageDimension>
+class SignedExactDistanceTransformWrapper {
+public:
+  SignedExactDistanceTransformWrapper(MatlabImportFilter::Pointer matlabImport,
+				      MatlabExportFilter::Pointer matlabExport,
+				      MatlabImageHeader &im) {
+    RunExactDistanceTransform<TPixelIn>(matlabImport, matlabExport, im, true);
+  }
+};
+
+// add the filters to the registry of itk_imfilter()
+void RegisterExactDistanceTransform(FilterRegistry &registry) {
+
+  registry.AddFilter("edt", "ExactDistanceTransform");
+  AddFilterWrapperAllTypesAndDimensions<ExactDistanceTransformWrapper>(registry, "edt");
+
+  registry.AddFilter("signedt", "SignedExactDistanceTransform");
+  AddFilterWrapperAllTypesAndDimensions<SignedExactDistanceTransformWrapper>(registry, "signedt");
+
+}
+
+#endif /* MEXEXACTDISTANCETRANSFORM_CPP */
@@ -0,0 +1,215 @@
+/*
+ * MexFilterRegistry.h
+ *
+ * Run-time registry of the filters that can be run by itk_imfilter().
+ *
+ * Each filter is implemented by a wrapper class template
+ * TWrapper<TPixelIn, VImageDimension> in its own translation unit
+ * MexFilter/Mex<FilterName>.cpp. The constructor of the wrapper
+ * acquires the inputs from Matlab, sets the parameters, runs the
+ * filter and grafts the outputs onto Matlab.
+ *
+ * The translation unit exports a Register<FilterName>() function that
+ * adds the filter's names to the registry, and a runner for each
+ * (pixel type, dimension) combination that the filter accepts. Only
+ * those combinations are instantiated, so unsupported combinations
+ * don't need error specialisations, and adding a filter doesn't
+ * recompile the others.
+ *
+ * itk_imfilter() then selects the runner at run time from the filter
+ * name, and the class and number of dimensions of the input image.
+ */
+
+ /*
+  * Author: Ramon Casero <rcasero@gmail.com>
+  * Copyright © 2014 University of Oxford
+  * Version: 0.1.1
+  *
+  * University of Oxford means the Chancellor, Masters and Scholars of
+  * the University of Oxford, having an administrative office at
+  * Wellington Square, Oxford OX1 2JD, UK.
+  *
+  * This file is part of Gerardus.
+  *
+  * This program is free software: you can redistribute it and/or modify
+  * it under the terms of the GNU General Public License as published by
+  * the Free Software Foundation, either version 3 of the License, or
+  * (at your option) any later version.
+  *
+  * This program is distributed in the hope that it will be useful,
+  * but WITHOUT ANY WARRANTY; without even the implied warranty of
+  * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  * GNU General Public License for more details. The offer of this
+  * program under the terms of the License is subject to the License
+  * being interpreted in accordance with English Law and subject to any
+  * action against the University of Oxford being under the jurisdiction
+  * of the English Courts.
+  *
+  * You should have received a copy of the GNU General Public License
+  * along with this program.  If not, see
+  * <http://www.gnu.org/licenses/>.
+  */
+
+#ifndef MEXFILTERREGISTRY_H
+#define MEXFILTERREGISTRY_H
+
+/* mex headers */
+#include <mex.h>
+
+/* C++ headers */
+#include <map>
+#include <sstream>
+#include <string>
+
+/* Gerardus headers */
+#include "GerardusCommon.h"
+#include "MatlabImageHeader.h"
+#include "MatlabImportFilter.h"
+#include "MatlabExportFilter.h"
+
+// common types
+typedef MatlabImportFilter::MatlabInputPointer MatlabInputPointer;
+
+// function that runs a filter on an input image of a given pixel type
+// and dimension
+typedef void (*FilterRunnerType)(MatlabImportFilter::Pointer matlabImport,
+				 MatlabExportFilter::Pointer matlabExport,
+				 MatlabImageHeader &im);
+
+class FilterRegistry {
+
+public:
+
+  // AddFilter(): register a filter with its short name (e.g. "canny")
+  // and its long name (e.g. "CannyEdgeDetectionImageFilter"). Either
+  // can be used to select the filter
+  void AddFilter(const std::string &shortName, const std::string &longName) {
+    this->alias[shortName] = shortName;
+    this->alias[longName] = shortName;
+    this->longName[shortName] = longName;
+  }
+
+  // AddRunner(): register the function that runs filter shortName on
+  // input images of class type and ndim dimensions
+  void AddRunner(const std::string &shortName, mxClassID type,
+		 unsigned int ndim, FilterRunnerType runner) {
+    this->runner[RunnerKeyType(shortName, RunnerSubkeyType(type, ndim))] = runner;
+  }
+
+  // GetRunner(): find the function that runs filter filterName (short
+  // or long name) on image im. If the filter doesn't exist or doesn't
+  // accept the image, this function gives a Matlab error
+  FilterRunnerType GetRunner(const std::string &filterName,
+			     const MatlabImageHeader &im) const {
+
+    std::map<std::string, std::string>::const_iterator itAlias
+      = this->alias.find(filterName);
+    if (itAlias == this->alias.end()) {
+      mexErrMsgTxt("Invalid filter type");
+    }
+    const std::string &shortName = itAlias->second;
+
+    // look up the (type, dimension) combination
+    const unsigned int ndim = (unsigned int)im.size.size();
+    std::map<RunnerKeyType, FilterRunnerType>::const_iterator itRunner
+      = this->runner.find(RunnerKeyType(shortName, RunnerSubkeyType(im.type, ndim)));
+    if (itRunner != this->runner.end()) {
+      return itRunner->second;
+    }
+
+    // the combination is not supported. Check whether it's because of
+    // the dimension or the pixel type to give a useful error message
+    const std::string &longName = this->longName.find(shortName)->second;
+    bool acceptsDimension = false;
+    for (itRunner = this->runner.begin(); itRunner != this->runner.end(); ++itRunner) {
+      if (itRunner->first.first == shortName
+	  && itRunner->first.second.second == ndim) {
+	acceptsDimension = true;
+	break;
+      }
+    }
+    if (!acceptsDimension) {
+      std::ostringstream msg;
+      msg << longName << " does not accept " << ndim << "D input images";
+      mexErrMsgTxt(msg.str().c_str());
+    }
+    mexErrMsgTxt((longName + " does not accept input images of class "
+		  + mxGetClassName(im.data)).c_str());
+    return NULL;
+  }
+
+private:
+
+  typedef std::pair<mxClassID, unsigned int> RunnerSubkeyType;
+  typedef std::pair<std::string, RunnerSubkeyType> RunnerKeyType;
+
+  // any filter name -> short name
+  std::map<std::string, std::string> alias;
+
+  // short name -> long name
+  std::map<std::string, std::string> longName;
+
+  // (short name, (class, dimension)) -> runner
+  std::map<RunnerKeyType, FilterRunnerType> runner;
+
+};
+
+// RunFilterWrapper(): runner that instantiates the wrapper class of a
+// filter for a given pixel type and dimension
+template <template <class, unsigned int> class TWrapper,
+	  class TPixelIn, unsigned int VImageDimension>
+void RunFilterWrapper(MatlabImportFilter::Pointer matlabImport,
+		      MatlabExportFilter::Pointer matlabExport,
+		      MatlabImageHeader &im) {
+  TWrapper<TPixelIn, VImageDimension> wrapper(matlabImport, matlabExport, im);
+}
+
+// AddFilterWrapper(): register the wrapper of a filter for a given
+// pixel type and dimension
+template <template <class, unsigned int> class TWrapper,
+	  class TPixelIn, unsigned int VImageDimension>
+void AddFilterWrapper(FilterRegistry &registry, const std::string &shortName) {
+  registry.AddRunner(shortName, convertCppDataTypeToMatlabCassId<TPixelIn>(),
+		     VImageDimension,
+		     &RunFilterWrapper<TWrapper, TPixelIn, VImageDimension>);
+}
+
+// AddFilterWrapperNumericTypes(): register the wrapper of a filter for
+// all the numeric pixel types supported by itk_imfilter() and a given
+// dimension
+template <template <class, unsigned int> class TWrapper,
+	  unsigned int VImageDimension>
+void AddFilterWrapperNumericTypes(FilterRegistry &registry,
+				  const std::string &shortName) {
+  AddFilterWrapper<TWrapper, double, VImageDimension>(registry, shortName);
+  AddFilterWrapper<TWrapper, float, VImageDimension>(registry, shortName);
+  AddFilterWrapper<TWrapper, int8_T, VImageDimension>(registry, shortName);
+  AddFilterWrapper<TWrapper, uint8_T, VImageDimension>(registry, shortName);
+  AddFilterWrapper<TWrapper, int16_T, VImageDimension>(registry, shortName);
+  AddFilterWrapper<TWrapper, uint16_T, VImageDimension>(registry, shortName);
+  AddFilterWrapper<TWrapper, int32_T, VImageDimension>(registry, shortName);
+  AddFilterWrapper<TWrapper, uint32_T, VImageDimension>(registry, shortName);
+  AddFilterWrapper<TWrapper, int64_T, VImageDimension>(registry, shortName);
+  AddFilterWrapper<TWrapper, uint64_T, VImageDimension>(registry, shortName);
+}
+
+// AddFilterWrapperAllTypes(): as above, plus boolean images
+template <template <class, unsigned int> class TWrapper,
+	  unsigned int VImageDimension>
+void AddFilterWrapperAllTypes(FilterRegistry &registry,
+			      const std::string &shortName) {
+  AddFilterWrapper<TWrapper, mxLogical, VImageDimension>(registry, shortName);
+  AddFilterWrapperNumericTypes<TWrapper, VImageDimension>(registry, shortName);
+}
+
+// AddFilterWrapperAllTypesAndDimensions(): register the wrapper of a
+// filter for all the pixel types and 2D, 3D and 4D images
+template <template <class, unsigned int> class TWrapper>
+void AddFilterWrapperAllTypesAndDimensions(FilterRegistry &registry,
+					   const std::string &shortName) {
+  AddFilterWrapperAllTypes<TWrapper, 2>(registry, shortName);
+  AddFilterWrapperAllTypes<TWrapper, 3>(registry, shortName);
+  AddFilterWrapperAllTypes<TWrapper, 4>(registry, shortName);
+}
+
+#endif /* MEXFILTERREGISTRY_H */
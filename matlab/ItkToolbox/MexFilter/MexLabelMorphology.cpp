@@ -0,0 +1,133 @@
+/* MexLabelMorphology.cpp
+ *
+ * itk_imfilter() wrapper for the multi-label dilation and erosion in
+ * DistanceMorphology.h ('labdilate' and 'laberode').
+ *
+ * See ItkImFilter.cpp or itk_imfilter.m for help.
+ */
+
+ /*
+  * Author: Ramon Casero <rcasero@gmail.com>
+  * Copyright © 2011-2014 University of Oxford
+  * Version: 0.1.1
+  *
+  * University of Oxford means the Chancellor, Masters and Scholars of
+  * the University of Oxford, having an administrative office at
+  * Wellington Square, Oxford OX1 2JD, UK. 
+  *
+  * This file is part of Gerardus.
+  *
+  * This program is free software: you can redistribute it and/or modify
+  * it under the terms of the GNU General Public License as published by
+  * the Free Software Foundation, either version 3 of the License, or
+  * (at your option) any later version.
+  *
+  * This program is distributed in the hope that it will be useful,
+  * but WITHOUT ANY WARRANTY; without even the implied warranty of
+  * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  * GNU General Public License for more details. The offer of this
+  * program under the terms of the License is subject to the License
+  * being interpreted in accordance with English Law and subject to any
+  * action against the University of Oxford being under the jurisdiction
+  * of the English Courts.
+  *
+  * You should have received a copy of the GNU General Public License
+  * along with this program.  If not, see
+  * <http://www.gnu.org/licenses/>.
+  */
+
+#ifndef MEXLABELMORPHOLOGY_CPP
+#define MEXLABELMORPHOLOGY_CPP
+
+#ifdef _MSC_VER
+#pragma warning ( disable : 4786 )
+#endif
+
+/* mex headers */
+#include <mex.h>
+
+/* Gerardus headers */
+#include "MexFilterRegistry.h"
+#include "DistanceMorphology.h"
+
+// LabelDilate, LabelErode
+//
+// These are not ITK filters. Both wrappers run the multi-label
+// dilation/erosion in DistanceMorphology.h directly on the Matlab
+// buffers
+template <class TPixelIn>
+void RunLabelMorphology(MatlabImportFilter::Pointer matlabImport,
+			MatlabExportFilter::Pointer matlabExport,
+			MatlabImageHeader &im, bool isDilate) {
+
+  // inputs/outputs interfaces
+  enum InputIndexType {IN_TYPE, IN_A, IN_RADIUS, InputIndexType_MAX};
+  enum OutputIndexType {OUT_B, OutputIndexType_MAX};
+
+  // check number of input and output arguments
+  matlabImport->CheckNumberOfArguments(2, InputIndexType_MAX);
+  matlabExport->CheckNumberOfArguments(0, OutputIndexType_MAX);
+
+  // register the inputs exclusive to this function
+  MatlabInputPointer inRADIUS = matlabImport->RegisterInput(IN_RADIUS, "RADIUS");
+
+  // register the outputs for this function at the export filter
+  typedef MatlabExportFilter::MatlabOutputPointer MatlabOutputPointer;
+  MatlabOutputPointer outB = matlabExport->RegisterOutput(OUT_B, "B");
+
+  // (opt) radius of the ball in real world units
+  const double radius = matlabImport->
+    ReadScalarFromMatlab<double>(inRADIUS, 0.0);
+  if (radius < 0.0) {
+    mexErrMsgTxt("RADIUS must be >= 0");
+  }
+
+  if (!outB->isRequested) {
+    return;
+  }
+  TPixelIn *b = matlabExport->
+    AllocateUninitialisedNDArrayInMatlab<TPixelIn>(outB, im.size);
+
+  // run filter
+  if (isDilate) {
+    DistanceLabelDilate((const TPixelIn *)mxGetData(im.data), b, im.size,
+			im.spacing, radius);
+  } else {
+    DistanceLabelErode((const TPixelIn *)mxGetData(im.data), b, im.size,
+		       im.spacing, radius);
+  }
+
+}
+
+template <class TPixelIn, unsigned int VImageDimension>
+class LabelDilateWrapper {
+public:
+  LabelDilateWrapper(MatlabImportFilter::Pointer matlabImport,
+		     MatlabExportFilter::Pointer matlabExport,
+		     MatlabImageHeader &im) {
+    RunLabelMorphology<TPixelIn>(matlabImport, matlabExport, im, true);
+  }
+};
+
+template <class TPixelIn, unsigned int VImageDimension>
+class LabelErodeWrapper {
+public:
+  LabelErodeWrapper(MatlabImportFilter::Pointer matlabImport,
+		    MatlabExportFilter::Pointer matlabExport,
+		    MatlabImageHeader &im) {
+    RunLabelMorphology<TPixelIn>(matlabImport, matlabExport, im, false);
+  }
+};
+
+// add the filters to the registry of itk_imfilter()
+void RegisterLabelMorphology(FilterRegistry &registry) {
+
+  registry.AddFilter("labdilate", "LabelDilate");
+  AddFilterWrapperAllTypesAndDimensions<LabelDilateWrapper>(registry, "labdilate");
+
+  registry.AddFilter("laberode", "LabelErode");
+  AddFilterWrapperAllTypesAndDimensions<LabelErodeWrapper>(registry, "laberode");
+
+}
+
+#endif /* MEXLABELMORPHOLOGY_CPP */
@@ -0,0 +1,358 @@
+/* MexMRFImageFilter.cpp
+ *
+ * itk_imfilter() wrapper for itk::MRFImageFilter, and the ICM and
+ * alpha-expansion engine in MrfSegmentation.h.
+ *
+ * See ItkImFilter.cpp or itk_imfilter.m for help.
+ */
+
+ /*
+  * Author: Ramon Casero <rcasero@gmail.com>
+  * Copyright © 2011-2014 University of Oxford
+  * Version: 0.1.1
+  *
+  * University of Oxford means the Chancellor, Masters and Scholars of
+  * the University of Oxford, having an administrative office at
+  * Wellington Square, Oxford OX1 2JD, UK. 
+  *
+  * This file is part of Gerardus.
+  *
+  * This program is free software: you can redistribute it and/or modify
+  * it under the terms of the GNU General Public License as published by
+  * the Free Software Foundation, either version 3 of the License, or
+  * (at your option) any later version.
+  *
+  * This program is distributed in the hope that it will be useful,
+  * but WITHOUT ANY WARRANTY; without even the implied warranty of
+  * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  * GNU General Public License for more details. The offer of this
+  * program under the terms of the License is subject to the License
+  * being interpreted in accordance with English Law and subject to any
+  * action against the University of Oxford being under the jurisdiction
+  * of the English Courts.
+  *
+  * You should have received a copy of the GNU General Public License
+  * along with this program.  If not, see
+  * <http://www.gnu.org/licenses/>.
+  */
+
+#ifndef MEXMRFIMAGEFILTER_CPP
+#define MEXMRFIMAGEFILTER_CPP
+
+#ifdef _MSC_VER
+#pragma warning ( disable : 4786 )
+#endif
+
+/* mex headers */
+#include <mex.h>
+
+/* C++ headers */
+#include <algorithm>
+#include <cmath>
+#include <string>
+#include <vector>
+
+/* ITK headers */
+#include "itkImage.h"
+#include "itkComposeImageFilter.h"
+#include "itkFixedArray.h"
+#include "itkDistanceToCentroidMembershipFunction.h"
+#include "itkMinimumDecisionRule.h"
+#include "itkMRFImageFilter.h"
+
+/* Gerardus headers */
+#include "MexFilterRegistry.h"
+#include "MrfSegmentation.h"
+
+// MRFImageFilter
+template <class TPixelIn, unsigned int VImageDimension>
+class MRFImageFilterWrapper {
+public:
+  
+  MRFImageFilterWrapper(MatlabImportFilter::Pointer matlabImport,
+			MatlabExportFilter::Pointer matlabExport,
+			MatlabImageHeader &im) {
+    
+    // inputs/outputs interfaces
+    enum InputIndexType {IN_TYPE, IN_A, IN_MU, IN_WEIGHTS, IN_SMOOTH, 
+			 IN_NITER, IN_TOL, IN_METHOD, InputIndexType_MAX};
+    enum OutputIndexType {OUT_B, OUT_STATS, OutputIndexType_MAX};
+
+    // check number of input and output arguments
+    matlabImport->CheckNumberOfArguments(3, InputIndexType_MAX);
+    matlabExport->CheckNumberOfArguments(0, OutputIndexType_MAX);
+    
+    // get pointer to image input
+    MatlabInputPointer inA       = matlabImport->GetRegisteredInput("A");
+  
+    // register the inputs exclusive to this function
+    MatlabInputPointer inMU      = matlabImport->RegisterInput(IN_MU, "MU");
+    MatlabInputPointer inWEIGHTS = matlabImport->RegisterInput(IN_WEIGHTS, "WEIGHTS");
+    MatlabInputPointer inSMOOTH  = matlabImport->RegisterInput(IN_SMOOTH, "SMOOTH");
+    MatlabInputPointer inNITER   = matlabImport->RegisterInput(IN_NITER, "NITER");
+    MatlabInputPointer inTOL     = matlabImport->RegisterInput(IN_TOL, "TOL");
+    MatlabInputPointer inMETHOD  = matlabImport->RegisterInput(IN_METHOD, "METHOD");
+
+    // register the outputs for this function at the export filter
+    typedef MatlabExportFilter::MatlabOutputPointer MatlabOutputPointer;
+    MatlabOutputPointer outB = matlabExport->RegisterOutput(OUT_B, "B");
+    MatlabOutputPointer outSTATS = matlabExport->RegisterOutput(OUT_STATS, "STATS");
+    
+    /* type definitions */
+
+    // input image
+    typedef typename itk::Image<TPixelIn, VImageDimension> InImageType;
+    
+    // segmentation masks
+    typedef unsigned char LabelPixelType;
+    typedef itk::Image<LabelPixelType, VImageDimension> LabelImageType;
+
+    // output pixel type
+    typedef LabelPixelType TPixelOut;
+
+    // dummy compose filter to convert the scalar image into a 1-vector image
+    typedef itk::FixedArray<TPixelIn, 1> ArrayPixelType;
+    typedef itk::Image<ArrayPixelType, VImageDimension> ArrayImageType;
+    typedef itk::ComposeImageFilter<
+      InImageType, ArrayImageType> ScalarToArrayFilterType;
+
+    // filter
+    typedef itk::MRFImageFilter<ArrayImageType, LabelImageType>
+      FilterType;
+
+    // classifier
+    typedef itk::ImageClassifierBase<ArrayImageType, LabelImageType> SupervisedClassifierType;
+
+    // decision rule
+    typedef itk::Statistics::MinimumDecisionRule DecisionRuleType;
+
+    // membership function
+    typedef itk::Statistics::DistanceToCentroidMembershipFunction<ArrayPixelType>
+      MembershipFunctionType;
+    typedef typename MembershipFunctionType::Pointer MembershipFunctionPointer;
+
+    /* filter actions */    
+
+    // instantiate the filter
+    typename FilterType::Pointer filter = FilterType::New();
+
+    /*    
+     * get input arguments (grouped here for clarity)
+     */
+    
+    // from the ITK guide: "Since the Markov Random Field algorithm is
+    // defined in general for images whose pixels have multiple
+    // components, that is, images of vector type, we must adapt our
+    // scalar image in order to satisfy the interface expected by the
+    // \code{MRFImageFilter}. We do this by using the
+    // \doxygen{ComposeImageFilter}. With this filter we will present
+    // our scalar image as a vector image whose vector pixels contain
+    // a single component"
+    typename ScalarToArrayFilterType::Pointer
+      scalarToArrayFilter = ScalarToArrayFilterType::New();
+    scalarToArrayFilter->SetInput(matlabImport->
+    				  GetImagePointerFromMatlab<TPixelIn, VImageDimension>(inA));
+
+    // vector of centroids
+    std::vector<TPixelIn> centroid = matlabImport->template
+      ReadRowVectorFromMatlab<TPixelIn, std::vector<TPixelIn> >(inMU, std::vector<TPixelIn>(0));
+    unsigned int numberOfClasses = centroid.size();
+
+    // by default, the neighbourhood is a hypercube with 1 voxel to
+    // either side of the centre, i.e. a hypercube with side 3. All
+    // elements of the default hypercube are 1.0, except for the
+    // central pixel, that is 0.0
+    mwSize neighLength = (mwSize)std::pow(3.0, (double)VImageDimension);
+    std::vector<double> weights(neighLength, 1.0);
+    weights[(neighLength-1)/2] = 0.0;
+    typename InImageType::SizeType neighHalfSize;
+    neighHalfSize.Fill(1);
+
+    // read neighbourhood weights provided by the user, but as a vector
+    weights = matlabImport->template
+      ReadArrayAsVectorFromMatlab<std::vector<double> >(inWEIGHTS, weights);
+    
+    // get size of neighbourhood weights array as provided by the
+    // user. We get the half-size, as required by this filter (size =
+    // 2 * halfsize + 1)
+    neighHalfSize = matlabImport->template
+      ReadMatlabArrayHalfSize<typename InImageType::SizeValueType, 
+		       typename InImageType::SizeType,
+		       VImageDimension>(inWEIGHTS, neighHalfSize);
+
+    double smoothingFactor = matlabImport->template
+      ReadScalarFromMatlab<double>(inSMOOTH, 1e-7);
+    unsigned int maximumNumberOfIterations = matlabImport->template
+      ReadScalarFromMatlab<unsigned int>(inNITER, 100);
+    double errorTolerance = matlabImport->template
+      ReadScalarFromMatlab<double>(inTOL, 1e-7);
+    std::string method = matlabImport->
+      ReadStringFromMatlab(inMETHOD, "itk");
+    if (method != "itk" && method != "icm" && method != "alphaexp") {
+      mexErrMsgTxt("METHOD must be 'itk', 'icm' or 'alphaexp'");
+    }
+
+    // ITK guide: "number of classes to be used during the
+    // classification, the maximum number of iterations to be run in
+    // this filter and the error tolerance that will be used as a
+    // criterion for convergence"
+    //
+    // ITK guide: "the smoothing factor represents the tradeoff
+    // between fidelity to the observed image and the smoothness of
+    // the segmented image. Typical smoothing factors have values
+    // between 1~5. This factor will multiply the weights that define
+    // the influence of neighbors on the classification of a given
+    // pixel.  The higher the value, the more uniform will be the
+    // regions resulting from the classification refinement"
+    filter->SetNumberOfClasses(numberOfClasses);
+    filter->SetSmoothingFactor(smoothingFactor);
+    filter->SetMaximumNumberOfIterations(maximumNumberOfIterations);
+    filter->SetErrorTolerance(errorTolerance);
+
+    // ITK guide: "Given that the MRF filter need to continually
+    // relabel the pixels, it needs access to a set of membership
+    // functions that will measure to what degree every pixel belongs
+    // to a particular class.  The classification is performed by the
+    // \doxygen{ImageClassifierBase} class, that is instantiated using
+    // the type of the input vector image and the type of the labeled
+    // image
+    typename SupervisedClassifierType::Pointer classifier 
+      = SupervisedClassifierType::New();
+
+    // ITK guide: "The classifier needs a decision rule to be set by
+    // the user. Note that we must use \code{GetPointer()} in the call
+    // of the \code{SetDecisionRule()} method because we are passing a
+    // SmartPointer, and smart pointers cannot perform polymorphism,
+    // we must then extract the raw pointer that is associated to the
+    // smart pointer. This extraction is done with the GetPointer()
+    // method"
+    //
+    // MinimumDecisionRule returns the class label with the smallest
+    // discriminant score
+    typename DecisionRuleType::Pointer classifierDecisionRule 
+      = DecisionRuleType::New();
+    classifier->SetDecisionRule(classifierDecisionRule.GetPointer());
+
+    // ITK guide: "we now instantiate the membership functions. In
+    // this case we use the
+    // \subdoxygen{Statistics}{DistanceToCentroidMembershipFunction}
+    // class templated over the pixel type of the vector image, that
+    // in our example happens to be a vector of dimension 1"
+    double meanDistance = 0.0;
+    typename MembershipFunctionType::CentroidType centroidAux(1);
+    for(unsigned int i=0; i < numberOfClasses; i++) {
+      MembershipFunctionPointer membershipFunction =
+    	MembershipFunctionType::New();
+      
+      centroidAux[0] = centroid[i];
+      
+      membershipFunction->SetCentroid(centroidAux);
+      
+      classifier->AddMembershipFunction(membershipFunction);
+      meanDistance += static_cast<double>(centroid[i]);
+    }
+    meanDistance /= numberOfClasses;
+    
+    // ITK guide: "and we set the neighborhood radius that will define
+    // the size of the clique to be used in the computation of the
+    // neighbors' influence in the classification of any given
+    // pixel. Note that despite the fact that we call this a radius,
+    // it is actually the half size of an hypercube. That is, the
+    // actual region of influence will not be circular but rather an
+    // N-Dimensional box. For example, a neighborhood radius of 2 in a
+    // 3D image will result in a clique of size 5x5x5 pixels, and a
+    // radius of 1 will result in a clique of size 3x3x3 pixels."
+    filter->SetNeighborhoodRadius(neighHalfSize);
+
+    // ITK guide: "We now scale weights so that the smoothing function
+    // and the image fidelity functions have comparable value. This is
+    // necessary since the label image and the input image can have
+    // different dynamic ranges. The fidelity function is usually
+    // computed using a distance function, such as the
+    // \doxygen{DistanceToCentroidMembershipFunction} or one of the
+    // other membership functions. They tend to have values in the
+    // order of the means specified."
+    double totalWeight = 0;
+    for(std::vector<double>::const_iterator wcIt = weights.begin();
+	wcIt != weights.end(); ++wcIt ) {
+      totalWeight += *wcIt;
+    }
+    for(std::vector<double>::iterator wIt = weights.begin();
+	wIt != weights.end(); wIt++) {
+      *wIt = static_cast<double> ((*wIt) * meanDistance / (2 * totalWeight));
+    }
+
+    // Gerardus' MrfSegmentation solves the same problem with parallel
+    // ICM or alpha-expansion. The smoothing factor is applied to the
+    // weights, as itk::MRFImageFilter does internally
+    if (method != "itk") {
+
+      std::vector<mwSize> halfSize(VImageDimension);
+      std::vector<double> smoothWeights(weights);
+      for (unsigned int d = 0; d < VImageDimension; ++d) {
+	halfSize[d] = neighHalfSize[d];
+      }
+      for (std::vector<double>::iterator wIt = smoothWeights.begin();
+	   wIt != smoothWeights.end(); ++wIt) {
+	*wIt *= smoothingFactor;
+      }
+
+      MrfSegmentation mrf(im.size, halfSize, smoothWeights);
+      mrf.SetDataCosts((const TPixelIn *)mxGetData(im.data),
+		       std::vector<double>(centroid.begin(), centroid.end()));
+      std::vector<mwSize> changed;
+      std::vector<double> energy;
+      mrf.Run((method == "alphaexp") ? MrfSegmentation::EXPANSION : MrfSegmentation::ICM,
+	      maximumNumberOfIterations, errorTolerance, changed, energy);
+
+      if (outB->isRequested) {
+	TPixelOut *b = matlabExport->
+	  AllocateUninitialisedNDArrayInMatlab<TPixelOut>(outB, im.size);
+	std::copy(mrf.GetLabels().begin(), mrf.GetLabels().end(), b);
+      }
+
+      // convergence statistics, one row per iteration
+      if (outSTATS->isRequested) {
+	double *stats = matlabExport->
+	  AllocateMatrixInMatlab<double>(outSTATS, changed.size(), 2);
+	for (mwIndex i = 0; i < changed.size(); ++i) {
+	  stats[i] = (double)changed[i];
+	  stats[i + changed.size()] = energy[i];
+	}
+      }
+
+      return;
+    }
+
+    // itk::MRFImageFilter doesn't provide statistics per iteration
+    if (outSTATS->isRequested) {
+      matlabExport->AllocateMatrixInMatlab<double>(outSTATS, 0, 2);
+    }
+
+    filter->SetMRFNeighborhoodWeight(weights);
+    
+    // ITK guide: "Finally, the classifier class is connected to the Markof Random Fields filter."
+    filter->SetClassifier(classifier);
+
+    // connect Matlab inputs to ITK filter
+    filter->SetInput(scalarToArrayFilter->GetOutput());
+    
+    // connect ITK filter outputs to Matlab outputs
+    matlabExport->GraftItkImageOntoMatlab<TPixelOut, VImageDimension>
+      (outB, filter->GetOutputs()[0], im.size);
+
+    // run filter
+    filter->Update();
+
+  }
+};
+
+// add the filter to the registry of itk_imfilter()
+void RegisterMRFImageFilter(FilterRegistry &registry) {
+
+  registry.AddFilter("mrf", "MRFImageFilter");
+  AddFilterWrapperAllTypesAndDimensions<MRFImageFilterWrapper>(registry, "mrf");
+
+}
+
+#endif /* MEXMRFIMAGEFILTER_CPP */
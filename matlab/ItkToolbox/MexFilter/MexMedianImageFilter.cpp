@@ -0,0 +1,230 @@
+/* MexMedianImageFilter.cpp
+ *
+ * itk_imfilter() wrapper for itk::MedianImageFilter, and the sliding
+ * histogram median in HistogramMedian.h for 8 and 16 bit integer
+ * images.
+ *
+ * See ItkImFilter.cpp or itk_imfilter.m for help.
+ */
+
+ /*
+  * Author: Ramon Casero <rcasero@gmail.com>
+  * Copyright © 2011-2014 University of Oxford
+  * Version: 0.1.1
+  *
+  * University of Oxford means the Chancellor, Masters and Scholars of
+  * the University of Oxford, having an administrative office at
+  * Wellington Square, Oxford OX1 2JD, UK. 
+  *
+  * This file is part of Gerardus.
+  *
+  * This program is free software: you can redistribute it and/or modify
+  * it under the terms of the GNU General Public License as published by
+  * the Free Software Foundation, either version 3 of the License, or
+  * (at your option) any later version.
+  *
+  * This program is distributed in the hope that it will be useful,
+  * but WITHOUT ANY WARRANTY; without even the implied warranty of
+  * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  * GNU General Public License for more details. The offer of this
+  * program under the terms of the License is subject to the License
+  * being interpreted in accordance with English Law and subject to any
+  * action against the University of Oxford being under the jurisdiction
+  * of the English Courts.
+  *
+  * You should have received a copy of the GNU General Public License
+  * along with this program.  If not, see
+  * <http://www.gnu.org/licenses/>.
+  */
+
+#ifndef MEXMEDIANIMAGEFILTER_CPP
+#define MEXMEDIANIMAGEFILTER_CPP
+
+#ifdef _MSC_VER
+#pragma warning ( disable : 4786 )
+#endif
+
+/* mex headers */
+#include <mex.h>
+
+/* C++ headers */
+#include <vector>
+
+/* ITK headers */
+#include "itkImage.h"
+#include "itkMedianImageFilter.h"
+
+/* Gerardus headers */
+#include "MexFilterRegistry.h"
+#include "HistogramMedian.h"
+
+// MedianImageFilter
+template <class TPixelIn, unsigned int VImageDimension>
+class MedianImageFilterWrapper {
+public:
+  
+  MedianImageFilterWrapper(MatlabImportFilter::Pointer matlabImport,
+			   MatlabExportFilter::Pointer matlabExport,
+			   MatlabImageHeader &im) {
+    
+    // inputs/outputs interfaces
+    enum InputIndexType {IN_TYPE, IN_A, IN_RADIUS, InputIndexType_MAX};
+    enum OutputIndexType {OUT_B, OutputIndexType_MAX};
+    
+    // check number of input and output arguments
+    matlabImport->CheckNumberOfArguments(2, InputIndexType_MAX);
+    matlabExport->CheckNumberOfArguments(0, OutputIndexType_MAX);
+    
+    // get pointer to image input
+    MatlabInputPointer inA      = matlabImport->GetRegisteredInput("A");
+  
+    // register the inputs exclusive to this function
+    MatlabInputPointer inRADIUS = matlabImport->RegisterInput(IN_RADIUS, "RADIUS");
+
+    // register the outputs for this function at the export filter
+    typedef MatlabExportFilter::MatlabOutputPointer MatlabOutputPointer;
+    MatlabOutputPointer outB = matlabExport->RegisterOutput(OUT_B, "B");
+
+    // instantiate the filter
+    typedef TPixelIn TPixelOut;
+    typedef typename itk::Image<TPixelIn, VImageDimension> InImageType;
+    typedef InImageType OutImageType;
+    typedef itk::MedianImageFilter<InImageType, OutImageType>
+      FilterType;
+    typename FilterType::Pointer filter = FilterType::New();
+    
+    // connect Matlab inputs to ITK filter
+    filter->SetInput(matlabImport->
+		     GetImagePointerFromMatlab<TPixelIn, VImageDimension>(inA));
+    
+    // set half size of the filter's box
+    typedef typename itk::BoxImageFilter<
+      itk::Image<TPixelIn, VImageDimension>,
+      itk::Image<TPixelOut, VImageDimension> > BoxFilterType;
+    typename BoxFilterType::RadiusType radius;
+    radius.Fill(0);
+    filter->SetRadius(matlabImport->
+		      ReadRowVectorFromMatlab<typename BoxFilterType::RadiusValueType, 
+					      typename BoxFilterType::RadiusType>(inRADIUS, radius));
+    
+    // graft ITK filter outputs onto Matlab outputs
+    matlabExport->GraftItkImageOntoMatlab<TPixelOut, VImageDimension>
+      (outB, filter->GetOutputs()[0], im.size);
+
+    // run filter
+    filter->Update();
+
+  }
+};
+
+// MedianImageFilter for 8 and 16 bit integer images
+//
+// itk::MedianImageFilter sorts the whole box around each voxel. For
+// these pixel types, the median is computed instead with the sliding
+// histogram in HistogramMedian.h directly on the Matlab buffers. The
+// result is the same
+template <class TPixelIn, unsigned int VImageDimension>
+void RunHistogramMedian(MatlabImportFilter::Pointer matlabImport,
+			MatlabExportFilter::Pointer matlabExport,
+			MatlabImageHeader &im) {
+
+  // inputs/outputs interfaces
+  enum InputIndexType {IN_TYPE, IN_A, IN_RADIUS, InputIndexType_MAX};
+  enum OutputIndexType {OUT_B, OutputIndexType_MAX};
+
+  // check number of input and output arguments
+  matlabImport->CheckNumberOfArguments(2, InputIndexType_MAX);
+  matlabExport->CheckNumberOfArguments(0, OutputIndexType_MAX);
+
+  // register the inputs exclusive to this function
+  MatlabInputPointer inRADIUS = matlabImport->RegisterInput(IN_RADIUS, "RADIUS");
+
+  // register the outputs for this function at the export filter
+  typedef MatlabExportFilter::MatlabOutputPointer MatlabOutputPointer;
+  MatlabOutputPointer outB = matlabExport->RegisterOutput(OUT_B, "B");
+
+  // half size of the filter's box, read the same way as for the ITK
+  // filter
+  typedef typename itk::BoxImageFilter<
+    itk::Image<TPixelIn, VImageDimension>,
+    itk::Image<TPixelIn, VImageDimension> > BoxFilterType;
+  typename BoxFilterType::RadiusType radiusDef;
+  radiusDef.Fill(0);
+  typename BoxFilterType::RadiusType radiusItk = matlabImport->
+    ReadRowVectorFromMatlab<typename BoxFilterType::RadiusValueType, 
+			    typename BoxFilterType::RadiusType>(inRADIUS, radiusDef);
+  std::vector<mwSize> radius(im.size.size(), 0);
+  for (size_t d = 0; d < radius.size() && d < VImageDimension; ++d) {
+    radius[d] = radiusItk[d];
+  }
+
+  if (!outB->isRequested) {
+    return;
+  }
+  TPixelIn *b = matlabExport->
+    AllocateUninitialisedNDArrayInMatlab<TPixelIn>(outB, im.size);
+
+  // run filter
+  HistogramMedian((const TPixelIn *)mxGetData(im.data), im.size, radius, b);
+
+}
+
+template <unsigned int VImageDimension>
+class MedianImageFilterWrapper<mxLogical, VImageDimension> {
+public:
+  MedianImageFilterWrapper(MatlabImportFilter::Pointer matlabImport,
+			   MatlabExportFilter::Pointer matlabExport,
+			   MatlabImageHeader &im) {
+    RunHistogramMedian<mxLogical, VImageDimension>(matlabImport, matlabExport, im);
+  }
+};
+
+template <unsigned int VImageDimension>
+class MedianImageFilterWrapper<uint8_T, VImageDimension> {
+public:
+  MedianImageFilterWrapper(MatlabImportFilter::Pointer matlabImport,
+			   MatlabExportFilter::Pointer matlabExport,
+			   MatlabImageHeader &im) {
+    RunHistogramMedian<uint8_T, VImageDimension>(matlabImport, matlabExport, im);
+  }
+};
+
+template <unsigned int VImageDimension>
+class MedianImageFilterWrapper<int8_T, VImageDimension> {
+public:
+  MedianImageFilterWrapper(MatlabImportFilter::Pointer matlabImport,
+			   MatlabExportFilter::Pointer matlabExport,
+			   MatlabImageHeader &im) {
+    RunHistogramMedian<int8_T, VImageDimension>(matlabImport, matlabExport, im);
+  }
+};
+
+template <unsigned int VImageDimension>
+class MedianImageFilterWrapper<uint16_T, VImageDimension> {
+public:
+  MedianImageFilterWrapper(MatlabImportFilter::Pointer matlabImport,
+			   MatlabExportFilter::Pointer matlabExport,
+			   MatlabImageHeader &im) {
+    RunHistogramMedian<uint16_T, VImageDimension>(matlabImport, matlabExport, im);
+  }
+};
+
+template <unsigned int VImageDimension>
+class MedianImageFilterWrapper<int16_T, VImageDimension> {
+public:
+  MedianImageFilterWrapper(MatlabImportFilter::Pointer matlabImport,
+			   MatlabExportFilter::Pointer matlabExport,
+			   MatlabImageHeader &im) {
+    RunHistogramMedian<int16_T, VImageDimension>(matlabImport, matlabExport, im);
+  }
+};
+
+// add the filter to the registry of itk_imfilter()
+void RegisterMedianImageFilter(FilterRegistry &registry) {
+
+  registry.AddFilter("median", "MedianImageFilter");
+  AddFilterWrapperAllTypesAndDimensions<MedianImageFilterWrapper>(registry, "median");
+
+}
+
+#endif /* MEXMEDIANIMAGEFILTER_CPP */
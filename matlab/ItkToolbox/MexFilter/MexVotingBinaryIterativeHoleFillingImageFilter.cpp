@@ -0,0 +1,149 @@
+/* MexVotingBinaryIterativeHoleFillingImageFilter.cpp
+ *
+ * itk_imfilter() wrapper for itk::VotingBinaryIterativeHoleFillingImageFilter.
+ *
+ * The filter is run by Gerardus' VotingHoleFilling, that gives the
+ * same result, but only evaluates the background voxels that can
+ * change in each iteration.
+ *
+ * See ItkImFilter.cpp or itk_imfilter.m for help.
+ */
+
+ /*
+  * Author: Ramon Casero <rcasero@gmail.com>
+  * Copyright © 2011-2014 University of Oxford
+  * Version: 0.2.0
+  *
+  * University of Oxford means the Chancellor, Masters and Scholars of
+  * the University of Oxford, having an administrative office at
+  * Wellington Square, Oxford OX1 2JD, UK. 
+  *
+  * This file is part of Gerardus.
+  *
+  * This program is free software: you can redistribute it and/or modify
+  * it under the terms of the GNU General Public License as published by
+  * the Free Software Foundation, either version 3 of the License, or
+  * (at your option) any later version.
+  *
+  * This program is distributed in the hope that it will be useful,
+  * but WITHOUT ANY WARRANTY; without even the implied warranty of
+  * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  * GNU General Public License for more details. The offer of this
+  * program under the terms of the License is subject to the License
+  * being interpreted in accordance with English Law and subject to any
+  * action against the University of Oxford being under the jurisdiction
+  * of the English Courts.
+  *
+  * You should have received a copy of the GNU General Public License
+  * along with this program.  If not, see
+  * <http://www.gnu.org/licenses/>.
+  */
+
+#ifndef MEXVOTINGBINARYITERATIVEHOLEFILLINGIMAGEFILTER_CPP
+#define MEXVOTINGBINARYITERATIVEHOLEFILLINGIMAGEFILTER_CPP
+
+#ifdef _MSC_VER
+#pragma warning ( disable : 4786 )
+#endif
+
+/* mex headers */
+#include <mex.h>
+
+/* C++ headers */
+#include <algorithm>
+#include <vector>
+
+/* ITK headers */
+#include "itkImage.h"
+
+/* Gerardus headers */
+#include "MexFilterRegistry.h"
+#include "VotingHoleFilling.h"
+
+// VotingBinaryIterativeHoleFillingImageFilter
+template <class TPixelIn, unsigned int VImageDimension>
+class VotingBinaryIterativeHoleFillingImageFilterWrapper {
+
+public:
+  
+  VotingBinaryIterativeHoleFillingImageFilterWrapper(MatlabImportFilter::Pointer matlabImport,
+						     MatlabExportFilter::Pointer matlabExport,
+						     MatlabImageHeader &im) {
+    
+    // inputs/outputs interfaces
+    enum InputIndexType {IN_TYPE, IN_A, IN_RADIUS, IN_MAXITER, IN_THR, 
+			 IN_BACKGROUND, IN_FOREGROUND, InputIndexType_MAX};
+    enum OutputIndexType {OUT_B, OutputIndexType_MAX};
+    
+    // check number of input and output arguments
+    matlabImport->CheckNumberOfArguments(2, InputIndexType_MAX);
+    matlabExport->CheckNumberOfArguments(0, OutputIndexType_MAX);
+
+    // get pointer to image input
+    MatlabInputPointer inA          = matlabImport->GetRegisteredInput("A");
+  
+    // register the inputs exclusive to this function
+    MatlabInputPointer inRADIUS     = matlabImport->RegisterInput(IN_RADIUS, "RADIUS");
+    MatlabInputPointer inMAXITER    = matlabImport->RegisterInput(IN_MAXITER, "MAXITER");
+    MatlabInputPointer inTHR        = matlabImport->RegisterInput(IN_THR, "THR");
+    MatlabInputPointer inBACKGROUND = matlabImport->RegisterInput(IN_BACKGROUND, "BACKGROUND");
+    MatlabInputPointer inFOREGROUND = matlabImport->RegisterInput(IN_FOREGROUND, "FOREGROUND");
+
+    // register the outputs for this function at the export filter
+    typedef MatlabExportFilter::MatlabOutputPointer MatlabOutputPointer;
+    MatlabOutputPointer outB = matlabExport->RegisterOutput(OUT_B, "B");
+
+    // image type, used for the radius
+    typedef TPixelIn TPixelOut;
+    typedef typename itk::Image<TPixelIn, VImageDimension> InImageType;
+
+    // default parameters
+    typename InImageType::SizeType radiusDef;
+    radiusDef.Fill(1);
+
+    // filter parameters
+    typename InImageType::SizeType radiusItk = matlabImport->template
+      ReadRowVectorFromMatlab<typename InImageType::SizeValueType,
+			      typename InImageType::SizeType>(inRADIUS, radiusDef);
+    unsigned int maxIter = matlabImport->template
+      ReadScalarFromMatlab<unsigned int>(inMAXITER, 1);
+    unsigned int majorityThreshold = matlabImport->template
+      ReadScalarFromMatlab<unsigned int>(inTHR, 2);
+    TPixelIn background = matlabImport->template
+      ReadScalarFromMatlab<TPixelIn>(inBACKGROUND, 0);
+    TPixelIn foreground = matlabImport->template
+      ReadScalarFromMatlab<TPixelIn>(inFOREGROUND, 1);
+
+    if (!outB->isRequested) {
+      return;
+    }
+
+    std::vector<mwSize> radius(VImageDimension);
+    for (unsigned int d = 0; d < VImageDimension; ++d) {
+      radius[d] = radiusItk[d];
+    }
+
+    // the holes are filled in place in the output, initialised with a
+    // copy of the input
+    mwSize n = mxGetNumberOfElements(im.data);
+    const TPixelIn *a = (const TPixelIn *)mxGetData(im.data);
+    TPixelOut *b = matlabExport->
+      AllocateUninitialisedNDArrayInMatlab<TPixelOut>(outB, im.size);
+    std::copy(a, a + n, b);
+
+    // run filter
+    VotingHoleFilling holeFilling(im.size, radius, majorityThreshold);
+    holeFilling.Run(b, background, foreground, maxIter);
+
+  }
+};
+
+// add the filter to the registry of itk_imfilter()
+void RegisterVotingBinaryIterativeHoleFillingImageFilter(FilterRegistry &registry) {
+
+  registry.AddFilter("voteholefill", "VotingBinaryIterativeHoleFillingImageFilter");
+  AddFilterWrapperAllTypesAndDimensions<VotingBinaryIterativeHoleFillingImageFilterWrapper>(registry, "voteholefill");
+
+}
+
+#endif /* MEXVOTINGBINARYITERATIVEHOLEFILLINGIMAGEFILTER_CPP */
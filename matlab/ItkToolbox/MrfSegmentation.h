@@ -0,0 +1,593 @@
+/*
+ * MrfSegmentation.h
+ *
+ * MrfSegmentation: Markov Random Field (MRF) segmentation of a 2D, 3D
+ * or 4D image stored in a Matlab buffer, with the same model as
+ * itk::MRFImageFilter with a DistanceToCentroidMembershipFunction per
+ * class.
+ *
+ * Each voxel i is given the label k that minimises
+ *
+ *   E_i(k) = |x_i - mu_k| - sum_j w_j [l(i+j) == k] - w_0 [l(i) == k]
+ *
+ * where mu_k are the class centroids, w_j are the weights of the
+ * neighbourhood (a box around the voxel), and w_0 is the weight of the
+ * central element of the box. As in itk::MRFImageFilter, w_0 favours
+ * the current label of the voxel. This corresponds to the global
+ * energy
+ *
+ *   E = sum_i |x_i - mu_l(i)| + 1/2 sum_i sum_j w_j [l(i) != l(i+j)]
+ *
+ * up to the constant term -n w_0. Thus, w_0 slows down the changes of
+ * ICM, but it does not change the result of alpha-expansion.
+ *
+ * Labels are initialised to the closest centroid, and then the energy
+ * is minimised with one of two methods:
+ *
+ *   Iterated Conditional Modes (ICM): each sweep relabels each voxel
+ *   with its best label given its neighbours' labels, like
+ *   itk::MRFImageFilter. Instead of a raster sweep, voxels are split
+ *   into colours such that no two voxels of the same colour are
+ *   neighbours, and each colour is relabelled in parallel with OpenMP.
+ *   For neighbourhoods where only the face neighbours have non-zero
+ *   weights (e.g. 6-connectivity in 3D), this is the red-black
+ *   checkerboard. Otherwise, voxels are coloured by blocks of
+ *   (halfSize+1) voxels in each dimension.
+ *
+ *   Alpha-expansion (Boykov, Veksler and Zabih): each cycle tries to
+ *   expand each label alpha with a graph cut that finds the optimal
+ *   set of voxels that switch to alpha. This finds better optima than
+ *   ICM, but needs memory for a graph with one vertex per voxel and
+ *   one edge per pair of neighbours, and is not parallel.
+ *
+ * Class costs |x_i - mu_k| are precomputed once, in a flat array.
+ * Voxels outside the image take the label of the closest voxel inside,
+ * like in itk::MRFImageFilter.
+ *
+ *   Y. Boykov, O. Veksler and R. Zabih, "Fast approximate energy
+ *   minimization via graph cuts", IEEE Transactions on Pattern Analysis
+ *   and Machine Intelligence, 23(11):1222-1239, 2001.
+ *
+ *   V. Kolmogorov and R. Zabih, "What energy functions can be
+ *   minimized via graph cuts?", IEEE Transactions on Pattern Analysis
+ *   and Machine Intelligence, 26(2):147-159, 2004.
+ *
+ * An example of how to use this class in a MEX Matlab function:
+ *
+ *   MrfSegmentation mrf(im.size, halfSize, weights);
+ *   mrf.SetDataCosts((float *)mxGetData(im.data), mu);
+ *   std::vector<mwSize> changed;
+ *   std::vector<double> energy;
+ *   mrf.Run(MrfSegmentation::ICM, 100, 1e-7, changed, energy);
+ *   const std::vector<uint8_T> &labels = mrf.GetLabels();
+ *
+ */
+
+/*
+ * Author: Ramon Casero <rcasero@gmail.com>
+ * Copyright © 2014 University of Oxford
+ * Version: 0.1.1
+ *
+ * University of Oxford means the Chancellor, Masters and Scholars of
+ * the University of Oxford, having an administrative office at
+ * Wellington Square, Oxford OX1 2JD, UK.
+ *
+ * This file is part of Gerardus.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details. The offer of this
+ * program under the terms of the License is subject to the License
+ * being interpreted in accordance with English Law and subject to any
+ * action against the University of Oxford being under the jurisdiction
+ * of the English Courts.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see
+ * <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MRFSEGMENTATION_H
+#define MRFSEGMENTATION_H
+
+/* mex headers */
+#include <mex.h>
+
+/* C++ headers */
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+/* Boost headers */
+#include <boost/graph/adjacency_list.hpp>
+#include <boost/graph/boykov_kolmogorov_max_flow.hpp>
+
+/* Gerardus headers */
+#include "GerardusCommon.h"
+
+class MrfSegmentation {
+
+ public:
+
+  enum MethodType {ICM, EXPANSION};
+
+  // size:     size of the image in Matlab order (row, column, slice, ...)
+  // halfSize: half size of the neighbourhood box in each dimension
+  // weights:  weights of the neighbourhood box, with size
+  //           (2*halfSize+1) and the first dimension running fastest
+  MrfSegmentation(const std::vector<mwSize> &_size,
+		  const std::vector<mwSize> &_halfSize,
+		  const std::vector<double> &weights);
+
+  mwSize GetNumberOfVoxels() const {
+    return this->n;
+  }
+
+  // compute the cost of each class in each voxel, |x_i - mu_k|, and
+  // initialise each voxel to the class with the lowest cost
+  template <class TPixel>
+  void SetDataCosts(const TPixel *im, const std::vector<double> &mu);
+
+  // energy of the current labelling
+  double ComputeEnergy() const;
+
+  // one ICM sweep or one alpha-expansion cycle. Returns the number of
+  // voxels that changed label
+  mwSize IterateICM();
+  mwSize IterateExpansion();
+
+  // iterate until the fraction of voxels that change label is below
+  // tol, or maxIter iterations. The number of voxels that changed and
+  // the energy after each iteration are returned in changed, energy
+  void Run(MethodType method, unsigned int maxIter, double tol,
+	   std::vector<mwSize> &changed, std::vector<double> &energy);
+
+  // labels 0, 1, ..., numberOfClasses-1
+  const std::vector<uint8_T> &GetLabels() const {
+    return this->labels;
+  }
+
+ private:
+
+  std::vector<mwSize> size;
+  std::vector<mwSize> halfSize;
+  size_t ndim;
+  mwSize n;
+  mwSize K;                       // number of classes
+
+  // neighbours with non-zero weight
+  std::vector<std::vector<mwSignedIndex> > nbOffset;  // offset in each dimension
+  std::vector<mwSignedIndex> nbLinearOffset;          // offset in the buffer
+  std::vector<double> nbWeight;
+
+  // weight of the central voxel
+  double centreWeight;
+
+  // colours for parallel ICM. If isCheckerboard (only face
+  // neighbours), there are 2 colours given by the parity of the sum of
+  // the subscripts. Otherwise, the colour is given by the subscripts
+  // modulo (halfSize+1)
+  bool isCheckerboard;
+  mwSize numberOfColours;
+
+  std::vector<double> cost;       // cost[i*K + k]: cost of class k in voxel i
+  std::vector<uint8_T> labels;
+
+  // subscripts of voxel i
+  void Subscripts(mwIndex i, mwSignedIndex *sub) const {
+    for (size_t d = 0; d < this->ndim; ++d) {
+      sub[d] = i % this->size[d];
+      i /= this->size[d];
+    }
+  }
+
+  // whether the whole neighbourhood of voxel with subscripts sub is
+  // within the image
+  bool IsInterior(const mwSignedIndex *sub) const {
+    for (size_t d = 0; d < this->ndim; ++d) {
+      if (sub[d] < (mwSignedIndex)this->halfSize[d]
+	  || sub[d] + (mwSignedIndex)this->halfSize[d] >= (mwSignedIndex)this->size[d]) {
+	return false;
+      }
+    }
+    return true;
+  }
+
+  // linear index of the j-th neighbour of voxel i, clamped to the
+  // image
+  mwIndex Neighbour(mwIndex i, const mwSignedIndex *sub, bool isInterior,
+		    size_t j) const {
+    if (isInterior) {
+      return (mwIndex)((mwSignedIndex)i + this->nbLinearOffset[j]);
+    }
+    mwIndex idx = 0;
+    mwSize stride = 1;
+    for (size_t d = 0; d < this->ndim; ++d) {
+      mwSignedIndex s = sub[d] + this->nbOffset[j][d];
+      s = std::max((mwSignedIndex)0, std::min((mwSignedIndex)this->size[d] - 1, s));
+      idx += s * stride;
+      stride *= this->size[d];
+    }
+    return idx;
+  }
+
+};
+
+inline
+MrfSegmentation::MrfSegmentation(const std::vector<mwSize> &_size,
+				 const std::vector<mwSize> &_halfSize,
+				 const std::vector<double> &weights)
+  : size(_size), halfSize(_halfSize), ndim(_size.size()), K(0),
+    centreWeight(0.0), isCheckerboard(true) {
+
+  if (this->halfSize.size() != this->ndim) {
+    mexErrMsgTxt("MrfSegmentation: Neighbourhood must have the same dimension as the image");
+  }
+
+  this->n = 1;
+  mwSize nbLength = 1;
+  for (size_t d = 0; d < this->ndim; ++d) {
+    this->n *= this->size[d];
+    nbLength *= 2 * this->halfSize[d] + 1;
+  }
+  if (weights.size() != nbLength) {
+    mexErrMsgTxt("MrfSegmentation: Number of weights does not match the size of the neighbourhood");
+  }
+
+  // list of neighbours with non-zero weight. The central voxel is not
+  // a neighbour, and its weight is kept apart
+  std::vector<mwSignedIndex> offset(this->ndim);
+  for (mwIndex j = 0; j < nbLength; ++j) {
+    mwIndex r = j;
+    mwSignedIndex linearOffset = 0;
+    mwSize stride = 1;
+    bool isCentre = true;
+    mwSize l1 = 0;
+    for (size_t d = 0; d < this->ndim; ++d) {
+      offset[d] = (mwSignedIndex)(r % (2 * this->halfSize[d] + 1))
+	- (mwSignedIndex)this->halfSize[d];
+      r /= 2 * this->halfSize[d] + 1;
+      linearOffset += offset[d] * (mwSignedIndex)stride;
+      stride *= this->size[d];
+      isCentre = isCentre && (offset[d] == 0);
+      l1 += (offset[d] < 0) ? -offset[d] : offset[d];
+    }
+    if (isCentre) {
+      this->centreWeight = weights[j];
+      continue;
+    }
+    if (weights[j] == 0.0) {
+      continue;
+    }
+    this->nbOffset.push_back(offset);
+    this->nbLinearOffset.push_back(linearOffset);
+    this->nbWeight.push_back(weights[j]);
+
+    // voxels with the same parity are not face neighbours, but they
+    // can be neighbours in any other way
+    if (l1 != 1) {
+      this->isCheckerboard = false;
+    }
+  }
+
+  if (this->isCheckerboard) {
+    this->numberOfColours = 2;
+  } else {
+    this->numberOfColours = 1;
+    for (size_t d = 0; d < this->ndim; ++d) {
+      this->numberOfColours *= this->halfSize[d] + 1;
+    }
+  }
+
+}
+
+template <class TPixel>
+void MrfSegmentation::SetDataCosts(const TPixel *im, const std::vector<double> &mu) {
+
+  this->K = mu.size();
+  if (this->K == 0) {
+    mexErrMsgTxt("MrfSegmentation: At least one class centroid must be provided");
+  }
+  if (this->K > 256) {
+    mexErrMsgTxt("MrfSegmentation: At most 256 classes can be used");
+  }
+
+  this->cost.resize(this->n * this->K);
+  this->labels.resize(this->n);
+
+#ifdef _OPENMP
+#pragma omp parallel for schedule(static)
+#endif
+  for (mwSignedIndex i = 0; i < (mwSignedIndex)this->n; ++i) {
+    double *c = &this->cost[i * this->K];
+    mwIndex best = 0;
+    for (mwIndex k = 0; k < this->K; ++k) {
+      c[k] = std::abs((double)im[i] - mu[k]);
+      if (c[k] < c[best]) {
+	best = k;
+      }
+    }
+    this->labels[i] = (uint8_T)best;
+  }
+
+}
+
+inline
+double MrfSegmentation::ComputeEnergy() const {
+
+  double energy = 0.0;
+
+#ifdef _OPENMP
+#pragma omp parallel
+#endif
+  {
+    std::vector<mwSignedIndex> sub(this->ndim);
+
+#ifdef _OPENMP
+#pragma omp for schedule(static) reduction(+:energy)
+#endif
+    for (mwSignedIndex i = 0; i < (mwSignedIndex)this->n; ++i) {
+      this->Subscripts(i, &sub[0]);
+      const bool isInterior = this->IsInterior(&sub[0]);
+      const uint8_T l = this->labels[i];
+      energy += this->cost[i * this->K + l];
+      for (size_t j = 0; j < this->nbWeight.size(); ++j) {
+	if (this->labels[this->Neighbour(i, &sub[0], isInterior, j)] != l) {
+	  energy += 0.5 * this->nbWeight[j];
+	}
+      }
+    }
+  }
+
+  return energy;
+}
+
+inline
+mwSize MrfSegmentation::IterateICM() {
+
+  const mwSize nx = this->size[0];
+  const mwSize nrows = this->n / nx;
+  mwSize changed = 0;
+
+  for (mwIndex colour = 0; colour < this->numberOfColours; ++colour) {
+
+#ifdef _OPENMP
+#pragma omp parallel
+#endif
+    {
+      std::vector<mwSignedIndex> sub(this->ndim);
+      std::vector<double> score(this->K);
+
+#ifdef _OPENMP
+#pragma omp for schedule(static) reduction(+:changed)
+#endif
+      for (mwSignedIndex row = 0; row < (mwSignedIndex)nrows; ++row) {
+
+	// subscripts of the row in dimensions 1, 2, ...
+	this->Subscripts((mwIndex)row * nx, &sub[0]);
+
+	// voxels of this colour in the row
+	mwSignedIndex x0;
+	mwSignedIndex step;
+	if (this->isCheckerboard) {
+	  mwSignedIndex s = 0;
+	  for (size_t d = 1; d < this->ndim; ++d) {
+	    s += sub[d];
+	  }
+	  x0 = (mwSignedIndex)((colour + s) % 2);
+	  step = 2;
+	} else {
+	  mwIndex c = colour;
+	  x0 = c % (this->halfSize[0] + 1);
+	  step = this->halfSize[0] + 1;
+	  c /= this->halfSize[0] + 1;
+	  bool isColour = true;
+	  for (size_t d = 1; d < this->ndim; ++d) {
+	    isColour = isColour
+	      && ((mwIndex)sub[d] % (this->halfSize[d] + 1) == c % (this->halfSize[d] + 1));
+	    c /= this->halfSize[d] + 1;
+	  }
+	  if (!isColour) {
+	    continue;
+	  }
+	}
+
+	for (mwSignedIndex x = x0; x < (mwSignedIndex)nx; x += step) {
+
+	  const mwIndex i = (mwIndex)row * nx + x;
+	  sub[0] = x;
+	  const bool isInterior = this->IsInterior(&sub[0]);
+
+	  // cost of each class given the labels of the neighbours
+	  for (mwIndex k = 0; k < this->K; ++k) {
+	    score[k] = this->cost[i * this->K + k];
+	  }
+	  for (size_t j = 0; j < this->nbWeight.size(); ++j) {
+	    score[this->labels[this->Neighbour(i, &sub[0], isInterior, j)]]
+	      -= this->nbWeight[j];
+	  }
+	  score[this->labels[i]] -= this->centreWeight;
+
+	  // best class. In case of a tie, the lowest class is chosen, as
+	  // in itk::MRFImageFilter
+	  mwIndex best = 0;
+	  for (mwIndex k = 1; k < this->K; ++k) {
+	    if (score[k] < score[best]) {
+	      best = k;
+	    }
+	  }
+	  if (best != this->labels[i]) {
+	    this->labels[i] = (uint8_T)best;
+	    ++changed;
+	  }
+
+	}
+      }
+    }
+  }
+
+  return changed;
+}
+
+inline
+mwSize MrfSegmentation::IterateExpansion() {
+
+  // graph types for Boost's Boykov-Kolmogorov max-flow
+  typedef boost::adjacency_list_traits<boost::vecS, boost::vecS,
+				       boost::directedS> Traits;
+  typedef boost::adjacency_list<
+    boost::vecS, boost::vecS, boost::directedS,
+    boost::property<boost::vertex_index_t, long,
+    boost::property<boost::vertex_color_t, boost::default_color_type,
+    boost::property<boost::vertex_distance_t, long,
+    boost::property<boost::vertex_predecessor_t, Traits::edge_descriptor> > > >,
+    boost::property<boost::edge_capacity_t, double,
+    boost::property<boost::edge_residual_capacity_t, double,
+    boost::property<boost::edge_reverse_t, Traits::edge_descriptor> > > > Graph;
+  typedef Traits::edge_descriptor Edge;
+
+  std::vector<mwSignedIndex> sub(this->ndim);
+  std::vector<uint8_T> oldLabels;
+  mwSize changed = 0;
+  double energy = this->ComputeEnergy();
+
+  for (mwIndex alpha = 0; alpha < this->K; ++alpha) {
+
+    // exit if user pressed Ctrl+C
+    ctrlcCheckPoint(__FILE__, __LINE__);
+
+    // one vertex per voxel, plus source and sink. Voxels on the
+    // source side keep their label, voxels on the sink side switch to
+    // alpha
+    Graph g(this->n + 2);
+    const mwIndex source = this->n;
+    const mwIndex sink = this->n + 1;
+    boost::property_map<Graph, boost::edge_capacity_t>::type
+      capacity = boost::get(boost::edge_capacity, g);
+    boost::property_map<Graph, boost::edge_reverse_t>::type
+      reverse = boost::get(boost::edge_reverse, g);
+
+    // capacity of the terminal edges, cost of switching (s->i) or not
+    // switching (i->t)
+    std::vector<double> capSource(this->n);
+    std::vector<double> capSink(this->n);
+    for (mwIndex i = 0; i < this->n; ++i) {
+      capSource[i] = this->cost[i * this->K + alpha];
+      capSink[i] = this->cost[i * this->K + this->labels[i]];
+    }
+
+    // pairwise terms E(xi, xq) with xi, xq = 0 (keep label) or 1
+    // (switch to alpha), decomposed as in Kolmogorov and Zabih
+    for (mwIndex i = 0; i < this->n; ++i) {
+      this->Subscripts(i, &sub[0]);
+      const bool isInterior = this->IsInterior(&sub[0]);
+      for (size_t j = 0; j < this->nbWeight.size(); ++j) {
+	const mwIndex q = this->Neighbour(i, &sub[0], isInterior, j);
+	if (q == i) {
+	  continue;
+	}
+	const double w = 0.5 * this->nbWeight[j];
+	const double A = (this->labels[i] != this->labels[q]) ? w : 0.0;
+	const double B = (this->labels[i] != alpha) ? w : 0.0;
+	const double C = (alpha != this->labels[q]) ? w : 0.0;
+	const double cap = B + C - A;
+
+	// (C - A) xi
+	if (C - A > 0) {
+	  capSource[i] += C - A;
+	} else {
+	  capSink[i] += A - C;
+	}
+
+	// (D - C) xq, with D = 0
+	capSink[q] += C;
+
+	// (B + C - A - D) (1 - xi) xq
+	if (cap > 0) {
+	  Edge e, er;
+	  e = boost::add_edge(i, q, g).first;
+	  er = boost::add_edge(q, i, g).first;
+	  capacity[e] = cap;
+	  capacity[er] = 0.0;
+	  reverse[e] = er;
+	  reverse[er] = e;
+	}
+      }
+    }
+    for (mwIndex i = 0; i < this->n; ++i) {
+      Edge e, er;
+      e = boost::add_edge(source, i, g).first;
+      er = boost::add_edge(i, source, g).first;
+      capacity[e] = capSource[i];
+      capacity[er] = 0.0;
+      reverse[e] = er;
+      reverse[er] = e;
+      e = boost::add_edge(i, sink, g).first;
+      er = boost::add_edge(sink, i, g).first;
+      capacity[e] = capSink[i];
+      capacity[er] = 0.0;
+      reverse[e] = er;
+      reverse[er] = e;
+    }
+
+    // minimum cut
+    boost::boykov_kolmogorov_max_flow(g, source, sink);
+
+    // voxels not in the source tree switch to alpha
+    boost::property_map<Graph, boost::vertex_color_t>::type
+      color = boost::get(boost::vertex_color, g);
+    oldLabels = this->labels;
+    mwSize changedAlpha = 0;
+    for (mwIndex i = 0; i < this->n; ++i) {
+      if (boost::get(color, i) != boost::black_color
+	  && this->labels[i] != alpha) {
+	this->labels[i] = (uint8_T)alpha;
+	++changedAlpha;
+      }
+    }
+
+    // the expansion move never increases the energy, but we check it
+    // to protect against rounding errors
+    double newEnergy = this->ComputeEnergy();
+    if (newEnergy < energy) {
+      energy = newEnergy;
+      changed += changedAlpha;
+    } else {
+      this->labels = oldLabels;
+    }
+
+  }
+
+  return changed;
+}
+
+inline
+void MrfSegmentation::Run(MethodType method, unsigned int maxIter, double tol,
+			  std::vector<mwSize> &changed, std::vector<double> &energy) {
+
+  changed.clear();
+  energy.clear();
+
+  for (unsigned int iter = 0; iter < maxIter; ++iter) {
+
+    // exit if user pressed Ctrl+C
+    ctrlcCheckPoint(__FILE__, __LINE__);
+
+    mwSize c = (method == EXPANSION) ? this->IterateExpansion() : this->IterateICM();
+    changed.push_back(c);
+    energy.push_back(this->ComputeEnergy());
+
+    if (c == 0 || (double)c / (double)this->n < tol) {
+      break;
+    }
+  }
+
+}
+
+#endif /* MRFSEGMENTATION_H */
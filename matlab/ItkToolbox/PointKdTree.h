@@ -0,0 +1,290 @@
+/*
+ * PointKdTree.h
+ *
+ * PointKdTree: k-d tree for nearest neighbour queries on a fixed set
+ * of points.
+ *
+ * Points are split recursively at the median of the coordinate with
+ * the widest extent of the box, until each leaf has at most a few
+ * points. The points of each box are contiguous in memory, stored
+ * point by point. A query descends to the leaf that contains the
+ * query point first, and then visits the other side of each split
+ * only if the splitting plane is closer than the nearest point found
+ * so far. For points sampled from a surface, a query costs about
+ * log(n) box visits instead of the n distance computations of a brute
+ * force search.
+ *
+ * The tree is not modified by queries, so many points can be queried
+ * in parallel.
+ *
+ * An example of how to use this class in a MEX Matlab function:
+ *
+ *   // x: (n, 3)-matrix with the points, stored by columns
+ *   PointKdTree<3> tree(n, x);
+ *
+ *   // p: 3-vector with the query point
+ *   double dist2;
+ *   mwIndex idx = tree.FindNearest(p, dist2);
+ *
+ */
+
+/*
+ * Author: Ramon Casero <rcasero@gmail.com>
+ * Copyright © 2014 University of Oxford
+ * Version: 0.2.0
+ *
+ * University of Oxford means the Chancellor, Masters and Scholars of
+ * the University of Oxford, having an administrative office at
+ * Wellington Square, Oxford OX1 2JD, UK.
+ *
+ * This file is part of Gerardus.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details. The offer of this
+ * program under the terms of the License is subject to the License
+ * being interpreted in accordance with English Law and subject to any
+ * action against the University of Oxford being under the jurisdiction
+ * of the English Courts.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see
+ * <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef POINTKDTREE_H
+#define POINTKDTREE_H
+
+/* mex headers */
+#include <mex.h>
+
+/* C++ headers */
+#include <algorithm>
+#include <limits>
+#include <vector>
+
+template <unsigned int VDimension>
+class PointKdTree {
+
+ public:
+
+  // n: number of points
+  // x: (n, VDimension)-matrix with the points, stored by columns, as
+  //    in Matlab
+  template <class TScalar>
+  PointKdTree(mwSize n, const TScalar *x);
+
+  mwSize GetNumberOfPoints() const {
+    return this->index.size();
+  }
+
+  // p:     VDimension-vector with the query point
+  // dist2: squared distance from p to its nearest point
+  //
+  // returns the index of the nearest point, in the order of x
+  mwIndex FindNearest(const double *p, double &dist2) const;
+
+  // coordinates of point i, in the order of x
+  const double *GetPoint(mwIndex i) const {
+    return &this->point[this->position[i] * VDimension];
+  }
+
+  // p:     VDimension-vector with the query point
+  // x:     VDimension-vector with the nearest point
+  // dist2: squared distance from p to x
+  void FindClosestPoint(const double *p, double *x, double &dist2) const {
+    const double *xi = this->GetPoint(this->FindNearest(p, dist2));
+    std::copy(xi, xi + VDimension, x);
+  }
+
+ private:
+
+  // box of points in the tree
+  struct Node {
+    mwIndex begin, end;             // points in the box (tree order)
+    unsigned int splitDim;          // splitting coordinate
+    double splitValue;              // splitting plane
+    int child[2];                   // -1 if leaf
+  };
+
+  // points in tree order, VDimension coordinates per point, the index
+  // of each point in x, and the position in the tree of each point of x
+  std::vector<double> point;
+  std::vector<mwIndex> index;
+  std::vector<mwIndex> position;
+
+  std::vector<Node> tree;
+
+  // maximum number of points in a leaf
+  static const mwSize leafSize = 8;
+
+  // compare points by one of their coordinates
+  struct CoordinateLess {
+    const std::vector<double> &coord;
+    unsigned int d;
+    CoordinateLess(const std::vector<double> &_coord, unsigned int _d)
+      : coord(_coord), d(_d) {}
+    bool operator()(mwIndex i, mwIndex j) const {
+      return this->coord[i * VDimension + this->d] < this->coord[j * VDimension + this->d];
+    }
+  };
+
+  int BuildNode(const std::vector<double> &x, mwIndex begin, mwIndex end);
+  void SearchNode(int node, const double *p, mwIndex &best, double &dist2) const;
+
+};
+
+template <unsigned int VDimension>
+const mwSize PointKdTree<VDimension>::leafSize;
+
+/*
+ * Definitions
+ */
+
+template <unsigned int VDimension>
+template <class TScalar>
+PointKdTree<VDimension>::PointKdTree(mwSize n, const TScalar *x) {
+
+  if (n == 0) {
+    mexErrMsgTxt("PointKdTree: The tree needs at least one point");
+  }
+
+  // points stored point by point, in the order of x
+  std::vector<double> xp(n * VDimension);
+  for (mwIndex i = 0; i < n; ++i) {
+    for (unsigned int d = 0; d < VDimension; ++d) {
+      xp[i * VDimension + d] = (double)x[i + d * n];
+    }
+  }
+
+  // sort the points into boxes
+  this->index.resize(n);
+  for (mwIndex i = 0; i < n; ++i) {
+    this->index[i] = i;
+  }
+  this->tree.clear();
+  this->BuildNode(xp, 0, n);
+
+  // copy the points in tree order, so that the points of a leaf are
+  // contiguous
+  this->point.resize(n * VDimension);
+  this->position.resize(n);
+  for (mwIndex i = 0; i < n; ++i) {
+    std::copy(&xp[this->index[i] * VDimension], &xp[this->index[i] * VDimension] + VDimension,
+	      &this->point[i * VDimension]);
+    this->position[this->index[i]] = i;
+  }
+
+}
+
+template <unsigned int VDimension>
+int PointKdTree<VDimension>::BuildNode(const std::vector<double> &x,
+				       mwIndex begin, mwIndex end) {
+
+  int idx = (int)this->tree.size();
+  this->tree.push_back(Node());
+  this->tree[idx].begin = begin;
+  this->tree[idx].end = end;
+  this->tree[idx].splitDim = 0;
+  this->tree[idx].splitValue = 0.0;
+  this->tree[idx].child[0] = this->tree[idx].child[1] = -1;
+
+  if (end - begin <= leafSize) {
+    return idx;
+  }
+
+  // split along the widest coordinate of the box
+  double lo[VDimension], hi[VDimension];
+  for (unsigned int d = 0; d < VDimension; ++d) {
+    lo[d] = std::numeric_limits<double>::max();
+    hi[d] = -std::numeric_limits<double>::max();
+  }
+  for (mwIndex i = begin; i < end; ++i) {
+    const double *xi = &x[this->index[i] * VDimension];
+    for (unsigned int d = 0; d < VDimension; ++d) {
+      lo[d] = std::min(lo[d], xi[d]);
+      hi[d] = std::max(hi[d], xi[d]);
+    }
+  }
+  unsigned int splitDim = 0;
+  for (unsigned int d = 1; d < VDimension; ++d) {
+    if (hi[d] - lo[d] > hi[splitDim] - lo[splitDim]) {
+      splitDim = d;
+    }
+  }
+
+  // all points are the same, no point splitting the box
+  if (hi[splitDim] == lo[splitDim]) {
+    return idx;
+  }
+
+  // split at the median
+  mwIndex mid = begin + (end - begin) / 2;
+  std::nth_element(this->index.begin() + begin, this->index.begin() + mid,
+		   this->index.begin() + end, CoordinateLess(x, splitDim));
+  this->tree[idx].splitDim = splitDim;
+  this->tree[idx].splitValue = x[this->index[mid] * VDimension + splitDim];
+
+  // note: this->tree can be reallocated by the recursive calls
+  int child0 = this->BuildNode(x, begin, mid);
+  int child1 = this->BuildNode(x, mid, end);
+  this->tree[idx].child[0] = child0;
+  this->tree[idx].child[1] = child1;
+
+  return idx;
+
+}
+
+template <unsigned int VDimension>
+mwIndex PointKdTree<VDimension>::FindNearest(const double *p, double &dist2) const {
+
+  mwIndex best = 0;
+  dist2 = std::numeric_limits<double>::max();
+  this->SearchNode(0, p, best, dist2);
+
+  return this->index[best];
+
+}
+
+template <unsigned int VDimension>
+void PointKdTree<VDimension>::SearchNode(int node, const double *p,
+					 mwIndex &best, double &dist2) const {
+
+  const Node &box = this->tree[node];
+
+  // leaf: brute force search
+  if (box.child[0] < 0) {
+    for (mwIndex i = box.begin; i < box.end; ++i) {
+      const double *xi = &this->point[i * VDimension];
+      double d2 = 0.0;
+      for (unsigned int d = 0; d < VDimension; ++d) {
+	double delta = xi[d] - p[d];
+	d2 += delta * delta;
+      }
+      if (d2 < dist2) {
+	dist2 = d2;
+	best = i;
+      }
+    }
+    return;
+  }
+
+  // visit first the side of the plane that contains the point, and
+  // the other side only if the plane is closer than the nearest point
+  double delta = p[box.splitDim] - box.splitValue;
+  int nearChild = (delta < 0.0) ? box.child[0] : box.child[1];
+  int farChild = (delta < 0.0) ? box.child[1] : box.child[0];
+  this->SearchNode(nearChild, p, best, dist2);
+  if (delta * delta < dist2) {
+    this->SearchNode(farChild, p, best, dist2);
+  }
+
+}
+
+#endif /* POINTKDTREE_H */
@@ -0,0 +1,435 @@
+/*
+ * TriangleMeshRasterizer.h
+ *
+ * TriangleMeshRasterizer: scanline rasterization of a closed triangular
+ * mesh onto a 3D image grid, i.e. a voxel is set as inside if its
+ * centre is inside the mesh.
+ *
+ * Vertices are converted to voxel index coordinates (u, v, w) =
+ * (column, row, slice), so that voxel centres have integer
+ * coordinates. Each image row in each slice is a scanline along u.
+ * A scanline (v, w) crosses a triangle if the point (v, w) is inside
+ * the projection of the triangle onto the (v, w) plane. The crossing
+ * position along u is interpolated from the vertices. Voxel centres
+ * inside the mesh are those with an odd number of crossings at or
+ * before them (parity rule).
+ *
+ * Scanlines that go exactly through an edge or a vertex of the mesh
+ * are counted once, with the "top-left" rule of polygon rasterization:
+ * a point on an edge belongs to the triangle only if the edge is on
+ * the low-v or low-w side of the triangle. The edge function is always
+ * evaluated with the vertices of the edge in the same order, so that
+ * the two triangles that share an edge agree exactly on which side of
+ * the edge the scanline is. Crossings at the same position as a voxel
+ * centre are counted before the voxel. Thus, a voxel with its centre
+ * exactly on the surface is inside if the mesh is on its side of
+ * increasing column index or, if that is a tie, of increasing row
+ * index, and then slice index. Each voxel is classified the same way
+ * however the surface is triangulated.
+ *
+ * Triangles are binned by slice, and slices are rasterized in parallel
+ * with OpenMP. Each slice only visits the triangles that intersect it.
+ *
+ * Several meshes can be rasterized in the same pass onto a label
+ * image. The parity of each mesh is computed separately, and voxels
+ * that are inside more than one mesh get the label selected by a
+ * priority rule (the last mesh, the first mesh, the largest label or
+ * the smallest label).
+ *
+ * An example of how to use this class in a MEX Matlab function:
+ *
+ *   TriangleMeshRasterizer rasterizer(size, spacing, origin);
+ *   rasterizer.SetMesh(ntri, tri, nvert, x);
+ *   rasterizer.Rasterize(im, (uint8_T)1);
+ *
+ * or, for several meshes
+ *
+ *   rasterizer.AddMesh(ntri1, tri1, nvert1, x1);
+ *   rasterizer.AddMesh(ntri2, tri2, nvert2, x2);
+ *   rasterizer.Rasterize(im, labels, TriangleMeshRasterizer::MAX);
+ *
+ */
+
+/*
+ * Author: Ramon Casero <rcasero@gmail.com>
+ * Copyright © 2014 University of Oxford
+ * Version: 0.2.0
+ *
+ * University of Oxford means the Chancellor, Masters and Scholars of
+ * the University of Oxford, having an administrative office at
+ * Wellington Square, Oxford OX1 2JD, UK.
+ *
+ * This file is part of Gerardus.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details. The offer of this
+ * program under the terms of the License is subject to the License
+ * being interpreted in accordance with English Law and subject to any
+ * action against the University of Oxford being under the jurisdiction
+ * of the English Courts.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see
+ * <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef TRIANGLEMESHRASTERIZER_H
+#define TRIANGLEMESHRASTERIZER_H
+
+/* mex headers */
+#include <mex.h>
+
+/* C++ headers */
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+class TriangleMeshRasterizer {
+
+ public:
+
+  // size:    number of voxels in (row, column, slice) format
+  // spacing: voxel size in (row, column, slice) format
+  // origin:  coordinates of the centre of the first voxel, in (x, y, z)
+  //          format
+  TriangleMeshRasterizer(const mwSize *_size, const double *_spacing,
+			 const double *_origin);
+
+  // rule to select the label of voxels inside more than one mesh
+  enum PriorityType {LAST, FIRST, MAX, MIN};
+
+  // ntri:  number of triangles
+  // tri:   (ntri, 3)-matrix with the indices of the vertices of each
+  //        triangle, starting at 1
+  // nvert: number of vertices
+  // x:     (nvert, 3)-matrix with the (x, y, z) coordinates of the
+  //        vertices
+  //
+  // Matrices are stored by columns, as in Matlab.
+  //
+  // SetMesh() replaces all meshes by this one. AddMesh() adds the mesh
+  // to the ones already added, and returns its index
+  void SetMesh(mwSize ntri, const double *tri, mwSize nvert, const double *x);
+  mwIndex AddMesh(mwSize ntri, const double *tri, mwSize nvert, const double *x);
+
+  mwSize GetNumberOfMeshes() const {
+    return this->nmeshes;
+  }
+
+  // im:       output image, with the size given to the constructor
+  // inside:   value of the voxels inside any mesh
+  // labels:   value of the voxels inside each mesh
+  // priority: label of the voxels inside more than one mesh
+  //
+  // Voxels outside all meshes are set to 0
+  template <class TPixel>
+  void Rasterize(TPixel *im, TPixel inside) const;
+  template <class TPixel>
+  void Rasterize(TPixel *im, const TPixel *labels, PriorityType priority) const;
+
+ private:
+
+  mwSize size[3];
+  double spacing[3];
+  double origin[3];
+
+  // vertices in voxel index coordinates (column, row, slice)
+  std::vector<double> u, v, w;
+
+  // vertex indices of the triangles, ordered so that their projection
+  // onto the (v, w) plane is counter-clockwise. Triangles with a
+  // degenerate projection are parallel to the scanlines and are
+  // discarded
+  std::vector<mwIndex> tri;
+
+  // mesh each triangle belongs to
+  std::vector<mwIndex> triMesh;
+  mwSize nmeshes;
+
+  // edge function of the edge a->b at point p in the (v, w) plane,
+  // evaluated with the vertices in canonical order, so that it is
+  // exactly antisymmetric
+  static double EdgeFunction(double av, double aw, double bv, double bw,
+			     double pv, double pw);
+
+  // whether point p is on the inside side of the edge a->b of a
+  // counter-clockwise triangle, with the top-left rule for ties
+  static bool IsInsideEdge(double e, double av, double aw, double bv, double bw);
+
+  // write a label to a voxel, with the priority rule
+  template <class TPixel>
+  static void WriteLabel(TPixel &voxel, TPixel label, PriorityType priority);
+
+};
+
+/*
+ * Definitions
+ */
+
+inline
+TriangleMeshRasterizer::TriangleMeshRasterizer(const mwSize *_size,
+					       const double *_spacing,
+					       const double *_origin)
+  : nmeshes(0) {
+
+  for (unsigned int i = 0; i < 3; ++i) {
+    this->size[i] = _size[i];
+    this->spacing[i] = _spacing[i];
+    this->origin[i] = _origin[i];
+    if (!(_spacing[i] > 0.0)) {
+      mexErrMsgTxt("TriangleMeshRasterizer: Voxel size must be > 0");
+    }
+  }
+
+}
+
+inline
+double TriangleMeshRasterizer::EdgeFunction(double av, double aw, double bv, double bw,
+					    double pv, double pw) {
+
+  if (bv < av || (bv == av && bw < aw)) {
+    return -((av - bv) * (pw - bw) - (aw - bw) * (pv - bv));
+  } else {
+    return (bv - av) * (pw - aw) - (bw - aw) * (pv - av);
+  }
+
+}
+
+inline
+bool TriangleMeshRasterizer::IsInsideEdge(double e, double av, double aw,
+					  double bv, double bw) {
+
+  if (e > 0.0) {
+    return true;
+  } else if (e < 0.0) {
+    return false;
+  }
+
+  // the point is on the edge. The edge belongs to the triangle if it
+  // is on its low-v side (going down) or on its low-w side
+  // (horizontal, going right)
+  return (bw < aw) || (bw == aw && bv > av);
+
+}
+
+template <class TPixel>
+inline
+void TriangleMeshRasterizer::WriteLabel(TPixel &voxel, TPixel label,
+					PriorityType priority) {
+
+  switch (priority) {
+  case LAST:
+    voxel = label;
+    break;
+  case FIRST:
+    if (voxel == 0) {
+      voxel = label;
+    }
+    break;
+  case MAX:
+    if (label > voxel) {
+      voxel = label;
+    }
+    break;
+  case MIN:
+    if (voxel == 0 || label < voxel) {
+      voxel = label;
+    }
+    break;
+  }
+
+}
+
+inline
+void TriangleMeshRasterizer::SetMesh(mwSize ntri, const double *_tri,
+				     mwSize nvert, const double *x) {
+
+  this->u.clear();
+  this->v.clear();
+  this->w.clear();
+  this->tri.clear();
+  this->triMesh.clear();
+  this->nmeshes = 0;
+  this->AddMesh(ntri, _tri, nvert, x);
+
+}
+
+inline
+mwIndex TriangleMeshRasterizer::AddMesh(mwSize ntri, const double *_tri,
+					mwSize nvert, const double *x) {
+
+  const mwIndex mesh = this->nmeshes++;
+
+  // vertices in voxel index coordinates. Note that x changes with the
+  // columns and y with the rows
+  const mwIndex offset = this->u.size();
+  this->u.resize(offset + nvert);
+  this->v.resize(offset + nvert);
+  this->w.resize(offset + nvert);
+  for (mwIndex i = 0; i < nvert; ++i) {
+    this->u[offset + i] = (x[i] - this->origin[0]) / this->spacing[1];
+    this->v[offset + i] = (x[i + nvert] - this->origin[1]) / this->spacing[0];
+    this->w[offset + i] = (x[i + 2 * nvert] - this->origin[2]) / this->spacing[2];
+  }
+
+  // read triangles, and discard the ones parallel to the scanlines
+  this->tri.reserve(this->tri.size() + 3 * ntri);
+  for (mwIndex i = 0; i < ntri; ++i) {
+    mwIndex idx[3];
+    for (unsigned int j = 0; j < 3; ++j) {
+      double t = _tri[i + j * ntri];
+      if (!(t >= 1.0 && t <= (double)nvert) || t != std::floor(t)) {
+	mexErrMsgTxt("TriangleMeshRasterizer: Triangle vertex index out of range");
+      }
+      idx[j] = offset + (mwIndex)t - 1;
+    }
+    double det = (this->v[idx[1]] - this->v[idx[0]]) * (this->w[idx[2]] - this->w[idx[0]])
+      - (this->w[idx[1]] - this->w[idx[0]]) * (this->v[idx[2]] - this->v[idx[0]]);
+    if (det == 0.0) {
+      continue;
+    } else if (det < 0.0) {
+      std::swap(idx[1], idx[2]);
+    }
+    this->tri.push_back(idx[0]);
+    this->tri.push_back(idx[1]);
+    this->tri.push_back(idx[2]);
+    this->triMesh.push_back(mesh);
+  }
+
+  return mesh;
+
+}
+
+template <class TPixel>
+void TriangleMeshRasterizer::Rasterize(TPixel *im, TPixel inside) const {
+
+  std::vector<TPixel> labels(std::max(this->nmeshes, (mwSize)1), inside);
+  this->Rasterize(im, &labels[0], LAST);
+
+}
+
+template <class TPixel>
+void TriangleMeshRasterizer::Rasterize(TPixel *im, const TPixel *labels,
+				       PriorityType priority) const {
+
+  const mwSize nr = this->size[0];
+  const mwSize nc = this->size[1];
+  const mwSize ns = this->size[2];
+  const mwSize n = this->tri.size() / 3;
+
+  // bin triangles by the slices they intersect, in compressed format
+  std::vector<mwIndex> first(n), last(n);
+  std::vector<mwIndex> sliceBegin(ns + 1, 0);
+  for (mwIndex i = 0; i < n; ++i) {
+    const mwIndex *t = &this->tri[3 * i];
+    double wmin = std::min(this->w[t[0]], std::min(this->w[t[1]], this->w[t[2]]));
+    double wmax = std::max(this->w[t[0]], std::max(this->w[t[1]], this->w[t[2]]));
+    wmin = std::max(std::ceil(wmin), 0.0);
+    wmax = std::min(std::floor(wmax), (double)ns - 1.0);
+    if (wmin > wmax) {
+      first[i] = 1;
+      last[i] = 0;
+      continue;
+    }
+    first[i] = (mwIndex)wmin;
+    last[i] = (mwIndex)wmax;
+    for (mwIndex s = first[i]; s <= last[i]; ++s) {
+      ++sliceBegin[s + 1];
+    }
+  }
+  for (mwIndex s = 0; s < ns; ++s) {
+    sliceBegin[s + 1] += sliceBegin[s];
+  }
+  std::vector<mwIndex> sliceTri(sliceBegin[ns]);
+  std::vector<mwIndex> pos(sliceBegin.begin(), sliceBegin.end() - 1);
+  for (mwIndex i = 0; i < n; ++i) {
+    for (mwIndex s = first[i]; s <= last[i]; ++s) {
+      sliceTri[pos[s]++] = i;
+    }
+  }
+
+#ifdef _OPENMP
+#pragma omp parallel
+#endif
+  {
+    // crossings of each row of the slice with the meshes, as (mesh,
+    // position) pairs
+    typedef std::pair<mwIndex, double> CrossingType;
+    std::vector<std::vector<CrossingType> > crossings(nr);
+
+#ifdef _OPENMP
+#pragma omp for schedule(dynamic)
+#endif
+    for (mwSignedIndex s = 0; s < (mwSignedIndex)ns; ++s) {
+
+      TPixel *slice = im + s * nr * nc;
+      std::fill(slice, slice + nr * nc, (TPixel)0);
+      for (mwIndex r = 0; r < nr; ++r) {
+	crossings[r].clear();
+      }
+
+      // crossings of the triangles that intersect this slice
+      const double pw = (double)s;
+      for (mwIndex k = sliceBegin[s]; k < sliceBegin[s + 1]; ++k) {
+	const mwIndex *t = &this->tri[3 * sliceTri[k]];
+	const mwIndex mesh = this->triMesh[sliceTri[k]];
+	const double av = this->v[t[0]], aw = this->w[t[0]];
+	const double bv = this->v[t[1]], bw = this->w[t[1]];
+	const double cv = this->v[t[2]], cw = this->w[t[2]];
+
+	double vmin = std::max(std::ceil(std::min(av, std::min(bv, cv))), 0.0);
+	double vmax = std::min(std::floor(std::max(av, std::max(bv, cv))), (double)nr - 1.0);
+	for (double pv = vmin; pv <= vmax; pv += 1.0) {
+	  const double ea = EdgeFunction(bv, bw, cv, cw, pv, pw);
+	  const double eb = EdgeFunction(cv, cw, av, aw, pv, pw);
+	  const double ec = EdgeFunction(av, aw, bv, bw, pv, pw);
+	  if (IsInsideEdge(ea, bv, bw, cv, cw)
+	      && IsInsideEdge(eb, cv, cw, av, aw)
+	      && IsInsideEdge(ec, av, aw, bv, bw)) {
+	    const double sum = ea + eb + ec;
+	    crossings[(mwIndex)pv].push_back(CrossingType(mesh,
+							 (ea * this->u[t[0]] + eb * this->u[t[1]]
+							  + ec * this->u[t[2]]) / sum));
+	  }
+	}
+      }
+
+      // fill voxels between pairs of crossings of the same mesh,
+      // u0 <= col < u1. Meshes are filled in order
+      for (mwIndex r = 0; r < nr; ++r) {
+	std::vector<CrossingType> &cr = crossings[r];
+	if (cr.size() < 2) {
+	  continue;
+	}
+	std::sort(cr.begin(), cr.end());
+	mwIndex i = 0;
+	while (i < cr.size()) {
+	  const mwIndex mesh = cr[i].first;
+	  mwIndex j = i;
+	  while (j < cr.size() && cr[j].first == mesh) {
+	    ++j;
+	  }
+	  for (mwIndex k = i; k + 1 < j; k += 2) {
+	    double c0 = std::max(std::ceil(cr[k].second), 0.0);
+	    double c1 = std::min(std::ceil(cr[k + 1].second), (double)nc);
+	    for (mwIndex c = (mwIndex)c0; (double)c < c1; ++c) {
+	      WriteLabel(slice[r + c * nr], labels[mesh], priority);
+	    }
+	  }
+	  i = j;
+	}
+      }
+
+    }
+  }
+
+}
+
+#endif /* TRIANGLEMESHRASTERIZER_H */
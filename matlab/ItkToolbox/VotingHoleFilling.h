@@ -0,0 +1,482 @@
+/*
+ * VotingHoleFilling.h
+ *
+ * VotingHoleFilling: iterative voting hole filling of a 2D, 3D or 4D
+ * image stored in a Matlab buffer, with the same result as
+ * itk::VotingBinaryIterativeHoleFillingImageFilter.
+ *
+ * In each iteration, each background voxel becomes foreground if the
+ * number of foreground voxels in the box around it is at least the
+ * birth threshold
+ *
+ *   (number of voxels in the box - 1) / 2 + majority threshold
+ *
+ * All voxels are updated at the same time from the image of the
+ * previous iteration. Voxels that are neither background nor
+ * foreground never change. Iterations stop when no voxel changes, or
+ * after the maximum number of iterations.
+ *
+ * itk::VotingBinaryIterativeHoleFillingImageFilter counts the
+ * foreground voxels of the whole box around every voxel of the image
+ * in every iteration. However, foreground voxels never change, and a
+ * background voxel can only change if a voxel in its box has just
+ * become foreground. Thus, this class:
+ *
+ *   1. Computes the number of foreground voxels in the box of every
+ *      voxel once, with a separable running box sum.
+ *
+ *   2. Keeps an active set with the background voxels that reach the
+ *      birth threshold. These are the voxels that change in the next
+ *      iteration.
+ *
+ *   3. When a voxel becomes foreground, adds 1 to the count of each
+ *      voxel in its box, and only those voxels are checked for the
+ *      next active set.
+ *
+ * Each step is run in parallel with OpenMP, if available.
+ *
+ * Boundary conditions are the same as in the ITK filter (zero flux
+ * Neumann, i.e. voxels outside the image take the value of the
+ * closest voxel inside). Thus, a voxel on the edge of the image can be
+ * counted several times in the box of a voxel near the edge.
+ *
+ * An example of how to use this class in a MEX Matlab function:
+ *
+ *   VotingHoleFilling holeFilling(im.size, radius, majorityThreshold);
+ *   holeFilling.Run((uint8_T *)mxGetData(im.data), 0, 1, maxIter);
+ *
+ */
+
+/*
+ * Author: Ramon Casero <rcasero@gmail.com>
+ * Copyright © 2014 University of Oxford
+ * Version: 0.1.0
+ *
+ * University of Oxford means the Chancellor, Masters and Scholars of
+ * the University of Oxford, having an administrative office at
+ * Wellington Square, Oxford OX1 2JD, UK.
+ *
+ * This file is part of Gerardus.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details. The offer of this
+ * program under the terms of the License is subject to the License
+ * being interpreted in accordance with English Law and subject to any
+ * action against the University of Oxford being under the jurisdiction
+ * of the English Courts.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see
+ * <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef VOTINGHOLEFILLING_H
+#define VOTINGHOLEFILLING_H
+
+/* mex headers */
+#include <mex.h>
+
+/* C++ headers */
+#include <algorithm>
+#include <vector>
+
+class VotingHoleFilling {
+
+ public:
+
+  // size:              size of the image in Matlab order (row, column, slice, ...)
+  // radius:            half size of the box in each dimension
+  // majorityThreshold: number of votes over 50% needed to flip a voxel
+  VotingHoleFilling(const std::vector<mwSize> &_size,
+		    const std::vector<mwSize> &_radius,
+		    unsigned int majorityThreshold);
+
+  // fill holes in image im in place. Returns the total number of
+  // voxels that changed from background to foreground
+  template <class TPixel>
+  mwSize Run(TPixel *im, TPixel background, TPixel foreground,
+	     unsigned int maxIter);
+
+  unsigned int GetBirthThreshold() const {
+    return this->birthThreshold;
+  }
+
+  // number of iterations run by the last call to Run()
+  unsigned int GetNumberOfIterations() const {
+    return this->numberOfIterations;
+  }
+
+ private:
+
+  std::vector<mwSize> size;
+  std::vector<mwSize> radius;
+  size_t ndim;
+  mwSize n;
+  unsigned int birthThreshold;
+  unsigned int numberOfIterations;
+
+  // linear offsets of all the voxels in the box, for voxels whose box
+  // is within the image
+  std::vector<mwSignedIndex> boxLinearOffset;
+
+  // number of foreground voxels in the box of each voxel
+  std::vector<unsigned int> count;
+
+  // subscripts of voxel i
+  void Subscripts(mwIndex i, mwSignedIndex *sub) const {
+    for (size_t d = 0; d < this->ndim; ++d) {
+      sub[d] = i % this->size[d];
+      i /= this->size[d];
+    }
+  }
+
+  // whether the whole box of voxel with subscripts sub is within the
+  // image
+  bool IsInterior(const mwSignedIndex *sub) const {
+    for (size_t d = 0; d < this->ndim; ++d) {
+      if (sub[d] < (mwSignedIndex)this->radius[d]
+	  || sub[d] + (mwSignedIndex)this->radius[d] >= (mwSignedIndex)this->size[d]) {
+	return false;
+      }
+    }
+    return true;
+  }
+
+  // number of times that voxel u is in the box of voxel v along
+  // dimension d, with the box clamped to the image. This is 1 if u is
+  // not on the edge of the image and v is in the box of u, but a voxel
+  // on the edge is repeated for every box position outside the image
+  mwSize Multiplicity(size_t d, mwSignedIndex u, mwSignedIndex v) const {
+    const mwSignedIndex r = (mwSignedIndex)this->radius[d];
+    mwSignedIndex a = (u == 0) ? -r : std::max(-r, u - v);
+    mwSignedIndex b = (u == (mwSignedIndex)this->size[d] - 1) ? r : std::min(r, u - v);
+    return (b >= a) ? (mwSize)(b - a + 1) : 0;
+  }
+
+  // count[i] = sum of count[] in the box of voxel i along dimension d
+  void BoxSum(size_t d);
+
+  // add voxel u, that has just become foreground, to the count of all
+  // the voxels in its box
+  void AddToBoxCounts(mwIndex u, mwSignedIndex *sub, mwSignedIndex *v);
+
+  // append to candidates the background voxels in the box of voxel u
+  // that have reached the birth threshold
+  template <class TPixel>
+  void FindCandidatesInBox(mwIndex u, const TPixel *im, TPixel background,
+			   mwSignedIndex *sub, mwSignedIndex *v,
+			   std::vector<mwIndex> &candidates) const;
+
+};
+
+inline
+VotingHoleFilling::VotingHoleFilling(const std::vector<mwSize> &_size,
+				     const std::vector<mwSize> &_radius,
+				     unsigned int majorityThreshold)
+  : size(_size), radius(_radius), ndim(_size.size()), numberOfIterations(0) {
+
+  if (this->radius.size() != this->ndim) {
+    mexErrMsgTxt("VotingHoleFilling: Radius must have the same dimension as the image");
+  }
+
+  // number of voxels in the image and in the box
+  this->n = 1;
+  mwSize boxLength = 1;
+  for (size_t d = 0; d < this->ndim; ++d) {
+    this->n *= this->size[d];
+    boxLength *= 2 * this->radius[d] + 1;
+  }
+
+  // same birth threshold as itk::VotingBinaryHoleFillingImageFilter
+  this->birthThreshold = (unsigned int)((boxLength - 1) / 2) + majorityThreshold;
+
+  // offsets of the box, including the central voxel
+  this->boxLinearOffset.resize(boxLength);
+  for (mwIndex j = 0; j < boxLength; ++j) {
+    mwIndex r = j;
+    mwSignedIndex linearOffset = 0;
+    mwSize stride = 1;
+    for (size_t d = 0; d < this->ndim; ++d) {
+      linearOffset += ((mwSignedIndex)(r % (2 * this->radius[d] + 1))
+		       - (mwSignedIndex)this->radius[d]) * (mwSignedIndex)stride;
+      r /= 2 * this->radius[d] + 1;
+      stride *= this->size[d];
+    }
+    this->boxLinearOffset[j] = linearOffset;
+  }
+
+}
+
+inline
+void VotingHoleFilling::BoxSum(size_t d) {
+
+  const mwSize len = this->size[d];
+  const mwSignedIndex r = (mwSignedIndex)this->radius[d];
+  if (r == 0 || len == 0) {
+    return;
+  }
+
+  // distance between consecutive voxels along dimension d
+  mwSize stride = 1;
+  for (size_t i = 0; i < d; ++i) {
+    stride *= this->size[i];
+  }
+  const mwSize nlines = this->n / len;
+
+#ifdef _OPENMP
+#pragma omp parallel
+#endif
+  {
+    std::vector<unsigned int> line(len);
+
+#ifdef _OPENMP
+#pragma omp for schedule(static)
+#endif
+    for (mwSignedIndex l = 0; l < (mwSignedIndex)nlines; ++l) {
+
+      unsigned int *p = &this->count[(l % stride) + (l / stride) * stride * len];
+      for (mwIndex i = 0; i < len; ++i) {
+	line[i] = p[i * stride];
+      }
+
+      // running sum, with indices clamped to the line
+      const mwSignedIndex last = (mwSignedIndex)len - 1;
+      unsigned int sum = 0;
+      for (mwSignedIndex o = -r; o <= r; ++o) {
+	sum += line[std::max((mwSignedIndex)0, std::min(last, o))];
+      }
+      p[0] = sum;
+      for (mwSignedIndex i = 1; i <= last; ++i) {
+	sum += line[std::min(last, i + r)];
+	sum -= line[std::max((mwSignedIndex)0, i - 1 - r)];
+	p[i * stride] = sum;
+      }
+    }
+  }
+
+}
+
+inline
+void VotingHoleFilling::AddToBoxCounts(mwIndex u, mwSignedIndex *sub, mwSignedIndex *v) {
+
+  this->Subscripts(u, sub);
+
+  if (this->IsInterior(sub)) {
+    for (size_t j = 0; j < this->boxLinearOffset.size(); ++j) {
+      unsigned int &c = this->count[(mwSignedIndex)u + this->boxLinearOffset[j]];
+#ifdef _OPENMP
+#pragma omp atomic
+#endif
+      c += 1;
+    }
+    return;
+  }
+
+  // box clipped to the image, visited with an odometer over the
+  // subscripts
+  for (size_t d = 0; d < this->ndim; ++d) {
+    v[d] = std::max((mwSignedIndex)0, sub[d] - (mwSignedIndex)this->radius[d]);
+  }
+  while (true) {
+    mwIndex idx = 0;
+    mwSize stride = 1;
+    mwSize m = 1;
+    for (size_t d = 0; d < this->ndim; ++d) {
+      idx += v[d] * stride;
+      stride *= this->size[d];
+      m *= this->Multiplicity(d, sub[d], v[d]);
+    }
+    unsigned int &c = this->count[idx];
+#ifdef _OPENMP
+#pragma omp atomic
+#endif
+    c += (unsigned int)m;
+
+    size_t d = 0;
+    for (; d < this->ndim; ++d) {
+      if (v[d] < std::min((mwSignedIndex)this->size[d] - 1,
+			  sub[d] + (mwSignedIndex)this->radius[d])) {
+	++v[d];
+	break;
+      }
+      v[d] = std::max((mwSignedIndex)0, sub[d] - (mwSignedIndex)this->radius[d]);
+    }
+    if (d == this->ndim) {
+      break;
+    }
+  }
+
+}
+
+template <class TPixel>
+void VotingHoleFilling::FindCandidatesInBox(mwIndex u, const TPixel *im, TPixel background,
+					    mwSignedIndex *sub, mwSignedIndex *v,
+					    std::vector<mwIndex> &candidates) const {
+
+  this->Subscripts(u, sub);
+
+  if (this->IsInterior(sub)) {
+    for (size_t j = 0; j < this->boxLinearOffset.size(); ++j) {
+      const mwIndex idx = (mwIndex)((mwSignedIndex)u + this->boxLinearOffset[j]);
+      if (im[idx] == background && this->count[idx] >= this->birthThreshold) {
+	candidates.push_back(idx);
+      }
+    }
+    return;
+  }
+
+  for (size_t d = 0; d < this->ndim; ++d) {
+    v[d] = std::max((mwSignedIndex)0, sub[d] - (mwSignedIndex)this->radius[d]);
+  }
+  while (true) {
+    mwIndex idx = 0;
+    mwSize stride = 1;
+    for (size_t d = 0; d < this->ndim; ++d) {
+      idx += v[d] * stride;
+      stride *= this->size[d];
+    }
+    if (im[idx] == background && this->count[idx] >= this->birthThreshold) {
+      candidates.push_back(idx);
+    }
+
+    size_t d = 0;
+    for (; d < this->ndim; ++d) {
+      if (v[d] < std::min((mwSignedIndex)this->size[d] - 1,
+			  sub[d] + (mwSignedIndex)this->radius[d])) {
+	++v[d];
+	break;
+      }
+      v[d] = std::max((mwSignedIndex)0, sub[d] - (mwSignedIndex)this->radius[d]);
+    }
+    if (d == this->ndim) {
+      break;
+    }
+  }
+
+}
+
+template <class TPixel>
+mwSize VotingHoleFilling::Run(TPixel *im, TPixel background, TPixel foreground,
+			      unsigned int maxIter) {
+
+  this->numberOfIterations = 0;
+
+  // if background and foreground are the same value, the ITK filter
+  // "flips" voxels to the value they already have, so the image
+  // doesn't change
+  if (maxIter == 0 || this->n == 0 || background == foreground) {
+    return 0;
+  }
+
+  // number of foreground voxels in the box of each voxel
+  this->count.resize(this->n);
+#ifdef _OPENMP
+#pragma omp parallel for schedule(static)
+#endif
+  for (mwSignedIndex i = 0; i < (mwSignedIndex)this->n; ++i) {
+    this->count[i] = (im[i] == foreground) ? 1 : 0;
+  }
+  for (size_t d = 0; d < this->ndim; ++d) {
+    this->BoxSum(d);
+  }
+
+  // active set of the first iteration
+  std::vector<mwIndex> active;
+#ifdef _OPENMP
+#pragma omp parallel
+#endif
+  {
+    std::vector<mwIndex> localActive;
+
+#ifdef _OPENMP
+#pragma omp for schedule(static)
+#endif
+    for (mwSignedIndex i = 0; i < (mwSignedIndex)this->n; ++i) {
+      if (im[i] == background && this->count[i] >= this->birthThreshold) {
+	localActive.push_back((mwIndex)i);
+      }
+    }
+
+#ifdef _OPENMP
+#pragma omp critical
+#endif
+    active.insert(active.end(), localActive.begin(), localActive.end());
+  }
+
+  mwSize changed = 0;
+  std::vector<mwIndex> next;
+  while (this->numberOfIterations < maxIter && !active.empty()) {
+
+    ++this->numberOfIterations;
+    changed += active.size();
+
+    // flip the active set. The active set was computed from the image
+    // of the previous iteration, so all voxels change at the same time
+#ifdef _OPENMP
+#pragma omp parallel for schedule(static)
+#endif
+    for (mwSignedIndex k = 0; k < (mwSignedIndex)active.size(); ++k) {
+      im[active[k]] = foreground;
+    }
+
+    // update the counts of the boxes around the flipped voxels
+#ifdef _OPENMP
+#pragma omp parallel
+#endif
+    {
+      std::vector<mwSignedIndex> sub(this->ndim);
+      std::vector<mwSignedIndex> v(this->ndim);
+
+#ifdef _OPENMP
+#pragma omp for schedule(static)
+#endif
+      for (mwSignedIndex k = 0; k < (mwSignedIndex)active.size(); ++k) {
+	this->AddToBoxCounts(active[k], &sub[0], &v[0]);
+      }
+    }
+
+    // next active set. Before the update, no background voxel reached
+    // the birth threshold, so only voxels in the boxes of the flipped
+    // voxels can be in it. A voxel can be found from several flipped
+    // voxels, so duplicates are removed
+    next.clear();
+#ifdef _OPENMP
+#pragma omp parallel
+#endif
+    {
+      std::vector<mwSignedIndex> sub(this->ndim);
+      std::vector<mwSignedIndex> v(this->ndim);
+      std::vector<mwIndex> localNext;
+
+#ifdef _OPENMP
+#pragma omp for schedule(static)
+#endif
+      for (mwSignedIndex k = 0; k < (mwSignedIndex)active.size(); ++k) {
+	this->FindCandidatesInBox(active[k], (const TPixel *)im, background,
+				  &sub[0], &v[0], localNext);
+      }
+
+#ifdef _OPENMP
+#pragma omp critical
+#endif
+      next.insert(next.end(), localNext.begin(), localNext.end());
+    }
+    std::sort(next.begin(), next.end());
+    next.erase(std::unique(next.begin(), next.end()), next.end());
+    active.swap(next);
+  }
+
+  // free the counts
+  std::vector<unsigned int>().swap(this->count);
+
+  return changed;
+}
+
+#endif /* VOTINGHOLEFILLING_H */
@@ -8,6 +8,11 @@
 # the input image, and doesn't require setup steps, then running this
 # script will suffice to add the filter to itk_imfilter().
 #
+# The script creates MexFilter/MexXXXImageFilter.cpp from
+# MexFilter/MexTemplateFilter.cpp, registers the filter in
+# ItkImFilter.cpp, and adds the new file to the sources of
+# itk_imfilter in CMakeLists.txt.
+#
 # Syntax:
 #
 #  $ ./add_filter_template.sh XXXImageFilter shortname
@@ -18,7 +23,7 @@
 
 # Author: Ramon Casero <rcasero@gmail.com>
 # Copyright © 2012, 2015 University of Oxford
-# Version: 0.1.4
+# Version: 0.2.0
 #
 # University of Oxford means the Chancellor, Masters and Scholars of
 # the University of Oxford, having an administrative office at
@@ -60,75 +65,49 @@ echo -e "Creating template files to add filter to itk_imfilter():\n    $filter"
 defilter="${filter^^}"
 
 #############################################################
-## MexFilter .hpp and .cpp files
+## MexFilter .cpp file
 #############################################################
 
-pushd MexFilter
+pushd MexFilter > /dev/null
 
-# copy template .hpp and .cpp files
-cp MexTemplateFilter.hpp Mex${filter}.hpp
+# copy template .cpp file
 cp MexTemplateFilter.cpp Mex${filter}.cpp
 
 # replace template strings by others specific to the new filter
+sed -i s/MexTemplateFilter/Mex"$filter"/g \
+    Mex${filter}.cpp
 sed -i s/TemplateImageFilter/"$filter"/g \
-    Mex${filter}.hpp Mex${filter}.cpp
+    Mex${filter}.cpp
 sed -i s/TEMPLATEIMAGEFILTER/"$defilter"/g \
-    Mex${filter}.hpp Mex${filter}.cpp
+    Mex${filter}.cpp
 sed -i -e "s/Copyright.*/Copyright © `date +%Y` University of Oxford/g" \
-    Mex${filter}.hpp Mex${filter}.cpp
+    Mex${filter}.cpp
 sed -i 's/Version:.*/Version: 0.1.0/g' \
-    Mex${filter}.hpp Mex${filter}.cpp
-# sed -i 's/$Rev:.*/$Rev$/g' \
-#     Mex${filter}.hpp Mex${filter}.cpp
-# sed -i 's/$Date:.*/$Date$/g' \
-#     Mex${filter}.hpp Mex${filter}.cpp
-sed -i -e "s/shortname = \"template\"/shortname = \"${shortname}\"/g" \
-    Mex${filter}.hpp Mex${filter}.cpp
+    Mex${filter}.cpp
+sed -i -e "s/\"template\"/\"${shortname}\"/g" \
+    Mex${filter}.cpp
 
-echo "    ... Created Mex${filter}.hpp/cpp"
+echo "    ... Created MexFilter/Mex${filter}.cpp"
 
-popd
+popd > /dev/null
 
 #############################################################
 ## ItkImFilter.cpp
 #############################################################
 
-# #include MexFilter.hpp
-line="#include \"Mex${filter}.hpp\""
-if [ `grep -c "$line" ItkImFilter.cpp` == 0 ]
-then
-    sed -i "/#include \"NrrdImage.hpp\"/i $line" \
-	ItkImFilter.cpp
-fi
-
-# add new filter to enum list of supported filters
-line="nMex${filter},"
-if [ `grep -c "$line" ItkImFilter.cpp` == 0 ]
-then
-    sed -i "/enum SupportedFilter {/a \  ${line}" \
-	ItkImFilter.cpp
-fi
-
-# add macro to instantiate new filter if the corresponding enum is
-# selected
-line="SELECTFILTER(nMex${filter},\n             Mex${filter})"
-if [ `grep -c "SELECTFILTER(nMex${filter}," ItkImFilter.cpp` == 0 ]
+# declare the registration function of the new filter
+line="void Register${filter}(FilterRegistry \&registry);"
+if [ `grep -c "void Register${filter}(" ItkImFilter.cpp` == 0 ]
 then
-    sed -i "/#undef SELECTFILTER/i ${line}" \
+    sed -i "/^void RegisterMRFImageFilter(FilterRegistry &registry);/a ${line}" \
 	ItkImFilter.cpp
 fi
 
-# add parsing of filter type to enum
-read -r -d '' line <<BLOCK
-\
-  } else if (ISFILTER(filterName, Mex${filter})) {\n\
-\n\
-    parseInputTypeToTemplate<nMex${filter}>(nargin, argIn,\n\
-							 nargout, argOut);\n
-BLOCK
-if [ `grep -c "else if (ISFILTER(filterName, Mex${filter}))" ItkImFilter.cpp` == 0 ]
+# call it when the registry is built
+line="    Register${filter}(registry);"
+if [ `grep -c "^    Register${filter}(registry);" ItkImFilter.cpp` == 0 ]
 then
-    sed -ie "/Insertion point: parseFilterTypeToTemplate/i \  ${line}" \
+    sed -i "/^    RegisterMRFImageFilter(registry);/a \\${line}" \
 	ItkImFilter.cpp
 fi
 
@@ -138,12 +117,12 @@ echo "    ... Modified ItkImFilter.cpp"
 ## CmakeLists.txt
 #############################################################
 
-# add MexFilter.cpp file to list of source files to build
+# add MexFilter .cpp file to list of source files to build
 # itk_imfilter() from
-line="Mex${filter}.cpp"
+line="MexFilter/Mex${filter}.cpp"
 if [ `grep -c "$line" CMakeLists.txt` == 0 ]
 then
-    sed -i "/  ItkImFilter.cpp/i \  ${line}" \
+    sed -i "/^  ItkImFilter.cpp)/i \  ${line}" \
 	CMakeLists.txt
 fi
 
@@ -0,0 +1,111 @@
+function varargout = itk_icp_registration(varargin)
+% ITK_ICP_REGISTRATION  Iterative Closest Point registration
+%
+% [Y2, T, INFO] = itk_icp_registration(X, Y, TRANSFORM, NITER, TOL, TRIM, NLEVELS, T0, RES)
+%
+%   X is a 3-column matrix with the fixed point set. Each row contains
+%   the coordinates of a point.
+%
+%   Y is a 3-column matrix with the moving point set, that is
+%   registered onto X. X and Y can have a different number of points.
+%
+%   TRANSFORM is a string with the type of transform. By default,
+%   TRANSFORM='rigid'.
+%
+%     'translation': translation only
+%     'rigid':       rotation and translation
+%     'similarity':  rotation, translation and isotropic scaling
+%     'affine':      affine transform
+%
+%   NITER is the maximum number of iterations at each level of
+%   resolution. By default, NITER=100.
+%
+%   TOL is the tolerance for the relative change of the RMS distance
+%   between paired points. Iterations at each level stop when the
+%   change is below TOL. By default, TOL=1e-6.
+%
+%   TRIM is the proportion of pairs used to compute the transform at
+%   each iteration, in (0, 1]. The pairs with the largest distances are
+%   rejected as outliers (trimmed ICP). By default, TRIM=1, all pairs
+%   are used.
+%
+%   NLEVELS is the number of levels of resolution. Level l uses one in
+%   4^l points of Y, starting from level NLEVELS-1, and the last level
+%   uses all the points. Levels with too few points to determine the
+%   transform (4 for 'affine', 3 for 'rigid' or 'similarity'), after
+%   trimming, are skipped. By default, NLEVELS=1.
+%
+%   T0 is a (4, 4) homogeneous matrix with the initial transform. By
+%   default, T0=eye(4). With TRANSFORM='translation', the rotation,
+%   scaling and shear of T0 are kept, and only its translation is
+%   optimised.
+%
+%   RES is a scalar or 3-vector with a voxel size. If RES is given, the
+%   closest points are found with a distance map of X instead of a
+%   k-d tree (see below). By default, RES=[], and the k-d tree is used.
+%
+%   Y2 is the moving point set after registration.
+%
+%   T is a (4, 4) homogeneous matrix with the transform. A point y,
+%   as a column vector, is mapped to T(1:3,1:3)*y+T(1:3,4), i.e.
+%   Y2 = [Y ones(size(Y, 1), 1)] * T(1:3, :)'.
+%
+%   INFO is a struct with the convergence history of the
+%   registration, with one element per iteration:
+%
+%     'rms':   RMS distance between the pairs kept after trimming
+%     'time':  time of the iteration, in seconds
+%     'level': level of resolution of the iteration
+%
+% Each iteration pairs each point of Y with its nearest point in X. X
+% is stored in a k-d tree built once, and points are paired in
+% parallel.
+%
+% With RES, X is instead rasterised once on a grid with voxel size
+% RES that covers the bounding box of X, extended by 10% of its
+% largest side. A distance map of the grid is computed with
+% itk::SignedMaurerDistanceMapImageFilter, and the closest point to
+% each point of Y is looked up in the map and its gradient by
+% trilinear interpolation. The time of each iteration does not depend
+% on the number of points in X, which pays off for large X. The
+% accuracy of the registration is limited by RES, and memory grows
+% with the number of voxels. Points of Y on the medial axis of X,
+% where the gradient of the map vanishes and the closest point is
+% undefined, are left out of the iteration, as if trimmed.
+%
+% The transform is then computed in closed form from the
+% pairs (Horn's quaternion method for 'rigid' and 'similarity', and
+% linear least squares for 'affine'). Before v0.1.0, this function was
+% an unfinished wrapper of itk::PointSetToPointSetRegistrationMethod
+% with a translation transform, derived from
+% https://github.com/Kitware/ITK/blob/master/Examples/Registration/IterativeClosestPoint3.cxx
+
+% Author: Ramon Casero <rcasero@gmail.com>
+% Copyright © 2013 University of Oxford
+% Version: 0.2.3
+%
+% University of Oxford means the Chancellor, Masters and Scholars of
+% the University of Oxford, having an administrative office at
+% Wellington Square, Oxford OX1 2JD, UK. 
+%
+% This file is part of Gerardus.
+%
+% This program is free software: you can redistribute it and/or modify
+% it under the terms of the GNU General Public License as published by
+% the Free Software Foundation, either version 3 of the License, or
+% (at your option) any later version.
+%
+% This program is distributed in the hope that it will be useful,
+% but WITHOUT ANY WARRANTY; without even the implied warranty of
+% MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+% GNU General Public License for more details. The offer of this
+% program under the terms of the License is subject to the License
+% being interpreted in accordance with English Law and subject to any
+% action against the University of Oxford being under the jurisdiction
+% of the English Courts.
+%
+% You should have received a copy of the GNU General Public License
+% along with this program.  If not, see
+% <http://www.gnu.org/licenses/>.
+
+error('MEX file not found')
@@ -22,7 +22,9 @@ function im = itk_imfilter(varargin)
 %     int16
 %     uint16
 %     int32
+%     uint32
 %     int64
+%     uint64
 %
 %   A can also be a SCI MAT struct, A = scimat, with the following fields:
 %
@@ -85,6 +87,42 @@ function im = itk_imfilter(varargin)
 %   foreground voxel from A(i,j,k). The vector coordinates are given
 %   in voxel units, and as (R,C,S), instead of (x,y,z).
 %
+%   For exact distances in a fraction of the time, see 'edt' below.
+%
+% -------------------------------------------------------------------------
+%
+% [B, V, W] = itk_imfilter('edt', A)
+% [B, V, W] = itk_imfilter('signedt', A)
+%
+%   (Not an ITK filter, but Gerardus' ExactDistanceTransform)
+%   Compute unsigned/signed exact Euclidean distance map for a binary
+%   mask. Distance values are given in real world coordinates, if the
+%   input image is given as a SCI MAT struct, or in voxel units, if the
+%   input image is a normal array.
+%
+%   The transform is separable (Felzenszwalb and Huttenlocher), and the
+%   lines along each axis are processed in parallel. Outputs V and W are
+%   only computed if they are requested.
+%
+%   A is a segmentation. Non-zero voxels are foreground.
+%
+%   B has the same size as A and type single. For 'edt', each element in
+%   B is the distance from that voxel to the closest foreground voxel
+%   (0 for foreground voxels). For 'signedt', background voxels have the
+%   distance to the closest foreground voxel, and foreground voxels have
+%   minus the distance to the closest background voxel. If there are no
+%   foreground (or background) voxels, distances are Inf.
+%
+%   V has the same size as A and type int32. V(i) is the linear index of
+%   the closest foreground voxel to voxel i (for 'signedt', the closest
+%   voxel of the opposite class), or 0 if there is none. A(V) gives the
+%   Voronoi partition of A.
+%
+%   W has size (R,C,S,3) if A has size (R,C,S), and type int32. Each
+%   vector W(i,j,k,:) points from voxel (i,j,k) to the closest voxel
+%   V(i,j,k). The vector coordinates are given in voxel units, and as
+%   (R,C,S), instead of (x,y,z).
+%
 % -------------------------------------------------------------------------
 %
 % B = itk_imfilter('maudist', A)
@@ -138,6 +176,43 @@ function im = itk_imfilter(varargin)
 %   FOREGROUND is a scalar. Voxels with that value will be the only ones
 %   dilated. By default, FOREGROUND=1.
 %
+%   Eroded voxels are set to the lowest value of the class of A, as in
+%   ITK: 0 for unsigned integers, intmin for signed integers, and
+%   -realmax for single and double. Other voxels keep their value.
+%
+%   For RADIUS >= 4, the ITK filter is replaced by a threshold of the
+%   exact distance transform (see 'edt' below), which takes the same time
+%   for any radius. The distance is measured with the voxel size of A,
+%   and the ball contains the voxels at distance <= (RADIUS+0.5)*S from
+%   the centre, where S is the smallest voxel side. For isotropic voxels
+%   this is the same ball as ITK's, so the result doesn't change. For
+%   anisotropic voxels, the ball is round in real world units, whereas
+%   the ITK ball is round in voxel units.
+%
+% -------------------------------------------------------------------------
+%
+% B = itk_imfilter('labdilate', A, RADIUS)
+% B = itk_imfilter('laberode', A, RADIUS)
+%
+%   (Not ITK filters, but Gerardus' DistanceMorphology)
+%   Dilation/erosion of all the labels of a segmentation at the same time,
+%   with a Euclidean ball, computed by thresholding the exact distance
+%   transform (see 'edt' below).
+%
+%   A is a segmentation. Voxels with value 0 are background, and each
+%   other value is a label.
+%
+%   RADIUS is a scalar with the radius of the ball. It is given in real
+%   world units, if A is given as a SCI MAT struct (so the ball is exact
+%   also for anisotropic voxels), or in voxel units, if A is a normal
+%   array. By default, RADIUS=0 and the image doesn't change.
+%
+%   B has the same size and class as A. For 'labdilate', labelled voxels
+%   keep their label, and background voxels get the label of the closest
+%   labelled voxel, if it is within RADIUS. For 'laberode', voxels within
+%   RADIUS of a voxel with a different value (background or another
+%   label) are set to 0. Voxels outside the image are not background.
+%
 % -------------------------------------------------------------------------
 %
 % B = itk_imfilter('advess', A, SIGMAMIN, SIGMAMAX, NUMSIGMASTEPS, NUMITERATIONS,
@@ -164,6 +239,12 @@ function im = itk_imfilter(varargin)
 %   results seem better if run directly on the image. The
 %   filter doesn't seem to be spacing invariant.
 %
+%   Note: At each iteration, the diffusion tensor of a voxel has its
+%   largest eigenvalue along the vessel direction, i.e. the eigenvector
+%   of the Hessian eigenvalue with the smallest magnitude (Manniesing
+%   et al., 2006). Hessians are computed in single precision, and
+%   eigenvalues and eigenvectors with a closed-form solver.
+%
 %   SIGMAMIN, SIGMAMAX are scalars with the limits of the multiscale
 %   scheme, in the same units as the image. They should be set to
 %   roughly the diameters of the smallest and largest vessels in the
@@ -237,6 +318,10 @@ function im = itk_imfilter(varargin)
 %   median is computed in a rectangular neighbourhood of [5, 7, 9]
 %   voxels.
 %
+%   For images of class logical, (u)int8 or (u)int16, the median is
+%   computed with a sliding histogram instead of itk::MedianImageFilter,
+%   which is much faster for large radii. The result is the same.
+%
 % -------------------------------------------------------------------------
 %
 % B = itk_imfilter('mrf', A, MU)
@@ -282,6 +367,29 @@ function im = itk_imfilter(varargin)
 %   TOL is a scalar with the error tolerance that will be used as a
 %   criterion for convergence. By default, TOL=1e-7.
 %
+% [B, STATS] = itk_imfilter(..., METHOD)
+%
+%   METHOD is a string with the optimisation method:
+%
+%     'itk' (default): itk::MRFImageFilter (Iterated Conditional Modes,
+%     ICM, with a raster sweep). Single-threaded.
+%
+%     'icm': Gerardus' MrfSegmentation. The same ICM, but voxels are
+%     relabelled in parallel by colours (red-black checkerboard if WEIGHTS
+%     only has face neighbours), so the result can be slightly different.
+%
+%     'alphaexp': Gerardus' MrfSegmentation with alpha-expansion graph
+%     cuts (Boykov et al., 2001). Usually finds a lower energy than ICM,
+%     but it's slower and needs a lot more memory for large images.
+%
+%   For 'icm' and 'alphaexp', the fraction of voxels that change label in
+%   an iteration is compared to TOL, and NITER is the maximum number of
+%   ICM sweeps or alpha-expansion cycles.
+%
+%   STATS is a matrix with one row per iteration. STATS(:,1) is the number
+%   of voxels that changed label, and STATS(:,2) is the energy after the
+%   iteration. For 'itk', STATS is empty.
+%
 % -------------------------------------------------------------------------
 %
 % B = itk_imfilter('voteholefill', A)
@@ -312,6 +420,12 @@ function im = itk_imfilter(varargin)
 %   foreground voxels, respectively. By default, BACKGROUND=0,
 %   FOREGROUND=1.
 %
+%   The filter is computed with an active set instead of
+%   itk::VotingBinaryIterativeHoleFillingImageFilter. After the first
+%   iteration, only background voxels close to voxels that have just
+%   become foreground are evaluated, which is much faster for large values
+%   of MAXITER. The result is the same.
+%
 % -------------------------------------------------------------------------
 %
 % [B, C] = itk_imfilter('canny', A)
@@ -362,7 +476,7 @@ function im = itk_imfilter(varargin)
 
 % Author: Ramon Casero <rcasero@gmail.com>
 % Copyright © 2011-2014 University of Oxford
-% Version: 0.7.7
+% Version: 0.10.5
 %
 % University of Oxford means the Chancellor, Masters and Scholars of
 % the University of Oxford, having an administrative office at
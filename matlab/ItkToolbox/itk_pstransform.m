@@ -43,6 +43,17 @@
 %   pts_tps_map(), as it implements the classic kernel proposed by
 %   Bookstein, r^2 ln(r^2).
 %
+% YI = itk_pstransform(..., TOL)
+%
+%   TOL is a scalar with the error tolerance of the warp, relative to the
+%   largest displacement. By default, TOL=0, and the warp is computed
+%   exactly, although in parallel and much faster than ITK's
+%   TransformPoint(). If TOL>0, the contribution of groups of landmarks
+%   that are far from the point is approximated with a treecode. This is
+%   much faster than the exact warp when there are many landmarks (e.g.
+%   more than 10,000) and points to warp. The treecode error stays below
+%   TOL. Values of TOL below 2e-8 give the exact warp.
+%
 % YI = itk_pstransform('bspline', X, Y, XI, ORDER, LEVELS)
 %
 %   'bspline':  itk::BSplineScatteredDataPointSetToImageFilter
@@ -57,11 +68,60 @@
 %   in the algorithm. A higher number of levels will make the spline
 %   more flexible and match the landmarks better. By default, LEVELS=5.
 %
-% See also: pts_tps_map, pts_tps_weights.
+% YI = itk_pstransform(S, XI)
+% YI = itk_pstransform(S, XI, TOL)
+% [YI, S] = itk_pstransform(TRANSFORM, X, Y, XI, ...)
+%
+%   S is a struct with the fitted transform. When S is requested, the
+%   transform fitted to X, Y is returned, so that it can be applied to
+%   other sets of points XI without fitting it again. XI can be empty
+%   when only S is needed. S is a plain struct that can be saved to a
+%   .mat file. Its fields have the same class as X:
+%
+%     S.type:        TRANSFORM string
+%     kernel transforms:
+%       S.landmarks:   source landmarks X
+%       S.weights:     (N, D)-matrix with the kernel weights
+%       S.affine:      (D, D)-matrix of the affine part of the warp
+%       S.translation: (1, D)-vector of the translation part
+%       S.alpha:       kernel constant of 'elastic' and 'elasticr'
+%     'bspline':
+%       S.order:       ORDER
+%       S.lattice:     (D, n1, n2[, n3])-array of control point
+%                      displacements
+%       S.origin:      (1, D)-vector with the origin of the bounding box
+%       S.scale:       length of the largest side of the bounding box
+%
+%   The B-spline is only defined within the bounding box of the X, Y
+%   and XI points used to fit it. Points outside of it give an error,
+%   so they must be included in XI when the B-spline is fitted.
+%
+% DX = itk_pstransform(S, SCIMAT)
+%
+%   SCIMAT is a struct with an image (see "help scimat" for details).
+%   Only the size, spacing and origin of the image are used. DX is the
+%   displacement field of the fitted transform S at the voxel centres.
+%   It is an (R, C, D) array for 2D and an (R, C, P, D) array for 3D,
+%   where R, C, P are the rows, columns and slices of the image, and D
+%   is the dimension. DX(:,:,:,1), DX(:,:,:,2), DX(:,:,:,3) are the x-, y-
+%   and z-displacements. Note that x changes with the columns of the
+%   image, and y with the rows, as in scimat_ndgrid().
+%
+%   For 'bspline', the field is computed with a separable evaluation of
+%   the B-spline: the basis weights are computed once for each row,
+%   column and slice, and slices are evaluated in parallel. This is much
+%   faster than warping the coordinates of every voxel as points XI.
+%   The voxel centres must be within the domain of the B-spline (see
+%   above).
+%
+%   To warp an image, interpolate it at the coordinates of the voxels
+%   plus DX, e.g. with interpn().
+%
+% See also: pts_tps_map, pts_tps_weights, scimat_ndgrid.
 
 % Author: Ramon Casero <rcasero@gmail.com>
 % Copyright © 2011 University of Oxford
-% Version: 0.1.1
+% Version: 0.4.1
 %
 % University of Oxford means the Chancellor, Masters and Scholars of
 % the University of Oxford, having an administrative office at
@@ -2,8 +2,8 @@ function varargout = itk_tri_rasterization(varargin)
 % ITK_TRI_RASTERIZATION  Rasterization of triangular mesh to binary
 % segmentation
 %
-% This function provides a Matlab interface to
-% itk::TriangleMeshToBinaryImageFilter.
+% This function rasterizes a closed triangular mesh, i.e. it computes
+% which voxels of an image grid are inside the mesh.
 %
 % BW = itk_tri_rasterization(TRI, X, RES, SIZE, ORIGIN)
 %
@@ -25,15 +25,46 @@ function varargout = itk_tri_rasterization(varargin)
 %   bottom-left image voxel, in (x, y, z) format.
 %
 %   BW is the output uint8 binary segmentation. Voxels inside the mesh will
-%   be set to 1, and voxels outside to 0. Note that voxels with their
-%   centre exactly on the mesh offer different results depending on whether
-%   they are at the left, right, top or bottom of the mesh. This is a
-%   limitation in itk::TriangleMeshToBinaryImageFilter. See
-%   test_itk_tri_rasterization.m in Gerardus for an example.
+%   be set to 1, and voxels outside to 0. A voxel is inside if its centre
+%   is inside the mesh. Voxels with their centre exactly on the mesh are
+%   resolved consistently: the voxel is inside if the mesh is on its side
+%   of increasing column or, if that is a tie, of increasing row, and then
+%   slice. Voxels on the same face of a closed mesh are all treated the
+%   same way, and the result does not depend on the triangulation of the
+%   surface.
+%
+%   The mesh is rasterized natively with scanlines along the image rows.
+%   Triangles are binned by slice, and slices are processed in parallel.
+%   Before v0.2.0, this function used itk::TriangleMeshToBinaryImageFilter,
+%   which is single-threaded and gives results that depend on the side of
+%   the mesh for voxels with their centre on the surface.
+%
+% IM = itk_tri_rasterization(MESHES, RES, SIZE, ORIGIN, LABELS, PRIORITY)
+%
+%   MESHES is a cell array with one mesh per row, {TRI1, X1; TRI2, X2;
+%   ...}. All meshes are rasterized in a single pass onto one label
+%   image IM. Empty meshes are allowed, and leave no voxels.
+%
+%   LABELS is a vector with the label of each mesh, given as positive
+%   integers. By default, LABELS=1:N, where N is the number of meshes.
+%
+%   PRIORITY is a string with the rule for voxels inside more than one
+%   mesh. By default, PRIORITY='last'.
+%
+%     'last':  the label of the last mesh in MESHES
+%     'first': the label of the first mesh in MESHES
+%     'max':   the largest label
+%     'min':   the smallest label
+%
+%   IM is the output label image, with 0 for voxels outside all meshes.
+%   IM is of class uint8, uint16 or uint32, the smallest class that
+%   can hold max(LABELS). The result is the same as rasterizing each
+%   mesh separately and merging the binary images with PRIORITY, but
+%   without the memory and time of one image per mesh.
 
 % Author: Ramon Casero <rcasero@gmail.com>
 % Copyright © 2013 University of Oxford
-% Version: 0.1.0
+% Version: 0.3.0
 %
 % University of Oxford means the Chancellor, Masters and Scholars of
 % the University of Oxford, having an administrative office at
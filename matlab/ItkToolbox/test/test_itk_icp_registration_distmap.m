@@ -0,0 +1,77 @@
+% TEST_ITK_ICP_REGISTRATION_DISTMAP  Test of the distance map closest
+% points of itk_icp_registration
+%
+% With RES, itk_icp_registration pairs the points with the closest
+% point computed from a distance map of the fixed set. This script
+% checks the RMS distance of the first iteration against a brute force
+% search, for random moving points, alone and together with moving
+% points on the medial plane between two planes of fixed points. On the
+% medial plane the gradient of the distance map vanishes, and those
+% points must be left out instead of paired with themselves.
+%
+% Run from a directory where itk_icp_registration is in the path. The
+% script raises an error if any test fails.
+
+% Author: Ramon Casero <rcasero@gmail.com>
+% Copyright © 2014 University of Oxford
+% Version: 0.1.1
+%
+% University of Oxford means the Chancellor, Masters and Scholars of
+% the University of Oxford, having an administrative office at
+% Wellington Square, Oxford OX1 2JD, UK.
+%
+% This file is part of Gerardus.
+%
+% This program is free software: you can redistribute it and/or modify
+% it under the terms of the GNU General Public License as published by
+% the Free Software Foundation, either version 3 of the License, or
+% (at your option) any later version.
+%
+% This program is distributed in the hope that it will be useful,
+% but WITHOUT ANY WARRANTY; without even the implied warranty of
+% MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+% GNU General Public License for more details. The offer of this
+% program under the terms of the License is subject to the License
+% being interpreted in accordance with English Law and subject to any
+% action against the University of Oxford being under the jurisdiction
+% of the English Courts.
+%
+% You should have received a copy of the GNU General Public License
+% along with this program.  If not, see
+% <http://www.gnu.org/licenses/>.
+
+% fixed points on a lattice on the planes z=2 and z=6
+[gx, gy, gz] = ndgrid(0:10, 0:10, [2 6]);
+x = [gx(:) gy(:) gz(:)];
+
+% moving points: random points between the planes, and lattice points
+% on the medial plane z=4
+rand('seed', 0);
+yrand = [1 + 8 * rand(200, 2), 1 + 6 * rand(200, 1)];
+[gx, gy] = ndgrid(1:9, 1:9);
+ymid = [gx(:) gy(:) 4 * ones(numel(gx), 1)];
+
+res = 0.25;
+
+% brute force distance from each random moving point to the fixed set
+d2 = inf(size(yrand, 1), 1);
+for I = 1:size(x, 1)
+    d2 = min(d2, sum(bsxfun(@minus, yrand, x(I, :)).^2, 2));
+end
+rmsref = sqrt(mean(d2));
+
+% one iteration from the identity, so that the RMS is computed with the
+% moving points as given. The points on the medial plane have no
+% closest point in the distance map, and must be left out of the RMS
+for y = {yrand, [yrand; ymid]}
+
+    [~, ~, info] = itk_icp_registration(x, y{1}, 'translation', 1, ...
+        1e-6, 1, 1, eye(4), res);
+
+    assert(abs(info.rms(1) - rmsref) <= 0.5 * res, ...
+        ['RMS distance ' num2str(info.rms(1)) ' differs from brute force ' ...
+        num2str(rmsref)])
+
+end
+
+disp('test_itk_icp_registration_distmap: OK')
@@ -0,0 +1,85 @@
+% TEST_ITK_IMFILTER_BWERODE  Test of itk_imfilter('bwerode')
+%
+% itk_imfilter('bwerode') runs itk::BinaryErodeImageFilter for RADIUS <=
+% 3, and thresholds the exact distance transform for RADIUS >= 4. This
+% script checks both implementations at RADIUS = 3 and 4 against a brute
+% force erosion with the same ball, for images of class int16 and
+% single. Eroded voxels must be set to the ITK background value (intmin
+% or -realmax), and the other voxels must keep their value.
+%
+% Run from a directory where itk_imfilter is in the path. The script
+% raises an error if any test fails.
+
+% Author: Ramon Casero <rcasero@gmail.com>
+% Copyright © 2014 University of Oxford
+% Version: 0.1.0
+%
+% University of Oxford means the Chancellor, Masters and Scholars of
+% the University of Oxford, having an administrative office at
+% Wellington Square, Oxford OX1 2JD, UK.
+%
+% This file is part of Gerardus.
+%
+% This program is free software: you can redistribute it and/or modify
+% it under the terms of the GNU General Public License as published by
+% the Free Software Foundation, either version 3 of the License, or
+% (at your option) any later version.
+%
+% This program is distributed in the hope that it will be useful,
+% but WITHOUT ANY WARRANTY; without even the implied warranty of
+% MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+% GNU General Public License for more details. The offer of this
+% program under the terms of the License is subject to the License
+% being interpreted in accordance with English Law and subject to any
+% action against the University of Oxford being under the jurisdiction
+% of the English Courts.
+%
+% You should have received a copy of the GNU General Public License
+% along with this program.  If not, see
+% <http://www.gnu.org/licenses/>.
+
+% segmentation with foreground (1), background (0), holes and another
+% label (2), and a negative value that must not be changed
+rand('seed', 0);
+a0 = zeros(20, 17, 15);
+a0(3:18, 3:15, 3:13) = 1;
+a0(rand(size(a0)) < 0.02) = 0;
+a0(7:9, 7:9, 9:12) = 2;
+a0(1, 1, 1) = -3;
+
+for classname = {'int16', 'single'}
+
+    a = cast(a0, classname{1});
+    if isinteger(a)
+        background = intmin(classname{1});
+    else
+        background = -realmax(classname{1});
+    end
+
+    for radius = 3:4
+
+        % itk::BinaryBallStructuringElement contains the voxels at
+        % distance <= RADIUS+0.5 from the centre
+        [gr, gc, gs] = ndgrid(-radius:radius);
+        ball = double(gr.^2 + gc.^2 + gs.^2 <= (radius + 0.5)^2);
+
+        % a foreground voxel is eroded if there's any other voxel in
+        % its ball. Voxels outside the image do not erode
+        isEroded = (a == 1) & (convn(double(a ~= 1), ball, 'same') > 0.5);
+        bref = a;
+        bref(isEroded) = background;
+
+        b = itk_imfilter('bwerode', a, radius, 1);
+
+        assert(strcmp(class(b), classname{1}), ...
+            ['bwerode, ' classname{1} ', RADIUS=' num2str(radius) ...
+            ': wrong output class'])
+        assert(isequal(b, bref), ...
+            ['bwerode, ' classname{1} ', RADIUS=' num2str(radius) ...
+            ': ' num2str(nnz(b ~= bref)) ' voxels differ from the reference'])
+
+    end
+
+end
+
+disp('test_itk_imfilter_bwerode: OK')
@@ -0,0 +1,87 @@
+% TEST_ITK_PSTRANSFORM_TOL  Test of the TOL argument of itk_pstransform
+%
+% itk_pstransform computes the kernel transforms exactly with TOL=0,
+% and with a treecode with TOL>0. This script builds the struct S of a
+% fitted transform for each kernel in 2D and 3D, and checks that for TOL
+% from 1e-1 to 1e-8, the difference between the treecode and the exact
+% warp is below TOL relative to the largest deformation. The deformation
+% is the kernel part of the warp, without the affine part.
+%
+% The weights of S are random, but orthogonal to the affine part, as
+% the weights of a fitted transform. These give larger relative errors
+% than unconstrained random weights. S is built directly instead of
+% fitted, because fitting this many landmarks with ITK would be too
+% slow.
+%
+% Run from a directory where itk_pstransform is in the path. The script
+% raises an error if any test fails.
+
+% Author: Ramon Casero <rcasero@gmail.com>
+% Copyright © 2014 University of Oxford
+% Version: 0.1.0
+%
+% University of Oxford means the Chancellor, Masters and Scholars of
+% the University of Oxford, having an administrative office at
+% Wellington Square, Oxford OX1 2JD, UK.
+%
+% This file is part of Gerardus.
+%
+% This program is free software: you can redistribute it and/or modify
+% it under the terms of the GNU General Public License as published by
+% the Free Software Foundation, either version 3 of the License, or
+% (at your option) any later version.
+%
+% This program is distributed in the hope that it will be useful,
+% but WITHOUT ANY WARRANTY; without even the implied warranty of
+% MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+% GNU General Public License for more details. The offer of this
+% program under the terms of the License is subject to the License
+% being interpreted in accordance with English Law and subject to any
+% action against the University of Oxford being under the jurisdiction
+% of the English Courts.
+%
+% You should have received a copy of the GNU General Public License
+% along with this program.  If not, see
+% <http://www.gnu.org/licenses/>.
+
+% enough landmarks so that the treecode approximates boxes of landmarks
+N = 10000;
+M = 1000;
+rand('seed', 0);
+
+for transform = {'elastic', 'elasticr', 'tps', 'tpsr2', 'volume'}
+    for D = 2:3
+
+        % transform with random landmarks, affine part and weights. The
+        % weights are projected onto the orthogonal complement of the
+        % affine part, [1 x]' * weights = 0
+        s.type = transform{1};
+        s.landmarks = 100 * rand(N, D);
+        q = orth([ones(N, 1) s.landmarks]);
+        s.weights = rand(N, D) - 0.5;
+        s.weights = s.weights - q * (q' * s.weights);
+        s.affine = 0.01 * (rand(D) - 0.5);
+        s.translation = rand(1, D);
+        s.alpha = 8;
+
+        % exact warp and largest deformation
+        xi = 100 * rand(M, D);
+        yi0 = itk_pstransform(s, xi);
+        def = yi0 - xi - xi * s.affine' - repmat(s.translation, M, 1);
+        maxdef = max(abs(def(:)));
+
+        for tol = [1e-1 1e-2 1e-4 1e-6 1e-8]
+
+            yi = itk_pstransform(s, xi, tol);
+            err = max(abs(yi(:) - yi0(:))) / maxdef;
+
+            assert(err <= tol, ...
+                [transform{1} ', ' num2str(D) 'D, TOL=' num2str(tol) ...
+                ': relative error ' num2str(err) ' is above TOL'])
+
+        end
+
+    end
+end
+
+disp('test_itk_pstransform_tol: OK')
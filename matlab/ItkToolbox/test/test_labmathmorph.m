@@ -0,0 +1,82 @@
+% TEST_LABMATHMORPH  Test of labmathmorph('close') with touching labels
+%
+% labmathmorph('close') dilates and erodes all labels at the same time
+% with itk_imfilter('labdilate') and itk_imfilter('laberode'). This
+% script checks, on a segmentation with two labels that touch and with
+% holes, that the result is a closing: every voxel labelled in the input
+% keeps its label, the holes are filled, and every voxel labelled in the
+% output is in the closing of its label computed with a brute force
+% dilation and erosion.
+%
+% Run from a directory where labmathmorph and itk_imfilter are in the
+% path. The script raises an error if any test fails.
+
+% Author: Ramon Casero <rcasero@gmail.com>
+% Copyright © 2014 University of Oxford
+% Version: 0.1.0
+%
+% University of Oxford means the Chancellor, Masters and Scholars of
+% the University of Oxford, having an administrative office at
+% Wellington Square, Oxford OX1 2JD, UK.
+%
+% This file is part of Gerardus.
+%
+% This program is free software: you can redistribute it and/or modify
+% it under the terms of the GNU General Public License as published by
+% the Free Software Foundation, either version 3 of the License, or
+% (at your option) any later version.
+%
+% This program is distributed in the hope that it will be useful,
+% but WITHOUT ANY WARRANTY; without even the implied warranty of
+% MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+% GNU General Public License for more details. The offer of this
+% program under the terms of the License is subject to the License
+% being interpreted in accordance with English Law and subject to any
+% action against the University of Oxford being under the jurisdiction
+% of the English Courts.
+%
+% You should have received a copy of the GNU General Public License
+% along with this program.  If not, see
+% <http://www.gnu.org/licenses/>.
+
+% two labels that touch along the plane c=15, with holes
+a = zeros(30, 30, 20, 'uint8');
+a(6:25, 6:15, 6:15) = 1;
+a(6:25, 16:25, 6:15) = 2;
+a(10, 10, 10) = 0;
+a(20, 20, 10) = 0;
+a(15, 14:17, 8) = 0;
+
+ndil = 2;
+nero = 2;
+b = labmathmorph('close', a, [ndil nero]);
+
+assert(strcmp(class(b), class(a)), 'close: wrong output class')
+
+% every voxel labelled in the input keeps its label, including the
+% voxels on the boundary between the labels
+idx = find(a);
+assert(isequal(b(idx), a(idx)), ...
+    ['close: ' num2str(nnz(b(idx) ~= a(idx))) ...
+    ' labelled voxels lost their label'])
+
+% the holes are filled
+assert(b(10, 10, 10) == 1 && b(20, 20, 10) == 2, ...
+    'close: holes were not filled')
+
+% every labelled voxel of the output is in the closing of its label.
+% The ball of radius R contains the voxels at distance <= R+0.5 from
+% the centre. Voxels outside the image are not background
+for lab = 1:2
+    [gr, gc, gs] = ndgrid(-ndil:ndil);
+    ball = double(gr.^2 + gc.^2 + gs.^2 <= (ndil + 0.5)^2);
+    dil = convn(double(a == lab), ball, 'same') > 0.5;
+    [gr, gc, gs] = ndgrid(-nero:nero);
+    ball = double(gr.^2 + gc.^2 + gs.^2 <= (nero + 0.5)^2);
+    clo = dil & ~(convn(double(~dil), ball, 'same') > 0.5);
+    assert(all(clo(b == lab)), ...
+        ['close: ' num2str(nnz(~clo(b == lab))) ' voxels of label ' ...
+        num2str(lab) ' are outside the closing of the label'])
+end
+
+disp('test_labmathmorph: OK')
@@ -8,7 +8,7 @@
  /*
   * Author: Ramon Casero <rcasero@gmail.com>
   * Copyright © 2012-2013 University of Oxford
-  * Version: 0.5.0
+  * Version: 0.8.1
   *
   * University of Oxford means the Chancellor, Masters and Scholars of
   * the University of Oxford, having an administrative office at
@@ -83,6 +83,11 @@ class MatlabExportFilter: public itk::Object {
 
   // list of the outputs registered at this exporter
   std::list<MatlabOutput> outputsList;
+
+  // put an array in a field of a struct output, adding the field if
+  // necessary and freeing the previous contents of the field
+  void SetStructFieldInMatlab(MatlabOutputPointer output, std::string field,
+			      mxArray *value);
   
  protected:
   
@@ -179,6 +184,26 @@ class MatlabExportFilter: public itk::Object {
   template<class TData>
     TData *AllocateNDArrayInMatlab(MatlabOutputPointer output, std::vector<mwSize> size);
 
+  // Function to allocate memory for an N-dimensional array in Matlab
+  // without initialising its values, and get the data pointer back.
+  //
+  // mxCreateNumericArray() fills the buffer with zeros, which for
+  // large outputs is a whole extra pass over memory. Instead, this
+  // function creates an empty array, and attaches to it a buffer
+  // allocated with mxMalloc(). Only use it when every element of the
+  // output is going to be written by the caller, e.g. an ITK filter
+  // output grafted onto Matlab.
+  //
+  // output: pointer to a registered output
+  //
+  // size:   vector with number of rows, cols, slices, etc of allocated N-dimensional array
+  //
+  // returns: pointer to the data buffer. If the allocated array has
+  //          size zero, the returned pointer is NULL
+  template<class TData>
+    TData *AllocateUninitialisedNDArrayInMatlab(MatlabOutputPointer output, 
+						std::vector<mwSize> size);
+
   // Functions to allocate memory for vectors, matrices and
   // N-dimensional arrays within a cell of a cell array in Matlab, and
   // get the data pointer back.
@@ -206,6 +231,34 @@ class MatlabExportFilter: public itk::Object {
   template<class TData>
     TData *AllocateNDArrayInCellInMatlab(MatlabOutputPointer output, int pos, std::vector<mwSize> size);
 
+  // Functions to allocate memory for matrices and N-dimensional
+  // arrays within a field of a struct in Matlab, and get the data
+  // pointer back. The field is added to the struct if it doesn't
+  // exist, and any previous contents of the field are freed.
+  //
+  // output:  pointer a registered output with a 1x1 struct
+  //
+  // field:   name of the field
+  //
+  // nrows:   number of rows of allocated matrix
+  //
+  // ncols:   number of columns of allocated matrix
+  //
+  // size:    vector with number of rows, cols, slices, etc of allocated N-dimensional array
+  //
+  // returns: pointer to the data buffer. If the allocated array has
+  //          size zero, the returned pointer is NULL
+  template<class TData>
+    TData *AllocateMatrixInStructFieldInMatlab(MatlabOutputPointer output, std::string field,
+					       mwSize nrows, mwSize ncols);
+  template<class TData>
+    TData *AllocateNDArrayInStructFieldInMatlab(MatlabOutputPointer output, std::string field,
+						std::vector<mwSize> size);
+
+  // Function to copy a string to a field of a struct in Matlab.
+  void CopyStringToStructFieldInMatlab(MatlabOutputPointer output, std::string field,
+				       std::string value);
+
   // Function to create an empty output in Matlab.
   void CopyEmptyArrayToMatlab(MatlabOutputPointer output);
 
@@ -215,6 +268,9 @@ class MatlabExportFilter: public itk::Object {
   // output; instead, use CopyItkImageOntoMatlab() after running the
   // filter
   //
+  // The Matlab buffer is not initialised, as the filter will
+  // overwrite all the voxels
+  //
   // size is a vector with the dimensions of the output image in
   // Matlab. For example, for a 256x200x512 image, size = {256, 200, 512}
   //
@@ -9,7 +9,7 @@
  /*
   * Author: Ramon Casero <rcasero@gmail.com>
   * Copyright © 2012-2013 University of Oxford
-  * Version: 0.6.1
+  * Version: 0.9.1
   *
   * University of Oxford means the Chancellor, Masters and Scholars of
   * the University of Oxford, having an administrative office at
@@ -49,6 +49,7 @@
 #include "MatlabExportFilter.h"
 
 // constructor
+inline
 MatlabExportFilter::MatlabExportFilter() {
   this->plhs = NULL;
   this->nlhs = 0;
@@ -57,15 +58,18 @@ MatlabExportFilter::MatlabExportFilter() {
 // destructor
 // this class is only an interface to handle pointer, so we must not
 // attempt to delete the argument list provided by Matlab
+inline
 MatlabExportFilter::~MatlabExportFilter() {}
 
 // get number of elements in the list of plhs arguments
+inline
 int MatlabExportFilter::GetNumberOfArguments() {
   return this->nlhs;
 }
 
 // function to check that number of plhs arguments is within
 // certain limits
+inline
 void MatlabExportFilter::CheckNumberOfArguments(int min, int max) {
   if (this->nlhs < min) {
     mexErrMsgTxt("Not enough output arguments");
@@ -77,12 +81,14 @@ void MatlabExportFilter::CheckNumberOfArguments(int min, int max) {
 
 // function to import into this class the array with the arguments
 // provided by Matlab
+inline
 void MatlabExportFilter::ConnectToMatlabFunctionOutput(int _nlhs, mxArray *_plhs[]) {
   this->nlhs = _nlhs;
   this->plhs = _plhs;
 }
 
 // Functions to register an output at the export filter. 
+inline
 MatlabExportFilter::MatlabOutputPointer
 MatlabExportFilter::RegisterOutput(int pos, std::string name) {
   
@@ -97,7 +103,11 @@ MatlabExportFilter::RegisterOutput(int pos, std::string name) {
   // example:
   // [y,z] = myfun(x); // y and z have been requested
   // y = myfun(x);     // y has been requested, z has not been requested
-  out.isRequested = (pos < this->nlhs);
+  //
+  // Matlab calls the function with nlhs = 0 when there are no output
+  // arguments, e.g. myfun(x), but the first output is still returned
+  // in ans, so it has been requested too
+  out.isRequested = (pos < this->nlhs) || (pos == 0);
 
   // insert the new output at the beginning of the list
   MatlabExportFilter::MatlabOutputPointer it;
@@ -202,6 +212,72 @@ MatlabExportFilter::AllocateNDArrayInMatlab(MatlabExportFilter::MatlabOutputPoin
 
 }
 
+// Function to allocate memory for an N-dimensional array in Matlab
+// without initialising its values, and get the data pointer back.
+template<class TData>
+TData *
+MatlabExportFilter::AllocateUninitialisedNDArrayInMatlab(MatlabExportFilter::MatlabOutputPointer output, 
+							 std::vector<mwSize> size) {
+
+  // get the Matlab class ID for the element type we need
+  mxClassID outputClassId = convertCppDataTypeToMatlabCassId<TData>();
+
+  // check whether there's already memory allocated in the output, and
+  // in that case, de-allocate it
+  if (*output->ppm != NULL) {
+    mxDestroyArray(*output->ppm);
+  }
+
+  // an empty matrix is created the same way as with
+  // AllocateNDArrayInMatlab()
+  mwSize ndim = size.size();
+  if (ndim == 0) {
+    *output->ppm = (mxArray *)mxCreateDoubleMatrix(0, 0, mxREAL);
+    if (*output->ppm == NULL) {
+      mexErrMsgIdAndTxt("Gerardus:MatlabExportFilter:MemoryAllocation", 
+			("Cannot allocate memory for output " + output->name).c_str());
+    }
+    return NULL;
+  }
+
+  // create an empty array of the output class. This doesn't allocate
+  // memory for the elements
+  if (outputClassId == mxLOGICAL_CLASS) {
+    *output->ppm = mxCreateLogicalMatrix(0, 0);
+  } else {
+    *output->ppm = mxCreateNumericMatrix(0, 0, outputClassId, mxREAL);
+  }
+  if (*output->ppm == NULL) {
+    mexErrMsgIdAndTxt("Gerardus:MatlabExportFilter:MemoryAllocation", 
+		      ("Cannot allocate memory for output " + output->name).c_str());
+  }
+
+  // number of elements in the array
+  mwSize numel = 1;
+  for (size_t i = 0; i < ndim; ++i) {
+    numel *= size[i];
+  }
+
+  // attach an uninitialised buffer to the array, and then give it
+  // its dimensions. The array takes ownership of the buffer
+  TData *buffer = NULL;
+  if (numel > 0) {
+    buffer = (TData *)mxMalloc(numel * sizeof(TData));
+    if (buffer == NULL) {
+      mexErrMsgIdAndTxt("Gerardus:MatlabExportFilter:MemoryAllocation", 
+			("Cannot allocate memory for output " + output->name).c_str());
+    }
+    mxSetData(*output->ppm, buffer);
+  }
+  if (mxSetDimensions(*output->ppm, &size[0], ndim)) {
+    mexErrMsgIdAndTxt("Gerardus:MatlabExportFilter:MemoryAllocation", 
+		      ("Cannot set dimensions of output " + output->name).c_str());
+  }
+
+  return buffer;
+
+}
+
 // Function to allocate memory for a column vector in Matlab, and get the
 // data pointer back. 
 template<class TData>
@@ -302,7 +378,111 @@ MatlabExportFilter::AllocateNDArrayInCellInMatlab(MatlabExportFilter::MatlabOutp
 
 }
 
+// Function to put an array in a field of a struct output in Matlab.
+inline
+void
+MatlabExportFilter::SetStructFieldInMatlab(MatlabOutputPointer output, std::string field,
+					   mxArray *value) {
+
+  if (*output->ppm == NULL || !mxIsStruct(*output->ppm)) {
+    mexErrMsgIdAndTxt("Gerardus:MatlabExportFilter:OutputType", 
+		      ("Output " + output->name + " must be a struct").c_str());
+  }
+
+  // add the field if the struct doesn't have it yet
+  int fieldNumber = mxGetFieldNumber(*output->ppm, field.c_str());
+  if (fieldNumber < 0) {
+    fieldNumber = mxAddField(*output->ppm, field.c_str());
+  }
+  if (fieldNumber < 0) {
+    mexErrMsgIdAndTxt("Gerardus:MatlabExportFilter:MemoryAllocation", 
+		      ("Cannot add field to output " + output->name + "." + field).c_str());
+  }
+
+  // free the previous contents of the field
+  mxArray *old = mxGetFieldByNumber(*output->ppm, 0, fieldNumber);
+  if (old != NULL) {
+    mxDestroyArray(old);
+  }
+
+  mxSetFieldByNumber(*output->ppm, 0, fieldNumber, value);
+
+}
+
+// Function to allocate memory for a matrix in a struct field in
+// Matlab, and get the data pointer back.
+template<class TData>
+TData *
+MatlabExportFilter::AllocateMatrixInStructFieldInMatlab(MatlabOutputPointer output, 
+							std::string field,
+							mwSize nrows, mwSize ncols) {
+
+  // vector with matrix dimensions
+  std::vector<mwSize> size;
+  size.push_back(nrows);
+  size.push_back(ncols);
+
+  return this->AllocateNDArrayInStructFieldInMatlab<TData>(output, field, size);
+
+}
+
+// Function to allocate memory for an N-dimensional array in a struct
+// field in Matlab, and get the data pointer back.
+template<class TData>
+TData *
+MatlabExportFilter::AllocateNDArrayInStructFieldInMatlab(MatlabOutputPointer output, 
+							 std::string field,
+							 std::vector<mwSize> size) {
+
+  // get the Matlab class ID for the element type we need
+  mxClassID outputClassId = convertCppDataTypeToMatlabCassId<TData>();
+
+  // allocate memory for the new array
+  mxArray *value;
+  if (size.size() > 0) {
+    value = mxCreateNumericArray(size.size(), &size[0], outputClassId, mxREAL);
+  } else {
+    value = mxCreateDoubleMatrix(0, 0, mxREAL);
+  }
+  if (value == NULL) {
+    mexErrMsgIdAndTxt("Gerardus:MatlabExportFilter:MemoryAllocation", 
+		      ("Cannot allocate memory for output " + output->name + "." + field).c_str());
+  }
+
+  // place the new array into the struct
+  this->SetStructFieldInMatlab(output, field, value);
+
+  // pointer to the Matlab output buffer. If the array created in the
+  // field is empty, mxGetData will return a NULL pointer. Do not treat
+  // this case as an error
+  TData *buffer = (TData *)mxGetData(value);
+  if (buffer == NULL && !mxIsEmpty(value)) {
+    mexErrMsgIdAndTxt("Gerardus:MatlabExportFilter:MemoryAccess", 
+		      ("Cannot get pointer to allocated memory for output " + output->name 
+		       + "." + field).c_str());
+  }
+
+  return buffer;
+
+}
+
+// Function to copy a string to a struct field in Matlab.
+inline
+void
+MatlabExportFilter::CopyStringToStructFieldInMatlab(MatlabOutputPointer output, std::string field,
+						    std::string value) {
+
+  mxArray *str = mxCreateString(value.c_str());
+  if (str == NULL) {
+    mexErrMsgIdAndTxt("Gerardus:MatlabExportFilter:MemoryAllocation", 
+		      ("Cannot allocate memory for output " + output->name + "." + field).c_str());
+  }
+  this->SetStructFieldInMatlab(output, field, str);
+
+}
+
 // Function to create an empty output in Matlab.
+inline
 void 
 MatlabExportFilter::CopyEmptyArrayToMatlab(MatlabOutputPointer output) {
   
@@ -351,7 +531,9 @@ MatlabExportFilter::GraftItkImageOntoMatlab(MatlabOutputPointer output,
     size.insert(size.begin(), VectorDimension);
   }
 
-  // allocate memory for the 3-D or 4-D image in Matlab, and get a pointer to the buffer
+  // allocate memory for the 3-D or 4-D image in Matlab, and get a
+  // pointer to the buffer. The buffer is not initialised, because the
+  // filter is going to overwrite all the voxels
   //
   // this is a rather ugly and dangerous hack. But
   // AllocateNDArrayInMatlab() will not accept a generalised TVector,
@@ -361,7 +543,7 @@ MatlabExportFilter::GraftItkImageOntoMatlab(MatlabOutputPointer output,
   // solve this assuming that the TVector is simply a concatenation of
   // TPixel, so we can do a reinterpret_cast(), but this can cause
   // leaks and segfaults if this is not the case.
-  TPixel *buffer =  this->AllocateNDArrayInMatlab<TPixel>(output, size);
+  TPixel *buffer =  this->AllocateUninitialisedNDArrayInMatlab<TPixel>(output, size);
   TVector *buffer2 = reinterpret_cast<TVector *>(buffer);
 
   // impersonate the data buffer in the filter with the Matlab output
@@ -450,7 +632,7 @@ MatlabExportFilter::CopyItkImageToMatlab(MatlabOutputPointer output,
   }
 
   // allocate memory for the 3-D or 4-D image in Matlab, and get a pointer to the buffer
-  TVector *buffer =  this->AllocateNDArrayInMatlab<TVector>(output, size);
+  TVector *buffer =  this->AllocateUninitialisedNDArrayInMatlab<TVector>(output, size);
 
   // copy ITK filter output to Matlab buffer
   typedef typename itk::ImageRegionConstIterator<OutputImageType> IteratorType;
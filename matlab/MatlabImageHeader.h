@@ -10,7 +10,7 @@
  /*
   * Author: Ramon Casero <rcasero@gmail.com>
   * Copyright © 2012-2013 University of Oxford
-  * Version: 0.2.1
+  * Version: 0.2.2
   *
   * University of Oxford means the Chancellor, Masters and Scholars of
   * the University of Oxford, having an administrative office at
@@ -69,6 +69,7 @@ class MatlabImageHeader {
 
 // constructor of the auxiliary class that preprocesses a Matlab
 // argument that corresponds to an image
+inline
 MatlabImageHeader::MatlabImageHeader(const mxArray *arg, std::string paramName) {
 
   if (arg == NULL) {
@@ -9,7 +9,7 @@
  /*
   * Author: Ramon Casero <rcasero@gmail.com>
   * Copyright © 2012-2013 University of Oxford
-  * Version: 0.8.0
+  * Version: 0.9.0
   *
   * University of Oxford means the Chancellor, Masters and Scholars of
   * the University of Oxford, having an administrative office at
@@ -76,6 +76,12 @@ private:
 
   // list of the inputs registered at this importer
   std::list<MatlabInput> inputsList;
+
+  // function to copy a column-major (N, D)-matrix into a vector of
+  // points, used by ReadPointsContainerFromMatlab()
+  template <class TInput, class TPointVector>
+    void CopyMatrixToPoints(const TInput *in, mwSize npoints,
+			    TPointVector &v, bool swapXY);
   
 protected:
 
@@ -296,6 +302,35 @@ public:
     ReadArrayAsVectorFromMatlab(MatlabInputPointer input,
 				VectorType def);
 
+  // function to read a Matlab (N, D)-matrix of point coordinates into
+  // an ITK container of points with dimension D, e.g. the
+  // itk::VectorContainer returned by itk::PointSet::GetPoints(). This
+  // is the equivalent of ReadVectorOfVectorsFromMatlab() followed by
+  // SwapXYInVectorOfVectors() and a loop of SetPoint(), but it reads
+  // each coordinate only once and transposes it directly into its
+  // place in the container. The container is resized once to N
+  // points, and large matrices are read in parallel.
+  //
+  // Note that you don't need to worry about the type of the scalars in
+  // Matlab. The type will be automatically detected and cast to the
+  // coordinate type of the points.
+  //
+  // input:
+  //   pointer to a registered input. If the user has not provided
+  //   the input, the container is left untouched
+  //
+  // points:
+  //   container of points, e.g. itk::PointSet::PointsContainer. It
+  //   must be a vector container (not a map container)
+  //
+  // swapXY:
+  //   if true, the first two coordinates are swapped, i.e. Matlab [x y z]
+  //   is read as ITK [y x z]. See SwapXYInVectorOfVectors() below
+  template <class TPointsContainer>
+    void ReadPointsContainerFromMatlab(MatlabInputPointer input,
+				       TPointsContainer *points,
+				       bool swapXY = false);
+
   // function to get an input argument that is an image. This function
   // returns an itk::ImportImageFilter, which can be used wherever an
   // itk:Image is required, without having to duplicate the Matlab
@@ -9,7 +9,7 @@
  /*
   * Author: Ramon Casero <rcasero@gmail.com>
   * Copyright © 2012-2013 University of Oxford
-  * Version: 0.8.1
+  * Version: 0.9.2
   *
   * University of Oxford means the Chancellor, Masters and Scholars of
   * the University of Oxford, having an administrative office at
@@ -54,28 +54,33 @@
 #include "MatlabImportFilter.h"
 
 // constructor
+inline
 MatlabImportFilter::MatlabImportFilter() {
   // left intentionally empty
 }
 
 // destructor
+inline
 MatlabImportFilter::~MatlabImportFilter() {
   // left intentionally empty
 }
 
 // function to import into this class the array with the arguments
 // provided by Matlab
+inline
 void MatlabImportFilter::ConnectToMatlabFunctionInput(int _nrhs, const mxArray *_prhs[]) {
   this->nrhs = _nrhs;
   this->prhs = _prhs;
 }
 
 // get number of elements in the prhs list of input arguments
+inline
 unsigned int MatlabImportFilter::GetNumberOfArguments() {
   return this->nrhs;
 }
 
 // function to get direct pointers to the Matlab input arguments
+inline
 const mxArray* MatlabImportFilter::GetPrhsArgument(int idx) {
   if ((idx >= 0) && (idx < this->nrhs)) {
     return this->prhs[idx];
@@ -93,6 +98,7 @@ const mxArray* MatlabImportFilter::GetPrhsArgument(int idx) {
 
 // function to check that number of prhs arguments is within
 // certain limits
+inline
 void MatlabImportFilter::CheckNumberOfArguments(int min, int max) {
   if (this->nrhs < min) {
     mexErrMsgIdAndTxt("Gerardus:MatlabImportFilter:BadInputFormat", 
@@ -105,6 +111,7 @@ void MatlabImportFilter::CheckNumberOfArguments(int min, int max) {
 }
 
 // Functions to register an input at the import filter. 
+inline
 MatlabImportFilter::MatlabInputPointer
 MatlabImportFilter::RegisterInput(int pos, std::string name) {
   
@@ -122,6 +129,7 @@ MatlabImportFilter::RegisterInput(int pos, std::string name) {
 
 }
 
+inline
 MatlabImportFilter::MatlabInputPointer
 MatlabImportFilter::RegisterInput(const mxArray *pm, std::string name) {
 
@@ -166,6 +174,7 @@ MatlabImportFilter::RegisterInput(const mxArray *pm, std::string name) {
 //
 // returns:
 //   a class of type MatlabInput, defined above
+inline
 MatlabImportFilter::MatlabInputPointer 
 MatlabImportFilter::RegisterStructFieldInput(MatlabImportFilter::MatlabInputPointer structInput, 
 					     std::string field) {
@@ -186,6 +195,7 @@ MatlabImportFilter::RegisterStructFieldInput(MatlabImportFilter::MatlabInputPoin
 
 // function to get a pointer to a registered Matlab input by
 // providing its name
+inline
 MatlabImportFilter::MatlabInputPointer 
 MatlabImportFilter::GetRegisteredInput(std::string name) {
   
@@ -275,6 +285,7 @@ VectorType MatlabImportFilter::ReadMatlabArrayHalfSize(MatlabImportFilter::Matla
 }
 
 // function to get the value of input arguments that are strings
+inline
 std::string MatlabImportFilter::ReadStringFromMatlab(MatlabImportFilter::MatlabInputPointer input,
 						     std::string def) {
   
@@ -379,13 +390,15 @@ ParamType MatlabImportFilter::ReadScalarFromMatlab(MatlabImportFilter::MatlabInp
   case mxINT32_CLASS:
     GETVALUE(int32_T);
     break;
-    // case mxUINT32_CLASS:
-    //   break;
+  case mxUINT32_CLASS:
+    GETVALUE(uint32_T);
+    break;
   case mxINT64_CLASS:
     GETVALUE(int64_T);
     break;
-    // case mxUINT64_CLASS:
-    //   break;
+  case mxUINT64_CLASS:
+    GETVALUE(uint64_T);
+    break;
   case mxUNKNOWN_CLASS:
     mexErrMsgIdAndTxt("Gerardus:MatlabImportFilter:BadInputFormat", 
 		      ("Input " + input->name + " has unknown type").c_str());
@@ -475,15 +488,24 @@ VectorType MatlabImportFilter::ReadRowVectorFromMatlab(MatlabImportFilter::Matla
     {VectorWrapper<VectorValueType, VectorType, int32_T> paramWrap;
       return paramWrap.ReadRowVector(input->pm, row, input->name);}
     break;
-    // case mxUINT32_CLASS:
-    //   break;
+  case mxUINT32_CLASS:
+    {VectorWrapper<VectorValueType, VectorType, uint32_T> paramWrap;
+      return paramWrap.ReadRowVector(input->pm, row, input->name);}
+    break;
+#ifndef _WIN64
+  // Note: mxINT64_CLASS causes compilation errors in Windows 64 bit, even though it's fine in linux
+  case mxINT64_CLASS:
+    {VectorWrapper<VectorValueType, VectorType, int64_T> paramWrap;
+      return paramWrap.ReadRowVector(input->pm, row, input->name);}
+    break;
+  case mxUINT64_CLASS:
+    {VectorWrapper<VectorValueType, VectorType, uint64_T> paramWrap;
+      return paramWrap.ReadRowVector(input->pm, row, input->name);}
+    break;
+#else
   case mxINT64_CLASS:
-    // Note: mxINT64_CLASS causes compilation errors in Windows 64 bit, even though it's fine in linux
-    //{VectorWrapper<VectorValueType, VectorType, int64_T> paramWrap;
-    //  return paramWrap.ReadRowVector(input->pm, row, input->name);}
-    //break;
-    // case mxUINT64_CLASS:
-    //   break;
+  case mxUINT64_CLASS:
+#endif
   case mxUNKNOWN_CLASS:
     mexErrMsgIdAndTxt("Gerardus:MatlabImportFilter:BadInputFormat", 
 		      ("Input " + input->name + " has unknown type").c_str());
@@ -637,8 +659,13 @@ MatlabImportFilter::ReadVectorOfVectorsFromMatlab(MatlabImportFilter::MatlabInpu
       }
     }
     break;
-    // case mxUINT32_CLASS:
-    //   break;
+  case mxUINT32_CLASS:
+    {VectorWrapper<VectorValueType, VectorType, uint32_T> paramWrap;
+      for (mwIndex row = 0; row < nrows; ++row) {
+	v[row] = paramWrap.ReadRowVector(input->pm, row, input->name);
+      }
+    }
+    break;
   case mxINT64_CLASS:
     {VectorWrapper<VectorValueType, VectorType, int64_T> paramWrap;
       for (mwIndex row = 0; row < nrows; ++row) {
@@ -646,8 +673,13 @@ MatlabImportFilter::ReadVectorOfVectorsFromMatlab(MatlabImportFilter::MatlabInpu
       }
     }
     break;
-    // case mxUINT64_CLASS:
-    //   break;
+  case mxUINT64_CLASS:
+    {VectorWrapper<VectorValueType, VectorType, uint64_T> paramWrap;
+      for (mwIndex row = 0; row < nrows; ++row) {
+	v[row] = paramWrap.ReadRowVector(input->pm, row, input->name);
+      }
+    }
+    break;
   case mxUNKNOWN_CLASS:
     mexErrMsgIdAndTxt("Gerardus:MatlabImportFilter:BadInputFormat", 
 		      ("Input " + input->name + " has unknown type").c_str());
@@ -726,15 +758,24 @@ MatlabImportFilter::ReadArrayAsVectorFromMatlab(MatlabImportFilter::MatlabInputP
     {VectorWrapper<VectorValueType, VectorType, int32_T> paramWrap;
       return paramWrap.ReadArrayAsVector(input->pm, input->name);}
     break;
-    // case mxUINT32_CLASS:
-    //   break;
+  case mxUINT32_CLASS:
+    {VectorWrapper<VectorValueType, VectorType, uint32_T> paramWrap;
+      return paramWrap.ReadArrayAsVector(input->pm, input->name);}
+    break;
+#ifndef _WIN64
+  // Note: mxINT64_CLASS causes compilation errors in Windows 64 bit, even though it's fine in linux
+  case mxINT64_CLASS:
+    {VectorWrapper<VectorValueType, VectorType, int64_T> paramWrap;
+      return paramWrap.ReadArrayAsVector(input->pm, input->name);}
+    break;
+  case mxUINT64_CLASS:
+    {VectorWrapper<VectorValueType, VectorType, uint64_T> paramWrap;
+      return paramWrap.ReadArrayAsVector(input->pm, input->name);}
+    break;
+#else
   case mxINT64_CLASS:
-    // Note: mxINT64_CLASS causes compilation errors in Windows 64 bit, even though it's fine in linux
-    //{VectorWrapper<VectorValueType, VectorType, int64_T> paramWrap;
-    //  return paramWrap.ReadArrayAsVector(input->pm, input->name);}
-    //break;
-    // case mxUINT64_CLASS:
-    //   break;
+  case mxUINT64_CLASS:
+#endif
   case mxUNKNOWN_CLASS:
     mexErrMsgTxt(("Input " + input->name + " has unknown type.").c_str());
     break;
@@ -750,6 +791,139 @@ MatlabImportFilter::ReadArrayAsVectorFromMatlab(MatlabImportFilter::MatlabInputP
 
 }
 
+// function to read a Matlab (N, D)-matrix of point coordinates into
+// an ITK container of points
+template <class TPointsContainer>
+void
+MatlabImportFilter::ReadPointsContainerFromMatlab(MatlabImportFilter::MatlabInputPointer input,
+						  TPointsContainer *points,
+						  bool swapXY) {
+
+  typedef typename TPointsContainer::Element PointType;
+  const mwSize Dimension = PointType::PointDimension;
+
+  // if user didn't provide a value, or provided an empty array,
+  // leave the container untouched
+  if (!input->isProvided) {
+    return;
+  }
+
+  // check for null pointers
+  if (input->pm == NULL) {
+    mexErrMsgIdAndTxt("Gerardus:MatlabImportFilter:AssertionFail", 
+		      ("Input " + input->name + " flagged as provided, but pointer to input is NULL").c_str());
+  }
+  if (points == NULL) {
+    mexErrMsgIdAndTxt("Gerardus:MatlabImportFilter:AssertionFail", 
+		      ("Container for input " + input->name + " is NULL").c_str());
+  }
+
+  // check that we have a 2D matrix, numeric or boolean, with one
+  // column per coordinate
+  if (mxGetNumberOfDimensions(input->pm) > 2) {
+    mexErrMsgIdAndTxt("Gerardus:MatlabImportFilter:BadInputFormat", 
+		      ("Input " + input->name + " cannot have more than 2 dimensions").c_str());
+  }
+  if (!mxIsNumeric(input->pm) && !mxIsLogical(input->pm)) {
+    mexErrMsgIdAndTxt("Gerardus:MatlabImportFilter:BadInputFormat", 
+		      ("Input " + input->name + " must be numeric or logical").c_str());
+  }
+  if (mxGetN(input->pm) != Dimension) {
+    mexErrMsgIdAndTxt("Gerardus:MatlabImportFilter:BadInputFormat", 
+		      ("Input " + input->name + " has the wrong number of columns for the point dimension").c_str());
+  }
+  if (swapXY && Dimension < 2) {
+    mexErrMsgIdAndTxt("Gerardus:MatlabImportFilter:BadInputFormat", 
+		      ("Input " + input->name + " needs at least 2 columns to swap X and Y").c_str());
+  }
+
+  // allocate all the points at once
+  mwSize npoints = mxGetM(input->pm);
+  points->Initialize();
+  points->Reserve(npoints);
+  typename TPointsContainer::STLContainerType &v = points->CastToSTLContainer();
+
+  // cast the class type provided by Matlab to the coordinate type
+  switch(mxGetClassID(input->pm))  { 
+  case mxLOGICAL_CLASS:
+    this->CopyMatrixToPoints((mxLogical *)mxGetData(input->pm), npoints, v, swapXY);
+    break;
+  case mxDOUBLE_CLASS:
+    this->CopyMatrixToPoints((double *)mxGetData(input->pm), npoints, v, swapXY);
+    break;
+  case mxSINGLE_CLASS:
+    this->CopyMatrixToPoints((float *)mxGetData(input->pm), npoints, v, swapXY);
+    break;
+  case mxINT8_CLASS:
+    this->CopyMatrixToPoints((int8_T *)mxGetData(input->pm), npoints, v, swapXY);
+    break;
+  case mxUINT8_CLASS:
+    this->CopyMatrixToPoints((uint8_T *)mxGetData(input->pm), npoints, v, swapXY);
+    break;
+  case mxINT16_CLASS:
+    this->CopyMatrixToPoints((int16_T *)mxGetData(input->pm), npoints, v, swapXY);
+    break;
+  case mxUINT16_CLASS:
+    this->CopyMatrixToPoints((uint16_T *)mxGetData(input->pm), npoints, v, swapXY);
+    break;
+  case mxINT32_CLASS:
+    this->CopyMatrixToPoints((int32_T *)mxGetData(input->pm), npoints, v, swapXY);
+    break;
+  case mxUINT32_CLASS:
+    this->CopyMatrixToPoints((uint32_T *)mxGetData(input->pm), npoints, v, swapXY);
+    break;
+  case mxINT64_CLASS:
+    this->CopyMatrixToPoints((int64_T *)mxGetData(input->pm), npoints, v, swapXY);
+    break;
+  case mxUINT64_CLASS:
+    this->CopyMatrixToPoints((uint64_T *)mxGetData(input->pm), npoints, v, swapXY);
+    break;
+  case mxUNKNOWN_CLASS:
+    mexErrMsgIdAndTxt("Gerardus:MatlabImportFilter:BadInputFormat", 
+		      ("Input " + input->name + " has unknown type").c_str());
+    break;
+  default:
+    mexErrMsgIdAndTxt("Gerardus:MatlabImportFilter:BadInputFormat", 
+		      ("Input " + input->name + " has invalid type").c_str());
+    break;
+  }
+
+}
+
+// function to copy a column-major (N, D)-matrix into a vector of
+// points. Each thread writes whole points, and reads each column of
+// the matrix sequentially
+template <class TInput, class TPointVector>
+void
+MatlabImportFilter::CopyMatrixToPoints(const TInput *in, mwSize npoints,
+				       TPointVector &v, bool swapXY) {
+
+  typedef typename TPointVector::value_type PointType;
+  typedef typename PointType::ValueType CoordinateType;
+  const mwSize Dimension = PointType::PointDimension;
+
+  // column of the matrix that goes into each coordinate of the point
+  mwIndex col[Dimension];
+  for (mwIndex d = 0; d < Dimension; ++d) {
+    col[d] = d;
+  }
+  if (swapXY) {
+    col[0] = 1;
+    col[1] = 0;
+  }
+
+#ifdef _OPENMP
+#pragma omp parallel for if (npoints > 10000)
+#endif
+  for (mwSignedIndex i = 0; i < (mwSignedIndex)npoints; ++i) {
+    PointType &point = v[i];
+    for (mwIndex d = 0; d < Dimension; ++d) {
+      point[d] = (CoordinateType)in[col[d] * npoints + i];
+    }
+  }
+
+}
+
 // function to get an input argument that is an image
 template <class TPixel, unsigned int VImageDimension>
 typename itk::Image<TPixel, VImageDimension>::Pointer
@@ -845,6 +1019,7 @@ MatlabImportFilter::GetImagePointerFromMatlab(MatlabImportFilter::MatlabInputPoi
 
 // function to get a pointer to a Matlab image, and the
 // metainformation, in a CGAL::_image format
+inline
 _image*
 MatlabImportFilter::ReadCgalImageFromMatlab(MatlabInputPointer input) {
 
@@ -901,21 +1076,21 @@ MatlabImportFilter::ReadCgalImageFromMatlab(MatlabInputPointer input) {
     wordKind = WK_FIXED;
     wordSign = SGN_SIGNED;
     break;
-  // case mxUINT32_CLASS:
-  //   wordSize = sizeof();
-  //   wordKind = WK_FIXED;
-  //   wordSign = SGN_UNSIGNED;
-  //   break;
+  case mxUINT32_CLASS:
+    wordSize = sizeof(uint32_T);
+    wordKind = WK_FIXED;
+    wordSign = SGN_UNSIGNED;
+    break;
   case mxINT64_CLASS:
     wordSize = sizeof(int64_T);
     wordKind = WK_FIXED;
     wordSign = SGN_SIGNED;
     break;
-  // case mxUINT64_CLASS:
-  //   wordSize = sizeof();
-  //   wordKind = WK_FIXED;
-  //   wordSign = SGN_UNSIGNED;
-  //   break;
+  case mxUINT64_CLASS:
+    wordSize = sizeof(uint64_T);
+    wordKind = WK_FIXED;
+    wordSign = SGN_UNSIGNED;
+    break;
   default:
     mexErrMsgTxt(("Input " + input->name + " has invalid type.").c_str());
   }
@@ -1015,8 +1190,13 @@ MatlabImportFilter::ReadCgalImageFromMatlab(MatlabInputPointer input) {
       std::copy(p, p + mxGetNumberOfElements(imHeader.data), (int32_T *)im->data);
       break;
     }
-  // case mxUINT32_CLASS:
-  //   break;
+  case mxUINT32_CLASS:
+    {
+      uint32_T *p = (uint32_T *)mxGetData(imHeader.data);
+      im->data = new uint32_T [mxGetNumberOfElements(imHeader.data)];
+      std::copy(p, p + mxGetNumberOfElements(imHeader.data), (uint32_T *)im->data);
+      break;
+    }
   case mxINT64_CLASS:
     {
       int64_T *p = (int64_T *)mxGetData(imHeader.data);
@@ -1024,8 +1204,13 @@ MatlabImportFilter::ReadCgalImageFromMatlab(MatlabInputPointer input) {
       std::copy(p, p + mxGetNumberOfElements(imHeader.data), (int64_T *)im->data);
       break;
     }
-  // case mxUINT64_CLASS:
-  //   break;
+  case mxUINT64_CLASS:
+    {
+      uint64_T *p = (uint64_T *)mxGetData(imHeader.data);
+      im->data = new uint64_T [mxGetNumberOfElements(imHeader.data)];
+      std::copy(p, p + mxGetNumberOfElements(imHeader.data), (uint64_T *)im->data);
+      break;
+    }
   default:
     mexErrMsgTxt(("Input " + input->name + " has invalid type.").c_str());
   }